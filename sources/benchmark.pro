@@ -0,0 +1,24 @@
+#-------------------------------------------------
+#
+# Benchmark of the sound engine and of the soundfont manager
+#
+# Same sources as Polyphone except the entry point, build it in a separate directory:
+#   mkdir build-benchmark && cd build-benchmark
+#   qmake ../benchmark.pro && make
+#   ./polyphone-benchmark [-d <seconds>] [scenario...]
+#
+#-------------------------------------------------
+
+include(polyphone.pro)
+
+TARGET = polyphone-benchmark
+SOURCES -= main.cpp
+SOURCES += benchmark/main.cpp \
+    benchmark/synthbenchmark.cpp \
+    benchmark/soundfontmanagerbenchmark.cpp
+HEADERS += benchmark/synthbenchmark.h \
+    benchmark/soundfontmanagerbenchmark.h
+INCLUDEPATH += benchmark
+
+# Nothing to install
+INSTALLS =
@@ -0,0 +1,96 @@
+/***************************************************************************
+**                                                                        **
+**  Polyphone, a soundfont editor                                         **
+**  Copyright (C) 2013-2019 Davy Triponney                                **
+**                                                                        **
+**  This program is free software: you can redistribute it and/or modify  **
+**  it under the terms of the GNU General Public License as published by  **
+**  the Free Software Foundation, either version 3 of the License, or     **
+**  (at your option) any later version.                                   **
+**                                                                        **
+**  This program is distributed in the hope that it will be useful,       **
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of        **
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the          **
+**  GNU General Public License for more details.                          **
+**                                                                        **
+**  You should have received a copy of the GNU General Public License     **
+**  along with this program. If not, see http://www.gnu.org/licenses/.    **
+**                                                                        **
+****************************************************************************
+**           Author: Davy Triponney                                       **
+**  Website/Contact: https://www.polyphone-soundfonts.com                 **
+**             Date: 01.01.2013                                           **
+***************************************************************************/
+
+
+#include <QApplication>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QTextStream>
+#include "synthbenchmark.h"
+#include "soundfontmanagerbenchmark.h"
+#include "contextmanager.h"
+#include "soundfontmanager.h"
+#include "utils.h"
+
+// Usage: polyphone-benchmark [-d <seconds>] [scenario...]
+// The result is written in the standard output (json)
+int main(int argc, char *argv[])
+{
+    // No display required
+    if (qEnvironmentVariableIsEmpty("QT_QPA_PLATFORM"))
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+
+    Utils::prepareConversionTables();
+    QApplication app(argc, argv);
+
+    // Configuration not shared with Polyphone, so that the default parameters are used
+    QApplication::setApplicationName("Polyphone benchmark");
+    QApplication::setOrganizationName("polyphone");
+    ContextManager::initializeNoAudioMidi();
+
+    // Arguments
+    double duration = 10;
+    QStringList scenarios;
+    QStringList arguments = app.arguments();
+    for (int i = 1; i < arguments.count(); i++)
+    {
+        if (arguments[i] == "-d" && i + 1 < arguments.count())
+            duration = arguments[++i].toDouble();
+        else
+            scenarios << arguments[i];
+    }
+    if (scenarios.isEmpty())
+        scenarios = SynthBenchmark::getScenarioNames() + SoundfontManagerBenchmark::getScenarioNames();
+    if (duration <= 0)
+    {
+        QTextStream(stderr) << "Invalid duration\n";
+        return 1;
+    }
+
+    // Run the scenarios
+    int valRet = 0;
+    {
+        SynthBenchmark benchmark(ContextManager::configuration());
+        SoundfontManagerBenchmark managerBenchmark;
+        foreach (QString scenario, scenarios)
+        {
+            bool ok = SoundfontManagerBenchmark::getScenarioNames().contains(scenario) ?
+                        managerBenchmark.run(scenario, duration) : benchmark.run(scenario, duration);
+            if (!ok)
+            {
+                QTextStream(stderr) << "Unknown scenario \"" << scenario << "\", possible values: "
+                                    << (SynthBenchmark::getScenarioNames() +
+                                        SoundfontManagerBenchmark::getScenarioNames()).join(", ") << "\n";
+                valRet = 1;
+            }
+        }
+
+        QJsonObject json = benchmark.toJson();
+        json["soundfont_manager"] = managerBenchmark.toJson();
+        QTextStream(stdout) << QJsonDocument(json).toJson();
+    }
+
+    SoundfontManager::kill();
+    return valRet;
+}
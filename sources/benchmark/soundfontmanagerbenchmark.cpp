@@ -0,0 +1,361 @@
+/***************************************************************************
+**                                                                        **
+**  Polyphone, a soundfont editor                                         **
+**  Copyright (C) 2013-2019 Davy Triponney                                **
+**                                                                        **
+**  This program is free software: you can redistribute it and/or modify  **
+**  it under the terms of the GNU General Public License as published by  **
+**  the Free Software Foundation, either version 3 of the License, or     **
+**  (at your option) any later version.                                   **
+**                                                                        **
+**  This program is distributed in the hope that it will be useful,       **
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of        **
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the          **
+**  GNU General Public License for more details.                          **
+**                                                                        **
+**  You should have received a copy of the GNU General Public License     **
+**  along with this program. If not, see http://www.gnu.org/licenses/.    **
+**                                                                        **
+****************************************************************************
+**           Author: Davy Triponney                                       **
+**  Website/Contact: https://www.polyphone-soundfonts.com                 **
+**             Date: 01.01.2013                                           **
+***************************************************************************/
+
+
+#include "soundfontmanagerbenchmark.h"
+#include "soundfontmanager.h"
+#include "sf2/sf2indexconverter.h"
+#include <QElapsedTimer>
+#include <QJsonObject>
+#include <QRunnable>
+#include <QThread>
+#include <QThreadPool>
+
+const int SoundfontManagerBenchmark::INSTRUMENT_NUMBER = 64;
+const int SoundfontManagerBenchmark::DIVISION_NUMBER = 32;
+const int SoundfontManagerBenchmark::LARGE_SAMPLE_NUMBER = 5000;
+const int SoundfontManagerBenchmark::LARGE_DIVISION_NUMBER = 100; // Per instrument, each sample being used once
+
+// Thread calling the manager in a loop until it is stopped
+class ManagerTask: public QRunnable
+{
+public:
+    ManagerTask(int sf2Index, bool isWriter, quint32 seed, QAtomicInt * stop) :
+        _sf2Index(sf2Index),
+        _isWriter(isWriter),
+        _seed(seed),
+        _stop(stop),
+        _count(0)
+    {
+        setAutoDelete(false);
+    }
+
+    void run() override
+    {
+        SoundfontManager * sm = SoundfontManager::getInstance();
+        EltID idInst(elementInst, _sf2Index);
+        EltID idDiv(elementInstSmpl, _sf2Index);
+        AttributeValue value;
+        value.dwValue = 0;
+
+        while (_stop->loadAcquire() == 0)
+        {
+            // Random division
+            _seed = _seed * 1664525 + 1013904223;
+            idDiv.indexElt = static_cast<int>((_seed >> 8) % SoundfontManagerBenchmark::INSTRUMENT_NUMBER);
+            idDiv.indexElt2 = static_cast<int>((_seed >> 16) % SoundfontManagerBenchmark::DIVISION_NUMBER);
+
+            if (_isWriter)
+            {
+                // Edition as done by a page, the changes being then kept without undo
+                value.shValue = static_cast<qint16>((_seed >> 4) % 1000);
+                sm->set(idDiv, champ_initialAttenuation, value);
+                if (++_count % 100 == 0)
+                    sm->clearNewEditing();
+            }
+            else
+            {
+                // Typical queries of the views and of the tools (one count per query)
+                idInst.indexElt = idDiv.indexElt;
+                sm->getSiblings(idDiv);
+                sm->isSet(idDiv, champ_keyRange);
+                sm->get(idDiv, champ_keyRange);
+                sm->get(idDiv, champ_initialAttenuation);
+                sm->getQstr(idInst, champ_name);
+                _count += 5;
+            }
+        }
+    }
+
+    quint64 getCount() { return _count; }
+
+private:
+    int _sf2Index;
+    bool _isWriter;
+    quint32 _seed;
+    QAtomicInt * _stop;
+    quint64 _count;
+};
+
+SoundfontManagerBenchmark::SoundfontManagerBenchmark() :
+    _largeSf2Index(-1)
+{
+    createSoundfont();
+}
+
+QStringList SoundfontManagerBenchmark::getScenarioNames()
+{
+    return QStringList() << "manager_readers" << "manager_readers_writer" << "manager_iteration";
+}
+
+void SoundfontManagerBenchmark::createSoundfont()
+{
+    SoundfontManager * sm = SoundfontManager::getInstance();
+    _sf2Index = sm->add(EltID(elementSf2));
+    sm->set(EltID(elementSf2, _sf2Index), champ_name, QString("manager benchmark"));
+
+    EltID idSmpl(elementSmpl, _sf2Index);
+    idSmpl.indexElt = sm->add(idSmpl);
+    sm->set(idSmpl, champ_name, QString("sample"));
+
+    // Instruments with many divisions
+    AttributeValue value;
+    for (int i = 0; i < INSTRUMENT_NUMBER; i++)
+    {
+        EltID idInst(elementInst, _sf2Index);
+        idInst.indexElt = sm->add(idInst);
+        sm->set(idInst, champ_name, QString("instrument %1").arg(i));
+
+        EltID idDiv(elementInstSmpl, _sf2Index, idInst.indexElt);
+        for (int j = 0; j < DIVISION_NUMBER; j++)
+        {
+            idDiv.indexElt2 = sm->add(idDiv);
+            value.wValue = static_cast<quint16>(idSmpl.indexElt);
+            sm->set(idDiv, champ_sampleID, value);
+            value.rValue.byLo = static_cast<quint8>(4 * j);
+            value.rValue.byHi = static_cast<quint8>(4 * j + 3);
+            sm->set(idDiv, champ_keyRange, value);
+        }
+    }
+
+    // No undo for this soundfont
+    sm->clearNewEditing();
+}
+
+void SoundfontManagerBenchmark::createLargeSoundfont()
+{
+    SoundfontManager * sm = SoundfontManager::getInstance();
+    _largeSf2Index = sm->add(EltID(elementSf2));
+    sm->set(EltID(elementSf2, _largeSf2Index), champ_name, QString("manager benchmark, large"));
+
+    EltID idSmpl(elementSmpl, _largeSf2Index);
+    for (int i = 0; i < LARGE_SAMPLE_NUMBER; i++)
+    {
+        idSmpl.indexElt = sm->add(idSmpl);
+        sm->set(idSmpl, champ_name, QString("sample %1").arg(i));
+    }
+
+    // Instruments sharing all samples
+    AttributeValue value;
+    for (int i = 0; i < LARGE_SAMPLE_NUMBER / LARGE_DIVISION_NUMBER; i++)
+    {
+        EltID idInst(elementInst, _largeSf2Index);
+        idInst.indexElt = sm->add(idInst);
+        sm->set(idInst, champ_name, QString("instrument %1").arg(i));
+
+        EltID idDiv(elementInstSmpl, _largeSf2Index, idInst.indexElt);
+        for (int j = 0; j < LARGE_DIVISION_NUMBER; j++)
+        {
+            idDiv.indexElt2 = sm->add(idDiv);
+            value.wValue = static_cast<quint16>(i * LARGE_DIVISION_NUMBER + j);
+            sm->set(idDiv, champ_sampleID, value);
+            value.rValue.byLo = static_cast<quint8>(j);
+            value.rValue.byHi = static_cast<quint8>(j);
+            sm->set(idDiv, champ_keyRange, value);
+        }
+    }
+
+    sm->clearNewEditing();
+}
+
+bool SoundfontManagerBenchmark::run(QString scenario, double duration)
+{
+    QJsonObject result;
+    if (scenario == "manager_readers" || scenario == "manager_readers_writer")
+        result["steps"] = runReaders(scenario == "manager_readers_writer", duration);
+    else if (scenario == "manager_iteration")
+        result["methods"] = runIteration(duration);
+    else
+        return false;
+
+    result["name"] = scenario;
+    _results.append(result);
+    return true;
+}
+
+QJsonArray SoundfontManagerBenchmark::runReaders(bool withWriter, double duration)
+{
+    // The duration is shared between the different numbers of readers
+    QList<int> threadNumbers;
+    threadNumbers << 1 << 2 << 4 << 8 << 16;
+    unsigned long stepDuration = static_cast<unsigned long>(1000. * duration / threadNumbers.count());
+
+    QJsonArray steps;
+    foreach (int threadNumber, threadNumbers)
+    {
+        QAtomicInt stop(0);
+        QList<ManagerTask *> readers;
+        for (int i = 0; i < threadNumber; i++)
+            readers << new ManagerTask(_sf2Index, false, 1000u + static_cast<quint32>(i), &stop);
+        ManagerTask writer(_sf2Index, true, 1u, &stop);
+
+        QThreadPool pool;
+        pool.setMaxThreadCount(threadNumber + 1);
+        foreach (ManagerTask * reader, readers)
+            pool.start(reader);
+        if (withWriter)
+            pool.start(&writer);
+        QThread::msleep(stepDuration);
+        stop.storeRelease(1);
+        pool.waitForDone();
+
+        quint64 readNumber = 0;
+        foreach (ManagerTask * reader, readers)
+        {
+            readNumber += reader->getCount();
+            delete reader;
+        }
+
+        double seconds = stepDuration / 1000.;
+        QJsonObject step;
+        step["readers"] = threadNumber;
+        step["reads_per_second"] = readNumber / seconds;
+        step["reads_per_second_per_reader"] = readNumber / seconds / threadNumber;
+        if (withWriter)
+            step["writes_per_second"] = writer.getCount() / seconds;
+        steps.append(step);
+    }
+    SoundfontManager::getInstance()->clearNewEditing();
+
+    return steps;
+}
+
+QJsonArray SoundfontManagerBenchmark::runIteration(double duration)
+{
+    if (_largeSf2Index < 0)
+        createLargeSoundfont();
+
+    // Same duration for each method
+    QStringList methods;
+    methods << "lists" << "iterators" << "index_conversion";
+    qint64 methodDuration = static_cast<qint64>(1000. * duration / methods.count());
+
+    QJsonArray results;
+    for (int method = 0; method < methods.count(); method++)
+    {
+        quint64 checksum = 0;
+        quint64 passNumber = 0;
+        QElapsedTimer timer;
+        timer.start();
+        while (timer.elapsed() < methodDuration)
+        {
+            switch (method)
+            {
+            case 0: checksum += browseWithLists(); break;
+            case 1: checksum += browseWithIterators(); break;
+            default: checksum += convertIndexes(); break;
+            }
+            passNumber++;
+        }
+        double seconds = timer.nsecsElapsed() / 1000000000.;
+
+        QJsonObject result;
+        result["method"] = methods[method];
+        result["passes_per_second"] = passNumber / seconds;
+        result["elements_per_second"] = 2. * LARGE_SAMPLE_NUMBER * passNumber / seconds; // Samples and divisions
+        result["checksum"] = static_cast<double>(checksum / qMax(passNumber, static_cast<quint64>(1)));
+        results.append(result);
+    }
+
+    return results;
+}
+
+quint64 SoundfontManagerBenchmark::browseWithLists()
+{
+    SoundfontManager * sm = SoundfontManager::getInstance();
+    quint64 checksum = 0;
+
+    EltID idSmpl(elementSmpl, _largeSf2Index);
+    foreach (int i, sm->getSiblings(idSmpl))
+        checksum += static_cast<quint64>(i);
+
+    EltID idInst(elementInst, _largeSf2Index);
+    foreach (int i, sm->getSiblings(idInst))
+    {
+        EltID idDiv(elementInstSmpl, _largeSf2Index, i);
+        foreach (int j, sm->getSiblings(idDiv))
+        {
+            idDiv.indexElt2 = j;
+            if (sm->isSet(idDiv, champ_keyRange))
+                checksum += sm->get(idDiv, champ_keyRange).rValue.byHi;
+            checksum += sm->get(idDiv, champ_sampleID).wValue;
+        }
+    }
+
+    return checksum;
+}
+
+quint64 SoundfontManagerBenchmark::browseWithIterators()
+{
+    SoundfontManager * sm = SoundfontManager::getInstance();
+    quint64 checksum = 0;
+
+    SiblingIterator itSmpl(sm, EltID(elementSmpl, _largeSf2Index));
+    while (itSmpl.hasNext())
+        checksum += static_cast<quint64>(itSmpl.next());
+
+    SiblingIterator itInst(sm, EltID(elementInst, _largeSf2Index));
+    while (itInst.hasNext())
+    {
+        EltID idDiv(elementInstSmpl, _largeSf2Index, itInst.next());
+        SiblingIterator itDiv(sm, idDiv);
+        while (itDiv.hasNext())
+        {
+            idDiv.indexElt2 = itDiv.next();
+            const QMap<AttributeType, AttributeValue> attributes = sm->getAttributes(idDiv);
+            if (attributes.contains(champ_keyRange))
+                checksum += attributes[champ_keyRange].rValue.byHi;
+            checksum += attributes.value(champ_sampleID).wValue;
+        }
+    }
+
+    return checksum;
+}
+
+quint64 SoundfontManagerBenchmark::convertIndexes()
+{
+    // Sample indexes of all divisions converted into positions, as done by the save
+    SoundfontManager * sm = SoundfontManager::getInstance();
+    quint64 checksum = 0;
+    Sf2IndexConverter converter(EltID(elementSmpl, _largeSf2Index));
+
+    SiblingIterator itInst(sm, EltID(elementInst, _largeSf2Index));
+    while (itInst.hasNext())
+    {
+        EltID idDiv(elementInstSmpl, _largeSf2Index, itInst.next());
+        SiblingIterator itDiv(sm, idDiv);
+        while (itDiv.hasNext())
+        {
+            idDiv.indexElt2 = itDiv.next();
+            checksum += static_cast<quint64>(converter.getIndexOf(sm->get(idDiv, champ_sampleID).wValue, false));
+        }
+    }
+
+    return checksum;
+}
+
+QJsonArray SoundfontManagerBenchmark::toJson()
+{
+    return _results;
+}
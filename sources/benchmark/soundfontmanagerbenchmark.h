@@ -0,0 +1,68 @@
+/***************************************************************************
+**                                                                        **
+**  Polyphone, a soundfont editor                                         **
+**  Copyright (C) 2013-2019 Davy Triponney                                **
+**                                                                        **
+**  This program is free software: you can redistribute it and/or modify  **
+**  it under the terms of the GNU General Public License as published by  **
+**  the Free Software Foundation, either version 3 of the License, or     **
+**  (at your option) any later version.                                   **
+**                                                                        **
+**  This program is distributed in the hope that it will be useful,       **
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of        **
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the          **
+**  GNU General Public License for more details.                          **
+**                                                                        **
+**  You should have received a copy of the GNU General Public License     **
+**  along with this program. If not, see http://www.gnu.org/licenses/.    **
+**                                                                        **
+****************************************************************************
+**           Author: Davy Triponney                                       **
+**  Website/Contact: https://www.polyphone-soundfonts.com                 **
+**             Date: 01.01.2013                                           **
+***************************************************************************/
+
+
+#ifndef SOUNDFONTMANAGERBENCHMARK_H
+#define SOUNDFONTMANAGERBENCHMARK_H
+
+#include "basetypes.h"
+#include <QJsonArray>
+
+// Read the soundfont manager from several threads at the same time (tools, sound engine, views)
+// and measure how the throughput scales with the number of threads
+// Also measure the browsing of a soundfont with 5000 samples, as done by the save or the overviews
+class SoundfontManagerBenchmark
+{
+public:
+    SoundfontManagerBenchmark();
+
+    // Names of the scenarios that can be run
+    static QStringList getScenarioNames();
+
+    // Run a scenario during a number of seconds, return false if the scenario is unknown
+    bool run(QString scenario, double duration);
+
+    // Results of all the scenarios run so far
+    QJsonArray toJson();
+
+    static const int INSTRUMENT_NUMBER;
+    static const int DIVISION_NUMBER;
+    static const int LARGE_SAMPLE_NUMBER;
+    static const int LARGE_DIVISION_NUMBER;
+
+private:
+    void createSoundfont();
+    void createLargeSoundfont();
+    QJsonArray runReaders(bool withWriter, double duration);
+    QJsonArray runIteration(double duration);
+    quint64 browseWithLists();
+    quint64 browseWithIterators();
+    quint64 convertIndexes();
+
+    int _sf2Index;
+    int _largeSf2Index;
+    QJsonArray _results;
+};
+
+#endif // SOUNDFONTMANAGERBENCHMARK_H
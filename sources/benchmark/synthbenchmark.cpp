@@ -0,0 +1,416 @@
+/***************************************************************************
+**                                                                        **
+**  Polyphone, a soundfont editor                                         **
+**  Copyright (C) 2013-2019 Davy Triponney                                **
+**                                                                        **
+**  This program is free software: you can redistribute it and/or modify  **
+**  it under the terms of the GNU General Public License as published by  **
+**  the Free Software Foundation, either version 3 of the License, or     **
+**  (at your option) any later version.                                   **
+**                                                                        **
+**  This program is distributed in the hope that it will be useful,       **
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of        **
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the          **
+**  GNU General Public License for more details.                          **
+**                                                                        **
+**  You should have received a copy of the GNU General Public License     **
+**  along with this program. If not, see http://www.gnu.org/licenses/.    **
+**                                                                        **
+****************************************************************************
+**           Author: Davy Triponney                                       **
+**  Website/Contact: https://www.polyphone-soundfonts.com                 **
+**             Date: 01.01.2013                                           **
+***************************************************************************/
+
+
+#include "synthbenchmark.h"
+#include "synth.h"
+#include "soundfontmanager.h"
+#include <QElapsedTimer>
+#include <QJsonArray>
+#include <QtMath>
+#include <cstdlib>
+#include <new>
+
+// All allocations of the program are counted, the audio computation being expected not to allocate
+static QAtomicInteger<quint64> s_allocationCount(0);
+
+void * operator new(std::size_t size)
+{
+    s_allocationCount.fetchAndAddRelaxed(1);
+    void * ptr = std::malloc(size > 0 ? size : 1);
+    if (ptr == nullptr)
+        throw std::bad_alloc();
+    return ptr;
+}
+
+void * operator new[](std::size_t size)
+{
+    return operator new(size);
+}
+
+void operator delete(void * ptr) noexcept
+{
+    std::free(ptr);
+}
+
+void operator delete[](void * ptr) noexcept
+{
+    std::free(ptr);
+}
+
+void operator delete(void * ptr, std::size_t) noexcept
+{
+    std::free(ptr);
+}
+
+void operator delete[](void * ptr, std::size_t) noexcept
+{
+    std::free(ptr);
+}
+
+SynthBenchmark::SynthBenchmark(ConfManager * configuration, quint32 sampleRate) :
+    _synth(new Synth(configuration, true)),
+    _sampleRate(sampleRate)
+{
+    AudioFormat format;
+    format.setChannelCount(2);
+    format.setSampleRate(sampleRate);
+    format.setSampleSize(32);
+    _synth->setFormat(format);
+
+    _dataL = new float[_synth->getBufferSize()];
+    _dataR = new float[_synth->getBufferSize()];
+
+    createSoundfont();
+}
+
+SynthBenchmark::~SynthBenchmark()
+{
+    delete _synth;
+    delete [] _dataL;
+    delete [] _dataR;
+}
+
+quint64 SynthBenchmark::getAllocationCount()
+{
+    return s_allocationCount.load();
+}
+
+QStringList SynthBenchmark::getScenarioNames()
+{
+    return QStringList() << "sustained_32" << "sustained_128" << "modulation" << "drum_roll"
+                         << "sustain_pileup" << "modulators";
+}
+
+void SynthBenchmark::createSoundfont()
+{
+    SoundfontManager * sm = SoundfontManager::getInstance();
+    _sf2Index = sm->add(EltID(elementSf2));
+    sm->set(EltID(elementSf2, _sf2Index), champ_name, QString("benchmark"));
+
+    // Sine of 440 Hz with a loop of 100 periods
+    QVector<float> sine(44100);
+    for (int i = 0; i < sine.size(); i++)
+        sine[i] = 0.5f * static_cast<float>(qSin(2. * M_PI * 440. * i / 44100.));
+    EltID idSine = addSample("sine", sine, 69, true);
+
+    // Decaying noise, reproducible
+    QVector<float> noise(22050);
+    quint32 seed = 12345;
+    for (int i = 0; i < noise.size(); i++)
+    {
+        seed = seed * 1664525 + 1013904223;
+        noise[i] = (static_cast<float>(seed >> 8) / 8388608.f - 1.f) * static_cast<float>(qExp(-i / 4000.));
+    }
+    EltID idNoise = addSample("noise", noise, 60, false);
+
+    // Loop only
+    AttributeValue value;
+    QMap<AttributeType, AttributeValue> parameters;
+    value.wValue = 1;
+    parameters[champ_sampleModes] = value;
+    _presets["loop"] = addPreset("loop", idSine, parameters, 0);
+
+    // Filter with a resonance, LFOs and modulation envelope
+    value.shValue = 6000;
+    parameters[champ_initialFilterFc] = value;
+    value.shValue = 120;
+    parameters[champ_initialFilterQ] = value;
+    value.shValue = 2400;
+    parameters[champ_modLfoToFilterFc] = value;
+    value.shValue = 200;
+    parameters[champ_freqModLFO] = value;
+    value.shValue = 60;
+    parameters[champ_modLfoToVolume] = value;
+    value.shValue = 50;
+    parameters[champ_vibLfoToPitch] = value;
+    value.shValue = -200;
+    parameters[champ_freqVibLFO] = value;
+    value.shValue = 3600;
+    parameters[champ_modEnvToFilterFc] = value;
+    value.shValue = 0;
+    parameters[champ_decayModEnv] = value;
+    value.shValue = 500;
+    parameters[champ_sustainModEnv] = value;
+    _presets["modulation"] = addPreset("modulation", idSine, parameters, 0);
+
+    // Drums cutting each other
+    parameters.clear();
+    value.wValue = 1;
+    parameters[champ_exclusiveClass] = value;
+    _presets["drums"] = addPreset("drums", idNoise, parameters, 0);
+
+    // Many modulators
+    parameters.clear();
+    value.wValue = 1;
+    parameters[champ_sampleModes] = value;
+    _presets["modulators"] = addPreset("modulators", idSine, parameters, 16);
+
+    // No undo for this soundfont
+    sm->clearNewEditing();
+}
+
+EltID SynthBenchmark::addSample(QString name, const QVector<float> &data, quint32 rootKey, bool isLooped)
+{
+    SoundfontManager * sm = SoundfontManager::getInstance();
+    EltID idSmpl(elementSmpl, _sf2Index);
+    idSmpl.indexElt = sm->add(idSmpl);
+    sm->set(idSmpl, champ_name, name);
+
+    // 16-bit data
+    QByteArray baData;
+    baData.resize(2 * data.size());
+    qint16 * data16 = reinterpret_cast<qint16 *>(baData.data());
+    for (int i = 0; i < data.size(); i++)
+        data16[i] = static_cast<qint16>(qBound(-1.f, data[i], 0.99997f) * 32768.f);
+    sm->set(idSmpl, champ_sampleData16, baData);
+
+    // Configuration
+    AttributeValue value;
+    value.dwValue = static_cast<quint32>(data.size());
+    sm->set(idSmpl, champ_dwLength, value);
+    value.dwValue = 44100;
+    sm->set(idSmpl, champ_dwSampleRate, value);
+    value.wValue = static_cast<quint16>(rootKey);
+    sm->set(idSmpl, champ_byOriginalPitch, value);
+    value.cValue = 0;
+    sm->set(idSmpl, champ_chPitchCorrection, value);
+    value.dwValue = isLooped ? 441 : 0;
+    sm->set(idSmpl, champ_dwStartLoop, value);
+    value.dwValue = isLooped ? static_cast<quint32>(data.size()) - 441 : 0;
+    sm->set(idSmpl, champ_dwEndLoop, value);
+    value.sfLinkValue = monoSample;
+    sm->set(idSmpl, champ_sfSampleType, value);
+
+    return idSmpl;
+}
+
+int SynthBenchmark::addPreset(QString name, EltID idSmpl, QMap<AttributeType, AttributeValue> parameters, int modulatorNumber)
+{
+    SoundfontManager * sm = SoundfontManager::getInstance();
+    AttributeValue value;
+
+    // Instrument with one division covering all keys
+    EltID idInst(elementInst, _sf2Index);
+    idInst.indexElt = sm->add(idInst);
+    sm->set(idInst, champ_name, name);
+    EltID idInstSmpl(elementInstSmpl, _sf2Index, idInst.indexElt);
+    idInstSmpl.indexElt2 = sm->add(idInstSmpl);
+    value.wValue = static_cast<quint16>(idSmpl.indexElt);
+    sm->set(idInstSmpl, champ_sampleID, value);
+    value.rValue.byLo = 0;
+    value.rValue.byHi = 127;
+    sm->set(idInstSmpl, champ_keyRange, value);
+    foreach (AttributeType champ, parameters.keys())
+        sm->set(idInstSmpl, champ, parameters[champ]);
+
+    // Modulators driven by the velocity, the key and several controllers
+    const quint8 controllers[4] = {1, 7, 11, 74};
+    const AttributeType destinations[6] = {
+        champ_initialFilterFc, champ_initialAttenuation, champ_pan,
+        champ_fineTune, champ_reverbEffectsSend, champ_modLfoToFilterFc
+    };
+    for (int i = 0; i < modulatorNumber; i++)
+    {
+        EltID idMod(elementInstSmplMod, _sf2Index, idInst.indexElt, idInstSmpl.indexElt2);
+        idMod.indexMod = sm->add(idMod);
+        if (i % 3 == 0)
+            value.sfModValue = SFModulator(GC_noteOnVelocity, static_cast<ModType>(i % 4), i % 2 == 1, false);
+        else if (i % 3 == 1)
+            value.sfModValue = SFModulator(GC_noteOnKeyNumber, typeLinear, false, true);
+        else
+            value.sfModValue = SFModulator(controllers[i % 4], static_cast<ModType>(i % 3), false, i % 2 == 0);
+        sm->set(idMod, champ_sfModSrcOper, value);
+        value.sfModValue = (i % 4 == 0) ? SFModulator(controllers[(i / 4) % 4], typeLinear, false, false) : SFModulator();
+        sm->set(idMod, champ_sfModAmtSrcOper, value);
+        value.wValue = destinations[i % 6];
+        sm->set(idMod, champ_sfModDestOper, value);
+        value.shValue = static_cast<qint16>(10 + 5 * i);
+        sm->set(idMod, champ_modAmount, value);
+        value.sfTransValue = linear;
+        sm->set(idMod, champ_sfModTransOper, value);
+    }
+
+    // Preset using the instrument
+    EltID idPrst(elementPrst, _sf2Index);
+    idPrst.indexElt = sm->add(idPrst);
+    sm->set(idPrst, champ_name, name);
+    value.wValue = static_cast<quint16>(idPrst.indexElt);
+    sm->set(idPrst, champ_wPreset, value);
+    value.wValue = 0;
+    sm->set(idPrst, champ_wBank, value);
+    EltID idPrstInst(elementPrstInst, _sf2Index, idPrst.indexElt);
+    idPrstInst.indexElt2 = sm->add(idPrstInst);
+    value.wValue = static_cast<quint16>(idInst.indexElt);
+    sm->set(idPrstInst, champ_instrument, value);
+    value.rValue.byLo = 0;
+    value.rValue.byHi = 127;
+    sm->set(idPrstInst, champ_keyRange, value);
+
+    return idPrst.indexElt;
+}
+
+QList<SynthBenchmark::Event> SynthBenchmark::getEvents(QString scenario, quint64 length)
+{
+    QList<Event> events;
+    Event event;
+    event.position = 0;
+    event.velocity = 100;
+
+    if (scenario == "sustained_32" || scenario == "sustained_128")
+    {
+        // Looped voices held during the whole scenario
+        int voiceNumber = (scenario == "sustained_32" ? 32 : 128);
+        event.presetIndex = _presets["loop"];
+        for (int i = 0; i < voiceNumber; i++)
+        {
+            event.key = (voiceNumber == 128 ? i : 48 + i);
+            events << event;
+        }
+    }
+    else if (scenario == "modulation" || scenario == "modulators")
+    {
+        // 64 voices with either filters and LFOs or many modulators
+        event.presetIndex = _presets[scenario];
+        for (int i = 0; i < 64; i++)
+        {
+            event.key = 32 + i;
+            events << event;
+        }
+    }
+    else if (scenario == "drum_roll")
+    {
+        // A hit every 5 ms, the exclusive class stopping the previous one
+        const int keys[3] = {42, 44, 46};
+        event.presetIndex = _presets["drums"];
+        int count = 0;
+        for (quint64 position = 0; position < length; position += _sampleRate / 200)
+        {
+            event.position = position;
+            event.key = keys[count % 3];
+            event.velocity = 60 + (count * 37) % 68;
+            events << event;
+            count++;
+        }
+    }
+    else if (scenario == "sustain_pileup")
+    {
+        // Chords played again every 100 ms while the sustain pedal is down: voices are never released
+        const int keys[8] = {48, 55, 60, 64, 67, 72, 76, 79};
+        event.presetIndex = _presets["loop"];
+        for (quint64 position = 0; position < length; position += _sampleRate / 10)
+        {
+            event.position = position;
+            for (int i = 0; i < 8; i++)
+            {
+                event.key = keys[i];
+                events << event;
+            }
+        }
+    }
+
+    return events;
+}
+
+bool SynthBenchmark::run(QString scenario, double duration)
+{
+    if (!getScenarioNames().contains(scenario))
+        return false;
+
+    quint64 length = static_cast<quint64>(duration * _sampleRate);
+    QList<Event> events = getEvents(scenario, length);
+    quint32 blockLength = _synth->getBufferSize();
+
+    // Render block by block, the events being triggered at the beginning of the block containing them
+    int eventIndex = 0;
+    quint64 blockNumber = 0;
+    quint64 voiceSampleNumber = 0;
+    qint64 totalTime = 0;
+    qint64 maxBlockTime = 0;
+    quint64 totalAllocations = 0;
+    quint64 maxBlockAllocations = 0;
+    int peakVoiceNumber = 0;
+    QElapsedTimer timer;
+    for (quint64 position = 0; position < length; position += blockLength)
+    {
+        while (eventIndex < events.count() && events[eventIndex].position < position + blockLength)
+        {
+            const Event &event = events[eventIndex++];
+            _synth->play(EltID(elementPrst, _sf2Index, event.presetIndex), event.key, event.velocity);
+        }
+        int voiceNumber = _synth->getVoiceNumber();
+        peakVoiceNumber = qMax(peakVoiceNumber, voiceNumber);
+
+        quint64 allocations = getAllocationCount();
+        timer.start();
+        _synth->readData(_dataL, _dataR, blockLength);
+        qint64 blockTime = timer.nsecsElapsed();
+        allocations = getAllocationCount() - allocations;
+
+        blockNumber++;
+        voiceSampleNumber += static_cast<quint64>(voiceNumber) * blockLength;
+        totalTime += blockTime;
+        maxBlockTime = qMax(maxBlockTime, blockTime);
+        totalAllocations += allocations;
+        maxBlockAllocations = qMax(maxBlockAllocations, allocations);
+    }
+    renderSilence();
+
+    // Store the result
+    double renderedDuration = static_cast<double>(blockNumber * blockLength) / _sampleRate;
+    QJsonObject result;
+    result["name"] = scenario;
+    result["blocks"] = static_cast<double>(blockNumber);
+    result["peak_voices"] = peakVoiceNumber;
+    result["ns_per_voice_sample"] = voiceSampleNumber > 0 ? static_cast<double>(totalTime) / voiceSampleNumber : 0.;
+    result["mean_block_ns"] = blockNumber > 0 ? static_cast<double>(totalTime) / blockNumber : 0.;
+    result["max_block_ns"] = static_cast<double>(maxBlockTime);
+    result["realtime_factor"] = totalTime > 0 ? renderedDuration * 1000000000. / totalTime : 0.;
+    result["allocations_per_block"] = blockNumber > 0 ? static_cast<double>(totalAllocations) / blockNumber : 0.;
+    result["max_allocations_block"] = static_cast<double>(maxBlockAllocations);
+    _results << result;
+
+    return true;
+}
+
+void SynthBenchmark::renderSilence()
+{
+    // Stop everything so that the next scenario starts from scratch
+    _synth->stop();
+    for (int i = 0; i < 1000 && _synth->getVoiceNumber() > 0; i++)
+        _synth->readData(_dataL, _dataR, _synth->getBufferSize());
+}
+
+QJsonObject SynthBenchmark::toJson()
+{
+    QJsonArray scenarios;
+    foreach (QJsonObject result, _results)
+        scenarios.append(result);
+
+    QJsonObject json;
+    json["sample_rate"] = static_cast<double>(_sampleRate);
+    json["block_length"] = static_cast<double>(_synth->getBufferSize());
+    json["scenarios"] = scenarios;
+    return json;
+}
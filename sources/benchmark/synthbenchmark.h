@@ -0,0 +1,76 @@
+/***************************************************************************
+**                                                                        **
+**  Polyphone, a soundfont editor                                         **
+**  Copyright (C) 2013-2019 Davy Triponney                                **
+**                                                                        **
+**  This program is free software: you can redistribute it and/or modify  **
+**  it under the terms of the GNU General Public License as published by  **
+**  the Free Software Foundation, either version 3 of the License, or     **
+**  (at your option) any later version.                                   **
+**                                                                        **
+**  This program is distributed in the hope that it will be useful,       **
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of        **
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the          **
+**  GNU General Public License for more details.                          **
+**                                                                        **
+**  You should have received a copy of the GNU General Public License     **
+**  along with this program. If not, see http://www.gnu.org/licenses/.    **
+**                                                                        **
+****************************************************************************
+**           Author: Davy Triponney                                       **
+**  Website/Contact: https://www.polyphone-soundfonts.com                 **
+**             Date: 01.01.2013                                           **
+***************************************************************************/
+
+
+#ifndef SYNTHBENCHMARK_H
+#define SYNTHBENCHMARK_H
+
+#include "basetypes.h"
+#include <QJsonObject>
+class ConfManager;
+class Synth;
+
+// Render reproducible voice loads with a synthetic soundfont, as fast as possible and without audio device
+class SynthBenchmark
+{
+public:
+    SynthBenchmark(ConfManager * configuration, quint32 sampleRate = 44100);
+    ~SynthBenchmark();
+
+    // Names of the scenarios that can be run
+    static QStringList getScenarioNames();
+
+    // Render a scenario during a number of seconds, return false if the scenario is unknown
+    bool run(QString scenario, double duration);
+
+    // Results of all the scenarios run so far
+    QJsonObject toJson();
+
+    // Number of allocations since the beginning of the program (all threads)
+    static quint64 getAllocationCount();
+
+private:
+    struct Event
+    {
+        quint64 position;
+        int presetIndex;
+        int key;
+        int velocity;
+    };
+
+    void createSoundfont();
+    EltID addSample(QString name, const QVector<float> &data, quint32 rootKey, bool isLooped);
+    int addPreset(QString name, EltID idSmpl, QMap<AttributeType, AttributeValue> parameters, int modulatorNumber);
+    QList<Event> getEvents(QString scenario, quint64 length);
+    void renderSilence();
+
+    Synth * _synth;
+    quint32 _sampleRate;
+    int _sf2Index;
+    QMap<QString, int> _presets; // Name => index of the preset
+    float * _dataL, * _dataR;
+    QList<QJsonObject> _results;
+};
+
+#endif // SYNTHBENCHMARK_H
@@ -52,6 +52,12 @@ int jackProcess(jack_nframes_t nframes, void * arg)
     }
     return 0;
 }
+int jackXrun(void * arg)
+{
+    Q_UNUSED(arg)
+    Profiler::addXrun();
+    return 0;
+}
 void jack_shutdown(void *arg) {Q_UNUSED(arg); exit(1);}
 #endif
 
@@ -62,7 +68,10 @@ int standardProcess(const void* inputBuffer, void* outputBuffer,
 {
     Q_UNUSED(inputBuffer);
     Q_UNUSED(timeInfo);
-    Q_UNUSED(statusFlags);
+
+    // Data that couldn't be provided in time
+    if (statusFlags & (paOutputUnderflow | paOutputOverflow))
+        Profiler::addXrun();
 
     // Récupération de l'instance de AudioDevice
     AudioDevice * instance = static_cast<AudioDevice*>(userData);
@@ -296,6 +305,7 @@ void AudioDevice::openJackConnection(quint32 bufferSize)
 
     // Callback de jack pour la récupération de données et l'arrêt
     jack_set_process_callback(_jack_client, jackProcess, this);
+    jack_set_xrun_callback(_jack_client, jackXrun, this);
     jack_on_shutdown(_jack_client, jack_shutdown, nullptr);
 
     // Enregistrement fréquence d'échantillonnage
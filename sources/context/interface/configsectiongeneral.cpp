@@ -134,6 +134,10 @@ void ConfigSectionGeneral::initializeAudio()
     case 512: default: ui->comboBufferSize->setCurrentIndex(5); break;
     }
 
+    ui->checkDirectRendering->blockSignals(true);
+    ui->checkDirectRendering->setChecked(ContextManager::configuration()->getValue(ConfManager::SECTION_AUDIO, "direct_rendering", false).toBool());
+    ui->checkDirectRendering->blockSignals(false);
+
     ui->comboAudioOuput->blockSignals(false);
     ui->comboBufferSize->blockSignals(false);
 }
@@ -152,6 +156,11 @@ void ConfigSectionGeneral::on_comboBufferSize_currentIndexChanged(int index)
     ContextManager::configuration()->setValue(ConfManager::SECTION_AUDIO, "buffer_size", bufferSize);
 }
 
+void ConfigSectionGeneral::on_checkDirectRendering_toggled(bool checked)
+{
+    ContextManager::configuration()->setValue(ConfManager::SECTION_AUDIO, "direct_rendering", checked);
+}
+
 void ConfigSectionGeneral::initializeMidi()
 {
     // Update the possible midi inputs
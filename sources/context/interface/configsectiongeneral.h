@@ -44,6 +44,7 @@ public:
 private slots:
     void on_comboAudioOuput_currentIndexChanged(int index);
     void on_comboBufferSize_currentIndexChanged(int index);
+    void on_checkDirectRendering_toggled(bool checked);
     void on_comboMidiInput_currentIndexChanged(int index);
 
     void on_checkBoucle_toggled(bool checked);
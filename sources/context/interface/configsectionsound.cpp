@@ -25,6 +25,7 @@
 #include "configsectionsound.h"
 #include "ui_configsectionsound.h"
 #include "contextmanager.h"
+#include "dialogdiagnostics.h"
 
 ConfigSectionSound::ConfigSectionSound(QWidget *parent) :
     QWidget(parent),
@@ -81,6 +82,30 @@ void ConfigSectionSound::initialize()
     ui->comboVelToFilter->blockSignals(true);
     ui->comboVelToFilter->setCurrentIndex(ContextManager::configuration()->getValue(ConfManager::SECTION_SOUND_ENGINE, "modulator_vel_to_filter", 1).toInt());
     ui->comboVelToFilter->blockSignals(false);
+    ui->comboInterpolation->blockSignals(true);
+    ui->comboInterpolation->setCurrentIndex(ContextManager::configuration()->getValue(ConfManager::SECTION_SOUND_ENGINE, "interpolation", 0).toInt());
+    ui->comboInterpolation->blockSignals(false);
+
+    // Polyphony
+    ui->spinPolyphony->blockSignals(true);
+    ui->spinPolyphony->setValue(ContextManager::configuration()->getValue(ConfManager::SECTION_SOUND_ENGINE, "max_polyphony", 256).toInt());
+    ui->spinPolyphony->blockSignals(false);
+    ui->comboVoiceStealing->blockSignals(true);
+    ui->comboVoiceStealing->setCurrentIndex(ContextManager::configuration()->getValue(ConfManager::SECTION_SOUND_ENGINE, "voice_stealing", 0).toInt());
+    ui->comboVoiceStealing->blockSignals(false);
+    ui->checkAdaptivePolyphony->blockSignals(true);
+    ui->checkAdaptivePolyphony->setChecked(ContextManager::configuration()->getValue(ConfManager::SECTION_SOUND_ENGINE, "adaptive_polyphony", false).toBool());
+    ui->checkAdaptivePolyphony->blockSignals(false);
+
+    // Streaming
+    bool streaming = ContextManager::configuration()->getValue(ConfManager::SECTION_SOUND_ENGINE, "streaming", false).toBool();
+    ui->checkStreaming->blockSignals(true);
+    ui->checkStreaming->setChecked(streaming);
+    ui->checkStreaming->blockSignals(false);
+    ui->spinStreamingPreload->blockSignals(true);
+    ui->spinStreamingPreload->setValue(ContextManager::configuration()->getValue(ConfManager::SECTION_SOUND_ENGINE, "streaming_preload", 500).toInt());
+    ui->spinStreamingPreload->blockSignals(false);
+    ui->spinStreamingPreload->setEnabled(streaming);
 }
 
 void ConfigSectionSound::on_dialRevNiveau_valueChanged(int value)
@@ -128,3 +153,40 @@ void ConfigSectionSound::on_comboVelToFilter_currentIndexChanged(int index)
 {
     ContextManager::configuration()->setValue(ConfManager::SECTION_SOUND_ENGINE, "modulator_vel_to_filter", index);
 }
+
+void ConfigSectionSound::on_comboInterpolation_currentIndexChanged(int index)
+{
+    ContextManager::configuration()->setValue(ConfManager::SECTION_SOUND_ENGINE, "interpolation", index);
+}
+
+void ConfigSectionSound::on_spinPolyphony_valueChanged(int value)
+{
+    ContextManager::configuration()->setValue(ConfManager::SECTION_SOUND_ENGINE, "max_polyphony", value);
+}
+
+void ConfigSectionSound::on_comboVoiceStealing_currentIndexChanged(int index)
+{
+    ContextManager::configuration()->setValue(ConfManager::SECTION_SOUND_ENGINE, "voice_stealing", index);
+}
+
+void ConfigSectionSound::on_checkAdaptivePolyphony_toggled(bool checked)
+{
+    ContextManager::configuration()->setValue(ConfManager::SECTION_SOUND_ENGINE, "adaptive_polyphony", checked);
+}
+
+void ConfigSectionSound::on_checkStreaming_toggled(bool checked)
+{
+    ContextManager::configuration()->setValue(ConfManager::SECTION_SOUND_ENGINE, "streaming", checked);
+    ui->spinStreamingPreload->setEnabled(checked);
+}
+
+void ConfigSectionSound::on_spinStreamingPreload_valueChanged(int value)
+{
+    ContextManager::configuration()->setValue(ConfManager::SECTION_SOUND_ENGINE, "streaming_preload", value);
+}
+
+void ConfigSectionSound::on_pushDiagnostics_clicked()
+{
+    DialogDiagnostics * dialog = new DialogDiagnostics(this);
+    dialog->show();
+}
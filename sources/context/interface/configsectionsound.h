@@ -50,6 +50,13 @@ private slots:
     void on_dialChoFrequence_valueChanged(int value);
     void on_sliderGain_valueChanged(int value);
     void on_comboVelToFilter_currentIndexChanged(int index);
+    void on_comboInterpolation_currentIndexChanged(int index);
+    void on_spinPolyphony_valueChanged(int value);
+    void on_comboVoiceStealing_currentIndexChanged(int index);
+    void on_checkAdaptivePolyphony_toggled(bool checked);
+    void on_checkStreaming_toggled(bool checked);
+    void on_spinStreamingPreload_valueChanged(int value);
+    void on_pushDiagnostics_clicked();
 
 private:
     Ui::ConfigSectionSound *ui;
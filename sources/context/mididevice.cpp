@@ -23,68 +23,33 @@
 ***************************************************************************/
 
 #include "mididevice.h"
-#include "controllerevent.h"
-#include "noteevent.h"
-#include "bendevent.h"
-#include "programevent.h"
-#include "monopressureevent.h"
-#include "polypressureevent.h"
 #include "pianokeybdcustom.h"
 #include "controllerarea.h"
 #include "confmanager.h"
 #include <QApplication>
+#include <QScreen>
+#include <QTimer>
 #include "synth.h"
+#include "soundfontmanager.h"
+
+const int MidiDevice::KEYBOARD_CHANNEL = 0;
 
 // Callback for MIDI signals
 void midiCallback(double deltatime, std::vector<unsigned char> *message, void *userData)
 {
     Q_UNUSED(deltatime);
+    if (message->empty())
+        return;
 
-    // Create an event
-    QEvent* ev = nullptr;
-    //unsigned char channel = message->at(0) & 0x0F;
-    unsigned char status = message->at(0) & 0xF0;
-
-    switch (status)
-    {
-    case 0x80: case 0x90: // NOTE ON or NOTE OFF
-        // First message is the note, second is velocity
-        if (status == 0x80 || message->at(2) == 0)
-            ev = new NoteEvent(message->at(1), 0);
-        else
-            ev = new NoteEvent(message->at(1), message->at(2));
-        break;
-    case 0xA0: // AFTERTOUCH
-        // First message is the note, second is the pressure
-        ev = new PolyPressureEvent(message->at(1), message->at(2));
-        break;
-    case 0xB0: // CONTROLLER CHANGE
-        // First message is the controller number, second is its value
-        ev = new ControllerEvent(message->at(1), message->at(2));
-        break;
-    case 0xC0: // PROGRAM CHANGED
-        // First message is the program number
-        ev = new ProgramEvent(message->at(1));
-        break;
-    case 0xD0: // MONO PRESSURE
-        // First message is the global pressure
-        ev = new MonoPressureEvent(message->at(1));
-        break;
-    case 0xE0: // BEND
-        // First message is the value
-        ev = new BendEvent(message->at(1), message->at(2));
-        break;
-    default:
-        // Nothing
-        break;
-    }
+    // Time of reception, so that the sound can be triggered with the right timing
+    MidiMessage midiMessage;
+    midiMessage.timestamp = CircularBuffer::currentTime();
+    midiMessage.status = message->at(0);
+    midiMessage.data1 = message->size() > 1 ? message->at(1) : 0;
+    midiMessage.data2 = message->size() > 2 ? message->at(2) : 0;
 
-    if (ev)
-    {
-        // Get the midi device instance and post the event
-        MidiDevice * instance = static_cast<MidiDevice*>(userData);
-        QApplication::postEvent(instance, ev);
-    }
+    // Forward the message to the dispatcher thread, the main thread being possibly busy
+    static_cast<MidiDispatcher*>(userData)->push(midiMessage);
 }
 
 MidiDevice::MidiDevice(ConfManager * configuration, Synth *synth) :
@@ -93,59 +58,67 @@ MidiDevice::MidiDevice(ConfManager * configuration, Synth *synth) :
     _configuration(configuration),
     _midiin(nullptr),
     _synth(synth),
-    _bendValue(0),
-    _isSustainOn(false),
-    _isSostenutoOn(false)
+    _dispatcher(nullptr),
+    _playedElement(elementUnknown),
+    _guiUpdates(4096)
 {
-    // Initialize MIDI values
-    _bendSensitivityValue = _configuration->getValue(ConfManager::SECTION_MIDI, "wheel_sensitivity", 2.0).toDouble();
-    _monoPressureValue = 0; // Always starts with 0
+    // Last MIDI values of the keyboard, restored for all channels except the pedals
+    _values = _synth->getControllerValues();
+    double bendSensitivity = _configuration->getValue(ConfManager::SECTION_MIDI, "wheel_sensitivity", 2.0).toDouble();
+    for (int channel = 0; channel < MIDI_CHANNEL_NUMBER; channel++)
+        _values->setBendSensitivityValue(channel, bendSensitivity);
     for (int i = 0; i < 128; i++)
     {
-        // Default value, depending on the CC number
-        int defaultValue = 64;
-        bool forceDefault = false;
-        switch (i)
-        {
-        case 0: // Bank select
-        case 1: // Modulation wheel
-        case 2: // Breath controller
-        case 12: case 13: // Effect controllers
-        case 80: case 81: case 82: case 83: // On/Off switch
-        case 91: case 92: case 93: case 94: case 95: // Effect amount
-            defaultValue = 0;
-            break;
-        case 4: case 64: case 65: case 66: case 67: case 68: case 69: // Pedals
-            defaultValue = 0;
-            forceDefault = true;
-            break;
-        case 7: case 11: // Main volume, expression
-            defaultValue = 127;
-            break;
-        default:
-            break;
-        }
+        if (i == 4 || (i >= 64 && i <= 69))
+            continue;
+        int value = _configuration->getValue(ConfManager::SECTION_MIDI, "CC_" + QString("%1").arg(i, 3, 10, QChar('0')),
+                                             ControllerValues::getDefaultValue(i)).toInt();
+        for (int channel = 0; channel < MIDI_CHANNEL_NUMBER; channel++)
+            _values->setControllerValue(channel, i, value);
+    }
 
-        _controllerValues[i] = forceDefault ?
-                    defaultValue : _configuration->getValue(ConfManager::SECTION_MIDI, "CC_" + QString("%1").arg(i, 3, 10, QChar('0')), defaultValue).toInt();
+    // Initial state of the channels, the 10th channel being for drums
+    for (int channel = 0; channel < MIDI_CHANNEL_NUMBER; channel++)
+    {
+        _channels[channel].bank = (channel == 9 ? 128 : 0);
+        _channels[channel].program = -1;
+        _channels[channel].preset = EltID(elementUnknown);
+        _channels[channel].isSustainOn = false;
+        _channels[channel].isSostenutoOn = false;
     }
 
+    // The display is updated once per frame
+    int refreshRate = 60;
+    if (QGuiApplication::primaryScreen() != nullptr && QGuiApplication::primaryScreen()->refreshRate() > 1)
+        refreshRate = static_cast<int>(QGuiApplication::primaryScreen()->refreshRate());
+    _guiTimer = new QTimer(this);
+    connect(_guiTimer, SIGNAL(timeout()), this, SLOT(flushGuiUpdates()));
+    _guiTimer->start(1000 / refreshRate);
+
+    // The presets of the channels must be resolved again after each edition
+    // Queued: the signal is emitted with the soundfont manager locked, which is always locked after _mutexState
+    connect(SoundfontManager::getInstance(), SIGNAL(editingDone(QString,QList<int>)),
+            this, SLOT(onEditingDone(QString,QList<int>)), Qt::QueuedConnection);
+
     // Initialize the connection
+    _dispatcher = new MidiDispatcher(this);
     this->openMidiPort(_configuration->getValue(ConfManager::SECTION_MIDI, "index_port", "-1#-1").toString());
 }
 
 MidiDevice::~MidiDevice()
 {
-    // Store some MIDI values
-    _configuration->setValue(ConfManager::SECTION_MIDI, "wheel_sensitivity", _bendSensitivityValue);
+    // Store some MIDI values of the keyboard channel
+    _configuration->setValue(ConfManager::SECTION_MIDI, "wheel_sensitivity", _values->getBendSensitivityValue(KEYBOARD_CHANNEL));
     for (int i = 0; i < 128; i++)
-        _configuration->setValue(ConfManager::SECTION_MIDI, "CC_" + QString("%1").arg(i, 3, 10, QChar('0')), _controllerValues[i]);
+        _configuration->setValue(ConfManager::SECTION_MIDI, "CC_" + QString("%1").arg(i, 3, 10, QChar('0')),
+                                 _values->getControllerValue(KEYBOARD_CHANNEL, i));
 
     if (_midiin != nullptr)
     {
         _midiin->closePort();
         delete _midiin;
     }
+    delete _dispatcher;
 }
 
 QMap<QString, QString> MidiDevice::getMidiList()
@@ -225,7 +198,7 @@ void MidiDevice::openMidiPort(QString source)
 
     // Associate a callback
     _midiin->ignoreTypes(false, false, false);
-    _midiin->setCallback(&midiCallback, this);
+    _midiin->setCallback(&midiCallback, _dispatcher);
 
     // Initialize the midi connection
     if (portNumber < static_cast<int>(_midiin->getPortCount()))
@@ -243,91 +216,147 @@ void MidiDevice::openMidiPort(QString source)
     }
 }
 
-void MidiDevice::customEvent(QEvent * event)
+void MidiDevice::processMidiMessage(const MidiMessage &message)
 {
-    if (event->type() == QEvent::User)
+    int channel = message.status & 0x0F;
+    _mutexState.lock();
+    switch (message.status & 0xF0)
     {
-        // Note on or off
-        NoteEvent *noteEvent = dynamic_cast<NoteEvent *>(event);
-        if (noteEvent->getVelocity() > 0)
-            this->processKeyOn(noteEvent->getNote(), noteEvent->getVelocity(), true);
+    case 0x80: case 0x90: // NOTE ON or NOTE OFF
+        // First data is the note, second is velocity
+        if ((message.status & 0xF0) == 0x80 || message.data2 == 0)
+            applyKeyOff(channel, message.data1, true, message.timestamp);
         else
-            this->processKeyOff(noteEvent->getNote(), true);
-        event->accept();
-    }
-    else if (event->type() == QEvent::User + 1)
-    {
-        // A controller value changed
-        ControllerEvent *controllerEvent = dynamic_cast<ControllerEvent *>(event);
-        processControllerChanged(controllerEvent->getNumController(), controllerEvent->getValue(), true);
-        event->accept();
-    }
-    else if (event->type() == QEvent::User + 2)
-    {
-        // The pressure of a note changed
-        PolyPressureEvent *pressureEvent = dynamic_cast<PolyPressureEvent *>(event);
-        processPolyPressureChanged(pressureEvent->getNote(), pressureEvent->getPressure(), true);
-        event->accept();
-    }
-    else if (event->type() == QEvent::User + 3)
-    {
-        // The global pressure changed
-        MonoPressureEvent *pressureEvent = dynamic_cast<MonoPressureEvent *>(event);
-        processMonoPressureChanged(pressureEvent->getPressure(), true);
-        event->accept();
-    }
-    else if (event->type() == QEvent::User + 4)
-    {
-        // The bend changed
-        BendEvent *bendEvent = dynamic_cast<BendEvent *>(event);
-        processBendChanged(bendEvent->getValue(), true);
-        event->accept();
-    }
-    else if (event->type() == QEvent::User + 5)
-    {
-        // The program changed (no need for now)
-        //ProgramEvent *programEvent = dynamic_cast<ProgramEvent *>(event);
-        event->accept();
+            applyKeyOn(channel, message.data1, message.data2, true, message.timestamp);
+        break;
+    case 0xA0: // AFTERTOUCH
+        // First data is the note, second is the pressure
+        applyPolyPressure(channel, message.data1, message.data2, true);
+        break;
+    case 0xB0: // CONTROLLER CHANGE
+        // First data is the controller number, second is its value
+        applyController(channel, message.data1, message.data2, true, message.timestamp);
+        break;
+    case 0xC0: // PROGRAM CHANGED
+        // First data is the program number
+        applyProgram(channel, message.data1);
+        break;
+    case 0xD0: // MONO PRESSURE
+        // First data is the global pressure
+        applyMonoPressure(channel, message.data1, true);
+        break;
+    case 0xE0: // BEND
+        // Value on 14 bits, converted between -1 and 1
+        applyBend(channel, static_cast<double>(((message.data2 << 7) | message.data1) - 8192) / 8192.0, true);
+        break;
+    default:
+        // Nothing
+        break;
     }
+    _mutexState.unlock();
 }
 
 void MidiDevice::processControllerChanged(int numController, int value, bool syncControllerArea)
 {
-    _mutexValues.lock();
-    _controllerValues[numController] = value;
-    _mutexValues.unlock();
+    _mutexState.lock();
+    applyController(KEYBOARD_CHANNEL, numController, value, syncControllerArea, -1);
+    _mutexState.unlock();
+    flushGuiUpdates();
+}
+
+void MidiDevice::processKeyOn(int key, int vel, bool syncKeyboard)
+{
+    _mutexState.lock();
+    applyKeyOn(KEYBOARD_CHANNEL, key, vel, syncKeyboard, -1);
+    _mutexState.unlock();
+    flushGuiUpdates();
+}
+
+void MidiDevice::processKeyOff(int key, bool syncKeyboard)
+{
+    _mutexState.lock();
+    applyKeyOff(KEYBOARD_CHANNEL, key, syncKeyboard, -1);
+    _mutexState.unlock();
+    flushGuiUpdates();
+}
+
+void MidiDevice::processPolyPressureChanged(int key, int pressure, bool syncKeyboard)
+{
+    _mutexState.lock();
+    applyPolyPressure(KEYBOARD_CHANNEL, key, pressure, syncKeyboard);
+    _mutexState.unlock();
+    flushGuiUpdates();
+}
+
+void MidiDevice::processMonoPressureChanged(int value, bool syncControllerArea)
+{
+    _mutexState.lock();
+    applyMonoPressure(KEYBOARD_CHANNEL, value, syncControllerArea);
+    _mutexState.unlock();
+    flushGuiUpdates();
+}
+
+void MidiDevice::processBendChanged(double value, bool syncControllerArea)
+{
+    _mutexState.lock();
+    applyBend(KEYBOARD_CHANNEL, value, syncControllerArea);
+    _mutexState.unlock();
+    flushGuiUpdates();
+}
+
+void MidiDevice::processBendSensitivityChanged(double semitones, bool syncControllerArea)
+{
+    _mutexState.lock();
+    applyBendSensitivity(KEYBOARD_CHANNEL, semitones, syncControllerArea);
+    _mutexState.unlock();
+    flushGuiUpdates();
+}
+
+void MidiDevice::applyController(int channel, int numController, int value, bool syncControllerArea, qint64 timestamp)
+{
+    _values->setControllerValue(channel, numController, value);
 
-    if (numController == 64)
+    ChannelState &state = _channels[channel];
+    if (numController == 0)
+    {
+        // Bank select (MSB), the drum channel keeps the bank 128
+        if (channel != 9)
+        {
+            state.bank = value;
+            updatePreset(channel);
+        }
+    }
+    else if (numController == 64)
     {
         // Sustain pedal
-        _isSustainOn = (value >= 64);
-        if (!_isSustainOn)
+        state.isSustainOn = (value >= 64);
+        if (!state.isSustainOn)
         {
             // Release all keys that have been sustained by the sustained pedal
-            while (_sustainedKeys.size())
+            while (state.sustainedKeys.size())
             {
-                int key = _sustainedKeys.takeFirst();
-                if (!_isSostenutoOn || !_sostenutoMemoryKeys.contains(key))
-                    processKeyOff(key, true);
+                int key = state.sustainedKeys.takeFirst();
+                if (!state.isSostenutoOn || !state.sostenutoMemoryKeys.contains(key))
+                    applyKeyOff(channel, key, true, timestamp);
             }
         }
     }
     else if (numController == 66)
     {
         // Sostenuto pedal
-        if (_isSostenutoOn != (value >= 64))
+        if (state.isSostenutoOn != (value >= 64))
         {
-            _isSostenutoOn = (value >= 64);
-            if (!_isSostenutoOn)
+            state.isSostenutoOn = (value >= 64);
+            if (!state.isSostenutoOn)
             {
                 // Release all keys that have been sustained by the sostenuto pedal
-                while (_sostenutoMemoryKeys.size())
+                while (state.sostenutoMemoryKeys.size())
                 {
-                    int key = _sostenutoMemoryKeys.takeFirst();
-                    if (!_isSustainOn)
-                        processKeyOff(key, true);
-                    else if (!_sustainedKeys.contains(key))
-                        _sustainedKeys << key; // Will be released later with the sustained pedal
+                    int key = state.sostenutoMemoryKeys.takeFirst();
+                    if (!state.isSustainOn)
+                        applyKeyOff(channel, key, true, timestamp);
+                    else if (!state.sustainedKeys.contains(key))
+                        state.sustainedKeys << key; // Will be released later with the sustained pedal
                 }
             }
         }
@@ -336,118 +365,238 @@ void MidiDevice::processControllerChanged(int numController, int value, bool syn
     {
         // RPN reception, store the messages since they are grouped by 4
         // http://midi.teragonaudio.com/tech/midispec/rpn.htm
-        _rpnHistory << QPair<int, int>(numController, value);
-        if (_rpnHistory.size() > 4)
-            _rpnHistory.removeFirst();
-        if (numController == 38 && _rpnHistory.size() == 4)
+        state.rpnHistory << QPair<int, int>(numController, value);
+        if (state.rpnHistory.size() > 4)
+            state.rpnHistory.removeFirst();
+        if (numController == 38 && state.rpnHistory.size() == 4)
         {
             // Bend sensitivity?
-            if (_rpnHistory[0].first == 101 && _rpnHistory[0].second == 0 && // B0 65 00
-                    _rpnHistory[1].first == 100 && _rpnHistory[1].second == 0 && // B0 64 00
-                    _rpnHistory[2].first == 6 && // B0 06 XX => semitones
-                    _rpnHistory[3].first == 38) // B0 38 YY => cents
+            if (state.rpnHistory[0].first == 101 && state.rpnHistory[0].second == 0 && // B0 65 00
+                    state.rpnHistory[1].first == 100 && state.rpnHistory[1].second == 0 && // B0 64 00
+                    state.rpnHistory[2].first == 6 && // B0 06 XX => semitones
+                    state.rpnHistory[3].first == 38) // B0 38 YY => cents
             {
-                double pitch = 0.01 * _rpnHistory[3].second + _rpnHistory[2].second;
-                processBendSensitivityChanged(pitch, syncControllerArea);
+                double pitch = 0.01 * state.rpnHistory[3].second + state.rpnHistory[2].second;
+                applyBendSensitivity(channel, pitch, syncControllerArea);
             }
         }
     }
 
-    if (syncControllerArea)
-        _controllerArea->updateController(numController, value);
+    notify(channel, GuiUpdate::CONTROLLER, numController, value, 0, syncControllerArea);
 }
 
-void MidiDevice::processKeyOn(int key, int vel, bool syncKeyboard)
+void MidiDevice::applyProgram(int channel, int program)
 {
-    // Possibly initialize the poly pressure value
-    _mutexValues.lock();
-    if (!_polyPressureValues.contains(key) || _polyPressureValues[key] == -1)
-        _polyPressureValues[key] = vel;
-    _mutexValues.unlock();
+    // The next notes of the channel will be played with another preset
+    _channels[channel].program = program;
+    updatePreset(channel);
+}
+
+EltID MidiDevice::getPlayedElement(int channel)
+{
+    // Preset resolved when the bank or the program changed, no soundfont browsing when a note is played
+    const ChannelState &state = _channels[channel];
+    return state.preset.typeElement == elementUnknown ? _playedElement : state.preset;
+}
+
+void MidiDevice::updatePreset(int channel)
+{
+    // Preset of the same soundfont played with the bank and program of the channel
+    // No program received or no presets: the element of the editor is played
+    ChannelState &state = _channels[channel];
+    int index = -1;
+    if (state.program >= 0 && _playedElement.typeElement != elementUnknown)
+        index = SoundfontManager::getInstance()->getMidiPreset(_playedElement.indexSf2, state.bank, state.program);
+    state.preset = (index == -1 ? EltID(elementUnknown) : EltID(elementPrst, _playedElement.indexSf2, index));
+}
+
+void MidiDevice::updatePresets()
+{
+    for (int channel = 0; channel < MIDI_CHANNEL_NUMBER; channel++)
+        updatePreset(channel);
+}
 
-    // Display the note on the keyboard
-    if (_keyboard && syncKeyboard)
-        _keyboard->inputNoteOn(key, vel);
+void MidiDevice::applyKeyOn(int channel, int key, int vel, bool syncKeyboard, qint64 timestamp)
+{
+    // Possibly initialize the poly pressure value
+    _values->initPolyPressure(channel, key, vel);
 
     // Update the memory list for the sostenuto
-    if (!_isSostenutoOn && !_sostenutoMemoryKeys.contains(key))
-        _sostenutoMemoryKeys << key;
+    ChannelState &state = _channels[channel];
+    if (!state.isSostenutoOn && !state.sostenutoMemoryKeys.contains(key))
+        state.sostenutoMemoryKeys << key;
 
-    // Notify about a key being played
-    emit(keyPlayed(key, vel));
+    // Play the key and notify about it
+    _synth->play(getPlayedElement(channel), key, vel, timestamp, channel);
+    notify(channel, GuiUpdate::KEY, key, vel, 0, syncKeyboard);
 }
 
-void MidiDevice::processKeyOff(int key, bool syncKeyboard)
+void MidiDevice::applyKeyOff(int channel, int key, bool syncKeyboard, qint64 timestamp)
 {
     // Remove the note from the keyboard
-    if (_keyboard && syncKeyboard)
-    {
-        _keyboard->inputNoteOff(key);
-        _keyboard->removeCurrentRange(key);
-    }
+    if (syncKeyboard)
+        notify(channel, GuiUpdate::KEY, key, -1, 0, true);
 
     // Stop a sample reading if key is -1
+    ChannelState &state = _channels[channel];
     if (key == -1)
         _synth->play(EltID(), -1, 0);
-    else if (_isSustainOn)
+    else if (state.isSustainOn)
     {
         // Add the key to the list of keys to release later when the pedal is released
-        if (!_sustainedKeys.contains(key))
-            _sustainedKeys << key;
+        if (!state.sustainedKeys.contains(key))
+            state.sustainedKeys << key;
     }
-    else if (!_isSostenutoOn || !_sostenutoMemoryKeys.contains(key))
+    else if (!state.isSostenutoOn || !state.sostenutoMemoryKeys.contains(key))
     {
         // Update the sostenuto memory
-        if (!_isSostenutoOn)
-            _sostenutoMemoryKeys.removeAll(key);
+        if (!state.isSostenutoOn)
+            state.sostenutoMemoryKeys.removeAll(key);
 
-        // Notify about a key being not played anymore
-        emit(keyPlayed(key, 0));
+        // Release the key and notify about it
+        _synth->play(_playedElement, key, 0, timestamp, channel);
+        notify(channel, GuiUpdate::KEY, key, 0, 0, false);
     }
 }
 
-void MidiDevice::processPolyPressureChanged(int key, int pressure, bool syncKeyboard)
+void MidiDevice::applyPolyPressure(int channel, int key, int pressure, bool syncKeyboard)
 {
     Q_UNUSED(syncKeyboard) // No synchronization with the keyboard
 
-    _mutexValues.lock();
-    _polyPressureValues[key] = pressure;
-    _mutexValues.unlock();
+    _values->setPolyPressure(channel, key, pressure);
 
-    emit(polyPressureChanged(key, pressure));
+    notify(channel, GuiUpdate::POLY_PRESSURE, key, pressure, 0, false);
 }
 
-void MidiDevice::processMonoPressureChanged(int value, bool syncControllerArea)
+void MidiDevice::applyMonoPressure(int channel, int value, bool syncControllerArea)
 {
-    _mutexValues.lock();
-    _monoPressureValue = value;
-    _mutexValues.unlock();
+    _values->setMonoPressure(channel, value);
 
-    emit(monoPressureChanged(value));
-    if (syncControllerArea)
-        _controllerArea->updateMonoPressure(value);
+    notify(channel, GuiUpdate::MONO_PRESSURE, value, 0, 0, syncControllerArea);
 }
 
-void MidiDevice::processBendChanged(double value, bool syncControllerArea)
+void MidiDevice::applyBend(int channel, double value, bool syncControllerArea)
 {
-    _mutexValues.lock();
-    _bendValue = value;
-    _mutexValues.unlock();
+    _values->setBendValue(channel, value);
 
-    emit(bendChanged(value));
-    if (syncControllerArea)
-        _controllerArea->updateBend(value);
+    notify(channel, GuiUpdate::BEND, 0, 0, value, syncControllerArea);
 }
 
-void MidiDevice::processBendSensitivityChanged(double semitones, bool syncControllerArea)
+void MidiDevice::applyBendSensitivity(int channel, double semitones, bool syncControllerArea)
+{
+    _values->setBendSensitivityValue(channel, semitones);
+
+    notify(channel, GuiUpdate::BEND_SENSITIVITY, 0, 0, semitones, syncControllerArea);
+}
+
+void MidiDevice::notify(int channel, GuiUpdate::Type type, int value1, int value2, double realValue, bool syncWidget)
+{
+    // The keys of all channels are displayed, the other values only for the keyboard channel
+    if (type != GuiUpdate::KEY && channel != KEYBOARD_CHANNEL)
+        return;
+
+    GuiUpdate update;
+    update.type = type;
+    update.value1 = value1;
+    update.value2 = value2;
+    update.realValue = realValue;
+    update.syncWidget = syncWidget;
+
+    // The main thread processes its updates as soon as the state is unlocked
+    // The MIDI dispatcher never waits for the display: an update is lost if the main thread is stuck
+    if (QThread::currentThread() == this->thread())
+        _pendingGuiUpdates << update;
+    else
+        _guiUpdates.push(update);
+}
+
+void MidiDevice::flushGuiUpdates()
 {
-    _mutexValues.lock();
-    _bendSensitivityValue = semitones;
-    _mutexValues.unlock();
+    // Updates of the main thread
+    while (!_pendingGuiUpdates.isEmpty())
+        dispatchGuiUpdate(_pendingGuiUpdates.takeFirst());
+
+    // Updates of the MIDI dispatcher thread since the last frame
+    // Keys are all processed, only the last value of continuous controllers is displayed
+    QMap<int, GuiUpdate> lastControllers, lastPolyPressures;
+    QList<GuiUpdate> lastOthers;
+    GuiUpdate update;
+    while (_guiUpdates.pop(update))
+    {
+        switch (update.type)
+        {
+        case GuiUpdate::KEY:
+            dispatchGuiUpdate(update);
+            break;
+        case GuiUpdate::CONTROLLER:
+            lastControllers[update.value1] = update;
+            break;
+        case GuiUpdate::POLY_PRESSURE:
+            lastPolyPressures[update.value1] = update;
+            break;
+        default:
+            for (int i = lastOthers.size() - 1; i >= 0; i--)
+                if (lastOthers[i].type == update.type)
+                    lastOthers.removeAt(i);
+            lastOthers << update;
+            break;
+        }
+    }
+    foreach (GuiUpdate controllerUpdate, lastControllers)
+        dispatchGuiUpdate(controllerUpdate);
+    foreach (GuiUpdate pressureUpdate, lastPolyPressures)
+        dispatchGuiUpdate(pressureUpdate);
+    foreach (GuiUpdate otherUpdate, lastOthers)
+        dispatchGuiUpdate(otherUpdate);
+}
 
-    emit(bendSensitivityChanged(semitones));
-    if (syncControllerArea)
-        _controllerArea->updateBendSensitivity(semitones);
+void MidiDevice::dispatchGuiUpdate(const GuiUpdate &update)
+{
+    switch (update.type)
+    {
+    case GuiUpdate::KEY:
+        if (update.value2 > 0)
+        {
+            // Display the note on the keyboard
+            if (_keyboard && update.syncWidget)
+                _keyboard->inputNoteOn(update.value1, update.value2);
+            emit(keyPlayed(update.value1, update.value2));
+        }
+        else if (update.value2 == -1)
+        {
+            // Remove the note from the keyboard
+            if (_keyboard)
+            {
+                _keyboard->inputNoteOff(update.value1);
+                _keyboard->removeCurrentRange(update.value1);
+            }
+        }
+        else
+            emit(keyPlayed(update.value1, 0));
+        break;
+    case GuiUpdate::POLY_PRESSURE:
+        emit(polyPressureChanged(update.value1, update.value2));
+        break;
+    case GuiUpdate::MONO_PRESSURE:
+        emit(monoPressureChanged(update.value1));
+        if (update.syncWidget)
+            _controllerArea->updateMonoPressure(update.value1);
+        break;
+    case GuiUpdate::CONTROLLER:
+        if (update.syncWidget)
+            _controllerArea->updateController(update.value1, update.value2);
+        break;
+    case GuiUpdate::BEND:
+        emit(bendChanged(update.realValue));
+        if (update.syncWidget)
+            _controllerArea->updateBend(update.realValue);
+        break;
+    case GuiUpdate::BEND_SENSITIVITY:
+        emit(bendSensitivityChanged(update.realValue));
+        if (update.syncWidget)
+            _controllerArea->updateBendSensitivity(update.realValue);
+        break;
+    }
 }
 
 void MidiDevice::setKeyboard(PianoKeybdCustom * keyboard)
@@ -470,15 +619,22 @@ void MidiDevice::setControllerArea(ControllerArea * controllerArea)
 void MidiDevice::stopAll()
 {
     // Release all keys sustained
-    _isSustainOn = false;
-    while (_sustainedKeys.size())
-        processKeyOff(_sustainedKeys.takeFirst(), true);
-    if (_isSostenutoOn)
+    _mutexState.lock();
+    for (int channel = 0; channel < MIDI_CHANNEL_NUMBER; channel++)
     {
-        _isSostenutoOn = false;
-        while (_sostenutoMemoryKeys.size())
-            processKeyOff(_sostenutoMemoryKeys.takeFirst(), true);
+        ChannelState &state = _channels[channel];
+        state.isSustainOn = false;
+        while (state.sustainedKeys.size())
+            applyKeyOff(channel, state.sustainedKeys.takeFirst(), true, -1);
+        if (state.isSostenutoOn)
+        {
+            state.isSostenutoOn = false;
+            while (state.sostenutoMemoryKeys.size())
+                applyKeyOff(channel, state.sostenutoMemoryKeys.takeFirst(), true, -1);
+        }
     }
+    _mutexState.unlock();
+    flushGuiUpdates();
 
     // Reset the keyboard
     _keyboard->clearCustomization();
@@ -487,42 +643,60 @@ void MidiDevice::stopAll()
     _synth->stop();
 }
 
-int MidiDevice::getControllerValue(int controllerNumber)
+int MidiDevice::getControllerValue(int controllerNumber, int channel)
+{
+    return _values->getControllerValue(channel, controllerNumber);
+}
+
+double MidiDevice::getBendValue(int channel)
+{
+    return _values->getBendValue(channel);
+}
+
+double MidiDevice::getBendSensitivityValue(int channel)
+{
+    return _values->getBendSensitivityValue(channel);
+}
+
+int MidiDevice::getMonoPressure(int channel)
 {
-    _mutexValues.lock();
-    int result = _controllerValues.contains(controllerNumber) ? _controllerValues[controllerNumber] : -1;
-    _mutexValues.unlock();
-    return result;
+    return _values->getMonoPressure(channel);
 }
 
-double MidiDevice::getBendValue()
+int MidiDevice::getPolyPressure(int key, int channel)
 {
-    _mutexValues.lock();
-    double result = _bendValue;
-    _mutexValues.unlock();
-    return result;
+    return _values->getPolyPressure(channel, key);
 }
 
-double MidiDevice::getBendSensitivityValue()
+void MidiDevice::setPlayedElement(EltID id)
 {
-    _mutexValues.lock();
-    double result = _bendSensitivityValue;
-    _mutexValues.unlock();
-    return result;
+    _mutexState.lock();
+    bool sf2Changed = (id.typeElement == elementUnknown || _playedElement.typeElement == elementUnknown ||
+                       id.indexSf2 != _playedElement.indexSf2);
+    _playedElement = id;
+    if (sf2Changed)
+        updatePresets();
+    _mutexState.unlock();
 }
 
-int MidiDevice::getMonoPressure()
+void MidiDevice::releasePlayedElement(EltID id)
 {
-    _mutexValues.lock();
-    int result = _monoPressureValue;
-    _mutexValues.unlock();
-    return result;
+    _mutexState.lock();
+    if (_playedElement == id)
+    {
+        _playedElement = EltID(elementUnknown);
+        updatePresets();
+    }
+    _mutexState.unlock();
 }
 
-int MidiDevice::getPolyPressure(int key)
+void MidiDevice::onEditingDone(QString editingSource, QList<int> sf2Indexes)
 {
-    _mutexValues.lock();
-    int result = _polyPressureValues.contains(key) ? _polyPressureValues[key] : -1;
-    _mutexValues.unlock();
-    return result;
+    Q_UNUSED(editingSource)
+
+    // Banks and programs may have changed, presets may have been added or removed
+    _mutexState.lock();
+    if (_playedElement.typeElement != elementUnknown && sf2Indexes.contains(_playedElement.indexSf2))
+        updatePresets();
+    _mutexState.unlock();
 }
@@ -31,11 +31,15 @@
 #include <QMap>
 #include <QMutex>
 #include "rtmidi/RtMidi.h"
+#include "basetypes.h"
+#include "mididispatcher.h"
+#include "controllervalues.h"
 class ConfManager;
 class RtMidiIn;
 class PianoKeybdCustom;
 class Synth;
 class ControllerArea;
+class QTimer;
 
 class MidiDevice: public QObject
 {
@@ -59,12 +63,23 @@ public:
     // Stop all keys
     void stopAll();
 
-    // Get last values (-1 if not received yet)
-    int getControllerValue(int controllerNumber);
-    double getBendValue();
-    double getBendSensitivityValue();
-    int getMonoPressure();
-    int getPolyPressure(int key);
+    // Get last values of a channel (-1 if not received yet)
+    int getControllerValue(int controllerNumber, int channel = KEYBOARD_CHANNEL);
+    double getBendValue(int channel = KEYBOARD_CHANNEL);
+    double getBendSensitivityValue(int channel = KEYBOARD_CHANNEL);
+    int getMonoPressure(int channel = KEYBOARD_CHANNEL);
+    int getPolyPressure(int key, int channel = KEYBOARD_CHANNEL);
+
+    // Element played by the keys (sample, instrument or preset), set by the visible editor page
+    // A channel having received a program change plays instead the corresponding preset of the same soundfont
+    void setPlayedElement(EltID id);
+    void releasePlayedElement(EltID id); // Only if id is still the element played
+
+    // MIDI dispatcher thread => process a message, the display being updated later by the main thread
+    void processMidiMessage(const MidiMessage &message);
+
+    // Channel of the virtual keyboard and of the controller area, the only one displayed
+    static const int KEYBOARD_CHANNEL;
 
 public slots:
     void processKeyOn(int key, int vel, bool syncKeyboard = false);
@@ -83,31 +98,80 @@ signals:
     void bendChanged(double value);
     void bendSensitivityChanged(double semitones);
 
-protected:
-    void customEvent(QEvent * event);
+private slots:
+    void flushGuiUpdates();
+    void onEditingDone(QString editingSource, QList<int> sf2Indexes);
 
 private:
+    // Update of the display, sent by the thread having changed a value
+    struct GuiUpdate
+    {
+        enum Type
+        {
+            KEY,
+            POLY_PRESSURE,
+            MONO_PRESSURE,
+            CONTROLLER,
+            BEND,
+            BEND_SENSITIVITY
+        };
+
+        Type type;
+        int value1, value2;
+        double realValue;
+        bool syncWidget;
+    };
+
     void getMidiList(RtMidi::Api api, QMap<QString, QString> *map);
 
+    // State of a channel, accessed with _mutexState
+    struct ChannelState
+    {
+        int bank;
+        int program; // -1 if no program has been received
+        EltID preset; // Preset resolved for the bank and program, elementUnknown if the played element is used
+        QList<QPair<int, int> > rpnHistory;
+
+        // Sustain / Sostenuto pedals
+        QList<int> sustainedKeys;
+        QList<int> sostenutoMemoryKeys;
+        bool isSustainOn, isSostenutoOn;
+    };
+
+    // Executed by the main thread or the MIDI dispatcher thread, _mutexState being locked
+    void applyKeyOn(int channel, int key, int vel, bool syncKeyboard, qint64 timestamp);
+    void applyKeyOff(int channel, int key, bool syncKeyboard, qint64 timestamp);
+    void applyPolyPressure(int channel, int key, int pressure, bool syncKeyboard);
+    void applyMonoPressure(int channel, int value, bool syncControllerArea);
+    void applyController(int channel, int num, int value, bool syncControllerArea, qint64 timestamp);
+    void applyProgram(int channel, int program);
+    void applyBend(int channel, double value, bool syncControllerArea);
+    void applyBendSensitivity(int channel, double semitones, bool syncControllerArea);
+    EltID getPlayedElement(int channel);
+    void updatePreset(int channel);
+    void updatePresets();
+    void notify(int channel, GuiUpdate::Type type, int value1, int value2, double realValue, bool syncWidget);
+    void dispatchGuiUpdate(const GuiUpdate &update);
+
     PianoKeybdCustom * _keyboard;
     ControllerArea * _controllerArea;
     ConfManager * _configuration;
     RtMidiIn * _midiin;
     Synth * _synth;
-    QList<QPair<int, int> > _rpnHistory;
-
-    // Last values
-    QMutex _mutexValues;
-    QMap<int, int> _controllerValues;
-    double _bendValue;
-    double _bendSensitivityValue;
-    int _monoPressureValue;
-    QMap<int, int> _polyPressureValues;
-
-    // Sustain / Sostenuto pedals
-    QList<int> _sustainedKeys;
-    QList<int> _sostenutoMemoryKeys;
-    bool _isSustainOn, _isSostenutoOn;
+    MidiDispatcher * _dispatcher;
+
+    // State shared by the main thread (virtual keyboard, controller area) and the MIDI dispatcher thread
+    QMutex _mutexState;
+    EltID _playedElement;
+    ChannelState _channels[MIDI_CHANNEL_NUMBER];
+
+    // Last values of each channel, shared with the sound engines of the synth
+    ControllerValues * _values;
+
+    // Display updates, processed at the refresh rate of the screen
+    LockFreeQueue<GuiUpdate> _guiUpdates; // From the MIDI dispatcher thread
+    QList<GuiUpdate> _pendingGuiUpdates; // From the main thread
+    QTimer * _guiTimer;
 };
 
 #endif // MIDIDEVICE_H
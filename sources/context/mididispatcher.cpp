@@ -0,0 +1,95 @@
+/***************************************************************************
+**                                                                        **
+**  Polyphone, a soundfont editor                                         **
+**  Copyright (C) 2013-2019 Davy Triponney                                **
+**                                                                        **
+**  This program is free software: you can redistribute it and/or modify  **
+**  it under the terms of the GNU General Public License as published by  **
+**  the Free Software Foundation, either version 3 of the License, or     **
+**  (at your option) any later version.                                   **
+**                                                                        **
+**  This program is distributed in the hope that it will be useful,       **
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of        **
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the          **
+**  GNU General Public License for more details.                          **
+**                                                                        **
+**  You should have received a copy of the GNU General Public License     **
+**  along with this program. If not, see http://www.gnu.org/licenses/.    **
+**                                                                        **
+****************************************************************************
+**           Author: Davy Triponney                                       **
+**  Website/Contact: https://www.polyphone-soundfonts.com                 **
+**             Date: 01.01.2013                                           **
+***************************************************************************/
+
+
+#include "mididispatcher.h"
+#include "mididevice.h"
+
+const quint32 MidiDispatcher::QUEUE_SIZE = 1024;
+const quint32 MidiDispatcher::RESERVED_SIZE = 256;
+QAtomicInt MidiDispatcher::s_droppedCount(0);
+
+MidiDispatcher::MidiDispatcher(MidiDevice * midiDevice) : QThread(),
+    _midiDevice(midiDevice),
+    _messages(QUEUE_SIZE),
+    _interrupted(0)
+{
+    this->start(QThread::TimeCriticalPriority);
+}
+
+MidiDispatcher::~MidiDispatcher()
+{
+    _interrupted.store(1);
+    _semaphore.release();
+    this->wait();
+}
+
+void MidiDispatcher::push(const MidiMessage &message)
+{
+    if (isRelease(message))
+    {
+        // Never dropped, otherwise notes would be stuck: wait for the dispatcher if even the reserved room is full
+        while (!_messages.push(message))
+        {
+            if (_interrupted.load() != 0)
+                return;
+            QThread::yieldCurrentThread();
+        }
+    }
+    else if (_messages.size() >= _messages.capacity() - RESERVED_SIZE || !_messages.push(message))
+    {
+        // Dispatcher late: the other messages are dropped and counted
+        s_droppedCount.fetchAndAddRelaxed(1);
+        return;
+    }
+    _semaphore.release();
+}
+
+bool MidiDispatcher::isRelease(const MidiMessage &message)
+{
+    switch (message.status & 0xF0)
+    {
+    case 0x80: // Note off
+        return true;
+    case 0x90: // Note on with a velocity of 0
+        return message.data2 == 0;
+    case 0xB0: // Sustain or sostenuto off, all sound off, reset all controllers, all notes off and modes
+        return ((message.data1 == 64 || message.data1 == 66) && message.data2 < 64) || message.data1 >= 120;
+    default:
+        return false;
+    }
+}
+
+void MidiDispatcher::run()
+{
+    MidiMessage message;
+    while (true)
+    {
+        _semaphore.acquire();
+        if (_interrupted.load() != 0)
+            break;
+        if (_messages.pop(message))
+            _midiDevice->processMidiMessage(message);
+    }
+}
@@ -0,0 +1,74 @@
+/***************************************************************************
+**                                                                        **
+**  Polyphone, a soundfont editor                                         **
+**  Copyright (C) 2013-2019 Davy Triponney                                **
+**                                                                        **
+**  This program is free software: you can redistribute it and/or modify  **
+**  it under the terms of the GNU General Public License as published by  **
+**  the Free Software Foundation, either version 3 of the License, or     **
+**  (at your option) any later version.                                   **
+**                                                                        **
+**  This program is distributed in the hope that it will be useful,       **
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of        **
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the          **
+**  GNU General Public License for more details.                          **
+**                                                                        **
+**  You should have received a copy of the GNU General Public License     **
+**  along with this program. If not, see http://www.gnu.org/licenses/.    **
+**                                                                        **
+****************************************************************************
+**           Author: Davy Triponney                                       **
+**  Website/Contact: https://www.polyphone-soundfonts.com                 **
+**             Date: 01.01.2013                                           **
+***************************************************************************/
+
+
+#ifndef MIDIDISPATCHER_H
+#define MIDIDISPATCHER_H
+
+#include <QThread>
+#include <QSemaphore>
+#include "lockfreequeue.h"
+class MidiDevice;
+
+// Raw MIDI message, stamped on reception (see CircularBuffer::currentTime)
+struct MidiMessage
+{
+    unsigned char status;
+    unsigned char data1;
+    unsigned char data2;
+    qint64 timestamp;
+};
+
+// Real-time thread processing the MIDI messages as soon as they are received, without the event loop
+// of the main thread: the synth and the controller values are directly updated
+class MidiDispatcher : public QThread
+{
+public:
+    MidiDispatcher(MidiDevice * midiDevice);
+    ~MidiDispatcher() override;
+
+    // MIDI input thread => add a message
+    // When the queue is nearly full, only the messages releasing notes are kept (see RESERVED_SIZE)
+    void push(const MidiMessage &message);
+
+    // Number of messages dropped since the start, read outside the real-time threads
+    static int getDroppedCount() { return s_droppedCount.load(); }
+
+protected:
+    void run() override;
+
+private:
+    static bool isRelease(const MidiMessage &message);
+
+    MidiDevice * _midiDevice;
+    LockFreeQueue<MidiMessage> _messages;
+    QSemaphore _semaphore; // Released for each message and when the thread is interrupted
+    QAtomicInt _interrupted;
+
+    static const quint32 QUEUE_SIZE;
+    static const quint32 RESERVED_SIZE; // Room only for note-off, sustain off and all notes off messages
+    static QAtomicInt s_droppedCount;
+};
+
+#endif // MIDIDISPATCHER_H
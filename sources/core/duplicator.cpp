@@ -852,14 +852,14 @@ bool Duplicator::isGlobalEmpty(EltID id)
         id.typeElement = elementInstGen;
     else
         id.typeElement = elementPrstGen;
-    bool isEmpty = _sm->getSiblings(id).empty();
+    bool isEmpty = _sm->getSiblingCount(id) == 0;
 
     // Nombre de modulateurs
     if (id.typeElement == elementInstGen)
         id.typeElement = elementInstMod;
     else
         id.typeElement = elementPrstMod;
-    isEmpty = isEmpty && _sm->getSiblings(id).empty();
+    isEmpty = isEmpty && _sm->getSiblingCount(id) == 0;
 
     return isEmpty;
 }
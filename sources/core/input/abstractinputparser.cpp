@@ -98,6 +98,10 @@ void AbstractInputParser::processAsync()
     else if (!tempFilePath.isEmpty())
         QFile::remove(tempFilePath);
 
+    // The soundfont is complete and can be displayed
+    if (_sf2Index >= 0)
+        _sm->endLoading(_sf2Index);
+
     // The operation are not stored in the action manager
     _sm->clearNewEditing();
 }
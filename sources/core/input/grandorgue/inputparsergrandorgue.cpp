@@ -183,10 +183,10 @@ void InputParserGrandOrgue::processData(QString key, QString value)
 
 void InputParserGrandOrgue::createSf2(int &sf2Index, QString filename)
 {
-    // Create a new soundfont, store the sf2 index
+    // Create a new soundfont (published when complete), store the sf2 index
     SoundfontManager * sm = SoundfontManager::getInstance();
     EltID idSf2(elementSf2, -1, -1, -1, -1);
-    idSf2.indexSf2 = sm->add(idSf2);
+    idSf2.indexSf2 = sm->beginLoading();
     sf2Index = idSf2.indexSf2;
 
     // Title, comment
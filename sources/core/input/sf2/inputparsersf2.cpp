@@ -29,6 +29,12 @@
 #include "sf2header.h"
 #include "sf2sdtapart.h"
 #include "sf2pdtapart.h"
+#include "soundfont.h"
+#include "smpl.h"
+#include "instprst.h"
+#include "division.h"
+#include "modulator.h"
+#include "utils.h"
 
 InputParserSf2::InputParserSf2() : AbstractInputParser() {}
 
@@ -98,292 +104,166 @@ void InputParserSf2::fillSf2(Sf2Header &header, Sf2SdtaPart &sdtaPart, Sf2PdtaPa
 {
     Q_UNUSED(error)
 
-    // Create a new soundfont
-    sf2Index = _sm->add(EltID(elementSf2));
-    EltID id(elementSf2, sf2Index);
+    // Create a new soundfont, directly filled from the parsed data (neither actions nor notifications)
+    sf2Index = _sm->beginLoading();
+    Soundfont * soundfont = _sm->getSoundfontBeingLoaded(sf2Index);
 
     /// General data
 
-    _sm->set(id, champ_ISNG, header.getInfo("isng"));
-    _sm->set(id, champ_name, header.getInfo("INAM"));
-    _sm->set(id, champ_IROM, header.getInfo("irom"));
-    _sm->set(id, champ_ICRD, header.getInfo("ICRD"));
-    _sm->set(id, champ_IENG, header.getInfo("IENG"));
-    _sm->set(id, champ_IPRD, header.getInfo("IPRD"));
-    _sm->set(id, champ_ICOP, header.getInfo("ICOP"));
-    _sm->set(id, champ_ICMT, header.getInfo("ICMT"));
-    _sm->set(id, champ_ISFT, header.getInfo("ISFT"));
-    AttributeValue value;
-    value.sfVerValue = header.getVersion("ifil");
-    _sm->set(id, champ_IFIL, value);
-    value.sfVerValue = header.getVersion("iver");
-    _sm->set(id, champ_IVER, value);
+    soundfont->_ISNG = header.getInfo("isng").left(255);
+    soundfont->_INAM = header.getInfo("INAM").left(256);
+    soundfont->_nameSort = Utils::removeAccents(soundfont->_INAM).toLower();
+    soundfont->_IROM = header.getInfo("irom").left(255);
+    soundfont->_ICRD = header.getInfo("ICRD").left(255);
+    soundfont->_IENG = header.getInfo("IENG").left(255);
+    soundfont->_IPRD = header.getInfo("IPRD").left(255);
+    soundfont->_ICOP = header.getInfo("ICOP").left(255);
+    soundfont->_ICMT = header.getInfo("ICMT").left(65535);
+    soundfont->_ISFT = header.getInfo("ISFT").left(255);
+    soundfont->_IFIL = header.getVersion("ifil");
+    soundfont->_IVER = header.getVersion("iver");
 
     // Mode 16 ou 24 bits au chargement
-    if (sdtaPart._startSm24Offset > 0)
-    {
-        value.wValue = 24;
-        _sm->set(id, champ_wBpsInit, value);
-        _sm->set(id, champ_wBpsSave, value);
-    }
-    else
-    {
-        value.wValue = 16;
-        _sm->set(id, champ_wBpsInit, value);
-        _sm->set(id, champ_wBpsSave, value);
-    }
+    soundfont->_wBpsInit = soundfont->_wBpsSave = (sdtaPart._startSm24Offset > 0 ? 24 : 16);
 
     /// Samples
 
-    id = EltID(elementSmpl, sf2Index);
+    AttributeValue value;
+    value.dwValue = 0;
     for (int i = 0; i < pdtaPart._shdrs.count() - 1; i++) // Terminal sample (EOS) is not read
     {
-        Sf2PdtaPart_shdr SHDR = pdtaPart._shdrs[i];
+        const Sf2PdtaPart_shdr &SHDR = pdtaPart._shdrs.at(i);
 
-        id.indexElt = _sm->add(id);
-        _sm->set(id, champ_name, SHDR._name);
+        Smpl * smpl = soundfont->getSample(soundfont->addSample());
+        smpl->setName(SHDR._name.trimmed().left(20));
+        smpl->_wSampleLink = SHDR._wSampleLink.value;
+        smpl->_sfSampleType = (SFSampleLink)SHDR._sfSampleType.value;
 
         // Sample properties
+        Sound &sound = smpl->_sound;
         value.bValue = SHDR._originalPitch;
-        _sm->set(id, champ_byOriginalPitch, value);
+        sound.set(champ_byOriginalPitch, value);
         value.cValue = SHDR._correction;
-        _sm->set(id, champ_chPitchCorrection, value);
-        value.wValue = SHDR._wSampleLink.value;
-        _sm->set(id, champ_wSampleLink, value);
-        value.sfLinkValue = (SFSampleLink)SHDR._sfSampleType.value;
-        _sm->set(id, champ_sfSampleType, value);
+        sound.set(champ_chPitchCorrection, value);
         value.wValue = 1;
-        _sm->set(id, champ_wChannel, value);
+        sound.set(champ_wChannel, value);
         value.dwValue = SHDR._sampleRate.value;
-        _sm->set(id, champ_dwSampleRate, value);
-        _sm->set(id, champ_filenameForData, _filename);
+        sound.set(champ_dwSampleRate, value);
+        sound.setFileName(_filename);
 
         // Start / end / length of the sample
         value.dwValue = SHDR._end.value - SHDR._start.value;
-        _sm->set(id, champ_dwLength, value);
+        sound.set(champ_dwLength, value);
         value.dwValue = SHDR._start.value * 2 + (20 + header._infoSize.value + sdtaPart._startSmplOffset);
-        _sm->set(id, champ_dwStart16, value);
+        sound.set(champ_dwStart16, value);
         if (sdtaPart._startSm24Offset > 0)
         {
             value.dwValue = SHDR._start.value + sdtaPart._startSm24Offset;
-            _sm->set(id, champ_dwStart24, value);
+            sound.set(champ_dwStart24, value);
             value.wValue = 24;
-            _sm->set(id, champ_bpsFile, value);
+            sound.set(champ_bpsFile, value);
         }
         else
         {
             value.dwValue = 0;
-            _sm->set(id, champ_dwStart24, value);
+            sound.set(champ_dwStart24, value);
             value.wValue = 16;
-            _sm->set(id, champ_bpsFile, value);
+            sound.set(champ_bpsFile, value);
         }
 
         // Loop
         value.dwValue = SHDR._startLoop.value - SHDR._start.value;
-        _sm->set(id, champ_dwStartLoop, value);
+        sound.set(champ_dwStartLoop, value);
         value.dwValue = SHDR._endLoop.value - SHDR._start.value;
-        _sm->set(id, champ_dwEndLoop, value);
+        sound.set(champ_dwEndLoop, value);
     }
 
     /// Instruments
 
-    EltID id2;
-    id = EltID(elementInst, sf2Index);
-    id2.indexSf2 = sf2Index;
-    quint16 bagmin, bagmax, modmin, modmax, genmin, genmax;
-    int l, global;
     for (int i = 0; i < pdtaPart._insts.count() - 1; i++) // Terminal instrument (EOI) is not read
     {
-        Sf2PdtaPart_inst inst = pdtaPart._insts[i];
+        const Sf2PdtaPart_inst &inst = pdtaPart._insts.at(i);
 
-        l = 0;
-        id.indexElt = _sm->add(id);
-        id2.indexElt = id.indexElt;
-        _sm->set(id, champ_name, inst._name.trimmed());
-
-        // Indexes
-        bagmin = inst._iBagIndex.value;
-        bagmax = pdtaPart._insts[i + 1]._iBagIndex.value;
+        InstPrst * instrument = soundfont->getInstrument(soundfont->addInstrument());
+        instrument->setName(inst._name.trimmed().left(20));
 
         // Foreach ibag
-        for (int j = bagmin; j < bagmax; j++)
-        {
-            Sf2PdtaPart_bag bag = pdtaPart._ibags[j];
-
-            // Indexes of IMOD and IGEN
-            modmin = bag._modIndex.value;
-            genmin = bag._genIndex.value;
-            if (j < pdtaPart._ibags.count() - 1)
-            {
-                modmax = pdtaPart._ibags[j + 1]._modIndex.value;
-                genmax = pdtaPart._ibags[j + 1]._genIndex.value;
-            }
-            else
-            {
-                modmax = pdtaPart._imods.count();
-                genmax = pdtaPart._igens.count();
-            }
-
-            // Global zone?
-            global = 1;
-            for (int k = genmin; k < genmax; k++)
-                if (pdtaPart._igens[k]._sfGenOper.value == champ_sampleID)
-                    global = 0;
-            id2.indexElt2 = -1;
-
-            // Parameters
-            if (global)
-                id2.typeElement = elementInst;
-            else
-            {
-                // Add a sample to an instrument
-                id2.typeElement = elementInstSmpl;
-                id2.indexElt2 = _sm->add(id2);
-            }
-            for (int k = genmin; k < genmax; k++)
-            {
-                value.wValue = pdtaPart._igens[k]._genAmount.value;
-                _sm->set(id2, (AttributeType)pdtaPart._igens[k]._sfGenOper.value, value);
-            }
-
-            // Modulators
-            for (unsigned int k = modmin; k < modmax; k++)
-            {
-                id2.indexMod = -1;
-                if (global)
-                {
-                    // Add a mod to an instrument
-                    id2.typeElement = elementInstMod;
-                    id2.indexMod = _sm->add(id2);
-                }
-                else
-                {
-                    // Add a mod to a sample linked to an instrument
-                    id2.typeElement = elementInstSmplMod;
-                    id2.indexMod = _sm->add(id2);
-                }
-
-                Sf2PdtaPart_mod mod = pdtaPart._imods[k];
-                value.sfModValue = mod._sfModSrcOper;
-                _sm->set(id2, champ_sfModSrcOper, value);
-                value.wValue = mod._sfModDestOper.value;
-                _sm->set(id2, champ_sfModDestOper, value);
-                value.shValue = mod._modAmount.value;
-                _sm->set(id2, champ_modAmount, value);
-                value.sfModValue = mod._sfModAmtSrcOper;
-                _sm->set(id2, champ_sfModAmtSrcOper, value);
-                value.sfTransValue = (SFTransform)mod._sfModTransOper.value;
-                _sm->set(id2, champ_sfModTransOper, value);
-                value.wValue = l;
-                _sm->set(id2, champ_indexMod, value);
-                l++;
-            }
-        }
+        fillDivisions(instrument, inst._iBagIndex.value, pdtaPart._insts.at(i + 1)._iBagIndex.value,
+                      pdtaPart._ibags, pdtaPart._imods, pdtaPart._igens, champ_sampleID);
     }
 
     /// Presets
 
-    id.typeElement = elementPrst;
-    id.indexSf2 = sf2Index;
-    id.indexElt = -1;
     for (int i = 0; i < pdtaPart._phdrs.count() - 1; i++) // Terminal preset (EOP) is not read
     {
-        Sf2PdtaPart_phdr prst = pdtaPart._phdrs[i];
-
-        l = 0;
-        id.indexElt = _sm->add(id);
-        id2.indexElt = id.indexElt;
-        _sm->set(id, champ_name, prst._name.trimmed());
-        value.wValue = prst._preset.value;
-        _sm->set(id, champ_wPreset, value);
-        value.wValue = prst._bank.value;
-        _sm->set(id, champ_wBank, value);
-        value.dwValue = prst._library.value;
-        _sm->set(id, champ_dwLibrary, value);
-        value.dwValue = prst._genre.value;
-        _sm->set(id, champ_dwGenre, value);
-        value.dwValue = prst._morphology.value;
-        _sm->set(id, champ_dwMorphology, value);
-
-        // Indexes
-        bagmin = prst._pBagIndex.value;
-        bagmax = pdtaPart._phdrs[i + 1]._pBagIndex.value;
+        const Sf2PdtaPart_phdr &prst = pdtaPart._phdrs.at(i);
+
+        InstPrst * preset = soundfont->getPreset(soundfont->addPreset());
+        preset->setName(prst._name.trimmed().left(20));
+        preset->setExtraField(champ_wPreset, prst._preset.value);
+        preset->setExtraField(champ_wBank, prst._bank.value);
+        preset->setExtraField(champ_dwLibrary, static_cast<int>(prst._library.value));
+        preset->setExtraField(champ_dwGenre, static_cast<int>(prst._genre.value));
+        preset->setExtraField(champ_dwMorphology, static_cast<int>(prst._morphology.value));
 
         // Foreach pbag
-        for (int j = bagmin; j < bagmax; j++)
-        {
-            Sf2PdtaPart_bag bag = pdtaPart._pbags[j];
-
-            // Indexes of PMOD and PGEN
-            modmin = bag._modIndex.value;
-            genmin = bag._genIndex.value;
-            if (j < pdtaPart._pbags.count() - 1)
-            {
-                modmax = pdtaPart._pbags[j + 1]._modIndex.value;
-                genmax = pdtaPart._pbags[j + 1]._genIndex.value;
-            }
-            else
-            {
-                modmax = pdtaPart._pmods.count();
-                genmax = pdtaPart._pgens.count();
-            }
-
-            // Global zone?
-            global = 1;
-            for (int k = genmin; k < genmax; k++)
-                if (pdtaPart._pgens[k]._sfGenOper.value == champ_instrument)
-                    global = 0;
-
-            // Parameters
-            id2.indexElt2 = -1;
-            if (global)
-                id2.typeElement = elementPrst;
-            else
-            {
-                // Add an instrument to a preset
-                id2.typeElement = elementPrstInst;
-                id2.indexElt2 = _sm->add(id2);
-            }
-            for (int k = genmin; k < genmax; k++)
-            {
-                value.wValue = pdtaPart._pgens[k]._genAmount.value;
-                _sm->set(id2, (AttributeType)pdtaPart._pgens[k]._sfGenOper.value, value);
-            }
-
-            // Modulators
-            for (int k = modmin; k < modmax; k++)
-            {
-                id2.indexMod = -1;
-                if (global)
-                {
-                    // Add a mod to a preset
-                    id2.typeElement = elementPrstMod;
-                    id2.indexMod = _sm->add(id2);
-                }
-                else
-                {
-                    // Add a mod to an instrument linked to a preset
-                    id2.typeElement = elementPrstInstMod;
-                    id2.indexMod = _sm->add(id2);
-                }
-
-                Sf2PdtaPart_mod mod = pdtaPart._pmods[k];
-                value.sfModValue = mod._sfModSrcOper;
-                _sm->set(id2, champ_sfModSrcOper, value);
-                value.wValue = mod._sfModDestOper.value;
-                _sm->set(id2, champ_sfModDestOper, value);
-                value.shValue = mod._modAmount.value;
-                _sm->set(id2, champ_modAmount, value);
-                value.sfModValue = mod._sfModAmtSrcOper;
-                _sm->set(id2, champ_sfModAmtSrcOper, value);
-                value.sfTransValue = (SFTransform)mod._sfModTransOper.value;
-                _sm->set(id2, champ_sfModTransOper, value);
-                value.wValue = l;
-                _sm->set(id2, champ_indexMod, value);
-                l++;
-            }
-        }
+        fillDivisions(preset, prst._pBagIndex.value, pdtaPart._phdrs.at(i + 1)._pBagIndex.value,
+                      pdtaPart._pbags, pdtaPart._pmods, pdtaPart._pgens, champ_instrument);
     }
 
     success = true;
 }
+
+void InputParserSf2::fillDivisions(InstPrst * instPrst, quint16 bagMin, quint16 bagMax, const QList<Sf2PdtaPart_bag> &bags,
+                                   const QList<Sf2PdtaPart_mod> &mods, const QList<Sf2PdtaPart_gen> &gens, AttributeType linkAttribute)
+{
+    AttributeValue value;
+    value.dwValue = 0;
+    quint16 modmin, modmax, genmin, genmax;
+    int l = 0;
+    for (int j = bagMin; j < bagMax; j++)
+    {
+        const Sf2PdtaPart_bag &bag = bags.at(j);
+
+        // Indexes of MOD and GEN
+        modmin = bag._modIndex.value;
+        genmin = bag._genIndex.value;
+        if (j < bags.count() - 1)
+        {
+            modmax = bags.at(j + 1)._modIndex.value;
+            genmax = bags.at(j + 1)._genIndex.value;
+        }
+        else
+        {
+            modmax = mods.count();
+            genmax = gens.count();
+        }
+
+        // Global zone? Otherwise a sample is added to an instrument or an instrument to a preset
+        bool global = true;
+        for (int k = genmin; k < genmax; k++)
+            if (gens.at(k)._sfGenOper.value == linkAttribute)
+                global = false;
+        Division * division = global ? instPrst->getGlobalDivision() : instPrst->getDivision(instPrst->addDivision());
+
+        // Parameters
+        for (int k = genmin; k < genmax; k++)
+        {
+            value.wValue = gens.at(k)._genAmount.value;
+            division->setGen((AttributeType)gens.at(k)._sfGenOper.value, value);
+        }
+
+        // Modulators
+        for (int k = modmin; k < modmax; k++)
+        {
+            const Sf2PdtaPart_mod &mod = mods.at(k);
+            ModulatorData &data = division->getMod(division->addMod())->_data;
+            data.srcOper = mod._sfModSrcOper;
+            data.destOper = mod._sfModDestOper.value;
+            data.amount = mod._modAmount.value;
+            data.amtSrcOper = mod._sfModAmtSrcOper;
+            data.transOper = (SFTransform)mod._sfModTransOper.value;
+            data.index = l++;
+        }
+    }
+}
@@ -26,10 +26,15 @@
 #define INPUTPARSERSF2_H
 
 #include "abstractinputparser.h"
+#include "basetypes.h"
 class SoundfontManager;
 class Sf2Header;
 class Sf2SdtaPart;
 class Sf2PdtaPart;
+class Sf2PdtaPart_bag;
+class Sf2PdtaPart_mod;
+class Sf2PdtaPart_gen;
+class InstPrst;
 
 class InputParserSf2 : public AbstractInputParser
 {
@@ -44,6 +49,8 @@ protected slots:
 private:
     void parse(QDataStream &stream, bool &success, QString &error, int &sf2Index);
     void fillSf2(Sf2Header &header, Sf2SdtaPart &sdtaPart, Sf2PdtaPart &pdtaPart, bool &success, QString &error, int &sf2Index);
+    void fillDivisions(InstPrst * instPrst, quint16 bagMin, quint16 bagMax, const QList<Sf2PdtaPart_bag> &bags,
+                       const QList<Sf2PdtaPart_mod> &mods, const QList<Sf2PdtaPart_gen> &gens, AttributeType linkAttribute);
 
     SoundfontManager * _sm;
     QString _filename;
@@ -278,7 +278,8 @@ void InputParserSfz::createSf2(int &sf2Index, QString filename, bool isChannel10
     EltID idSf2(elementSf2, -1, -1, -1, -1);
     if (sf2Index == -1)
     {
-        idSf2.indexSf2 = sm->add(idSf2);
+        // New soundfont, built without actions nor notifications until it is complete
+        idSf2.indexSf2 = sm->beginLoading();
         sf2Index = idSf2.indexSf2;
         sm->set(idSf2, champ_name, nom);
     }
@@ -53,7 +53,7 @@ AttributeValue Division::getGen(AttributeType champ)
 {
     AttributeValue value;
     if (_parameters.contains(champ))
-        value = _parameters[champ];
+        value = _parameters.value(champ); // Const access: the parameters may be shared by readers
     else
         value.wValue = 0;
     return value;
@@ -33,7 +33,8 @@
 
 Soundfont::Soundfont(EltID id) :
     _id(id),
-    _smpl(IndexedElementList<Smpl *>())
+    _smpl(IndexedElementList<Smpl *>()),
+    _isLoading(false)
 {
     // Prepare the root items and the model
     _rootItem = new TreeItemRoot(EltID(elementUnknown));
@@ -134,6 +135,18 @@ Soundfont::~Soundfont()
     delete _model;
 }
 
+void Soundfont::beginLoading()
+{
+    _isLoading = true;
+    static_cast<TreeModel *>(_model)->beginLoading();
+}
+
+void Soundfont::endLoading()
+{
+    _isLoading = false;
+    static_cast<TreeModel *>(_model)->endLoading();
+}
+
 int Soundfont::addSample()
 {
     int index = _smpl.add(new Smpl(_smpl.positionCount(), _sampleTreeItem, EltID(elementSmpl, _id.indexSf2, _smpl.indexCount(), -1, -1)));
@@ -45,7 +45,7 @@ public:
     // Add, get or delete a sample
     int addSample();
     Smpl * getSample(int index);
-    const IndexedElementList<Smpl *> getSamples() { return _smpl; }
+    const IndexedElementList<Smpl *> & getSamples() { return _smpl; }
     bool deleteSample(int index);
 
     // Add, get or delete an instrument
@@ -63,6 +63,11 @@ public:
     // Tree model associated to the soundfont
     QAbstractItemModel * getModel() { return _model; }
 
+    // Bulk loading: the soundfont is filled without notifying the tree model
+    void beginLoading();
+    void endLoading();
+    bool isLoading() { return _isLoading; }
+
     // Doc: "max 255 characters except for "comments", ended by 1 or 2 \0 for an even number of bits"
     SfVersionTag _IFIL; // version of the Sound Font RIFF file     e.g. 2.01                                MANDATORY
     QString _ISNG; // Target Sound Engine                          e.g. "EMU8000"                           MANDATORY
@@ -92,6 +97,7 @@ private:
     IndexedElementList<InstPrst *> _prst;
 
     QAbstractItemModel * _model;
+    bool _isLoading;
     TreeItemRoot * _rootItem;
     TreeItem * _generalTreeItem;
     TreeItem * _sampleTreeItem;
@@ -27,7 +27,8 @@
 #include "soundfontmanager.h"
 
 TreeModel::TreeModel(TreeItem * rootItem) : QAbstractItemModel(),
-    _rootItem(rootItem)
+    _rootItem(rootItem),
+    _isLoading(false)
 {
 
 }
@@ -125,6 +126,9 @@ QModelIndex TreeModel::parent(const QModelIndex &index) const
 
 void TreeModel::elementBeingAdded(EltID id)
 {
+    if (_isLoading)
+        return;
+
     int position;
     QModelIndex index = getParentIndexWithPosition(id, position);
     emit(saveExpandedState());
@@ -133,12 +137,18 @@ void TreeModel::elementBeingAdded(EltID id)
 
 void TreeModel::endOfAddition()
 {
+    if (_isLoading)
+        return;
+
     emit(endInsertRows());
     emit(restoreExpandedState());
 }
 
 void TreeModel::elementUpdated(EltID id)
 {
+    if (_isLoading)
+        return;
+
     int position;
     QModelIndex index = getParentIndexWithPosition(id, position);
     index = this->index(position, 0, index);
@@ -196,6 +206,9 @@ void TreeModel::elementUpdated(EltID id)
 
 void TreeModel::elementBeingDeleted(EltID id, bool storeExpandedState)
 {
+    if (_isLoading)
+        return;
+
     int position;
     QModelIndex index = getParentIndexWithPosition(id, position);
 
@@ -206,18 +219,32 @@ void TreeModel::elementBeingDeleted(EltID id, bool storeExpandedState)
 
 void TreeModel::endOfDeletion()
 {
+    if (_isLoading)
+        return;
+
     emit(endRemoveRows());
     emit(restoreExpandedState());
 }
 
 void TreeModel::visibilityChanged(EltID id)
 {
+    if (_isLoading)
+        return;
+
     int position;
     QModelIndex indexParent = getParentIndexWithPosition(id, position);
     QModelIndex index = this->index(position, 0, indexParent);
     emit(dataChanged(index, index));
 }
 
+void TreeModel::endLoading()
+{
+    // All elements appear at once
+    _isLoading = false;
+    beginResetModel();
+    endResetModel();
+}
+
 QModelIndex TreeModel::getParentIndexWithPosition(EltID id, int &position)
 {
     // Find the corresponding parent index of an id
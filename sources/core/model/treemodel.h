@@ -54,6 +54,10 @@ public:
     void endOfDeletion();
     void visibilityChanged(EltID id);
 
+    /// Bulk loading: the changes are not notified one by one, the model is reset at the end
+    void beginLoading() { _isLoading = true; }
+    void endLoading();
+
 signals:
     void saveExpandedState();
     void restoreExpandedState();
@@ -61,6 +65,7 @@ signals:
 private:
     QModelIndex getParentIndexWithPosition(EltID id, int &position);
     TreeItem * _rootItem;
+    bool _isLoading;
 };
 
 #endif // TREEMODEL_H
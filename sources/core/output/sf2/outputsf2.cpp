@@ -23,11 +23,13 @@
 ***************************************************************************/
 
 #include "outputsf2.h"
-#include "sf2indexconverter.h"
+#include "sf2pdtabuilder.h"
+#include "sf2filewriter.h"
 #include "soundfontmanager.h"
 #include "contextmanager.h"
 #include <QFile>
 #include <QFileInfo>
+#include <QVector>
 
 OutputSf2::OutputSf2() : AbstractOutput() {}
 
@@ -47,9 +49,20 @@ void OutputSf2::processInternal(QString fileName, SoundfontManager * sm, bool &s
         }
     }
 
-    // Do we override the current file?
+    // Do we override the current file, or a file from which sample data is copied?
     EltID id(elementSf2, sf2Index);
-    if (sm->getQstr(id, champ_filenameForData) == fileName)
+    bool overrideSource = (sm->getQstr(id, champ_filenameForData) == fileName);
+    {
+        // Read only, the iterator is released before saving
+        EltID idSmpl(elementSmpl, sf2Index);
+        SiblingIterator itSmpl(sm, idSmpl);
+        while (!overrideSource && itSmpl.hasNext())
+        {
+            idSmpl.indexElt = itSmpl.next();
+            overrideSource = (sm->getQstr(idSmpl, champ_filenameForData) == fileName);
+        }
+    }
+    if (overrideSource)
     {
         // Use a temporary file
         QString filenameTmp = fileName.left(fileName.length() - 4) + "_tmp";
@@ -109,1130 +122,212 @@ void OutputSf2::processInternal(QString fileName, SoundfontManager * sm, bool &s
 
 void OutputSf2::save(QString fileName, SoundfontManager * sm, bool &success, QString &error, int sf2Index)
 {
-    EltID id(elementSf2, sf2Index, 0, 0, 0);
-
-    // Préparation de la sauvegarde
-    SfVersionTag sfVersionTmp;
-    quint32 dwTmp, dwTmp2;
-    quint16 wTmp;
-    quint8 byTmp;
-    char charTmp;
-    char tcharTmp[32];
-    AttributeValue valTmp;
+    EltID id(elementSf2, sf2Index);
+    bool is24bits = (sm->get(id, champ_wBpsSave).wValue == 24);
 
-    // Modification du logiciel d'édition
+    // Modification du logiciel d'édition et de la version
     sm->set(id, champ_ISFT, QString("Polyphone"));
+    AttributeValue valTmp;
+    valTmp.sfVerValue.wMajor = 2;
+    valTmp.sfVerValue.wMinor = 4;
+    sm->set(id, champ_IFIL, valTmp);
 
-    //////////////////// TAILLES DES BLOCS ////////////////////
-
-    quint32 taille_fichier, taille_info, taille_smpl, taille_pdta,
-            taille_phdr, taille_pbag, taille_pmod, taille_pgen,
-            taille_inst, taille_ibag, taille_imod, taille_igen,
-            taille_shdr, taille_sm24;
-    taille_info = 16; // INFO + champ ifil
-    dwTmp = sm->getQstr(id, champ_ISNG).length();
-    if (dwTmp > 255) dwTmp = 255;
-    dwTmp2 = dwTmp + 2 - (dwTmp)%2;
-    if (dwTmp != 0)
-        taille_info += dwTmp2 + 8;
-    else
-        taille_info += 8 + 8;
-    dwTmp = sm->getQstr(id, champ_name).length();
-    if (dwTmp > 255) dwTmp = 255;
-    dwTmp2 = dwTmp + 2 - (dwTmp)%2;
-    if (dwTmp != 0)
-        taille_info += dwTmp2 + 8;
-    else
-        taille_info += 10 + 8;
-    dwTmp = sm->getQstr(id, champ_IROM).length();
-    if (dwTmp > 0)
-    {
-        if (dwTmp > 255) dwTmp = 255;
-        dwTmp2 = dwTmp + 2 - (dwTmp)%2;
-        taille_info += dwTmp2 + 8;
-    }
-    sfVersionTmp = sm->get(id, champ_IVER).sfVerValue;
-    if (sfVersionTmp.wMinor != 0 || sfVersionTmp.wMajor != 0)
-        taille_info += 12;
-    dwTmp = sm->getQstr(id, champ_ICRD).length();
-    if (dwTmp > 0)
-    {
-        if (dwTmp > 255) dwTmp = 255;
-        dwTmp2 = dwTmp + 2 - (dwTmp)%2;
-        taille_info += dwTmp2 + 8;
-    }
-    dwTmp = sm->getQstr(id, champ_IENG).length();
-    if (dwTmp > 0)
-    {
-        if (dwTmp > 255) dwTmp = 255;
-        dwTmp2 = dwTmp + 2 - (dwTmp)%2;
-        taille_info += dwTmp2 + 8;
-    }
-    dwTmp = sm->getQstr(id, champ_IPRD).length();
-    if (dwTmp > 0)
-    {
-        if (dwTmp > 255) dwTmp = 255;
-        dwTmp2 = dwTmp + 2 - (dwTmp)%2;
-        taille_info += dwTmp2 + 8;
-    }
-    dwTmp = sm->getQstr(id, champ_ICOP).length();
-    if (dwTmp > 0)
-    {
-        if (dwTmp > 255) dwTmp = 255;
-        dwTmp2 = dwTmp + 2 - (dwTmp)%2;
-        taille_info += dwTmp2 + 8;
-    }
-    dwTmp = sm->getQstr(id, champ_ICMT).length();
-    if (dwTmp > 0)
-    {
-        if (dwTmp > 65536) dwTmp = 65536;
-        dwTmp2 = dwTmp + 2 - (dwTmp)%2;
-        taille_info += dwTmp2 + 8;
-    }
-    dwTmp = sm->getQstr(id, champ_ISFT).length();
-    if (dwTmp > 0)
-    {
-        if (dwTmp > 255) dwTmp = 255;
-        dwTmp2 = dwTmp + 2 - (dwTmp)%2;
-        taille_info += dwTmp2 + 8;
-    }
-
-    taille_smpl = 12;
-    EltID id2(elementSmpl, id.indexSf2);
-    foreach (int i, sm->getSiblings(id2))
-    {
-        id2.indexElt = i;
-        taille_smpl += 2 * (sm->get(id2, champ_dwLength).dwValue + 46); // 46 zeros supplémentaires
-    }
-    if (sm->get(id, champ_wBpsSave).wValue == 24)
-    {
-        // Sauvegarde 24 bits
-        char T[20];
-        sprintf(T, "%u", taille_smpl);
-        taille_sm24 = (taille_smpl - 12) / 2 + 8;
-        taille_sm24 += taille_sm24 % 2; // chiffre pair
-    }
-    else
-    {
-        // Sauvegarde 16 bits
-        taille_sm24 = 0;
-    }
-    EltID id3(elementPrst, id.indexSf2);
-    id.typeElement = elementPrst;
-    taille_phdr = 38 + sm->getSiblings(id).count() * 38;
-
-    id2.typeElement = elementPrstInst;
-    taille_pbag = 4;
-    taille_pmod = 10;
-    taille_pgen = 4;
-
-    // pour chaque preset
-    foreach (int i, sm->getSiblings(id))
-    {
-        id2.indexElt = i;
-        id3.typeElement = elementPrst;
-        id3.indexElt = i;
-
-        taille_pbag += 4; // bag global
-        id3.typeElement = elementPrstMod;
-        taille_pmod += 10 * sm->getSiblings(id3).count(); // mod globaux
-
-        id3.typeElement = elementPrstGen;
-        taille_pgen += 4 * sm->getSiblings(id3).count(); // gen globaux
-
-        // pour chaque instrument lié
-        foreach (int j, sm->getSiblings(id2))
-        {
-            id2.indexElt2 = j;
-            taille_pbag += 4; // 1 bag par instrument lié
-            id3.indexElt2 = j;
-            id3.typeElement = elementPrstInstMod;
-            taille_pmod += 10 * sm->getSiblings(id3).count(); // mod par instrument
-
-            id3.typeElement = elementPrstInstGen;
-            taille_pgen += 4 * sm->getSiblings(id3).count(); // gen par instrument
-        }
-    }
-    id.typeElement = elementInst;
-    taille_inst = 22 + sm->getSiblings(id).count() * 22;
-
-    id2.typeElement = elementInstSmpl;
-    taille_ibag = 4;
-    taille_imod = 10;
-    taille_igen = 4;
+    // Blocs INFO et pdta préparés en mémoire
+    QByteArray info = getInfo(sm, sf2Index, is24bits);
+    QByteArray pdta = Sf2PdtaBuilder(sm, sf2Index).build();
 
-    // pour chaque instrument
-    foreach (int i, sm->getSiblings(id))
+    // Taille des données, 46 zeros étant ajoutés après chaque sample
+    EltID idSmpl(elementSmpl, sf2Index);
+    QList<int> samples = sm->getSiblings(idSmpl);
+    QVector<quint32> lengths(samples.count());
+    quint32 taille_smpl = 0;
+    for (int i = 0; i < samples.count(); i++)
     {
-        id2.indexElt = i;
-        id3.typeElement = elementInst;
-        id3.indexElt = i;
-        taille_ibag += 4; // bag global
-        id3.typeElement = elementInstMod;
-        taille_imod += 10 * sm->getSiblings(id3).count(); // mod globaux
-
-        id3.typeElement = elementInstGen;
-        taille_igen += 4 * sm->getSiblings(id3).count(); // gen globaux
-        // pour chaque sample lié
-        foreach (int j, sm->getSiblings(id2))
-        {
-            id2.indexElt2 = j;
-            taille_ibag += 4; // 1 bag par sample lié
-            id3.indexElt2 = j;
-            id3.typeElement = elementInstSmplMod;
-            taille_imod += 10 * sm->getSiblings(id3).count(); // mod par instrument
-
-            id3.typeElement = elementInstSmplGen;
-            taille_igen += 4 * sm->getSiblings(id3).count(); // gen par instrument
-        }
+        idSmpl.indexElt = samples[i];
+        lengths[i] = sm->get(idSmpl, champ_dwLength).dwValue;
+        taille_smpl += 2 * (lengths[i] + 46);
     }
-    id.typeElement = elementSmpl;
-    taille_shdr = 46 + sm->getSiblings(id).count() * 46;
-
-    taille_pdta = taille_phdr + taille_pbag + taille_pmod + taille_pgen +
-            taille_inst + taille_ibag + taille_imod + taille_igen +
-            taille_shdr + 19*4;
-
-    taille_fichier = taille_info + taille_smpl + taille_sm24 + taille_pdta + 7*4;
-
-    // Préparation de la sauvegarde
-    id.typeElement = elementSmpl;
-    sfVersionTmp.wMajor = 2;
-    sfVersionTmp.wMinor = 4;
-    valTmp.sfVerValue = sfVersionTmp;
-
-    // Mise à jour de la version
-    id.typeElement = elementSf2;
-    sm->set(id, champ_IFIL, valTmp);
+    quint32 taille_sm24 = is24bits ? taille_smpl / 2 : 0;
+    quint32 taille_sdta = 4 + 8 + taille_smpl + (is24bits ? 8 + taille_sm24 + taille_sm24 % 2 : 0);
+    quint32 taille_fichier = 4 + 8 + info.size() + 8 + taille_sdta + 8 + pdta.size();
 
     // Sauvegarde sous le nom fileName
-    QFile fi(fileName);
-    if (!fi.open(QIODevice::WriteOnly))
+    Sf2FileWriter writer(fileName);
+    if (!writer.open())
     {
         success = false;
         error = tr("Cannot create file \"%1\"").arg(fileName);
         return;
     }
 
-    // entête
-    fi.write("RIFF", 4);
-
-    // taille du fichier -8 octets
-    fi.write((char *)&taille_fichier, 4);
-    fi.write("sfbk", 4);
-
-    /////////////////////////////////////// BLOC INFO ///////////////////////////////////////
-    fi.write("LIST", 4);
-    fi.write((char *)&taille_info, 4);
-    fi.write("INFO", 4);
-
-    fi.write("ifil", 4); // version, champ obligatoire
-    dwTmp = 4; fi.write((char *)&dwTmp, 4);
-    id.typeElement = elementSf2;
-
-    if (sm->get(id, champ_wBpsSave).wValue == 24)
-    {
-        sfVersionTmp.wMajor = 2;
-        sfVersionTmp.wMinor = 4;
-    }
-    else
-    {
-        sfVersionTmp.wMajor = 2;
-        sfVersionTmp.wMinor = 1;
-    }
-    fi.write((char *)&sfVersionTmp, 4);
-
-    fi.write("isng", 4); // wavetable sound engine, champ obligatoire
-    dwTmp = sm->getQstr(id, champ_ISNG).length();
-    if (dwTmp > 255) dwTmp = 255;
-    dwTmp2 = dwTmp + 2 - (dwTmp)%2;
-    if (dwTmp != 0)
-    {
-        fi.write((char *)&dwTmp2, 4);
-        fi.write(sm->getQstr(id, champ_ISNG).toLatin1());
-        charTmp = '\0';
-        for (quint32 i = 0; i < dwTmp2-dwTmp; i++)
-            fi.write(&charTmp, 1);
-    }
-    else
-    {
-        dwTmp2 = 8;
-        fi.write((char *)&dwTmp2, 4);
-        fi.write("Generic", 7);
-        charTmp = '\0';
-        fi.write(&charTmp, 1);
-    }
-    fi.write("INAM", 4); // nom du sf2, champ obligatoire
-    dwTmp = sm->getQstr(id, champ_name).length();
-    if (dwTmp > 255) dwTmp = 255;
-    dwTmp2 = dwTmp + 2 - (dwTmp)%2;
-    if (dwTmp != 0)
-    {
-        fi.write((char *)&dwTmp2, 4);
-        fi.write(sm->getQstr(id, champ_name).toLatin1());
-        charTmp = '\0';
-        for (quint32 i = 0; i < dwTmp2-dwTmp; i++)
-            fi.write(&charTmp, 1);
-    }
-    else
-    {
-        dwTmp2 = 10;
-        fi.write((char *)&dwTmp2, 4);
-        fi.write("no title", 8);
-        charTmp = '\0';
-        fi.write(&charTmp, 1);
-        fi.write(&charTmp, 1);
-    }
-
-    dwTmp = sm->getQstr(id, champ_IROM).length(); // identification d'une table d'onde, champ optionnel
-    if (dwTmp > 0)
-    {
-        if (dwTmp > 255) dwTmp = 255;
-        dwTmp2 = dwTmp + 2 - (dwTmp)%2;
-        fi.write("irom", 4);
-        fi.write((char *)&dwTmp2, 4);
-        fi.write(sm->getQstr(id, champ_IROM).toLatin1());
-        charTmp = '\0';
-        for (quint32 i = 0; i < dwTmp2-dwTmp; i++)
-            fi.write(&charTmp, 1);
-    }
-
-    sfVersionTmp = sm->get(id, champ_IVER).sfVerValue; // révision de la table d'onde, champ optionnel
-    if (sfVersionTmp.wMinor != 0 || sfVersionTmp.wMajor != 0)
-    {
-        fi.write("iver", 4);
-        dwTmp = 4;
-        fi.write((char *)&dwTmp, 4);
-        fi.write((char *)&sfVersionTmp, 4);
-    }
-
-    dwTmp = sm->getQstr(id, champ_ICRD).length(); // date de création du sf2, champ optionnel
-    if (dwTmp > 0)
-    {
-        if (dwTmp > 255) dwTmp = 255;
-        dwTmp2 = dwTmp + 2 - (dwTmp)%2;
-        fi.write("ICRD", 4);
-        fi.write((char *)&dwTmp2, 4);
-        fi.write(sm->getQstr(id, champ_ICRD).toLatin1());
-        charTmp = '\0';
-        for (quint32 i = 0; i < dwTmp2-dwTmp; i++)
-            fi.write(&charTmp, 1);
-    }
-
-    dwTmp = sm->getQstr(id, champ_IENG).length(); // responsable de la création du sf2, champ optionnel
-    if (dwTmp > 0)
-    {
-        if (dwTmp > 255) dwTmp = 255;
-        dwTmp2 = dwTmp + 2 - (dwTmp)%2;
-        fi.write("IENG", 4);
-        fi.write((char *)&dwTmp2, 4);
-        fi.write(sm->getQstr(id, champ_IENG).toLatin1());
-        charTmp = '\0';
-        for (quint32 i = 0; i < dwTmp2-dwTmp; i++)
-            fi.write(&charTmp, 1);
-    }
-
-    dwTmp = sm->getQstr(id, champ_IPRD).length(); // produit de destination, champ optionnel
-    if (dwTmp > 0)
-    {
-        if (dwTmp > 255) dwTmp = 255;
-        dwTmp2 = dwTmp + 2 - (dwTmp)%2;
-        fi.write("IPRD", 4);
-        fi.write((char *)&dwTmp2, 4);
-        fi.write(sm->getQstr(id, champ_IPRD).toLatin1());
-        charTmp = '\0';
-        for (quint32 i = 0; i < dwTmp2-dwTmp; i++)
-            fi.write(&charTmp, 1);
-    }
-
-    dwTmp = sm->getQstr(id, champ_ICOP).length(); // copyright, champ optionnel
-    if (dwTmp > 0)
-    {
-        if (dwTmp > 255) dwTmp = 255;
-        dwTmp2 = dwTmp + 2 - (dwTmp)%2;
-        fi.write("ICOP", 4);
-        fi.write((char *)&dwTmp2, 4);
-        fi.write(sm->getQstr(id, champ_ICOP).toLatin1());
-        charTmp = '\0';
-        for (quint32 i = 0; i < dwTmp2-dwTmp; i++)
-            fi.write(&charTmp, 1);
-    }
-
-    dwTmp = sm->getQstr(id, champ_ICMT).length(); // commentaires, champ optionnel
-    if (dwTmp > 0)
-    {
-        if (dwTmp > 65536) dwTmp = 65536;
-        dwTmp2 = dwTmp + 2 - (dwTmp)%2;
-        fi.write("ICMT", 4);
-        fi.write((char *)&dwTmp2, 4);
-        fi.write(sm->getQstr(id, champ_ICMT).toLatin1());
-        charTmp = '\0';
-        for (quint32 i = 0; i < dwTmp2-dwTmp; i++)
-            fi.write(&charTmp, 1);
-    }
-
-    dwTmp = sm->getQstr(id, champ_ISFT).length(); // outil d'édition sf2, champ optionnel
-    if (dwTmp > 0)
-    {
-        if (dwTmp > 255) dwTmp = 255;
-        dwTmp2 = dwTmp + 2 - (dwTmp)%2;
-        fi.write("ISFT", 4);
-        fi.write((char *)&dwTmp2, 4);
-        fi.write(sm->getQstr(id, champ_ISFT).toLatin1());
-        charTmp = '\0';
-        for (quint32 i = 0; i < dwTmp2-dwTmp; i++)
-            fi.write(&charTmp, 1);
-    }
+    // Entête et bloc INFO
+    QByteArray header("RIFF");
+    Sf2PdtaBuilder::appendDWord(header, taille_fichier);
+    header.append("sfbk", 4);
+    Sf2PdtaBuilder::appendChunk(header, "LIST", info);
+    writer.write(header);
 
     /////////////////////////////////////// BLOC SDTA ///////////////////////////////////////
 
-    fi.write("LIST", 4);
-    dwTmp = taille_smpl + taille_sm24;
-    fi.write((char *)&dwTmp, 4);
-    fi.write("sdta", 4);
-    fi.write("smpl", 4);
-    taille_smpl -= 12;
-    fi.write((char *)&taille_smpl, 4);
-    id2.typeElement = elementSmpl;
-    dwTmp2 = 10 * 4 + taille_info;
-    QByteArray baData;
-    foreach (int i, sm->getSiblings(id2))
-    {
-        // Copy each sample
-        id2.indexElt = i;
-        dwTmp = 2 * sm->get(id2, champ_dwLength).dwValue;
-        baData = sm->getData(id2, champ_sampleData16);
-        fi.write(baData.data(), dwTmp);
+    header.clear();
+    header.append("LIST", 4);
+    Sf2PdtaBuilder::appendDWord(header, taille_sdta);
+    header.append("sdta", 4);
+    header.append("smpl", 4);
+    Sf2PdtaBuilder::appendDWord(header, taille_smpl);
+    writer.write(header);
 
-        // Add 46 null sample points
-        charTmp = '\0';
-        for (int i = 0; i < 46 * 2; i++)
-            fi.write(&charTmp, 1);
-        dwTmp += 92;
-
-        // Mise à jour des champs fileName, dwStart
-        if (sm->get(id2, champ_dwStart16).dwValue != dwTmp2)
-        {
-            valTmp.dwValue = dwTmp2;
-            sm->set(id2, champ_dwStart16, valTmp);
-        }
-        sm->set(id2, champ_filenameForData, fileName);
-        dwTmp2 += dwTmp;
+    // Each sample is copied from its source file if not edited, then followed by 46 null sample points
+    // The new positions are only stored once the file is complete
+    QVector<quint32> starts16(samples.count()), starts24(samples.count());
+    quint32 position = 40 + info.size();
+    for (int i = 0; i < samples.count(); i++)
+    {
+        idSmpl.indexElt = samples[i];
+        writeSampleData(writer, sm, idSmpl, false, 2 * lengths[i]);
+        writer.writeZeros(92);
+        starts16[i] = position;
+        position += 2 * lengths[i] + 92;
     }
 
     // 24 bits
-    id.typeElement = elementSf2;
-    if (sm->get(id, champ_wBpsSave).wValue == 24)
+    if (is24bits)
     {
-        // Ajout données 24 bits
-        fi.write("sm24", 4);
-        taille_sm24 -= 8;
-        fi.write((char *)&taille_sm24, 4);
-        dwTmp2 = 12*4 + taille_info + taille_smpl;
-        foreach (int i, sm->getSiblings(id2))
-        {
-            // copie de chaque sample
-            id2.indexElt = i;
-            dwTmp = sm->get(id2, champ_dwLength).dwValue;
-            baData = sm->getData(id2, champ_sampleData24);
-            fi.write(baData.data(), dwTmp);
-            // ajout de 46 zeros
-            charTmp = '\0';
-            for (quint32 i = 0; i < 46; i++)
-                fi.write(&charTmp, 1);
-            dwTmp += 46;
-            // Mise à jour du champ dwStart24
-            if (sm->get(id2, champ_dwStart24).dwValue != dwTmp2)
-            {
-                valTmp.dwValue = dwTmp2;
-                sm->set(id2, champ_dwStart24, valTmp);
-            }
-            dwTmp2 += dwTmp;
-        }
+        header.clear();
+        header.append("sm24", 4);
+        Sf2PdtaBuilder::appendDWord(header, taille_sm24 + taille_sm24 % 2);
+        writer.write(header);
 
-        // 0 de fin
-        if (dwTmp2 % 2)
+        position += 8;
+        for (int i = 0; i < samples.count(); i++)
         {
-            charTmp = '\0';
-            fi.write(&charTmp, sizeof(char));
+            idSmpl.indexElt = samples[i];
+            writeSampleData(writer, sm, idSmpl, true, lengths[i]);
+            writer.writeZeros(46);
+            starts24[i] = position;
+            position += lengths[i] + 46;
         }
-    }
 
-    // Mise à jour wBpsFile
-    if (sm->get(id, champ_wBpsSave).wValue == 24)
-    {
-        foreach (int i, sm->getSiblings(id2))
-        {
-            id2.indexElt = i;
-            if (sm->get(id2, champ_bpsFile).wValue != 24)
-            {
-                valTmp.wValue = 24;
-                sm->set(id2, champ_bpsFile, valTmp);
-            }
-        }
-    }
-    else
-    {
-        foreach (int i, sm->getSiblings(id2))
-        {
-            id2.indexElt = i;
-            if (sm->get(id2, champ_bpsFile).wValue != 16)
-            {
-                valTmp.wValue = 16;
-                sm->set(id2, champ_bpsFile, valTmp);
-            }
-        }
+        // 0 de fin
+        if (taille_sm24 % 2)
+            writer.writeZeros(1);
     }
 
     /////////////////////////////////////// BLOC PDTA ///////////////////////////////////////
 
-    int nBag, nMod, nGen;
-    fi.write("LIST", 4);
-    fi.write((char *)&taille_pdta, 4);
-    fi.write("pdta", 4);
-    fi.write("phdr", 4);
-    fi.write((char *)&taille_phdr, 4);
-
-    // un bloc phdr par preset
-    id.typeElement = elementPrst;
-    id2.typeElement = elementPrstInst;
-    nBag = 0;
-    foreach (int i, sm->getSiblings(id))
-    {
-        id.indexElt = i;
-        id2.indexElt = i;
-        // Name
-        dwTmp = sm->getQstr(id, champ_name).length();
-        if (dwTmp > 20) dwTmp = 20;
-        if (dwTmp != 0)
-        {
-            fi.write(sm->getQstr(id, champ_name).toLatin1());
-            charTmp = '\0';
-            for (quint32 i = 0; i < 20-dwTmp; i++)
-                fi.write(&charTmp, 1);
-        }
-        else
-        {
-            dwTmp = sprintf(tcharTmp, "preset %d", i+1);
-            fi.write(tcharTmp, dwTmp);
-            charTmp = '\0';
-            for (quint32 i = 0; i < 20-dwTmp; i++)
-                fi.write(&charTmp, 1);
-        }
-        // wPreset
-        wTmp = sm->get(id, champ_wPreset).wValue;
-        fi.write((char *)&wTmp, 2);
-        // wBank
-        wTmp = sm->get(id, champ_wBank).wValue;
-        fi.write((char *)&wTmp, 2);
-        // wPresetBagNdx
-        wTmp = nBag;
-        fi.write((char *)&wTmp, 2);
-        nBag++; // bag global
-        nBag += sm->getSiblings(id2).count();
-
-        // dwLibrary
-        dwTmp = sm->get(id, champ_dwLibrary).dwValue;
-        fi.write((char *)&wTmp, 4);
-        // dwGenre
-        dwTmp = sm->get(id, champ_dwGenre).dwValue;
-        fi.write((char *)&wTmp, 4);
-        // dwMorphology
-        dwTmp = sm->get(id, champ_dwMorphology).dwValue;
-        fi.write((char *)&wTmp, 4);
-    }
-    // phdr de fin (38 byte)
-    fi.write("EOP", 3);
-    charTmp = '\0';
-    for (quint32 i = 0; i < 21; i++)
-        fi.write(&charTmp, 1);
-    // index bag de fin
-    wTmp = nBag;
-    fi.write((char *)&wTmp, 2);
-    for (quint32 i = 0; i < 12; i++)
-        fi.write(&charTmp, 1);
-
-    fi.write("pbag", 4);
-    fi.write((char*)&taille_pbag, 4);
-    id.typeElement = elementPrst;
-    id2.typeElement = elementPrstInst;
-    nGen = 0;
-    nMod = 0;
-
-    // pour chaque preset
-    foreach (int i, sm->getSiblings(id))
-    {
-        id.indexElt = i;
-        id2.indexElt = i;
-        id3.indexElt = i;
-
-        // bag global
-        wTmp = nGen;
-        fi.write((char *)&wTmp, 2);
-        id2.typeElement = elementPrstGen;
-        nGen += sm->getSiblings(id2).count();
-        wTmp = nMod;
-        fi.write((char *)&wTmp, 2);
-        id2.typeElement = elementPrstMod;
-        nMod += sm->getSiblings(id2).count();
-
-        // un bag par instrument lié
-        id2.typeElement = elementPrstInst;
-        foreach (int j, sm->getSiblings(id2))
-        {
-            id2.indexElt2 = j;
-            wTmp = nGen;
-            fi.write((char *)&wTmp, 2);
-            id3.typeElement = elementPrstInstGen;
-            id3.indexElt2 = j;
-            nGen += sm->getSiblings(id3).count();
-            wTmp = nMod;
-            fi.write((char *)&wTmp, 2);
-            id3.typeElement = elementPrstInstMod;
-            nMod += sm->getSiblings(id3).count();
-        }
-    }
-
-    // bag de fin
-    wTmp = nGen;
-    fi.write((char *)&wTmp, 2);
-    wTmp = nMod;
-    fi.write((char *)&wTmp, 2);
-
-    fi.write("pmod", 4);
-    fi.write((char *)&taille_pmod, 4);
-    id.typeElement = elementPrst;
-    id2.typeElement = elementPrstInst;
-    SFModulator sfTmp;
-
-    // pour chaque preset
-    foreach (int i, sm->getSiblings(id))
-    {
-        id.indexElt = i;
-        id2.indexElt = i;
-        id3.indexElt = i;
-
-        // mods du bag global
-        id3.typeElement = elementPrstMod;
-        Sf2IndexConverter converterMod(id3);
-        foreach (int k, sm->getSiblings(id3))
-        {
-            id3.indexMod = k;
-
-            // écriture
-            sfTmp = sm->get(id3, champ_sfModSrcOper).sfModValue;
-            byTmp = sfTmp.Index + sfTmp.CC * 128;
-            fi.write((char *)&byTmp, 1);
-            byTmp = sfTmp.isDescending + 2 * sfTmp.isBipolar + 4 * sfTmp.Type;
-            fi.write((char *)&byTmp, 1);
-            wTmp = converterMod.getIndexOf(sm->get(id3, champ_sfModDestOper).wValue, true);
-            fi.write((char *)&wTmp, 2);
-            wTmp = sm->get(id3, champ_modAmount).wValue;
-            fi.write((char *)&wTmp, 2);
-            sfTmp = sm->get(id3, champ_sfModAmtSrcOper).sfModValue;
-            byTmp = sfTmp.Index + sfTmp.CC * 128;
-            fi.write((char *)&byTmp, 1);
-            byTmp = sfTmp.isDescending + 2 * sfTmp.isBipolar + 4 * sfTmp.Type;
-            fi.write((char *)&byTmp, 1);
-            wTmp = sm->get(id3, champ_sfModTransOper).wValue == 2 ? absolute_value : linear;
-            fi.write((char *)&wTmp, 2);
-        }
-
-        // pour chaque instrument associé
-        foreach (int j, sm->getSiblings(id2))
-        {
-            id2.indexElt2 = j;
-            id3.indexElt2 = j;
-            id3.typeElement = elementPrstInstMod;
-            Sf2IndexConverter converterMod2(id3);
-
-            // mods associés aux instruments
-            foreach (int k, sm->getSiblings(id3))
-            {
-                id3.indexMod = k;
+    header.clear();
+    Sf2PdtaBuilder::appendChunk(header, "LIST", pdta);
+    writer.write(header);
 
-                // écriture
-                sfTmp = sm->get(id3, champ_sfModSrcOper).sfModValue;
-                byTmp = sfTmp.Index + sfTmp.CC * 128;
-                fi.write((char *)&byTmp, 1);
-                byTmp = sfTmp.isDescending + 2 * sfTmp.isBipolar + 4 * sfTmp.Type;
-                fi.write((char *)&byTmp, 1);
-                wTmp = converterMod2.getIndexOf(sm->get(id3, champ_sfModDestOper).wValue, true);
-                fi.write((char *)&wTmp, 2);
-                wTmp = sm->get(id3, champ_modAmount).wValue;
-                fi.write((char *)&wTmp, 2);
-                sfTmp = sm->get(id3, champ_sfModAmtSrcOper).sfModValue;
-                byTmp = sfTmp.Index + sfTmp.CC * 128;
-                fi.write((char *)&byTmp, 1);
-                byTmp = sfTmp.isDescending + 2 * sfTmp.isBipolar + 4 * sfTmp.Type;
-                fi.write((char *)&byTmp, 1);
-                wTmp = sm->get(id3, champ_sfModTransOper).wValue == 2 ? absolute_value : linear;
-                fi.write((char *)&wTmp, 2);
-            }
-        }
-    }
-
-    // mod de fin
-    charTmp = '\0';
-    for (quint32 i = 0; i < 10; i++)
-        fi.write(&charTmp, 1);
-
-    AttributeValue genTmp;
-    fi.write("pgen", 4);
-    fi.write((char *)&taille_pgen, 4);
-    id.typeElement = elementPrst;
-    id2.typeElement = elementPrstInst;
-    Sf2IndexConverter converterInst(EltID(elementInst, id.indexSf2));
-
-    // pour chaque preset
-    foreach (int i , sm->getSiblings(id))
+    // Fermeture du fichier
+    if (!writer.close())
     {
-        id.indexElt = i;
-        id2.indexElt = i;
-        id3.indexElt = i;
-        id3.typeElement = elementPrstGen;
-
-        // gens du bag global
-        // - 1er gen : keyrange si présent
-        // - 2ème gen : velocity si présent
-        if (sm->isSet(id, champ_keyRange))
-        {
-            wTmp = champ_keyRange;
-            fi.write((char *)&wTmp, 2);
-            genTmp = sm->get(id, champ_keyRange);
-            if (genTmp.rValue.byLo > 127)
-                genTmp.rValue.byLo = 127;
-            if (genTmp.rValue.byHi > 127)
-                genTmp.rValue.byHi = 127;
-            fi.write((char *)&genTmp, 2);
-        }
-        if (sm->isSet(id, champ_velRange))
-        {
-            wTmp = champ_velRange;
-            fi.write((char *)&wTmp, 2);
-            genTmp = sm->get(id, champ_velRange);
-            if (genTmp.rValue.byLo > 127)
-                genTmp.rValue.byLo = 127;
-            if (genTmp.rValue.byHi > 127)
-                genTmp.rValue.byHi = 127;
-            fi.write((char *)&genTmp, 2);
-        }
-        foreach (int k, sm->getSiblings(id3))
-        {
-            if (k != champ_keyRange && k != champ_velRange && k != champ_instrument)
-            {
-                wTmp = k;
-                fi.write((char *)&wTmp, 2);
-                genTmp = sm->get(id, (AttributeType)k);
-                fi.write((char *)&genTmp, 2);
-            }
-        }
-        id3.typeElement = elementPrstInstGen;
-
-        // pour chaque instrument associé
-        foreach (int j, sm->getSiblings(id2))
-        {
-            id2.indexElt2 = j;
-            id3.indexElt2 = j;
-
-            // gens associés aux instruments
-            // - 1er gen : keyrange si présent
-            // - 2ème gen : velocity si présent
-            // - dernier gen : sample_ID
-            if (sm->isSet(id2, champ_keyRange))
-            {
-                wTmp = champ_keyRange;
-                fi.write((char *)&wTmp, 2);
-                genTmp = sm->get(id2, champ_keyRange);
-                if (genTmp.rValue.byLo > 127)
-                    genTmp.rValue.byLo = 127;
-                if (genTmp.rValue.byHi > 127)
-                    genTmp.rValue.byHi = 127;
-                fi.write((char *)&genTmp, 2);
-            }
-            if (sm->isSet(id2, champ_velRange))
-            {
-                wTmp = champ_velRange;
-                fi.write((char *)&wTmp, 2);
-                genTmp = sm->get(id2, champ_velRange);
-                if (genTmp.rValue.byLo > 127)
-                    genTmp.rValue.byLo = 127;
-                if (genTmp.rValue.byHi > 127)
-                    genTmp.rValue.byHi = 127;
-                fi.write((char *)&genTmp, 2);
-            }
-            foreach (int k, sm->getSiblings(id3))
-            {
-                if (k != champ_keyRange && k != champ_velRange && k != champ_instrument)
-                {
-                    wTmp = k;
-                    fi.write((char *)&wTmp, 2);
-                    genTmp = sm->get(id2, (AttributeType)k);
-                    fi.write((char *)&genTmp, 2);
-                }
-            }
-            wTmp = champ_instrument;
-            fi.write((char *)&wTmp, 2);
-            genTmp.wValue = converterInst.getIndexOf(sm->get(id2, champ_instrument).wValue, false);
-            fi.write((char *)&genTmp, 2);
-        }
+        success = false;
+        error = tr("Cannot write file \"%1\"").arg(fileName);
+        return;
     }
 
-    // gen de fin
-    charTmp = '\0';
-    for (quint32 i = 0; i < 4; i++)
-        fi.write(&charTmp, 1);
-
-    fi.write("inst", 4);
-    fi.write((char *)&taille_inst, 4);
-
-    // un bloc inst par instrument
-    id.typeElement = elementInst;
-    id2.typeElement = elementInstSmpl;
-    nBag = 0;
-    foreach (int i, sm->getSiblings(id))
+    // Mise à jour des champs dwStart et wBpsFile
+    for (int i = 0; i < samples.count(); i++)
     {
-        id.indexElt = i;
-        id2.indexElt = i;
-
-        // Name
-        dwTmp = sm->getQstr(id, champ_name).length();
-        if (dwTmp > 20) dwTmp = 20;
-        if (dwTmp != 0)
+        idSmpl.indexElt = samples[i];
+        if (sm->get(idSmpl, champ_dwStart16).dwValue != starts16[i])
         {
-            fi.write(sm->getQstr(id, champ_name).toLatin1());
-            charTmp = '\0';
-            for (quint32 iteration = 0; iteration < 20-dwTmp; iteration++)
-                fi.write(&charTmp, 1);
+            valTmp.dwValue = starts16[i];
+            sm->set(idSmpl, champ_dwStart16, valTmp);
         }
-        else
+        if (is24bits && sm->get(idSmpl, champ_dwStart24).dwValue != starts24[i])
         {
-            dwTmp = sprintf(tcharTmp, "instrument %d", i+1);
-            fi.write(tcharTmp, dwTmp);
-            charTmp = '\0';
-            for (quint32 iteration = 0; iteration < 20-dwTmp; iteration++)
-                fi.write(&charTmp, 1);
+            valTmp.dwValue = starts24[i];
+            sm->set(idSmpl, champ_dwStart24, valTmp);
         }
-
-        // wInstBagNdx
-        wTmp = nBag;
-        fi.write((char *)&wTmp, 2);
-        nBag++; // bag global
-        nBag += sm->getSiblings(id2).count(); // un bag par sample lié
-    }
-
-    // inst de fin
-    fi.write("EOI", 3);
-    charTmp = '\0';
-    for (quint32 iteration = 0; iteration < 17; iteration++)
-        fi.write(&charTmp, 1);
-
-    // index bag de fin
-    wTmp = nBag;
-    fi.write((char *)&wTmp, 2);
-
-    fi.write("ibag", 4);
-    fi.write((char *)&taille_ibag, 4);
-    id.typeElement = elementInst;
-    id2.typeElement = elementInstSmpl;
-    nGen = 0;
-    nMod = 0;
-
-    // pour chaque instrument
-    foreach (int i, sm->getSiblings(id))
-    {
-        id.indexElt = i;
-        id2.indexElt = i;
-        id3.indexElt = i;
-
-        // bag global
-        wTmp = nGen;
-        fi.write((char *)&wTmp, 2);
-        id2.typeElement = elementInstGen;
-        nGen += sm->getSiblings(id2).count();
-        wTmp = nMod;
-        fi.write((char *)&wTmp, 2);
-        id2.typeElement = elementInstMod;
-        nMod += sm->getSiblings(id2).count();
-
-        // un bag par instrument lié
-        id2.typeElement = elementInstSmpl;
-        foreach (int j, sm->getSiblings(id2))
+        if (sm->get(idSmpl, champ_bpsFile).wValue != (is24bits ? 24 : 16))
         {
-            id2.indexElt2 = j;
-            wTmp = nGen;
-            fi.write((char *)&wTmp, 2);
-            id3.typeElement = elementInstSmplGen;
-            id3.indexElt2 = j;
-            nGen += sm->getSiblings(id3).count();
-            wTmp = nMod;
-            fi.write((char *)&wTmp, 2);
-            id3.typeElement = elementInstSmplMod;
-            nMod += sm->getSiblings(id3).count();
+            valTmp.wValue = is24bits ? 24 : 16;
+            sm->set(idSmpl, champ_bpsFile, valTmp);
         }
     }
 
-    // bag de fin
-    wTmp = nGen;
-    fi.write((char *)&wTmp, 2);
-    wTmp = nMod;
-    fi.write((char *)&wTmp, 2);
-
-    fi.write("imod", 4);
-    fi.write((char *)&taille_imod, 4);
-    id.typeElement = elementInst;
-    id2.typeElement = elementInstSmpl;
-
-    // pour chaque instrument
-    foreach (int i, sm->getSiblings(id))
+    // The data is now read from the new file, once all positions are updated
+    // (data not edited is viewed in the file and would be read at the new positions in the previous file)
+    foreach (int i, samples)
     {
-        id.indexElt = i;
-        id2.indexElt = i;
-        id3.indexElt = i;
-
-        // mods du bag global
-        id3.typeElement = elementInstMod;
-        Sf2IndexConverter converterMod(id3);
-        foreach (int k, sm->getSiblings(id3))
-        {
-            id3.indexMod = k;
-
-            // écriture
-            sfTmp = sm->get(id3, champ_sfModSrcOper).sfModValue;
-            byTmp = sfTmp.Index + sfTmp.CC * 128;
-            fi.write((char *)&byTmp, 1);
-            byTmp = sfTmp.isDescending + 2 * sfTmp.isBipolar + 4 * sfTmp.Type;
-            fi.write((char *)&byTmp, 1);
-            wTmp = converterMod.getIndexOf(sm->get(id3, champ_sfModDestOper).wValue, true);
-            fi.write((char *)&wTmp, 2);
-            wTmp = sm->get(id3, champ_modAmount).wValue;
-            fi.write((char *)&wTmp, 2);
-            sfTmp = sm->get(id3, champ_sfModAmtSrcOper).sfModValue;
-            byTmp = sfTmp.Index + sfTmp.CC * 128;
-            fi.write((char *)&byTmp, 1);
-            byTmp = sfTmp.isDescending + 2 * sfTmp.isBipolar + 4 * sfTmp.Type;
-            fi.write((char *)&byTmp, 1);
-            wTmp = sm->get(id3, champ_sfModTransOper).wValue == 2 ? absolute_value : linear;
-            fi.write((char *)&wTmp, 2);
-        }
-
-        // pour chaque sample associé
-        foreach (int j, sm->getSiblings(id2))
-        {
-            id2.indexElt2 = j;
-            id3.indexElt2 = j;
-            id3.typeElement = elementInstSmplMod;
-            Sf2IndexConverter converterMod2(id3);
-
-            // mods associés aux samples
-            foreach (int k, sm->getSiblings(id3))
-            {
-                id3.indexMod = k;
-
-                // écriture
-                sfTmp = sm->get(id3, champ_sfModSrcOper).sfModValue;
-                byTmp = sfTmp.Index + sfTmp.CC * 128;
-                fi.write((char *)&byTmp, 1);
-                byTmp = sfTmp.isDescending + 2 * sfTmp.isBipolar + 4 * sfTmp.Type;
-                fi.write((char *)&byTmp, 1);
-                wTmp = converterMod2.getIndexOf(sm->get(id3, champ_sfModDestOper).wValue, true);
-                fi.write((char *)&wTmp, 2);
-                wTmp = sm->get(id3, champ_modAmount).wValue;
-                fi.write((char *)&wTmp, 2);
-                sfTmp = sm->get(id3, champ_sfModAmtSrcOper).sfModValue;
-                byTmp = sfTmp.Index + sfTmp.CC * 128;
-                fi.write((char *)&byTmp, 1);
-                byTmp = sfTmp.isDescending + 2 * sfTmp.isBipolar + 4 * sfTmp.Type;
-                fi.write((char *)&byTmp, 1);
-                wTmp = sm->get(id3, champ_sfModTransOper).wValue == 2 ? absolute_value : linear;
-                fi.write((char *)&wTmp, 2);
-            }
-        }
+        idSmpl.indexElt = i;
+        sm->set(idSmpl, champ_filenameForData, fileName);
     }
 
-    // mod de fin
-    charTmp = '\0';
-    for (quint32 iteration = 0; iteration < 10; iteration++)
-        fi.write(&charTmp, 1);
-
-    fi.write("igen", 4);
-    fi.write((char *)&taille_igen, 4);
-    id.typeElement = elementInst;
-    id2.typeElement = elementInstSmpl;
-    Sf2IndexConverter converterSmpl(EltID(elementSmpl, id.indexSf2));
-
-    // pour chaque instrument
-    foreach (int i, sm->getSiblings(id))
-    {
-        id.indexElt = i;
-        id2.indexElt = i;
-        id3.indexElt = i;
-        id3.typeElement = elementInstGen;
-
-        // gens du bag global
-        // - 1er gen : keyrange si présent
-        // - 2ème gen : velocity si présent
-        if (sm->isSet(id, champ_keyRange))
-        {
-            wTmp = champ_keyRange;
-            fi.write((char *)&wTmp, 2);
-            genTmp = sm->get(id, champ_keyRange);
-            if (genTmp.rValue.byLo > 127)
-                genTmp.rValue.byLo = 127;
-            if (genTmp.rValue.byHi > 127)
-                genTmp.rValue.byHi = 127;
-            fi.write((char *)&genTmp, 2);
-        }
-        if (sm->isSet(id, champ_velRange))
-        {
-            wTmp = champ_velRange;
-            fi.write((char *)&wTmp, 2);
-            genTmp = sm->get(id, champ_velRange);
-            if (genTmp.rValue.byLo > 127)
-                genTmp.rValue.byLo = 127;
-            if (genTmp.rValue.byHi > 127)
-                genTmp.rValue.byHi = 127;
-            fi.write((char *)&genTmp, 2);
-        }
-        foreach (int k, sm->getSiblings(id3))
-        {
-            if (k != champ_keyRange && k != champ_velRange && k != champ_sampleID)
-            {
-                wTmp = k;
-                fi.write((char *)&wTmp, 2);
-                genTmp = sm->get(id, (AttributeType)k);
-                fi.write((char *)&genTmp, 2);
-            }
-        }
-        id3.typeElement = elementInstSmplGen;
+    // Sauvegarde de fileName, wBpsInit
+    sm->set(id, champ_filenameInitial, fileName);
+    sm->set(id, champ_filenameForData, fileName);
+    sm->set(id, champ_wBpsInit, sm->get(id, champ_wBpsSave));
 
-        // pour chaque sample associé
-        foreach (int j, sm->getSiblings(id2))
-        {
-            id2.indexElt2 = j;
-            id3.indexElt2 = j;
+    success = true;
+    error = "";
+}
 
-            // gens associés aux samples
-            // - 1er gen : keyrange si présent
-            // - 2ème gen : velocity si présent
-            // - dernier gen : sample_ID
-            if (sm->isSet(id2, champ_keyRange))
-            {
-                wTmp = champ_keyRange;
-                fi.write((char *)&wTmp, 2);
-                genTmp = sm->get(id2, champ_keyRange);
-                if (genTmp.rValue.byLo > 127)
-                    genTmp.rValue.byLo = 127;
-                if (genTmp.rValue.byHi > 127)
-                    genTmp.rValue.byHi = 127;
-                fi.write((char *)&genTmp, 2);
-            }
-            if (sm->isSet(id2, champ_velRange))
-            {
-                wTmp = champ_velRange;
-                fi.write((char *)&wTmp, 2);
-                genTmp = sm->get(id2, champ_velRange);
-                if (genTmp.rValue.byLo > 127)
-                    genTmp.rValue.byLo = 127;
-                if (genTmp.rValue.byHi > 127)
-                    genTmp.rValue.byHi = 127;
-                fi.write((char *)&genTmp, 2);
-            }
-            foreach (int k, sm->getSiblings(id3))
-            {
-                if (k != champ_keyRange && k != champ_velRange && k != champ_sampleID)
-                {
-                    wTmp = k;
-                    fi.write((char *)&wTmp, 2);
-                    genTmp = sm->get(id2, (AttributeType)k);
-                    fi.write((char *)&genTmp, 2);
-                }
-            }
-            wTmp = champ_sampleID;
-            fi.write((char *)&wTmp, 2);
-            genTmp.wValue = converterSmpl.getIndexOf(sm->get(id2, champ_sampleID).wValue, false);
-            fi.write((char *)&genTmp, 2);
-        }
-    }
+void OutputSf2::writeSampleData(Sf2FileWriter &writer, SoundfontManager * sm, EltID idSmpl, bool extra24, quint32 length)
+{
+    // Direct copy from the source file if the data has not been edited
+    Sound * sound = sm->getSound(idSmpl);
+    quint32 start, rangeLength;
+    if (sound != nullptr && sound->getFileRange(extra24 ? 8 : 16, start, rangeLength) && rangeLength == length &&
+            writer.copy(sound->getFileName(), start, length))
+        return;
 
-    // gen de fin
-    charTmp = '\0';
-    for (quint32 iteration = 0; iteration < 4; iteration++)
-        fi.write(&charTmp, 1);
+    // Otherwise the data is written from memory
+    QByteArray baData = sm->getData(idSmpl, extra24 ? champ_sampleData24 : champ_sampleData16);
+    quint32 size = qMin(static_cast<quint32>(baData.size()), length);
+    writer.write(baData.constData(), size);
+    writer.writeZeros(length - size);
+}
 
-    fi.write("shdr", 4);
-    fi.write((char *)&taille_shdr, 4);
+QByteArray OutputSf2::getInfo(SoundfontManager * sm, int sf2Index, bool is24bits)
+{
+    EltID id(elementSf2, sf2Index);
+    QByteArray info("INFO");
 
-    // un bloc shdr par sample
-    id.typeElement = elementSmpl;
-    nBag = 0;
-    dwTmp2 = 0;
-    foreach (int i, sm->getSiblings(id))
+    // Version, champ obligatoire
+    SfVersionTag sfVersionTmp;
+    sfVersionTmp.wMajor = 2;
+    sfVersionTmp.wMinor = is24bits ? 4 : 1;
+    info.append("ifil", 4);
+    Sf2PdtaBuilder::appendDWord(info, 4);
+    info.append(reinterpret_cast<const char *>(&sfVersionTmp), 4);
+
+    // Wavetable sound engine et nom du sf2, champs obligatoires
+    QString text = sm->getQstr(id, champ_ISNG);
+    appendInfoText(info, "isng", text.isEmpty() ? QString("Generic") : text, 255);
+    text = sm->getQstr(id, champ_name);
+    appendInfoText(info, "INAM", text.isEmpty() ? QString("no title") : text, 255);
+
+    // Identification et révision d'une table d'onde, champs optionnels
+    appendInfoText(info, "irom", sm->getQstr(id, champ_IROM), 255);
+    sfVersionTmp = sm->get(id, champ_IVER).sfVerValue;
+    if (sfVersionTmp.wMinor != 0 || sfVersionTmp.wMajor != 0)
     {
-        id.indexElt = i;
-
-        // Name
-        dwTmp = sm->getQstr(id, champ_name).length();
-        if (dwTmp > 20) dwTmp = 20;
-        if (dwTmp != 0)
-        {
-            fi.write(sm->getQstr(id, champ_name).toLatin1());
-            charTmp = '\0';
-            for (quint32 iteration = 0; iteration < 20 - dwTmp; iteration++)
-                fi.write(&charTmp, 1);
-        }
-        else
-        {
-            dwTmp = sprintf(tcharTmp, "sample %d", i+1);
-            fi.write(tcharTmp, dwTmp);
-            charTmp = '\0';
-            for (quint32 iteration = 0; iteration < 20 - dwTmp; iteration++)
-                fi.write(&charTmp, 1);
-        }
-        // dwStart, dwEnd, dwStartLoop, dwEndLoop
-        fi.write((char *)&dwTmp2, 4);
-        dwTmp = dwTmp2 + sm->get(id, champ_dwLength).dwValue;
-        fi.write((char *)&dwTmp, 4);
-        dwTmp = dwTmp2 + sm->get(id, champ_dwStartLoop).dwValue;
-        fi.write((char *)&dwTmp, 4);
-        dwTmp = dwTmp2 + sm->get(id, champ_dwEndLoop).dwValue;
-        fi.write((char *)&dwTmp, 4);
-
-        // on avance
-        dwTmp2 += sm->get(id, champ_dwLength).dwValue + 46; // 46 zeros
-
-        // dwSampleRate
-        dwTmp = sm->get(id, champ_dwSampleRate).dwValue;
-        fi.write((char *)&dwTmp, 4);
-        // byOriginalPitch
-        byTmp = sm->get(id, champ_byOriginalPitch).bValue;
-        fi.write((char *)&byTmp, 1);
-        // chPitchCorrection
-        charTmp = sm->get(id, champ_chPitchCorrection).cValue;
-        fi.write((char *)&charTmp, sizeof(char));
-        // wSampleLink
-        wTmp = converterSmpl.getIndexOf(sm->get(id, champ_wSampleLink).wValue, false);
-        fi.write((char *)&wTmp, 2);
-        // sfSampleType
-        wTmp = sm->get(id, champ_sfSampleType).sfLinkValue;
-        fi.write((char *)&wTmp, 2);
+        info.append("iver", 4);
+        Sf2PdtaBuilder::appendDWord(info, 4);
+        info.append(reinterpret_cast<const char *>(&sfVersionTmp), 4);
     }
 
-    // shdr de fin
-    fi.write("EOS", 3);
-    charTmp = '\0';
-    for (quint32 iteration = 0; iteration < 43; iteration++)
-        fi.write(&charTmp, 1);
+    // Date, auteur, produit, copyright, commentaires et outil d'édition, champs optionnels
+    appendInfoText(info, "ICRD", sm->getQstr(id, champ_ICRD), 255);
+    appendInfoText(info, "IENG", sm->getQstr(id, champ_IENG), 255);
+    appendInfoText(info, "IPRD", sm->getQstr(id, champ_IPRD), 255);
+    appendInfoText(info, "ICOP", sm->getQstr(id, champ_ICOP), 255);
+    appendInfoText(info, "ICMT", sm->getQstr(id, champ_ICMT), 65536);
+    appendInfoText(info, "ISFT", sm->getQstr(id, champ_ISFT), 255);
 
-    // Fermeture du fichier
-    fi.close();
+    return info;
+}
 
-    // Sauvegarde de fileName, wBpsInit
-    id.typeElement = elementSf2;
-    sm->set(id, champ_filenameInitial, fileName);
-    sm->set(id, champ_filenameForData, fileName);
-    sm->set(id, champ_wBpsInit, sm->get(id, champ_wBpsSave));
+void OutputSf2::appendInfoText(QByteArray &info, const char * name, QString text, int maxLength)
+{
+    if (text.isEmpty())
+        return;
 
-    success = true;
-    error = "";
+    // Terminated by one or two '\0' so that the size is even
+    QByteArray data = text.left(maxLength).toLatin1();
+    data.append(QByteArray(2 - data.size() % 2, '\0'));
+    Sf2PdtaBuilder::appendChunk(info, name, data);
 }
@@ -26,7 +26,9 @@
 #define OUTPUTSF2_H
 
 #include "abstractoutput.h"
+#include "basetypes.h"
 class SoundfontManager;
+class Sf2FileWriter;
 
 class OutputSf2 : public AbstractOutput
 {
@@ -40,6 +42,9 @@ protected slots:
 
 private:
     void save(QString fileName, SoundfontManager * sm, bool &success, QString &error, int sf2Index);
+    static void writeSampleData(Sf2FileWriter &writer, SoundfontManager * sm, EltID idSmpl, bool extra24, quint32 length);
+    static QByteArray getInfo(SoundfontManager * sm, int sf2Index, bool is24bits);
+    static void appendInfoText(QByteArray &info, const char * name, QString text, int maxLength);
 };
 
 #endif // OUTPUTSF2_H
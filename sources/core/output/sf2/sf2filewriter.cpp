@@ -0,0 +1,153 @@
+/***************************************************************************
+**                                                                        **
+**  Polyphone, a soundfont editor                                         **
+**  Copyright (C) 2013-2019 Davy Triponney                                **
+**                                                                        **
+**  This program is free software: you can redistribute it and/or modify  **
+**  it under the terms of the GNU General Public License as published by  **
+**  the Free Software Foundation, either version 3 of the License, or     **
+**  (at your option) any later version.                                   **
+**                                                                        **
+**  This program is distributed in the hope that it will be useful,       **
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of        **
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the          **
+**  GNU General Public License for more details.                          **
+**                                                                        **
+**  You should have received a copy of the GNU General Public License     **
+**  along with this program. If not, see http://www.gnu.org/licenses/.    **
+**                                                                        **
+****************************************************************************
+**           Author: Davy Triponney                                       **
+**  Website/Contact: https://www.polyphone-soundfonts.com                 **
+**             Date: 01.01.2013                                           **
+***************************************************************************/
+
+
+#include "sf2filewriter.h"
+#ifdef Q_OS_LINUX
+#  include <unistd.h>
+#  ifdef __GLIBC__
+#    if __GLIBC_PREREQ(2, 27)
+#      define USE_COPY_FILE_RANGE
+#    endif
+#  endif
+#endif
+
+const int Sf2FileWriter::CHUNK_SIZE = 4 * 1024 * 1024;
+
+Sf2FileWriter::Sf2FileWriter(QString fileName) :
+    _file(fileName),
+    _isValid(false)
+{
+
+}
+
+bool Sf2FileWriter::open()
+{
+    _isValid = _file.open(QIODevice::WriteOnly);
+    return _isValid;
+}
+
+bool Sf2FileWriter::close()
+{
+    _source.close();
+    if (_file.isOpen())
+    {
+        _isValid = _file.flush() && _isValid;
+        _file.close();
+    }
+    return _isValid;
+}
+
+void Sf2FileWriter::write(const char * data, qint64 length)
+{
+    if (_isValid && length > 0)
+        _isValid = (_file.write(data, length) == length);
+}
+
+void Sf2FileWriter::writeZeros(qint64 length)
+{
+    static const char zeros[1024] = {0};
+    while (length > 0)
+    {
+        qint64 size = qMin(length, static_cast<qint64>(sizeof(zeros)));
+        write(zeros, size);
+        length -= size;
+    }
+}
+
+bool Sf2FileWriter::copy(QString sourceFileName, quint32 start, quint32 length)
+{
+    if (!_isValid)
+        return false;
+
+    // Source file, possibly already opened
+    if (!_source.isOpen() || _source.fileName() != sourceFileName)
+    {
+        _source.close();
+        _source.setFileName(sourceFileName);
+        if (!_source.open(QIODevice::ReadOnly))
+            return false;
+    }
+    if (static_cast<qint64>(start) + length > _source.size())
+        return false;
+
+    qint64 position = start;
+    qint64 remaining = length;
+    if (!copyBySystem(position, remaining) || remaining == 0)
+        return true;
+
+    // Copy of the rest by chunks
+    if (_buffer.isEmpty())
+        _buffer.resize(CHUNK_SIZE);
+    if (!_source.seek(position))
+    {
+        _isValid = false;
+        return true;
+    }
+    while (remaining > 0 && _isValid)
+    {
+        qint64 size = _source.read(_buffer.data(), qMin(remaining, static_cast<qint64>(CHUNK_SIZE)));
+        if (size <= 0)
+        {
+            _isValid = false;
+            break;
+        }
+        write(_buffer.constData(), size);
+        remaining -= size;
+    }
+
+    return true;
+}
+
+bool Sf2FileWriter::copyBySystem(qint64 &start, qint64 &length)
+{
+#ifdef USE_COPY_FILE_RANGE
+    // The data doesn't go through the user space (and is possibly not even duplicated on the disk)
+    if (!_file.flush())
+    {
+        _isValid = false;
+        return false;
+    }
+    loff_t positionIn = start;
+    loff_t positionOut = _file.pos();
+    while (length > 0)
+    {
+        ssize_t size = copy_file_range(_source.handle(), &positionIn, _file.handle(), &positionOut,
+                                       static_cast<size_t>(length), 0);
+        if (size <= 0)
+            break; // Not supported between these files: the rest is copied by chunks
+        length -= size;
+    }
+    start = positionIn;
+
+    // Position of the file updated after the write
+    if (!_file.seek(positionOut))
+        _isValid = false;
+    return _isValid;
+#else
+    Q_UNUSED(start)
+    Q_UNUSED(length)
+    return true;
+#endif
+}
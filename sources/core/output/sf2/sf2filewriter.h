@@ -0,0 +1,59 @@
+/***************************************************************************
+**                                                                        **
+**  Polyphone, a soundfont editor                                         **
+**  Copyright (C) 2013-2019 Davy Triponney                                **
+**                                                                        **
+**  This program is free software: you can redistribute it and/or modify  **
+**  it under the terms of the GNU General Public License as published by  **
+**  the Free Software Foundation, either version 3 of the License, or     **
+**  (at your option) any later version.                                   **
+**                                                                        **
+**  This program is distributed in the hope that it will be useful,       **
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of        **
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the          **
+**  GNU General Public License for more details.                          **
+**                                                                        **
+**  You should have received a copy of the GNU General Public License     **
+**  along with this program. If not, see http://www.gnu.org/licenses/.    **
+**                                                                        **
+****************************************************************************
+**           Author: Davy Triponney                                       **
+**  Website/Contact: https://www.polyphone-soundfonts.com                 **
+**             Date: 01.01.2013                                           **
+***************************************************************************/
+
+
+#ifndef SF2FILEWRITER_H
+#define SF2FILEWRITER_H
+
+#include <QFile>
+
+// Sequential writing of a soundfont, the unchanged sample data being copied from the source files
+// in large chunks (by the system when possible) instead of being loaded in memory
+class Sf2FileWriter
+{
+public:
+    Sf2FileWriter(QString fileName);
+
+    bool open();
+    bool close(); // False if an error occurred since the file has been opened
+
+    void write(const char * data, qint64 length);
+    void write(const QByteArray &data) { write(data.constData(), data.size()); }
+    void writeZeros(qint64 length);
+
+    // Copy a part of another file, false (and nothing written) if the part cannot be read
+    bool copy(QString sourceFileName, quint32 start, quint32 length);
+
+private:
+    bool copyBySystem(qint64 &start, qint64 &length);
+
+    QFile _file;
+    QFile _source; // Kept open for the next copies
+    QByteArray _buffer; // Used when the system cannot copy the data itself
+    bool _isValid;
+
+    static const int CHUNK_SIZE;
+};
+
+#endif // SF2FILEWRITER_H
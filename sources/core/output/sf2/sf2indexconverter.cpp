@@ -27,7 +27,16 @@
 
 Sf2IndexConverter::Sf2IndexConverter(EltID id)
 {
-    _indexes = SoundfontManager::getInstance()->getSiblings(id);
+    // Position of each index in the file, -1 for the hidden elements
+    int position = 0;
+    SiblingIterator it(SoundfontManager::getInstance(), id);
+    while (it.hasNext())
+    {
+        int index = it.next();
+        while (_positions.size() <= index)
+            _positions << -1;
+        _positions[index] = position++;
+    }
 }
 
 int Sf2IndexConverter::getIndexOf(int index, bool isModDestOper)
@@ -38,11 +47,11 @@ int Sf2IndexConverter::getIndexOf(int index, bool isModDestOper)
     {
         if (index < 32768) // Same destination
             correspondingIndex = index;
-        else if (_indexes.contains(index - 32768)) // Adapt the destination mod
-            correspondingIndex = 32768 + _indexes.indexOf(index - 32768);
+        else if (positionOf(index - 32768) >= 0) // Adapt the destination mod
+            correspondingIndex = 32768 + positionOf(index - 32768);
     }
-    else if (_indexes.contains(index))
-        correspondingIndex = _indexes.indexOf(index);
+    else if (positionOf(index) >= 0)
+        correspondingIndex = positionOf(index);
 
     return correspondingIndex;
 }
@@ -26,6 +26,7 @@
 #define SF2INDEXCONVERTER_H
 
 #include "basetypes.h"
+#include <QVector>
 
 class Sf2IndexConverter
 {
@@ -34,7 +35,9 @@ public:
     int getIndexOf(int index, bool isModDestOper);
 
 private:
-    QList<int> _indexes;
+    int positionOf(int index) { return (index >= 0 && index < _positions.size()) ? _positions[index] : -1; }
+
+    QVector<int> _positions;
 };
 
 #endif // SF2INDEXCONVERTER_H
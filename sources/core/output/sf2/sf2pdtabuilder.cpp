@@ -0,0 +1,241 @@
+/***************************************************************************
+**                                                                        **
+**  Polyphone, a soundfont editor                                         **
+**  Copyright (C) 2013-2019 Davy Triponney                                **
+**                                                                        **
+**  This program is free software: you can redistribute it and/or modify  **
+**  it under the terms of the GNU General Public License as published by  **
+**  the Free Software Foundation, either version 3 of the License, or     **
+**  (at your option) any later version.                                   **
+**                                                                        **
+**  This program is distributed in the hope that it will be useful,       **
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of        **
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the          **
+**  GNU General Public License for more details.                          **
+**                                                                        **
+**  You should have received a copy of the GNU General Public License     **
+**  along with this program. If not, see http://www.gnu.org/licenses/.    **
+**                                                                        **
+****************************************************************************
+**           Author: Davy Triponney                                       **
+**  Website/Contact: https://www.polyphone-soundfonts.com                 **
+**             Date: 01.01.2013                                           **
+***************************************************************************/
+
+
+#include "sf2pdtabuilder.h"
+#include "sf2indexconverter.h"
+#include "soundfontmanager.h"
+
+Sf2PdtaBuilder::Sf2PdtaBuilder(SoundfontManager * sm, int sf2Index) :
+    _sm(sm),
+    _sf2Index(sf2Index)
+{}
+
+QByteArray Sf2PdtaBuilder::build()
+{
+    QByteArray phdr, pbag, pmod, pgen, inst, ibag, imod, igen, shdr;
+    addElements(true, phdr, pbag, pmod, pgen);
+    addElements(false, inst, ibag, imod, igen);
+    addSamples(shdr);
+
+    QByteArray pdta("pdta");
+    appendChunk(pdta, "phdr", phdr);
+    appendChunk(pdta, "pbag", pbag);
+    appendChunk(pdta, "pmod", pmod);
+    appendChunk(pdta, "pgen", pgen);
+    appendChunk(pdta, "inst", inst);
+    appendChunk(pdta, "ibag", ibag);
+    appendChunk(pdta, "imod", imod);
+    appendChunk(pdta, "igen", igen);
+    appendChunk(pdta, "shdr", shdr);
+    return pdta;
+}
+
+void Sf2PdtaBuilder::appendChunk(QByteArray &data, const char * name, const QByteArray &content)
+{
+    data.append(name, 4);
+    appendDWord(data, static_cast<quint32>(content.size()));
+    data.append(content);
+}
+
+void Sf2PdtaBuilder::addElements(bool isPrst, QByteArray &hdr, QByteArray &bag, QByteArray &mod, QByteArray &gen)
+{
+    // Presets are linked to instruments, instruments to samples
+    AttributeType link = isPrst ? champ_instrument : champ_sampleID;
+    Sf2IndexConverter linkConverter(EltID(isPrst ? elementInst : elementSmpl, _sf2Index));
+    int bagNumber = 0;
+    int modNumber = 0;
+    int genNumber = 0;
+
+    EltID id(isPrst ? elementPrst : elementInst, _sf2Index);
+    SiblingIterator it(_sm, id);
+    while (it.hasNext())
+    {
+        id.indexElt = it.next();
+
+        // Header
+        appendName(hdr, _sm->getQstr(id, champ_name),
+                   QString(isPrst ? "preset %1" : "instrument %1").arg(id.indexElt + 1));
+        if (isPrst)
+        {
+            appendWord(hdr, _sm->get(id, champ_wPreset).wValue);
+            appendWord(hdr, _sm->get(id, champ_wBank).wValue);
+            appendWord(hdr, static_cast<quint16>(bagNumber));
+            appendDWord(hdr, _sm->get(id, champ_dwLibrary).dwValue);
+            appendDWord(hdr, _sm->get(id, champ_dwGenre).dwValue);
+            appendDWord(hdr, _sm->get(id, champ_dwMorphology).dwValue);
+        }
+        else
+            appendWord(hdr, static_cast<quint16>(bagNumber));
+
+        // Global division
+        appendWord(bag, static_cast<quint16>(genNumber));
+        appendWord(bag, static_cast<quint16>(modNumber));
+        bagNumber++;
+        modNumber += addModulators(mod, EltID(isPrst ? elementPrstMod : elementInstMod, _sf2Index, id.indexElt));
+        genNumber += addGenerators(gen, _sm->getAttributes(id), link);
+
+        // One division per linked element, the last generator being the link
+        EltID idDiv(isPrst ? elementPrstInst : elementInstSmpl, _sf2Index, id.indexElt);
+        SiblingIterator itDiv(_sm, idDiv);
+        while (itDiv.hasNext())
+        {
+            idDiv.indexElt2 = itDiv.next();
+            appendWord(bag, static_cast<quint16>(genNumber));
+            appendWord(bag, static_cast<quint16>(modNumber));
+            bagNumber++;
+            modNumber += addModulators(mod, EltID(isPrst ? elementPrstInstMod : elementInstSmplMod, _sf2Index,
+                                                  id.indexElt, idDiv.indexElt2));
+            const QMap<AttributeType, AttributeValue> attributes = _sm->getAttributes(idDiv);
+            genNumber += addGenerators(gen, attributes, link);
+            appendWord(gen, static_cast<quint16>(link));
+            appendWord(gen, static_cast<quint16>(linkConverter.getIndexOf(attributes.value(link).wValue, false)));
+            genNumber++;
+        }
+    }
+
+    // Terminal records
+    if (isPrst)
+    {
+        hdr.append("EOP", 3);
+        hdr.append(QByteArray(21, '\0'));
+        appendWord(hdr, static_cast<quint16>(bagNumber));
+        hdr.append(QByteArray(12, '\0'));
+    }
+    else
+    {
+        hdr.append("EOI", 3);
+        hdr.append(QByteArray(17, '\0'));
+        appendWord(hdr, static_cast<quint16>(bagNumber));
+    }
+    appendWord(bag, static_cast<quint16>(genNumber));
+    appendWord(bag, static_cast<quint16>(modNumber));
+    mod.append(QByteArray(10, '\0'));
+    gen.append(QByteArray(4, '\0'));
+}
+
+int Sf2PdtaBuilder::addModulators(QByteArray &mod, EltID idMod)
+{
+    int count = 0;
+    Sf2IndexConverter converter(idMod);
+    SiblingIterator it(_sm, idMod);
+    while (it.hasNext())
+    {
+        idMod.indexMod = it.next();
+
+        SFModulator sfMod = _sm->get(idMod, champ_sfModSrcOper).sfModValue;
+        mod.append(static_cast<char>(sfMod.Index + sfMod.CC * 128));
+        mod.append(static_cast<char>(sfMod.isDescending + 2 * sfMod.isBipolar + 4 * sfMod.Type));
+        appendWord(mod, static_cast<quint16>(converter.getIndexOf(_sm->get(idMod, champ_sfModDestOper).wValue, true)));
+        appendWord(mod, _sm->get(idMod, champ_modAmount).wValue);
+        sfMod = _sm->get(idMod, champ_sfModAmtSrcOper).sfModValue;
+        mod.append(static_cast<char>(sfMod.Index + sfMod.CC * 128));
+        mod.append(static_cast<char>(sfMod.isDescending + 2 * sfMod.isBipolar + 4 * sfMod.Type));
+        appendWord(mod, _sm->get(idMod, champ_sfModTransOper).wValue == 2 ? absolute_value : linear);
+        count++;
+    }
+    return count;
+}
+
+int Sf2PdtaBuilder::addGenerators(QByteArray &gen, const QMap<AttributeType, AttributeValue> &attributes, AttributeType link)
+{
+    int count = 0;
+
+    // Key range first if present, then velocity range
+    if (attributes.contains(champ_keyRange))
+    {
+        appendRange(gen, champ_keyRange, attributes.value(champ_keyRange));
+        count++;
+    }
+    if (attributes.contains(champ_velRange))
+    {
+        appendRange(gen, champ_velRange, attributes.value(champ_velRange));
+        count++;
+    }
+
+    // Then all the others, except the link
+    QMapIterator<AttributeType, AttributeValue> i(attributes);
+    while (i.hasNext())
+    {
+        i.next();
+        if (i.key() != champ_keyRange && i.key() != champ_velRange && i.key() != link)
+        {
+            appendWord(gen, static_cast<quint16>(i.key()));
+            AttributeValue value = i.value();
+            gen.append(reinterpret_cast<const char *>(&value), 2);
+            count++;
+        }
+    }
+
+    return count;
+}
+
+void Sf2PdtaBuilder::appendRange(QByteArray &gen, AttributeType champ, AttributeValue value)
+{
+    if (value.rValue.byLo > 127)
+        value.rValue.byLo = 127;
+    if (value.rValue.byHi > 127)
+        value.rValue.byHi = 127;
+    appendWord(gen, static_cast<quint16>(champ));
+    gen.append(reinterpret_cast<const char *>(&value), 2);
+}
+
+void Sf2PdtaBuilder::addSamples(QByteArray &shdr)
+{
+    Sf2IndexConverter converter(EltID(elementSmpl, _sf2Index));
+    quint32 position = 0;
+
+    EltID id(elementSmpl, _sf2Index);
+    SiblingIterator it(_sm, id);
+    while (it.hasNext())
+    {
+        id.indexElt = it.next();
+        appendName(shdr, _sm->getQstr(id, champ_name), QString("sample %1").arg(id.indexElt + 1));
+
+        // Positions in the sample data, each sample being followed by 46 zeros
+        quint32 length = _sm->get(id, champ_dwLength).dwValue;
+        appendDWord(shdr, position);
+        appendDWord(shdr, position + length);
+        appendDWord(shdr, position + _sm->get(id, champ_dwStartLoop).dwValue);
+        appendDWord(shdr, position + _sm->get(id, champ_dwEndLoop).dwValue);
+        position += length + 46;
+
+        appendDWord(shdr, _sm->get(id, champ_dwSampleRate).dwValue);
+        shdr.append(static_cast<char>(_sm->get(id, champ_byOriginalPitch).bValue));
+        shdr.append(static_cast<char>(_sm->get(id, champ_chPitchCorrection).cValue));
+        appendWord(shdr, static_cast<quint16>(converter.getIndexOf(_sm->get(id, champ_wSampleLink).wValue, false)));
+        appendWord(shdr, static_cast<quint16>(_sm->get(id, champ_sfSampleType).sfLinkValue));
+    }
+
+    shdr.append("EOS", 3);
+    shdr.append(QByteArray(43, '\0'));
+}
+
+void Sf2PdtaBuilder::appendName(QByteArray &data, QString name, QString defaultName)
+{
+    // 20 characters, completed with '\0'
+    QByteArray text = (name.isEmpty() ? defaultName : name).toLatin1().left(20);
+    data.append(text);
+    data.append(QByteArray(20 - text.size(), '\0'));
+}
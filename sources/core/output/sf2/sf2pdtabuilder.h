@@ -0,0 +1,60 @@
+/***************************************************************************
+**                                                                        **
+**  Polyphone, a soundfont editor                                         **
+**  Copyright (C) 2013-2019 Davy Triponney                                **
+**                                                                        **
+**  This program is free software: you can redistribute it and/or modify  **
+**  it under the terms of the GNU General Public License as published by  **
+**  the Free Software Foundation, either version 3 of the License, or     **
+**  (at your option) any later version.                                   **
+**                                                                        **
+**  This program is distributed in the hope that it will be useful,       **
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of        **
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the          **
+**  GNU General Public License for more details.                          **
+**                                                                        **
+**  You should have received a copy of the GNU General Public License     **
+**  along with this program. If not, see http://www.gnu.org/licenses/.    **
+**                                                                        **
+****************************************************************************
+**           Author: Davy Triponney                                       **
+**  Website/Contact: https://www.polyphone-soundfonts.com                 **
+**             Date: 01.01.2013                                           **
+***************************************************************************/
+
+
+#ifndef SF2PDTABUILDER_H
+#define SF2PDTABUILDER_H
+
+#include "basetypes.h"
+class SoundfontManager;
+
+// Description of the presets, instruments and samples of a soundfont (pdta list),
+// built in memory in a single pass so that the size of each sub-chunk is known when it is written
+class Sf2PdtaBuilder
+{
+public:
+    Sf2PdtaBuilder(SoundfontManager * sm, int sf2Index);
+
+    // Content of the list, starting with "pdta"
+    QByteArray build();
+
+    // Little helpers, shared with the INFO list
+    static void appendWord(QByteArray &data, quint16 value) { data.append(reinterpret_cast<const char *>(&value), 2); }
+    static void appendDWord(QByteArray &data, quint32 value) { data.append(reinterpret_cast<const char *>(&value), 4); }
+    static void appendChunk(QByteArray &data, const char * name, const QByteArray &content);
+
+private:
+    void addElements(bool isPrst, QByteArray &hdr, QByteArray &bag, QByteArray &mod, QByteArray &gen);
+    int addModulators(QByteArray &mod, EltID idMod);
+    int addGenerators(QByteArray &gen, const QMap<AttributeType, AttributeValue> &attributes, AttributeType link);
+    void addSamples(QByteArray &shdr);
+
+    static void appendName(QByteArray &data, QString name, QString defaultName);
+    static void appendRange(QByteArray &gen, AttributeType champ, AttributeValue value);
+
+    SoundfontManager * _sm;
+    int _sf2Index;
+};
+
+#endif // SF2PDTABUILDER_H
@@ -0,0 +1,82 @@
+/***************************************************************************
+**                                                                        **
+**  Polyphone, a soundfont editor                                         **
+**  Copyright (C) 2013-2019 Davy Triponney                                **
+**                                                                        **
+**  This program is free software: you can redistribute it and/or modify  **
+**  it under the terms of the GNU General Public License as published by  **
+**  the Free Software Foundation, either version 3 of the License, or     **
+**  (at your option) any later version.                                   **
+**                                                                        **
+**  This program is distributed in the hope that it will be useful,       **
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of        **
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the          **
+**  GNU General Public License for more details.                          **
+**                                                                        **
+**  You should have received a copy of the GNU General Public License     **
+**  along with this program. If not, see http://www.gnu.org/licenses/.    **
+**                                                                        **
+****************************************************************************
+**           Author: Davy Triponney                                       **
+**  Website/Contact: https://www.polyphone-soundfonts.com                 **
+**             Date: 01.01.2013                                           **
+***************************************************************************/
+
+
+#include "readwritelock.h"
+#include <QThread>
+
+ReadWriteLock::ReadWriteLock() :
+    _lock(QReadWriteLock::NonRecursive),
+    _writer(nullptr),
+    _writeDepth(0)
+{
+
+}
+
+void ReadWriteLock::lockForRead()
+{
+    // The writer can read what it is writing
+    if (_writer.loadAcquire() == QThread::currentThreadId())
+    {
+        _writeDepth++;
+        return;
+    }
+
+    int &depth = _readDepth.localData();
+    if (depth++ == 0)
+        _lock.lockForRead();
+}
+
+void ReadWriteLock::lockForWrite()
+{
+    Qt::HANDLE self = QThread::currentThreadId();
+    if (_writer.loadAcquire() == self)
+    {
+        _writeDepth++;
+        return;
+    }
+
+    Q_ASSERT_X(!_readDepth.hasLocalData() || _readDepth.localData() == 0, "ReadWriteLock::lockForWrite",
+               "a reader cannot become a writer");
+    _lock.lockForWrite();
+    _writer.storeRelease(self);
+    _writeDepth = 1;
+}
+
+void ReadWriteLock::unlock()
+{
+    if (_writer.loadAcquire() == QThread::currentThreadId())
+    {
+        if (--_writeDepth == 0)
+        {
+            _writer.storeRelease(nullptr);
+            _lock.unlock();
+        }
+        return;
+    }
+
+    int &depth = _readDepth.localData();
+    if (--depth == 0)
+        _lock.unlock();
+}
@@ -0,0 +1,72 @@
+/***************************************************************************
+**                                                                        **
+**  Polyphone, a soundfont editor                                         **
+**  Copyright (C) 2013-2019 Davy Triponney                                **
+**                                                                        **
+**  This program is free software: you can redistribute it and/or modify  **
+**  it under the terms of the GNU General Public License as published by  **
+**  the Free Software Foundation, either version 3 of the License, or     **
+**  (at your option) any later version.                                   **
+**                                                                        **
+**  This program is distributed in the hope that it will be useful,       **
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of        **
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the          **
+**  GNU General Public License for more details.                          **
+**                                                                        **
+**  You should have received a copy of the GNU General Public License     **
+**  along with this program. If not, see http://www.gnu.org/licenses/.    **
+**                                                                        **
+****************************************************************************
+**           Author: Davy Triponney                                       **
+**  Website/Contact: https://www.polyphone-soundfonts.com                 **
+**             Date: 01.01.2013                                           **
+***************************************************************************/
+
+
+#ifndef READWRITELOCK_H
+#define READWRITELOCK_H
+
+#include <QReadWriteLock>
+#include <QThreadStorage>
+#include <QAtomicPointer>
+
+// Lock allowing either several readers at the same time, or a single writer
+// Both kinds of lock are recursive and the writer can also read,
+// but a thread only reading must not ask for writing (this would be a deadlock)
+class ReadWriteLock
+{
+public:
+    ReadWriteLock();
+
+    void lockForRead();
+    void lockForWrite();
+    void unlock();
+
+private:
+    QReadWriteLock _lock; // Not recursive: nested locks are counted here, so that they never wait for a writer
+    QAtomicPointer<void> _writer; // Thread holding the write lock
+    int _writeDepth; // Only used by the writer
+    QThreadStorage<int> _readDepth;
+};
+
+class ReadLocker
+{
+public:
+    ReadLocker(ReadWriteLock * lock) : _lock(lock) { _lock->lockForRead(); }
+    ~ReadLocker() { _lock->unlock(); }
+
+private:
+    ReadWriteLock * _lock;
+};
+
+class WriteLocker
+{
+public:
+    WriteLocker(ReadWriteLock * lock) : _lock(lock) { _lock->lockForWrite(); }
+    ~WriteLocker() { _lock->unlock(); }
+
+private:
+    ReadWriteLock * _lock;
+};
+
+#endif // READWRITELOCK_H
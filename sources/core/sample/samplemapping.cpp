@@ -0,0 +1,95 @@
+/***************************************************************************
+**                                                                        **
+**  Polyphone, a soundfont editor                                         **
+**  Copyright (C) 2013-2019 Davy Triponney                                **
+**                                                                        **
+**  This program is free software: you can redistribute it and/or modify  **
+**  it under the terms of the GNU General Public License as published by  **
+**  the Free Software Foundation, either version 3 of the License, or     **
+**  (at your option) any later version.                                   **
+**                                                                        **
+**  This program is distributed in the hope that it will be useful,       **
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of        **
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the          **
+**  GNU General Public License for more details.                          **
+**                                                                        **
+**  You should have received a copy of the GNU General Public License     **
+**  along with this program. If not, see http://www.gnu.org/licenses/.    **
+**                                                                        **
+****************************************************************************
+**           Author: Davy Triponney                                       **
+**  Website/Contact: https://www.polyphone-soundfonts.com                 **
+**             Date: 01.01.2013                                           **
+***************************************************************************/
+
+
+#include "samplemapping.h"
+#include <QFileInfo>
+
+QMap<QString, QWeakPointer<SampleMapping> > SampleMapping::_mappings;
+QMutex SampleMapping::_mutexMappings;
+
+QSharedPointer<SampleMapping> SampleMapping::get(QString fileName)
+{
+    QString key = QFileInfo(fileName).absoluteFilePath();
+    QMutexLocker locker(&_mutexMappings);
+
+    // Mapping already shared by other samples?
+    QSharedPointer<SampleMapping> mapping = _mappings.value(key).toStrongRef();
+    if (mapping.isNull())
+    {
+        // Forget the files that are not mapped anymore
+        QMutableMapIterator<QString, QWeakPointer<SampleMapping> > it(_mappings);
+        while (it.hasNext())
+            if (it.next().value().isNull())
+                it.remove();
+
+        SampleMapping * newMapping = new SampleMapping(key);
+        if (newMapping->_data == nullptr)
+        {
+            delete newMapping;
+            return mapping;
+        }
+        mapping = QSharedPointer<SampleMapping>(newMapping);
+        _mappings[key] = mapping;
+    }
+
+    return mapping;
+}
+
+SampleMapping::SampleMapping(QString fileName) :
+    _file(fileName),
+    _data(nullptr),
+    _size(0)
+{
+    if (_file.open(QFile::ReadOnly))
+    {
+        _size = _file.size();
+        if (_size > 0)
+            _data = _file.map(0, _size);
+        if (_data == nullptr)
+            _file.close();
+    }
+}
+
+SampleMapping::~SampleMapping()
+{
+    if (_data != nullptr)
+    {
+        _file.unmap(_data);
+        _file.close();
+    }
+}
+
+QByteArray SampleMapping::view(quint32 start, quint32 length) const
+{
+    if (static_cast<qint64>(start) + length > _size || length > 0x7FFFFFFF)
+        return QByteArray();
+    return QByteArray::fromRawData(reinterpret_cast<const char *>(_data + start), static_cast<int>(length));
+}
+
+bool SampleMapping::contains(const QByteArray &data) const
+{
+    const uchar * pointer = reinterpret_cast<const uchar *>(data.constData());
+    return !data.isEmpty() && pointer >= _data && pointer < _data + _size;
+}
@@ -0,0 +1,63 @@
+/***************************************************************************
+**                                                                        **
+**  Polyphone, a soundfont editor                                         **
+**  Copyright (C) 2013-2019 Davy Triponney                                **
+**                                                                        **
+**  This program is free software: you can redistribute it and/or modify  **
+**  it under the terms of the GNU General Public License as published by  **
+**  the Free Software Foundation, either version 3 of the License, or     **
+**  (at your option) any later version.                                   **
+**                                                                        **
+**  This program is distributed in the hope that it will be useful,       **
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of        **
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the          **
+**  GNU General Public License for more details.                          **
+**                                                                        **
+**  You should have received a copy of the GNU General Public License     **
+**  along with this program. If not, see http://www.gnu.org/licenses/.    **
+**                                                                        **
+****************************************************************************
+**           Author: Davy Triponney                                       **
+**  Website/Contact: https://www.polyphone-soundfonts.com                 **
+**             Date: 01.01.2013                                           **
+***************************************************************************/
+
+
+#ifndef SAMPLEMAPPING_H
+#define SAMPLEMAPPING_H
+
+#include <QFile>
+#include <QMap>
+#include <QMutex>
+#include <QSharedPointer>
+#include <QWeakPointer>
+
+// Read-only mapping of a whole file in memory, shared by all samples reading it
+// Sample data are then accessed without any copy, the system loading the pages when they are read
+class SampleMapping
+{
+public:
+    ~SampleMapping();
+
+    // Mapping of a file, null if the file cannot be mapped
+    static QSharedPointer<SampleMapping> get(QString fileName);
+
+    // View of a part of the file (empty if outside the file), valid as long as the mapping exists
+    // The data is copied as soon as the view is modified
+    QByteArray view(quint32 start, quint32 length) const;
+
+    // True if the data of an array belongs to the mapping
+    bool contains(const QByteArray &data) const;
+
+private:
+    SampleMapping(QString fileName);
+
+    QFile _file;
+    uchar * _data;
+    qint64 _size;
+
+    static QMap<QString, QWeakPointer<SampleMapping> > _mappings;
+    static QMutex _mutexMappings;
+};
+
+#endif // SAMPLEMAPPING_H
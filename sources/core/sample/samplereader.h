@@ -26,7 +26,9 @@
 #define SAMPLEREADER_H
 
 #include <QFile>
+#include <QSharedPointer>
 #include "infosound.h"
+class SampleMapping;
 
 class SampleReader
 {
@@ -115,13 +117,55 @@ public:
         return _result;
     }
 
+    // Random access to the data (streaming), the file being already opened
+    // Values are 32-bit, the 24 most significant bits being filled by the sample
+    virtual bool canReadRanges() { return false; }
+    virtual SampleReaderResult getData32(QFile &fi, const InfoSound &info, quint32 start, quint32 length, qint32 *data)
+    {
+        Q_UNUSED(fi)
+        Q_UNUSED(info)
+        Q_UNUSED(start)
+        Q_UNUSED(length)
+        Q_UNUSED(data)
+        return FILE_NOT_READABLE;
+    }
+
+    // Data viewed in a mapping of the file, without copy (if the format allows it)
+    // The mapping returned must be kept as long as the view is used, null if the data is not mapped
+    virtual QSharedPointer<SampleMapping> mapData16(QByteArray &smpl)
+    {
+        Q_UNUSED(smpl)
+        return QSharedPointer<SampleMapping>();
+    }
+    virtual QSharedPointer<SampleMapping> mapExtraData24(QByteArray &sm24)
+    {
+        Q_UNUSED(sm24)
+        return QSharedPointer<SampleMapping>();
+    }
+
+    // Bytes of the file containing the data in the soundfont format, so that they can be copied as is
+    // False if the data must be decoded first
+    virtual bool getFileRange16(quint32 &start, quint32 &length)
+    {
+        Q_UNUSED(start)
+        Q_UNUSED(length)
+        return false;
+    }
+    virtual bool getFileRangeExtra24(quint32 &start, quint32 &length)
+    {
+        Q_UNUSED(start)
+        Q_UNUSED(length)
+        return false;
+    }
+
 protected:
     virtual SampleReaderResult getInfo(QFile &fi, InfoSound &info) = 0;
     virtual SampleReaderResult getData16(QFile &fi, QByteArray &smpl) = 0;
     virtual SampleReaderResult getExtraData24(QFile &fi, QByteArray &sm24) = 0;
 
-private:
     QString _filename;
+
+private:
     SampleReaderResult _result;
 };
 
@@ -23,9 +23,12 @@
 ***************************************************************************/
 
 #include "samplereadersf2.h"
+#include "samplemapping.h"
+#include <QFileInfo>
 
 SampleReaderSf2::SampleReaderSf2(QString filename) : SampleReader(filename),
-    _info(nullptr)
+    _info(nullptr),
+    _isCompressed(QFileInfo(filename).suffix().toLower() == "sf3")
 {
 
 }
@@ -88,3 +91,88 @@ SampleReaderSf2::SampleReaderResult SampleReaderSf2::getExtraData24(QFile &fi, Q
 
     return FILE_OK;
 }
+
+bool SampleReaderSf2::canReadRanges()
+{
+    return !_isCompressed;
+}
+
+SampleReaderSf2::SampleReaderResult SampleReaderSf2::getData32(QFile &fi, const InfoSound &info, quint32 start, quint32 length, qint32 *data)
+{
+    if (start + length > info.dwLength)
+        return FILE_CORRUPT;
+
+    // 16 most significant bits
+    QByteArray smpl(static_cast<int>(length) * 2, '\0');
+    fi.seek(info.dwStart + 2 * start);
+    if (fi.read(smpl.data(), length * 2) != length * 2)
+        return FILE_NOT_READABLE;
+    const qint16 * values16 = reinterpret_cast<const qint16 *>(smpl.constData());
+    for (quint32 i = 0; i < length; i++)
+        data[i] = static_cast<qint32>(values16[i]) * 65536;
+
+    // Possibly 8 extra bits
+    if (info.wBpsFile >= 24)
+    {
+        QByteArray sm24(static_cast<int>(length), '\0');
+        fi.seek(info.dwStart2 + start);
+        if (fi.read(sm24.data(), length) != length)
+            return FILE_NOT_READABLE;
+        const quint8 * values8 = reinterpret_cast<const quint8 *>(sm24.constData());
+        for (quint32 i = 0; i < length; i++)
+            data[i] |= static_cast<qint32>(values8[i]) << 8;
+    }
+
+    return FILE_OK;
+}
+
+QSharedPointer<SampleMapping> SampleReaderSf2::mapData16(QByteArray &smpl)
+{
+    // Compressed data (sf3) are decoded when the file is loaded
+    if (_isCompressed || _info == nullptr || _info->dwLength == 0)
+        return QSharedPointer<SampleMapping>();
+
+    QSharedPointer<SampleMapping> mapping = SampleMapping::get(_filename);
+    if (!mapping.isNull())
+    {
+        smpl = mapping->view(_info->dwStart, _info->dwLength * 2);
+        if (smpl.isEmpty())
+            mapping.clear(); // Outside the file: the usual reading will report it
+    }
+    return mapping;
+}
+
+QSharedPointer<SampleMapping> SampleReaderSf2::mapExtraData24(QByteArray &sm24)
+{
+    if (_isCompressed || _info == nullptr || _info->dwLength == 0 || _info->wBpsFile < 24)
+        return QSharedPointer<SampleMapping>();
+
+    QSharedPointer<SampleMapping> mapping = SampleMapping::get(_filename);
+    if (!mapping.isNull())
+    {
+        sm24 = mapping->view(_info->dwStart2, _info->dwLength);
+        if (sm24.isEmpty())
+            mapping.clear();
+    }
+    return mapping;
+}
+
+bool SampleReaderSf2::getFileRange16(quint32 &start, quint32 &length)
+{
+    if (_isCompressed || _info == nullptr || _info->dwLength == 0)
+        return false;
+
+    start = _info->dwStart;
+    length = _info->dwLength * 2;
+    return true;
+}
+
+bool SampleReaderSf2::getFileRangeExtra24(quint32 &start, quint32 &length)
+{
+    if (_isCompressed || _info == nullptr || _info->dwLength == 0 || _info->wBpsFile < 24)
+        return false;
+
+    start = _info->dwStart2;
+    length = _info->dwLength;
+    return true;
+}
@@ -42,8 +42,21 @@ public:
     // Get sample data (extra 8 bits)
     SampleReaderResult getExtraData24(QFile &fi, QByteArray &sm24) override;
 
+    // Random access to the data
+    bool canReadRanges() override;
+    SampleReaderResult getData32(QFile &fi, const InfoSound &info, quint32 start, quint32 length, qint32 *data) override;
+
+    // Views in the smpl / sm24 chunks
+    QSharedPointer<SampleMapping> mapData16(QByteArray &smpl) override;
+    QSharedPointer<SampleMapping> mapExtraData24(QByteArray &sm24) override;
+
+    // Positions in the smpl / sm24 chunks
+    bool getFileRange16(quint32 &start, quint32 &length) override;
+    bool getFileRangeExtra24(quint32 &start, quint32 &length) override;
+
 private:
     InfoSound * _info;
+    bool _isCompressed; // sf3
 };
 
 #endif // SAMPLEREADERSF2_H
@@ -258,8 +258,62 @@ QByteArray SampleReaderWav::loadData(QFile &fi)
         float * dataF = reinterpret_cast<float *>(data.data());
         qint32 * data32 = reinterpret_cast<qint32 *>(data.data());
         for (int i = 0; i < data.size() / 4; i++)
-            data32[i] = static_cast<qint32>(dataF[i] * 2147483647);
+            data32[i] = static_cast<qint32>(qBound(-1.0, static_cast<double>(dataF[i]), 1.0) * 2147483647);
     }
 
     return data;
 }
+
+bool SampleReaderWav::canReadRanges()
+{
+    return true;
+}
+
+SampleReaderWav::SampleReaderResult SampleReaderWav::getData32(QFile &fi, const InfoSound &info, quint32 start, quint32 length, qint32 *data)
+{
+    if (start + length > info.dwLength || info.wBpsFile < 8 || info.wBpsFile > 32)
+        return FILE_CORRUPT;
+
+    // Read all channels
+    unsigned int bytePerValue = info.wBpsFile / 8;
+    unsigned int bytePerSample = info.wChannels * bytePerValue;
+    QByteArray buffer(static_cast<int>(length * bytePerSample), '\0');
+    fi.seek(info.dwStart + start * bytePerSample);
+    if (fi.read(buffer.data(), buffer.size()) != buffer.size())
+        return FILE_NOT_READABLE;
+
+    // Keep the right channel, same precision as getData16 + getExtraData24
+    const char * dataSource = &buffer.constData()[info.wChannel * bytePerValue];
+    for (quint32 i = 0; i < length; i++)
+    {
+        const quint8 * value = reinterpret_cast<const quint8 *>(&dataSource[i * bytePerSample]);
+        switch (bytePerValue)
+        {
+        case 1:
+            data[i] = static_cast<qint32>(static_cast<quint32>(static_cast<quint8>(value[0] - 128)) << 24);
+            break;
+        case 2:
+            data[i] = static_cast<qint32>((static_cast<quint32>(value[1]) << 24) | (static_cast<quint32>(value[0]) << 16));
+            break;
+        case 3:
+            data[i] = static_cast<qint32>((static_cast<quint32>(value[2]) << 24) | (static_cast<quint32>(value[1]) << 16) |
+                                          (static_cast<quint32>(value[0]) << 8));
+            break;
+        default:
+            if (_isIeeeFloat)
+            {
+                // Clamped first, the conversion of a value out of the range of qint32 being undefined
+                float valueF;
+                memcpy(&valueF, value, 4);
+                double valueD = qBound(-1.0, static_cast<double>(valueF), 1.0);
+                data[i] = static_cast<qint32>(valueD * 2147483647) & static_cast<qint32>(0xFFFFFF00);
+            }
+            else
+                data[i] = static_cast<qint32>((static_cast<quint32>(value[3]) << 24) | (static_cast<quint32>(value[2]) << 16) |
+                                              (static_cast<quint32>(value[1]) << 8));
+            break;
+        }
+    }
+
+    return FILE_OK;
+}
@@ -42,6 +42,10 @@ public:
     // Get sample data (extra 8 bits)
     SampleReaderResult getExtraData24(QFile &fi, QByteArray &sm24) override;
 
+    // Random access to the data
+    bool canReadRanges() override;
+    SampleReaderResult getData32(QFile &fi, const InfoSound &info, quint32 start, quint32 length, qint32 *data) override;
+
 private:
     QByteArray loadData(QFile &fi);
 
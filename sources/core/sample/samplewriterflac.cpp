@@ -0,0 +1,127 @@
+/***************************************************************************
+**                                                                        **
+**  Polyphone, a soundfont editor                                         **
+**  Copyright (C) 2013-2019 Davy Triponney                                **
+**                                                                        **
+**  This program is free software: you can redistribute it and/or modify  **
+**  it under the terms of the GNU General Public License as published by  **
+**  the Free Software Foundation, either version 3 of the License, or     **
+**  (at your option) any later version.                                   **
+**                                                                        **
+**  This program is distributed in the hope that it will be useful,       **
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of        **
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the          **
+**  GNU General Public License for more details.                          **
+**                                                                        **
+**  You should have received a copy of the GNU General Public License     **
+**  along with this program. If not, see http://www.gnu.org/licenses/.    **
+**                                                                        **
+****************************************************************************
+**           Author: Davy Triponney                                       **
+**  Website/Contact: https://www.polyphone-soundfonts.com                 **
+**             Date: 01.01.2013                                           **
+***************************************************************************/
+
+
+#include "samplewriterflac.h"
+#include "FLAC/stream_encoder.h"
+
+// https://xiph.org/flac/api/group__flac__stream__encoder.html
+
+const quint32 SampleWriterFlac::BLOCK_SIZE = 4096;
+
+SampleWriterFlac::SampleWriterFlac(QString fileName) :
+    _fileName(fileName),
+    _encoder(nullptr),
+    _buffer(nullptr),
+    _channelNumber(0),
+    _bytesPerValue(0),
+    _isOk(false)
+{
+
+}
+
+SampleWriterFlac::~SampleWriterFlac()
+{
+    close();
+}
+
+bool SampleWriterFlac::write(QByteArray &baData, InfoSound &info)
+{
+    // Length known in advance
+    InfoSound infoTmp = info;
+    if (info.wChannels > 0 && info.wBpsFile >= 8)
+        infoTmp.dwLength = static_cast<quint32>(baData.size()) / (info.wChannels * info.wBpsFile / 8);
+    if (!open(infoTmp))
+        return false;
+    append(baData);
+    return close();
+}
+
+bool SampleWriterFlac::open(InfoSound &info)
+{
+    close();
+    if (info.wChannels == 0 || (info.wBpsFile != 16 && info.wBpsFile != 24))
+        return false;
+    _channelNumber = info.wChannels;
+    _bytesPerValue = info.wBpsFile / 8;
+
+    // Encoder configuration (the length of the info, in frames, is an estimate that can be 0)
+    _encoder = FLAC__stream_encoder_new();
+    if (_encoder == nullptr)
+        return false;
+    FLAC__stream_encoder_set_verify(_encoder, false);
+    FLAC__stream_encoder_set_compression_level(_encoder, 5);
+    FLAC__stream_encoder_set_channels(_encoder, info.wChannels);
+    FLAC__stream_encoder_set_bits_per_sample(_encoder, info.wBpsFile);
+    FLAC__stream_encoder_set_sample_rate(_encoder, info.dwSampleRate);
+    FLAC__stream_encoder_set_total_samples_estimate(_encoder, info.dwLength);
+    if (FLAC__stream_encoder_init_file(_encoder, _fileName.toLocal8Bit().constData(), nullptr, nullptr) !=
+            FLAC__STREAM_ENCODER_INIT_STATUS_OK)
+    {
+        FLAC__stream_encoder_delete(_encoder);
+        _encoder = nullptr;
+        return false;
+    }
+
+    _buffer = new qint32[BLOCK_SIZE * static_cast<quint32>(_channelNumber)];
+    _isOk = true;
+    return true;
+}
+
+bool SampleWriterFlac::append(const QByteArray &baData)
+{
+    if (_encoder == nullptr || !_isOk)
+        return false;
+
+    // Data is encoded by blocks of BLOCK_SIZE frames
+    quint32 frameNumber = static_cast<quint32>(baData.size()) / static_cast<quint32>(_bytesPerValue * _channelNumber);
+    const quint8 * data = reinterpret_cast<const quint8 *>(baData.constData());
+    for (quint32 frame = 0; frame < frameNumber && _isOk; frame += BLOCK_SIZE)
+    {
+        quint32 chunk = qMin(BLOCK_SIZE, frameNumber - frame);
+        for (quint32 i = 0; i < chunk * _channelNumber; i++)
+        {
+            const quint8 * value = &data[(frame * _channelNumber + i) * _bytesPerValue];
+            if (_bytesPerValue == 2)
+                _buffer[i] = static_cast<qint16>(value[0] | (value[1] << 8));
+            else
+                _buffer[i] = static_cast<qint32>((value[0] << 8) | (value[1] << 16) | (value[2] << 24)) >> 8;
+        }
+        _isOk = FLAC__stream_encoder_process_interleaved(_encoder, _buffer, chunk);
+    }
+    return _isOk;
+}
+
+bool SampleWriterFlac::close()
+{
+    if (_encoder == nullptr)
+        return false;
+
+    _isOk = FLAC__stream_encoder_finish(_encoder) && _isOk;
+    FLAC__stream_encoder_delete(_encoder);
+    _encoder = nullptr;
+    delete [] _buffer;
+    _buffer = nullptr;
+    return _isOk;
+}
@@ -1,7 +1,7 @@
 /***************************************************************************
 **                                                                        **
 **  Polyphone, a soundfont editor                                         **
-**  Copyright (C) 2013-2020 Davy Triponney                                **
+**  Copyright (C) 2013-2019 Davy Triponney                                **
 **                                                                        **
 **  This program is free software: you can redistribute it and/or modify  **
 **  it under the terms of the GNU General Public License as published by  **
@@ -22,31 +22,36 @@
 **             Date: 01.01.2013                                           **
 ***************************************************************************/
 
-#ifndef CONTROLLEREVENT_H
-#define CONTROLLEREVENT_H
 
-#include <QEvent>
+#ifndef SAMPLEWRITERFLAC_H
+#define SAMPLEWRITERFLAC_H
 
-class ControllerEvent : public QEvent
+#include "basetypes.h"
+#include "infosound.h"
+struct FLAC__StreamEncoder;
+
+class SampleWriterFlac
 {
 public:
-    ControllerEvent(unsigned char numController, unsigned char value) : QEvent((QEvent::Type)(QEvent::User+1)),
-          _numController(numController),
-          _value(value) {}
-
-    unsigned char getNumController() const
-    {
-        return _numController;
-    }
-
-    unsigned char getValue() const
-    {
-        return _value;
-    }
-
-protected:
-    unsigned char _numController;
-    unsigned char _value;
+    SampleWriterFlac(QString fileName);
+    ~SampleWriterFlac();
+
+    // Write interleaved little-endian data (16 or 24 bits), return false if the file couldn't be written
+    bool write(QByteArray &baData, InfoSound &info);
+
+    // Same but block after block
+    bool open(InfoSound &info);
+    bool append(const QByteArray &baData);
+    bool close();
+
+private:
+    QString _fileName;
+    FLAC__StreamEncoder * _encoder;
+    qint32 * _buffer;
+    int _channelNumber, _bytesPerValue;
+    bool _isOk;
+
+    static const quint32 BLOCK_SIZE; // In frames
 };
 
-#endif // CONTROLLEREVENT_H
+#endif // SAMPLEWRITERFLAC_H
@@ -26,11 +26,19 @@
 #include "sampleutils.h"
 
 SampleWriterWav::SampleWriterWav(QString fileName) :
-    _fileName(fileName)
+    _fileName(fileName),
+    _file(nullptr),
+    _dataLength(0),
+    _isOk(false)
 {
 
 }
 
+SampleWriterWav::~SampleWriterWav()
+{
+    close();
+}
+
 void SampleWriterWav::write(Sound * sound)
 {
     // Exportation d'un sample mono au format wav
@@ -109,25 +117,89 @@ void SampleWriterWav::write(Sound *leftSound, Sound *rightSound)
     write(baData, info);
 }
 
-void SampleWriterWav::write(QByteArray &baData, InfoSound &info)
+bool SampleWriterWav::write(QByteArray &baData, InfoSound &info)
 {
     // Création d'un fichier
     QFile fi(_fileName);
     if (!fi.open(QIODevice::WriteOnly))
-        return;
+        return false;
+
+    // Ecriture
+    QDataStream out(&fi);
+    out.setByteOrder(QDataStream::LittleEndian);
+    writeHeader(out, info, static_cast<quint32>(baData.size()));
+    out.writeRawData(baData.constData(), baData.size());
+
+    // Fermeture du fichier
+    fi.close();
+    return out.status() == QDataStream::Ok;
+}
+
+bool SampleWriterWav::open(InfoSound &info)
+{
+    close();
+    _file = new QFile(_fileName);
+    if (!_file->open(QIODevice::WriteOnly))
+    {
+        delete _file;
+        _file = nullptr;
+        return false;
+    }
+
+    // Length completed when closing
+    QDataStream out(_file);
+    out.setByteOrder(QDataStream::LittleEndian);
+    writeHeader(out, info, 0);
+    _dataLength = 0;
+    _isOk = (out.status() == QDataStream::Ok);
+    return _isOk;
+}
 
+bool SampleWriterWav::append(const QByteArray &baData)
+{
+    if (_file == nullptr || !_isOk)
+        return false;
+
+    // The length of a wav file is stored with 32 bits
+    _dataLength += static_cast<quint64>(baData.size());
+    if (_file->pos() + baData.size() > 0xFFFFFFFFLL || _file->write(baData) != baData.size())
+        _isOk = false;
+    return _isOk;
+}
+
+bool SampleWriterWav::close()
+{
+    if (_file == nullptr)
+        return false;
+
+    // Size of the file and of the data (at the end of the header)
+    if (_isOk)
+    {
+        qint64 headerSize = _file->pos() - static_cast<qint64>(_dataLength);
+        QDataStream out(_file);
+        out.setByteOrder(QDataStream::LittleEndian);
+        _file->seek(4);
+        out << static_cast<quint32>(_file->size() - 8);
+        _file->seek(headerSize - 4);
+        out << static_cast<quint32>(_dataLength);
+        _isOk = (out.status() == QDataStream::Ok);
+    }
+    _file->close();
+    delete _file;
+    _file = nullptr;
+    return _isOk;
+}
+
+void SampleWriterWav::writeHeader(QDataStream &out, InfoSound &info, quint32 dwLength)
+{
     bool withLoop = !info.loops.empty();
 
-    // Ecriture
     quint32 dwTemp;
     quint16 wTemp;
-    QDataStream out(&fi);
-    out.setByteOrder(QDataStream::LittleEndian);
     quint32 dwTailleFmt = 18;
     quint32 dwTailleSmpl = 36;
     if (withLoop)
         dwTailleSmpl += 24;
-    quint32 dwLength = static_cast<quint32>(baData.size());
     dwTemp = dwLength + dwTailleFmt + dwTailleSmpl + 12 + 8 + 8;
 
     // Entete
@@ -220,8 +292,4 @@ void SampleWriterWav::write(QByteArray &baData, InfoSound &info)
     ///////////// BLOC DATA /////////////
     out.writeRawData("data", 4);
     out << dwLength;
-    out.writeRawData(baData.constData(), baData.size());
-
-    // Fermeture du fichier
-    fi.close();
 }
@@ -27,19 +27,33 @@
 
 #include "basetypes.h"
 #include "sound.h"
+class QFile;
+class QDataStream;
 
 class SampleWriterWav
 {
 public:
     SampleWriterWav(QString fileName);
+    ~SampleWriterWav();
 
     void write(Sound *sound);
     void write(Sound *leftSound, Sound *rightSound);
 
+    // Write interleaved little-endian data, return false if the file couldn't be written
+    bool write(QByteArray &baData, InfoSound &info);
+
+    // Same but block after block, the length being written in the header when closing
+    bool open(InfoSound &info);
+    bool append(const QByteArray &baData);
+    bool close();
+
 private:
-    void write(QByteArray &baData, InfoSound &info);
+    void writeHeader(QDataStream &out, InfoSound &info, quint32 dwLength);
 
     QString _fileName;
+    QFile * _file;
+    quint64 _dataLength;
+    bool _isOk;
 };
 
 #endif // SAMPLEWRITERWAV_H
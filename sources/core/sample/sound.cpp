@@ -35,13 +35,17 @@
 #include "sampleutils.h"
 #include "samplereader.h"
 #include "samplereaderfactory.h"
+#include "samplemapping.h"
+#include "streamedsample.h"
 
 Sound::Sound(QString filename, bool tryFindRootkey) :
+    _streamedPreloadDuration(0),
     _reader(nullptr)
 {
     // Initialize data
     _sm24.clear();
     _smpl.clear();
+    _data32.clear();
     if (!filename.isEmpty())
         this->setFileName(filename, tryFindRootkey);
 }
@@ -54,6 +58,14 @@ Sound::~Sound()
 void Sound::setFileName(QString qStr, bool tryFindRootKey)
 {
     _fileName = qStr;
+    _streamedSample.clear();
+
+    // Data viewed in the previous file will be viewed in the new one, edited data is kept
+    if (isMapped(_smpl))
+        _smpl.clear();
+    if (isMapped(_sm24))
+        _sm24.clear();
+    _mapping.clear();
 
     // Initialize the reader
     if (_reader != nullptr)
@@ -100,18 +112,31 @@ QByteArray Sound::getData(quint16 wBps)
     // wBps =  8 : chargement sm24, 8 bits suivant le 16 de poids fort
     // wBps = 24 : chargement 24 bits de poids fort
     // wBps = 32 : chargement en 32 bits
+    QMutexLocker locker(&_mutexData);
 
     if (_reader != nullptr)
     {
-        // Possibly load 16 bits
+        // Possibly load 16 bits, viewed in the file without copy if possible
         if (_smpl.isEmpty() && wBps != 8)
-            _reader->getData16(_smpl);
+        {
+            QSharedPointer<SampleMapping> mapping = _reader->mapData16(_smpl);
+            if (mapping.isNull())
+                _reader->getData16(_smpl);
+            else
+                _mapping = mapping;
+        }
 
         // Possibly load the 8 extra bits
         if (_sm24.isEmpty() && wBps != 16)
         {
             if (_info.wBpsFile > 16)
-                _reader->getExtraData24(_sm24);
+            {
+                QSharedPointer<SampleMapping> mapping = _reader->mapExtraData24(_sm24);
+                if (mapping.isNull())
+                    _reader->getExtraData24(_sm24);
+                else
+                    _mapping = mapping;
+            }
             else
             {
                 // Fill with 0
@@ -142,6 +167,7 @@ QByteArray Sound::getData(quint16 wBps)
                 _sm24[i] = 0;
         }
     }
+    releaseMapping(); // A resized view has been copied
 
     // Compute the result
     QByteArray baRet;
@@ -149,19 +175,20 @@ QByteArray Sound::getData(quint16 wBps)
     {
     case 8:
         // Load the 8 extra bits
-        baRet = this->_sm24;
+        // A view is copied, the result being possibly kept longer than the mapping (undo, other soundfont, ...)
+        baRet = isMapped(_sm24) ? QByteArray(_sm24.constData(), _sm24.size()) : _sm24;
         break;
     case 16:
         // Load 16 bits
-        baRet = this->_smpl;
+        baRet = isMapped(_smpl) ? QByteArray(_smpl.constData(), _smpl.size()) : _smpl;
         break;
     case 24:
         // Concat 16 bits and 8 bits
         baRet.resize(static_cast<int>(_info.dwLength) * 3);
     {
         char * cDest = baRet.data();
-        char * cFrom = _smpl.data();
-        char * cFrom24 = _sm24.data();
+        const char * cFrom = _smpl.constData();
+        const char * cFrom24 = _sm24.constData();
         unsigned int len = _info.dwLength;
         for (unsigned int i = 0; i < len; i++)
         {
@@ -173,20 +200,23 @@ QByteArray Sound::getData(quint16 wBps)
         break;
     case 32:
         // Concat 16 bits, 8 bits, and null values
-        baRet.resize(static_cast<int>(_info.dwLength) * 4);
-    {
-        char * cDest = baRet.data();
-        char * cFrom = _smpl.data();
-        char * cFrom24 = _sm24.data();
-        unsigned int len = _info.dwLength;
-        for (unsigned int i = 0; i < len; i++)
+        // The result is kept and shared by all voices playing the sample, until the data changes
+        if (_data32.isEmpty())
         {
-            cDest[4*i] = 0;
-            cDest[4*i+1] = cFrom24[i];
-            cDest[4*i+2] = cFrom[2*i];
-            cDest[4*i+3] = cFrom[2*i+1];
+            _data32.resize(static_cast<int>(_info.dwLength) * 4);
+            char * cDest = _data32.data();
+            const char * cFrom = _smpl.constData();
+            const char * cFrom24 = _sm24.constData();
+            unsigned int len = _info.dwLength;
+            for (unsigned int i = 0; i < len; i++)
+            {
+                cDest[4*i] = 0;
+                cDest[4*i+1] = cFrom24[i];
+                cDest[4*i+2] = cFrom[2*i];
+                cDest[4*i+3] = cFrom[2*i+1];
+            }
         }
-    }
+        baRet = _data32;
         break;
     default:
         QMessageBox::warning(QApplication::activeWindow(), QObject::tr("Warning"), "Error in Sound::getData.");
@@ -195,6 +225,51 @@ QByteArray Sound::getData(quint16 wBps)
     return baRet;
 }
 
+bool Sound::getFileRange(quint16 wBps, quint32 &start, quint32 &length)
+{
+    QMutexLocker locker(&_mutexData);
+    if (_reader == nullptr)
+        return false;
+
+    // Data edited in memory must be written from memory (a view in the file is not an edition)
+    switch (wBps)
+    {
+    case 16:
+        if (!_smpl.isEmpty() && !isMapped(_smpl))
+            return false;
+        return _reader->getFileRange16(start, length);
+    case 8:
+        if (!_sm24.isEmpty() && !isMapped(_sm24))
+            return false;
+        return _reader->getFileRangeExtra24(start, length);
+    default:
+        return false;
+    }
+}
+
+QSharedPointer<StreamedSample> Sound::getStreamedSample(quint32 preloadDuration)
+{
+    QMutexLocker locker(&_mutexData);
+
+    // Data edited in memory: nothing to stream (a view in the file can still be streamed)
+    if ((!_smpl.isEmpty() && !isMapped(_smpl)) || _reader == nullptr)
+    {
+        _streamedSample.clear();
+        return _streamedSample;
+    }
+
+    // Resident parts loaded once, as long as the sample is not modified
+    if (_streamedSample.isNull() || _streamedPreloadDuration != preloadDuration)
+    {
+        _streamedPreloadDuration = preloadDuration;
+        _streamedSample = QSharedPointer<StreamedSample>(new StreamedSample(
+                    _fileName, _info, static_cast<quint32>(static_cast<quint64>(preloadDuration) * _info.dwSampleRate / 1000)));
+    }
+
+    // Kept even if not valid (format not allowing partial reads), so that the file is not opened for each voice
+    return _streamedSample->isValid() ? _streamedSample : QSharedPointer<StreamedSample>();
+}
+
 quint32 Sound::getUInt32(AttributeType champ)
 {
     quint32 result = 0;
@@ -255,6 +330,10 @@ qint32 Sound::getInt32(AttributeType champ)
 
 void Sound::setData(QByteArray data, quint16 wBps)
 {
+    // The 32-bit version must be computed again
+    _data32.clear();
+    _streamedSample.clear();
+
     if (wBps == 8)
     {
         // Remplacement des données 17-24 bits
@@ -267,10 +346,17 @@ void Sound::setData(QByteArray data, quint16 wBps)
     }
     else
         QMessageBox::warning(QApplication::activeWindow(), "warning", "In Sound::setData, forbidden operation");
+
+    // The file is possibly not viewed anymore
+    releaseMapping();
 }
 
 void Sound::set(AttributeType champ, AttributeValue value)
 {
+    // The resident parts of a streamed sample depend on the positions and on the format
+    if (champ != champ_byOriginalPitch && champ != champ_chPitchCorrection)
+        _streamedSample.clear();
+
     switch (champ)
     {
     case champ_dwStart16:
@@ -284,6 +370,7 @@ void Sound::set(AttributeType champ, AttributeValue value)
     case champ_dwLength:
         // modification de la longueur
         _info.dwLength = value.dwValue;
+        _data32.clear();
         break;
     case champ_dwStartLoop:
         // modification du début de la boucle
@@ -315,7 +402,11 @@ void Sound::set(AttributeType champ, AttributeValue value)
         // modification de la résolution
         _info.wBpsFile = value.wValue;
         if (value.wValue < 24)
+        {
             this->_sm24.clear();
+            _data32.clear();
+            releaseMapping();
+        }
         break;
     case champ_byOriginalPitch:
         // Modification de la note en demi tons
@@ -334,22 +425,36 @@ void Sound::setRam(bool ram)
 {
     if (ram)
     {
-        // Load the 16 strong bits
-        if (this->_smpl.isEmpty())
+        // Load the 16 strong bits (copied if viewed in the file)
+        if (this->_smpl.isEmpty() || isMapped(_smpl))
             this->_smpl = this->getData(16);
 
         // Load the extra 8 bits
-        if (this->_sm24.isEmpty() && _info.wBpsFile >= 24)
+        if ((this->_sm24.isEmpty() || isMapped(_sm24)) && _info.wBpsFile >= 24)
             this->_sm24 = this->getData(8);
+        releaseMapping();
     }
     else
     {
         // Clear data
         this->_smpl.clear();
         this->_sm24.clear();
+        this->_data32.clear();
+        _mapping.clear();
     }
 }
 
+bool Sound::isMapped(const QByteArray &data)
+{
+    return !_mapping.isNull() && _mapping->contains(data);
+}
+
+void Sound::releaseMapping()
+{
+    if (!isMapped(_smpl) && !isMapped(_sm24))
+        _mapping.clear();
+}
+
 void Sound::determineRootKey()
 {
     // Try to find the root key with the help of the file name
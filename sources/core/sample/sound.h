@@ -27,10 +27,14 @@
 
 #include "basetypes.h"
 #include "infosound.h"
+#include <QSharedPointer>
+#include <QMutex>
 
 class QFile;
 class QWidget;
 class SampleReader;
+class SampleMapping;
+class StreamedSample;
 
 class Sound
 {
@@ -42,6 +46,13 @@ public:
     InfoSound getInfo() { return _info; }
     QString getFileName() { return this->_fileName; }
     QByteArray getData(quint16 wBps);
+
+    // Bytes of the file "getFileName()" that can be copied as is in a soundfont, if the data is not edited
+    // wBps = 16: 16 most significant bits, wBps = 8: 8 extra bits
+    bool getFileRange(quint16 wBps, quint32 &start, quint32 &length);
+
+    // Sample read from the disk while being played, null if the data is already loaded or cannot be streamed
+    QSharedPointer<StreamedSample> getStreamedSample(quint32 preloadDuration); // Duration in ms
     quint32 getUInt32(AttributeType champ); // For everything but the pitch correction
     qint32 getInt32(AttributeType champ); // For the pitch correction
 
@@ -54,11 +65,18 @@ public:
 private:
     QString _fileName;
     InfoSound _info;
-    QByteArray _smpl;
-    QByteArray _sm24;
+    QByteArray _smpl; // Possibly a read-only view in _mapping, until the sample is edited
+    QByteArray _sm24; // Same
+    QSharedPointer<SampleMapping> _mapping; // Mapping of the file, kept while _smpl or _sm24 is viewed in it
+    QByteArray _data32; // Implicitly shared with the voices, built on demand
+    QSharedPointer<StreamedSample> _streamedSample; // Also shared with the voices
+    quint32 _streamedPreloadDuration;
     SampleReader * _reader;
+    QMutex _mutexData; // Data loaded on demand, possibly by several readers at the same time
 
     void determineRootKey();
+    bool isMapped(const QByteArray &data);
+    void releaseMapping();
 };
 
 #endif // SOUND_H
@@ -0,0 +1,128 @@
+/***************************************************************************
+**                                                                        **
+**  Polyphone, a soundfont editor                                         **
+**  Copyright (C) 2013-2019 Davy Triponney                                **
+**                                                                        **
+**  This program is free software: you can redistribute it and/or modify  **
+**  it under the terms of the GNU General Public License as published by  **
+**  the Free Software Foundation, either version 3 of the License, or     **
+**  (at your option) any later version.                                   **
+**                                                                        **
+**  This program is distributed in the hope that it will be useful,       **
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of        **
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the          **
+**  GNU General Public License for more details.                          **
+**                                                                        **
+**  You should have received a copy of the GNU General Public License     **
+**  along with this program. If not, see http://www.gnu.org/licenses/.    **
+**                                                                        **
+****************************************************************************
+**           Author: Davy Triponney                                       **
+**  Website/Contact: https://www.polyphone-soundfonts.com                 **
+**             Date: 01.01.2013                                           **
+***************************************************************************/
+
+
+#include "streamedsample.h"
+#include "samplereader.h"
+#include "samplereaderfactory.h"
+
+const quint32 StreamedSample::MAX_LOOP_DURATION = 10;
+
+StreamedSample::StreamedSample(QString fileName, const InfoSound &info, quint32 preloadLength) :
+    _fileName(fileName),
+    _info(info),
+    _readerInfo(info),
+    _reader(SampleReaderFactory::getSampleReader(fileName)),
+    _isValid(false),
+    _headLength(qMin(preloadLength, info.dwLength)),
+    _loopStart(info.dwLength),
+    _loopEnd(info.dwLength)
+{
+    // The reader keeps a pointer to the info it parsed
+    if (_reader == nullptr || !_reader->canReadRanges() || _reader->getInfo(_readerInfo) != SampleReader::FILE_OK)
+        return;
+
+    // Resident loop, the part already in the head being excluded
+    if (!_info.loops.empty())
+    {
+        quint32 loopStart = qMax(_info.loops[0].first, _headLength);
+        quint32 loopEnd = qMin(_info.loops[0].second, _info.dwLength);
+        if (loopStart < loopEnd && loopEnd - loopStart <= MAX_LOOP_DURATION * _info.dwSampleRate)
+        {
+            _loopStart = loopStart;
+            _loopEnd = loopEnd;
+        }
+    }
+
+    // Load the resident parts
+    QFile file(_fileName);
+    if (!file.open(QFile::ReadOnly))
+        return;
+    _head.resize(static_cast<int>(_headLength * 4));
+    _loop.resize(static_cast<int>((_loopEnd - _loopStart) * 4));
+    _isValid = readData(file, 0, _headLength, reinterpret_cast<qint32 *>(_head.data())) &&
+            readData(file, _loopStart, _loopEnd - _loopStart, reinterpret_cast<qint32 *>(_loop.data()));
+    file.close();
+}
+
+StreamedSample::~StreamedSample()
+{
+    delete _reader;
+}
+
+quint32 StreamedSample::getResident(quint32 position, const qint32 *&data)
+{
+    if (position < _headLength)
+    {
+        data = &reinterpret_cast<const qint32 *>(_head.constData())[position];
+        return _headLength - position;
+    }
+    if (position >= _loopStart && position < _loopEnd)
+    {
+        data = &reinterpret_cast<const qint32 *>(_loop.constData())[position - _loopStart];
+        return _loopEnd - position;
+    }
+    return 0;
+}
+
+bool StreamedSample::read(QFile &file, quint32 position, quint32 length, qint32 *data)
+{
+    while (length > 0)
+    {
+        const qint32 * resident;
+        quint32 count = getResident(position, resident);
+        if (count > 0)
+        {
+            // Values in memory
+            count = qMin(count, length);
+            memcpy(data, resident, count * sizeof(qint32));
+        }
+        else if (position >= _info.dwLength)
+        {
+            // After the end
+            memset(data, 0, length * sizeof(qint32));
+            break;
+        }
+        else
+        {
+            // Values read from the file, until the resident loop or the end
+            count = qMin(length, (position < _loopStart ? _loopStart : _info.dwLength) - position);
+            if (!readData(file, position, count, data))
+                return false;
+        }
+
+        position += count;
+        data += count;
+        length -= count;
+    }
+
+    return true;
+}
+
+bool StreamedSample::readData(QFile &file, quint32 start, quint32 length, qint32 *data)
+{
+    if (length == 0)
+        return true;
+    return _reader->getData32(file, _info, start, length, data) == SampleReader::FILE_OK;
+}
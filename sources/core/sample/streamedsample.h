@@ -0,0 +1,69 @@
+/***************************************************************************
+**                                                                        **
+**  Polyphone, a soundfont editor                                         **
+**  Copyright (C) 2013-2019 Davy Triponney                                **
+**                                                                        **
+**  This program is free software: you can redistribute it and/or modify  **
+**  it under the terms of the GNU General Public License as published by  **
+**  the Free Software Foundation, either version 3 of the License, or     **
+**  (at your option) any later version.                                   **
+**                                                                        **
+**  This program is distributed in the hope that it will be useful,       **
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of        **
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the          **
+**  GNU General Public License for more details.                          **
+**                                                                        **
+**  You should have received a copy of the GNU General Public License     **
+**  along with this program. If not, see http://www.gnu.org/licenses/.    **
+**                                                                        **
+****************************************************************************
+**           Author: Davy Triponney                                       **
+**  Website/Contact: https://www.polyphone-soundfonts.com                 **
+**             Date: 01.01.2013                                           **
+***************************************************************************/
+
+
+#ifndef STREAMEDSAMPLE_H
+#define STREAMEDSAMPLE_H
+
+#include "infosound.h"
+class SampleReader;
+class QFile;
+
+// Sample played from the disk: only the beginning and the loop are resident in memory
+// The other values are read by the streaming thread, following the positions played by each voice
+class StreamedSample
+{
+public:
+    // "preloadLength" values are resident at the beginning
+    StreamedSample(QString fileName, const InfoSound &info, quint32 preloadLength);
+    ~StreamedSample();
+
+    bool isValid() { return _isValid; }
+    QString getFileName() { return _fileName; }
+    quint32 getLength() { return _info.dwLength; }
+    quint32 getHeadLength() { return _headLength; }
+
+    // Number of consecutive resident values from "position" (0 if not resident) and pointer to them
+    quint32 getResident(quint32 position, const qint32 *&data);
+
+    // Copy "length" values from "position", from memory if resident or from the file (only by the streaming thread)
+    // Values after the end are 0
+    bool read(QFile &file, quint32 position, quint32 length, qint32 *data);
+
+    static const quint32 MAX_LOOP_DURATION; // In seconds, longer loops are not resident
+
+private:
+    bool readData(QFile &file, quint32 start, quint32 length, qint32 *data);
+
+    QString _fileName;
+    InfoSound _info, _readerInfo;
+    SampleReader * _reader;
+    bool _isValid;
+
+    // Resident values: [0, _headLength[ and [_loopStart, _loopEnd[ (loop of the sample)
+    QByteArray _head, _loop;
+    quint32 _headLength, _loopStart, _loopEnd;
+};
+
+#endif // STREAMEDSAMPLE_H
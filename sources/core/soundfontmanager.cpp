@@ -62,7 +62,6 @@ QAbstractItemModel * SoundfontManager::getModel(int indexSf2)
 SoundfontManager::SoundfontManager() :
     _soundfonts(new Soundfonts()),
     _undoRedo(new ActionManager()),
-    _mutex(QMutex::Recursive),
     _solo(new SoloManager(this))
 {
     connect(_undoRedo, SIGNAL(dropId(EltID)), this, SLOT(onDropId(EltID)));
@@ -78,20 +77,20 @@ SoundfontManager::~SoundfontManager()
 // Ajout / suppression des données
 void SoundfontManager::remove(EltID id, int *message)
 {
-    QMutexLocker locker(&_mutex);
+    WriteLocker locker(editLock());
     this->remove(id, false, true, message);
 }
 
 void SoundfontManager::onDropId(EltID id)
 {
-    QMutexLocker locker(&_mutex);
+    WriteLocker locker(editLock());
     this->remove(id, true, false);
 }
 
 // Accès / modification des propriétés
 bool SoundfontManager::isSet(EltID id, AttributeType champ)
 {
-    QMutexLocker locker(&_mutex);
+    ReadLocker locker(&_lock);
     bool value = false;
     if (!this->isValid(id))
         return value;
@@ -160,7 +159,7 @@ bool SoundfontManager::isSet(EltID id, AttributeType champ)
 
 AttributeValue SoundfontManager::get(EltID id, AttributeType champ)
 {
-    QMutexLocker locker(&_mutex);
+    ReadLocker locker(&_lock);
     AttributeValue value;
     value.dwValue = 0;
     if (!this->isValid(id))
@@ -331,7 +330,7 @@ AttributeValue SoundfontManager::get(EltID id, AttributeType champ)
 
 Sound * SoundfontManager::getSound(EltID id)
 {
-    QMutexLocker locker(&_mutex);
+    ReadLocker locker(&_lock);
     Sound * son = nullptr;
     if (!this->isValid(id))
         return son;
@@ -344,7 +343,7 @@ Sound * SoundfontManager::getSound(EltID id)
 
 QString SoundfontManager::getQstr(EltID id, AttributeType champ)
 {
-    QMutexLocker locker(&_mutex);
+    ReadLocker locker(&_lock);
     if (!this->isValid(id))
         return "";
 
@@ -435,7 +434,7 @@ QString SoundfontManager::getQstr(EltID id, AttributeType champ)
 
 QByteArray SoundfontManager::getData(EltID id, AttributeType champ)
 {
-    QMutexLocker locker(&_mutex);
+    ReadLocker locker(&_lock);
     QByteArray baRet;
     if (!this->isValid(id))
         return baRet;
@@ -470,132 +469,40 @@ QByteArray SoundfontManager::getData(EltID id, AttributeType champ)
     return baRet;
 }
 
-QList<int> SoundfontManager::getSiblings(EltID &id)
+QSharedPointer<StreamedSample> SoundfontManager::getStreamedSample(EltID id, quint32 preloadDuration)
 {
-    QMutexLocker locker(&_mutex);
+    ReadLocker locker(&_lock);
+    if (!this->isValid(id) || id.typeElement != elementSmpl)
+        return QSharedPointer<StreamedSample>();
+    return _soundfonts->getSoundfont(id.indexSf2)->getSample(id.indexElt)->_sound.getStreamedSample(preloadDuration);
+}
 
+QList<int> SoundfontManager::getSiblings(EltID &id)
+{
     QList<int> result;
-    if (!this->isValid(id, true, true))
-        return result;
+    SiblingIterator i(this, id);
+    while (i.hasNext())
+        result << i.next();
+    return result;
+}
 
-    switch (id.typeElement)
+int SoundfontManager::getSiblingCount(EltID &id)
+{
+    int count = 0;
+    SiblingIterator i(this, id);
+    while (i.hasNext())
     {
-    case elementSf2:
-        result = _soundfonts->getSoundfonts().keys();
-        break;
-    case elementSmpl: {
-        QVectorIterator<Smpl*> i(_soundfonts->getSoundfont(id.indexSf2)->getSamples().values());
-        while (i.hasNext())
-        {
-            Smpl * elt = i.next();
-            if (!elt->isHidden())
-                result << elt->getId().indexElt;
-        }
-    } break;
-    case elementInst: {
-        QVectorIterator<InstPrst*> i(_soundfonts->getSoundfont(id.indexSf2)->getInstruments().values());
-        while (i.hasNext())
-        {
-            InstPrst* elt = i.next();
-            if (!elt->isHidden())
-                result << elt->getId().indexElt;
-        }
-    } break;
-    case elementPrst: {
-        QVectorIterator<InstPrst*> i(_soundfonts->getSoundfont(id.indexSf2)->getPresets().values());
-        while (i.hasNext())
-        {
-            InstPrst* elt = i.next();
-            if (!elt->isHidden())
-                result << elt->getId().indexElt;
-        }
-    } break;
-    case elementInstSmpl: {
-        QVectorIterator<Division*> i(_soundfonts->getSoundfont(id.indexSf2)->getInstrument(id.indexElt)->getDivisions().values());
-        while (i.hasNext())
-        {
-            Division* elt = i.next();
-            if (!elt->isHidden())
-                result << elt->getId().indexElt2;
-        }
-    } break;
-    case elementPrstInst: {
-        QVectorIterator<Division*> i(_soundfonts->getSoundfont(id.indexSf2)->getPreset(id.indexElt)->getDivisions().values());
-        while (i.hasNext())
-        {
-            Division* elt = i.next();
-            if (!elt->isHidden())
-                result << elt->getId().indexElt2;
-        }
-    } break;
-    case elementInstMod: {
-        QVectorIterator<Modulator*> i(_soundfonts->getSoundfont(id.indexSf2)->getInstrument(id.indexElt)->getGlobalDivision()->getMods().values());
-        while (i.hasNext())
-        {
-            Modulator* elt = i.next();
-            if (!elt->isHidden())
-                result << elt->_id;
-        }
-    } break;
-    case elementPrstMod: {
-        QVectorIterator<Modulator*> i(_soundfonts->getSoundfont(id.indexSf2)->getPreset(id.indexElt)->getGlobalDivision()->getMods().values());
-        while (i.hasNext())
-        {
-            Modulator* elt = i.next();
-            if (!elt->isHidden())
-                result << elt->_id;
-        }
-    } break;
-    case elementInstSmplMod: {
-        QVectorIterator<Modulator*> i(_soundfonts->getSoundfont(id.indexSf2)->getInstrument(id.indexElt)->getDivision(id.indexElt2)->getMods().values());
-        while (i.hasNext())
-        {
-            Modulator* elt = i.next();
-            if (!elt->isHidden())
-                result << elt->_id;
-        }
-    } break;
-    case elementPrstInstMod: {
-        QVectorIterator<Modulator*> i(_soundfonts->getSoundfont(id.indexSf2)->getPreset(id.indexElt)->getDivision(id.indexElt2)->getMods().values());
-        while (i.hasNext())
-        {
-            Modulator* elt = i.next();
-            if (!elt->isHidden())
-                result << elt->_id;
-        }
-    } break;
-    case elementInstGen: {
-        QListIterator<AttributeType> i(_soundfonts->getSoundfont(id.indexSf2)->getInstrument(id.indexElt)->getGlobalDivision()->getGens().keys());
-        while (i.hasNext())
-            result << (int)i.next();
-    } break;
-    case elementPrstGen: {
-        QListIterator<AttributeType> i(_soundfonts->getSoundfont(id.indexSf2)->getPreset(id.indexElt)->getGlobalDivision()->getGens().keys());
-        while (i.hasNext())
-            result << (int)i.next();
-    } break;
-    case elementInstSmplGen: {
-        QListIterator<AttributeType> i(_soundfonts->getSoundfont(id.indexSf2)->getInstrument(id.indexElt)->getDivision(id.indexElt2)->getGens().keys());
-        while (i.hasNext())
-            result << (int)i.next();
-    } break;
-    case elementPrstInstGen: {
-        QListIterator<AttributeType> i(_soundfonts->getSoundfont(id.indexSf2)->getPreset(id.indexElt)->getDivision(id.indexElt2)->getGens().keys());
-        while (i.hasNext())
-            result << (int)i.next();
-    } break;
-    default:
-        break;
+        i.next();
+        count++;
     }
-
-    return result;
+    return count;
 }
 
 /// ACTION MANAGER ///
 
 void SoundfontManager::endEditing(QString editingSource)
 {
-    QMutexLocker locker(&_mutex);
+    WriteLocker locker(editLock());
 
     // Close the action set and get the list of sf2 that have been edited
     QList<int> sf2Indexes = _undoRedo->commitActionSet();
@@ -605,32 +512,32 @@ void SoundfontManager::endEditing(QString editingSource)
 
 void SoundfontManager::clearNewEditing()
 {
-    QMutexLocker locker(&_mutex);
+    WriteLocker locker(editLock());
     _undoRedo->clearCurrentActionSet();
 }
 
 void SoundfontManager::revertNewEditing()
 {
-    QMutexLocker locker(&_mutex);
+    WriteLocker locker(editLock());
     undo(_undoRedo->getCurrentActions());
     _undoRedo->clearCurrentActionSet();
 }
 
 bool SoundfontManager::isUndoable(int indexSf2)
 {
-    QMutexLocker locker(&_mutex);
+    ReadLocker locker(&_lock);
     return _undoRedo->isUndoable(indexSf2);
 }
 
 bool SoundfontManager::isRedoable(int indexSf2)
 {
-    QMutexLocker locker(&_mutex);
+    ReadLocker locker(&_lock);
     return _undoRedo->isRedoable(indexSf2);
 }
 
 void SoundfontManager::undo(int indexSf2)
 {
-    QMutexLocker locker(&_mutex);
+    WriteLocker locker(editLock());
     QList<int> sf2Indexes = undo(_undoRedo->undo(indexSf2));
     if (!sf2Indexes.empty())
         emit(editingDone("command:undo", sf2Indexes));
@@ -680,7 +587,7 @@ QList<int> SoundfontManager::undo(QList<Action *> actions)
 
 void SoundfontManager::redo(int indexSf2)
 {
-    QMutexLocker locker(&_mutex);
+    WriteLocker locker(editLock());
     QList<Action *> actions = _undoRedo->redo(indexSf2);
 
     // Process actions in reverse order
@@ -728,73 +635,41 @@ void SoundfontManager::redo(int indexSf2)
 
 void SoundfontManager::markAsSaved(int indexSf2)
 {
-    QMutexLocker locker(&_mutex);
+    WriteLocker locker(editLock());
     _soundfonts->getSoundfont(indexSf2)->_numEdition = this->_undoRedo->getEdition(indexSf2);
     emit(editingDone("command:save", QList<int>() << indexSf2));
 }
 
 bool SoundfontManager::isEdited(int indexSf2)
 {
-    QMutexLocker locker(&_mutex);
+    ReadLocker locker(&_lock);
     if (_soundfonts->getSoundfont(indexSf2) == nullptr)
         return false;
     return this->_undoRedo->getEdition(indexSf2) != _soundfonts->getSoundfont(indexSf2)->_numEdition ||
             !this->getQstr(EltID(elementSf2, indexSf2), champ_filenameInitial).toLower().endsWith(".sf2");
 }
 
-void SoundfontManager::getAllAttributes(EltID id, QList<AttributeType> &listeChamps, QList<AttributeValue> &listeValeurs)
+QMap<AttributeType, AttributeValue> SoundfontManager::getAttributes(EltID id)
 {
-    QMutexLocker locker(&_mutex);
+    ReadLocker locker(&_lock);
     if (!this->isValid(id))
-        return;
+        return QMap<AttributeType, AttributeValue>();
 
-    Division * division = nullptr;
-    switch (id.typeElement)
-    {
-    case elementInst:
-        division = _soundfonts->getSoundfont(id.indexSf2)->getInstrument(id.indexElt)->getGlobalDivision();
-        break;
-    case elementInstSmpl:
-        division = _soundfonts->getSoundfont(id.indexSf2)->getInstrument(id.indexElt)->getDivision(id.indexElt2);
-        break;
-    case elementPrst:
-        division = _soundfonts->getSoundfont(id.indexSf2)->getPreset(id.indexElt)->getGlobalDivision();
-        break;
-    case elementPrstInst:
-        division = _soundfonts->getSoundfont(id.indexSf2)->getPreset(id.indexElt)->getDivision(id.indexElt2);
-        break;
-    default:
-        return;
-    }
-
-    listeChamps = division->getGens().keys();
-    listeValeurs = division->getGens().values();
+    Division * division = this->getDivision(id);
+    if (division == nullptr)
+        return QMap<AttributeType, AttributeValue>();
+    return division->getGens();
 }
 
 void SoundfontManager::getAllModulators(EltID id, QList<ModulatorData> &modulators)
 {
-    QMutexLocker locker(&_mutex);
+    ReadLocker locker(&_lock);
     if (!this->isValid(id))
         return;
 
-    Division * division = nullptr;
-    switch (id.typeElement)
-    {
-    case elementInst:
-        division = _soundfonts->getSoundfont(id.indexSf2)->getInstrument(id.indexElt)->getGlobalDivision();
-        break;
-    case elementInstSmpl:
-        division = _soundfonts->getSoundfont(id.indexSf2)->getInstrument(id.indexElt)->getDivision(id.indexElt2);
-        break;
-    case elementPrst:
-        division = _soundfonts->getSoundfont(id.indexSf2)->getPreset(id.indexElt)->getGlobalDivision();
-        break;
-    case elementPrstInst:
-        division = _soundfonts->getSoundfont(id.indexSf2)->getPreset(id.indexElt)->getDivision(id.indexElt2);
-        break;
-    default:
+    Division * division = this->getDivision(id);
+    if (division == nullptr)
         return;
-    }
 
     // Fill the lists with the modulators that are not hidden
     QVector<Modulator *> mods = division->getMods().values();
@@ -806,7 +681,7 @@ void SoundfontManager::getAllModulators(EltID id, QList<ModulatorData> &modulato
 // Add a child to ID
 int SoundfontManager::add(EltID id)
 {
-    QMutexLocker locker(&_mutex);
+    WriteLocker locker(editLock());
     if (!this->isValid(id, false, true))
         return -1;
 
@@ -880,14 +755,72 @@ int SoundfontManager::add(EltID id)
     }
 
     // Create and store an action
-    Action *action = new Action();
-    action->typeAction = Action::TypeCreation;
-    action->id = id;
-    this->_undoRedo->add(action);
+    if (!this->isLoading(id.indexSf2))
+    {
+        Action *action = new Action();
+        action->typeAction = Action::TypeCreation;
+        action->id = id;
+        this->_undoRedo->add(action);
+    }
 
     return i;
 }
 
+int SoundfontManager::beginLoading()
+{
+    WriteLocker locker(editLock());
+    int indexSf2 = _soundfonts->addSoundfont();
+    Soundfont * soundfont = _soundfonts->getSoundfont(indexSf2);
+    soundfont->beginLoading();
+    soundfont->_wBpsInit = 16;
+    soundfont->_wBpsSave = 16;
+    return indexSf2;
+}
+
+Soundfont * SoundfontManager::getSoundfontBeingLoaded(int indexSf2)
+{
+    ReadLocker locker(&_lock);
+    return this->isLoading(indexSf2) ? _soundfonts->getSoundfont(indexSf2) : nullptr;
+}
+
+void SoundfontManager::endLoading(int indexSf2)
+{
+    WriteLocker locker(editLock());
+    if (this->isLoading(indexSf2))
+        _soundfonts->getSoundfont(indexSf2)->endLoading();
+}
+
+bool SoundfontManager::isLoading(int indexSf2)
+{
+    Soundfont * soundfont = _soundfonts->getSoundfont(indexSf2);
+    return soundfont != nullptr && soundfont->isLoading();
+}
+
+Division * SoundfontManager::getDivision(EltID id)
+{
+    switch (id.typeElement)
+    {
+    case elementInst: case elementInstMod: case elementInstGen:
+        return _soundfonts->getSoundfont(id.indexSf2)->getInstrument(id.indexElt)->getGlobalDivision();
+    case elementInstSmpl: case elementInstSmplMod: case elementInstSmplGen:
+        return _soundfonts->getSoundfont(id.indexSf2)->getInstrument(id.indexElt)->getDivision(id.indexElt2);
+    case elementPrst: case elementPrstMod: case elementPrstGen:
+        return _soundfonts->getSoundfont(id.indexSf2)->getPreset(id.indexElt)->getGlobalDivision();
+    case elementPrstInst: case elementPrstInstMod: case elementPrstInstGen:
+        return _soundfonts->getSoundfont(id.indexSf2)->getPreset(id.indexElt)->getDivision(id.indexElt2);
+    default:
+        return nullptr;
+    }
+}
+
+ReadWriteLock * SoundfontManager::editLock()
+{
+    // The lists browsed by an iterator cannot change, and the edition would wait for the iterator forever
+    Q_ASSERT_X(!_iteratorCount.hasLocalData() || _iteratorCount.localData() == 0, "SoundfontManager::editLock",
+               "edition while browsing siblings");
+    return &_lock;
+}
+
 int SoundfontManager::remove(EltID id, bool permanently, bool storeAction, int *message)
 {
     if (!this->isValid(id, permanently)) // Hidden ID are accepted for a permanent removal
@@ -1127,7 +1060,7 @@ int SoundfontManager::remove(EltID id, bool permanently, bool storeAction, int *
     }
 
     // Create and store the action
-    if (storeAction)
+    if (storeAction && !this->isLoading(id.indexSf2))
     {
         Action *action = new Action();
         action->typeAction = Action::TypeRemoval;
@@ -1158,6 +1091,8 @@ void SoundfontManager::supprGenAndStore(EltID id, int storeAction)
     default:
         return;
     }
+    if (this->isLoading(id.indexSf2))
+        storeAction = false;
 
     const QMap<AttributeType, AttributeValue> parameters = division->getGens();
     foreach (AttributeType champ, parameters.keys())
@@ -1179,7 +1114,7 @@ void SoundfontManager::supprGenAndStore(EltID id, int storeAction)
 
 int SoundfontManager::set(EltID id, AttributeType champ, AttributeValue value)
 {
-    QMutexLocker locker(&_mutex);
+    WriteLocker locker(editLock());
     if (!this->isValid(id))
         return 1;
     bool storeAction = true;
@@ -1364,7 +1299,7 @@ int SoundfontManager::set(EltID id, AttributeType champ, AttributeValue value)
         break;
     }
 
-    if (storeAction)
+    if (storeAction && !this->isLoading(id.indexSf2))
     {
         // Create and store the action
         Action *action = new Action();
@@ -1384,7 +1319,7 @@ int SoundfontManager::set(EltID id, AttributeType champ, AttributeValue value)
 
 int SoundfontManager::set(EltID id, AttributeType champ, QString qStr)
 {
-    QMutexLocker locker(&_mutex);
+    WriteLocker locker(editLock());
     if (!this->isValid(id))
         return 1;
 
@@ -1494,20 +1429,23 @@ int SoundfontManager::set(EltID id, AttributeType champ, QString qStr)
     }
 
     // Create and store the action
-    Action *action = new Action();
-    action->typeAction = Action::TypeUpdate;
-    action->id = id;
-    action->champ = champ;
-    action->qOldValue = qOldStr;
-    action->qNewValue = qStr;
-    this->_undoRedo->add(action);
+    if (!this->isLoading(id.indexSf2))
+    {
+        Action *action = new Action();
+        action->typeAction = Action::TypeUpdate;
+        action->id = id;
+        action->champ = champ;
+        action->qOldValue = qOldStr;
+        action->qNewValue = qStr;
+        this->_undoRedo->add(action);
+    }
 
     return 0;
 }
 
 int SoundfontManager::set(EltID id, AttributeType champ, QByteArray data)
 {
-    QMutexLocker locker(&_mutex);
+    WriteLocker locker(editLock());
     if (!this->isValid(id))
         return 1;
 
@@ -1555,20 +1493,23 @@ int SoundfontManager::set(EltID id, AttributeType champ, QByteArray data)
     }
 
     // Création et stockage de l'action
-    Action *action = new Action();
-    action->typeAction = Action::TypeUpdate;
-    action->id = id;
-    action->champ = champ;
-    action->baOldValue = oldData;
-    action->baNewValue = data;
-    this->_undoRedo->add(action);
+    if (!this->isLoading(id.indexSf2))
+    {
+        Action *action = new Action();
+        action->typeAction = Action::TypeUpdate;
+        action->id = id;
+        action->champ = champ;
+        action->baOldValue = oldData;
+        action->baNewValue = data;
+        this->_undoRedo->add(action);
+    }
 
     return 0;
 }
 
 void SoundfontManager::reset(EltID id, AttributeType champ)
 {
-    QMutexLocker locker(&_mutex);
+    WriteLocker locker(editLock());
     if (!this->isValid(id))
         return;
 
@@ -1617,17 +1558,20 @@ void SoundfontManager::reset(EltID id, AttributeType champ)
     }
 
     // Create and store the action
-    Action *action = new Action();
-    action->typeAction = Action::TypeChangeToDefault;
-    action->id = id;
-    action->champ = champ;
-    action->vOldValue = oldValue;
-    _undoRedo->add(action);
+    if (!this->isLoading(id.indexSf2))
+    {
+        Action *action = new Action();
+        action->typeAction = Action::TypeChangeToDefault;
+        action->id = id;
+        action->champ = champ;
+        action->vOldValue = oldValue;
+        _undoRedo->add(action);
+    }
 }
 
 void SoundfontManager::simplify(EltID id, AttributeType champ)
 {
-    QMutexLocker locker(&_mutex);
+    WriteLocker locker(editLock());
     EltID idElement = id;
     if (id.typeElement == elementInst || id.typeElement == elementInstSmpl)
     {
@@ -1741,7 +1685,7 @@ int SoundfontManager::display(EltID id)
 
 bool SoundfontManager::isValid(EltID &id, bool acceptHidden, bool justCheckParentLevel)
 {
-    QMutexLocker locker(&_mutex);
+    ReadLocker locker(&_lock);
     if (id.typeElement < elementSf2 || id.typeElement > elementPrstInstGen)
         return false;
 
@@ -1838,7 +1782,7 @@ bool SoundfontManager::isValid(EltID &id, bool acceptHidden, bool justCheckParen
 
 void SoundfontManager::firstAvailablePresetBank(EltID id, int &nBank, int &nPreset)
 {
-    QMutexLocker locker(&_mutex);
+    ReadLocker locker(&_lock);
     if (nBank != -1 && nPreset != -1)
     {
         // bank et preset par défaut disponibles ?
@@ -1873,7 +1817,7 @@ void SoundfontManager::firstAvailablePresetBank(EltID id, int &nBank, int &nPres
 
 int SoundfontManager::closestAvailablePreset(EltID id, quint16 wBank, quint16 wPreset)
 {
-    QMutexLocker locker(&_mutex);
+    ReadLocker locker(&_lock);
     int initVal = wPreset;
     int delta = 0;
     int sens = 0;
@@ -1899,7 +1843,7 @@ int SoundfontManager::closestAvailablePreset(EltID id, quint16 wBank, quint16 wP
 
 bool SoundfontManager::isAvailable(EltID id, quint16 wBank, quint16 wPreset)
 {
-    QMutexLocker locker(&_mutex);
+    ReadLocker locker(&_lock);
     id.typeElement = elementPrst;
     foreach (int i, this->getSiblings(id))
     {
@@ -1910,3 +1854,154 @@ bool SoundfontManager::isAvailable(EltID id, quint16 wBank, quint16 wPreset)
     }
     return true;
 }
+
+int SoundfontManager::getMidiPreset(int indexSf2, int bank, int program)
+{
+    // Preset matching the bank and program, or the same program in the first bank (general midi),
+    // or the first drum kit if a drum kit is requested, or the preset having the lowest bank / program
+    ReadLocker locker(&_lock);
+    EltID id(elementPrst, indexSf2);
+    int defaultBank = (bank == 128 ? 128 : 0);
+    int bestIndex = -1;
+    int bestScore = 0;
+    int bestKey = 0;
+    foreach (int i, this->getSiblings(id))
+    {
+        id.indexElt = i;
+        int presetBank = this->get(id, champ_wBank).wValue;
+        int presetProgram = this->get(id, champ_wPreset).wValue;
+        if (presetBank == bank && presetProgram == program)
+            return i;
+
+        int score = 1;
+        if (presetBank == defaultBank && presetProgram == program)
+            score = 3;
+        else if (defaultBank == 128 && presetBank == 128 && presetProgram == 0)
+            score = 2;
+
+        // The first preset in the file is kept if several presets share the same bank and program
+        int key = (presetBank << 8) | presetProgram;
+        if (score > bestScore || (score == bestScore && key < bestKey))
+        {
+            bestIndex = i;
+            bestScore = score;
+            bestKey = key;
+        }
+    }
+    return bestIndex;
+}
+
+SiblingIterator::SiblingIterator(SoundfontManager * sm, EltID id) :
+    _sm(sm),
+    _locker(&sm->_lock),
+    _isDivision(id.typeElement == elementInstSmpl || id.typeElement == elementPrstInst),
+    _position(0),
+    _next(-1),
+    _smpls(nullptr),
+    _instPrsts(nullptr),
+    _divisions(nullptr),
+    _mods(nullptr)
+{
+    _sm->_iteratorCount.localData()++;
+    if (!sm->isValid(id, true, true))
+        return;
+
+    // The elements are browsed in place, the lock preventing any change
+    switch (id.typeElement)
+    {
+    case elementSf2: {
+        const QMap<int, Soundfont *> &soundfonts = sm->_soundfonts->getSoundfonts();
+        _sf2 = soundfonts.constBegin();
+        _sf2End = soundfonts.constEnd();
+    } break;
+    case elementSmpl:
+        _smpls = &sm->_soundfonts->getSoundfont(id.indexSf2)->getSamples();
+        break;
+    case elementInst:
+        _instPrsts = &sm->_soundfonts->getSoundfont(id.indexSf2)->getInstruments();
+        break;
+    case elementPrst:
+        _instPrsts = &sm->_soundfonts->getSoundfont(id.indexSf2)->getPresets();
+        break;
+    case elementInstSmpl:
+        _divisions = &sm->_soundfonts->getSoundfont(id.indexSf2)->getInstrument(id.indexElt)->getDivisions();
+        break;
+    case elementPrstInst:
+        _divisions = &sm->_soundfonts->getSoundfont(id.indexSf2)->getPreset(id.indexElt)->getDivisions();
+        break;
+    case elementInstMod: case elementPrstMod: case elementInstSmplMod: case elementPrstInstMod:
+        _mods = &sm->getDivision(id)->getMods();
+        break;
+    case elementInstGen: case elementPrstGen: case elementInstSmplGen: case elementPrstInstGen: {
+        const QMap<AttributeType, AttributeValue> &gens = sm->getDivision(id)->getGens();
+        _gen = gens.constBegin();
+        _genEnd = gens.constEnd();
+    } break;
+    default:
+        break;
+    }
+}
+
+SiblingIterator::~SiblingIterator()
+{
+    _sm->_iteratorCount.localData()--;
+}
+
+TreeItem * SiblingIterator::getItem(int position)
+{
+    // Each list keeps its own type, the items being then used through their base class
+    if (_smpls != nullptr)
+        return position < _smpls->positionCount() ? _smpls->atPosition(position) : nullptr;
+    if (_instPrsts != nullptr)
+        return position < _instPrsts->positionCount() ? _instPrsts->atPosition(position) : nullptr;
+    if (_divisions != nullptr)
+        return position < _divisions->positionCount() ? _divisions->atPosition(position) : nullptr;
+    return nullptr;
+}
+
+bool SiblingIterator::hasNext()
+{
+    while (_next < 0)
+    {
+        if (_smpls != nullptr || _instPrsts != nullptr || _divisions != nullptr)
+        {
+            TreeItem * item = getItem(_position++);
+            if (item == nullptr)
+                return false;
+            if (!item->isHidden())
+                _next = _isDivision ? item->getId().indexElt2 : item->getId().indexElt;
+        }
+        else if (_mods != nullptr)
+        {
+            if (_position >= _mods->positionCount())
+                return false;
+            Modulator * mod = _mods->atPosition(_position++);
+            if (!mod->isHidden())
+                _next = mod->_id;
+        }
+        else if (_gen != _genEnd)
+        {
+            _next = static_cast<int>(_gen.key());
+            ++_gen;
+        }
+        else if (_sf2 != _sf2End)
+        {
+            // Soundfonts being loaded are not published yet
+            if (!_sf2.value()->isLoading())
+                _next = _sf2.key();
+            ++_sf2;
+        }
+        else
+            return false;
+    }
+    return true;
+}
+
+int SiblingIterator::next()
+{
+    if (!this->hasNext())
+        return -1;
+    int index = _next;
+    _next = -1;
+    return index;
+}
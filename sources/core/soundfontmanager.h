@@ -27,13 +27,22 @@
 
 #include "sound.h"
 #include "basetypes.h"
+#include "readwritelock.h"
+#include "indexedelementlist.h"
 #include <QMap>
 #include <QObject>
 class Action;
 class ActionManager;
 class Soundfonts;
+class Soundfont;
 class QAbstractItemModel;
 class SoloManager;
+class TreeItem;
+class Modulator;
+class Smpl;
+class InstPrst;
+class Division;
+class SiblingIterator;
 
 class SoundfontManager : public QObject
 {
@@ -49,12 +58,20 @@ public:
     int add(EltID id);
     void remove(EltID id, int *message = nullptr);
 
+    // Bulk loading of a new soundfont by an input parser: no actions are stored, the tree model is not
+    // notified and the soundfont is not listed in the siblings until it is published by endLoading
+    // The model can then be filled directly, without going through "add" and "set"
+    int beginLoading();
+    Soundfont * getSoundfontBeingLoaded(int indexSf2);
+    void endLoading(int indexSf2);
+
     // Get / set properties
     bool isSet(EltID id, AttributeType champ);
     AttributeValue get(EltID id, AttributeType champ);
     QString getQstr(EltID id, AttributeType champ);
     Sound *getSound(EltID id);
     QByteArray getData(EltID id, AttributeType champ);
+    QSharedPointer<StreamedSample> getStreamedSample(EltID id, quint32 preloadDuration);
     int set(EltID id, AttributeType champ, AttributeValue value);
     int set(EltID id, AttributeType champ, QString qStr);
     int set(EltID id, AttributeType champ, QByteArray data);
@@ -63,6 +80,7 @@ public:
 
     // Nombre de freres de id (id compris)
     QList<int> getSiblings(EltID &id);
+    int getSiblingCount(EltID &id);
 
     // Gestionnaire d'actions
     void endEditing(QString editingSource);
@@ -78,7 +96,8 @@ public:
     bool isEdited(int indexSf2);
 
     // Get all attributes or modulators related to inst, instsmpl, prst, prstinst
-    void getAllAttributes(EltID id, QList<AttributeType> &listeChamps, QList<AttributeValue> &listeValeurs);
+    // The attributes are shared with the division (no copy) and are not affected by later editions
+    QMap<AttributeType, AttributeValue> getAttributes(EltID id);
     void getAllModulators(EltID id, QList<ModulatorData> &modulators);
 
     // Find if an ID is valid (allowing or not browing in hidden ID, not allowed by default)
@@ -89,6 +108,9 @@ public:
     int closestAvailablePreset(EltID id, quint16 wBank, quint16 wPreset);
     bool isAvailable(EltID id, quint16 wBank, quint16 wPreset);
 
+    // Preset played by a MIDI bank and program, -1 if the soundfont has no presets
+    int getMidiPreset(int indexSf2, int bank, int program);
+
     // Access to the solo manager
     SoloManager * solo() { return _solo; }
 
@@ -115,13 +137,58 @@ private:
     /// Clear parameters
     void supprGenAndStore(EltID id, int storeAction);
 
+    /// True if a soundfont is being loaded (see beginLoading)
+    bool isLoading(int indexSf2);
+
+    /// Global or local division containing the element id (which must be valid)
+    Division * getDivision(EltID id);
+
     QList<int> undo(QList<Action *> actions);
 
+    /// Lock to take before an edition, nothing being browsed by a SiblingIterator in the current thread
+    ReadWriteLock * editLock();
+
     static SoundfontManager * s_instance;
     Soundfonts * _soundfonts;
     ActionManager * _undoRedo;
-    QMutex _mutex;
+    ReadWriteLock _lock; // Readers don't block each other, edits are exclusive
+    QThreadStorage<int> _iteratorCount; // SiblingIterator alive in each thread
     SoloManager * _solo;
+
+    friend class SiblingIterator;
+};
+
+// Iteration over the siblings of an element (id included) without building a list, for instance:
+//     SiblingIterator i(sm, id);
+//     while (i.hasNext())
+//         id.indexElt2 = i.next();
+// The soundfont manager is locked for reading during the whole iteration: nothing can be edited in
+// the loop (getSiblings must be used in this case). An edition would wait for the read lock held by
+// the same thread, this deadlock being caught by an assertion in debug mode
+class SiblingIterator
+{
+public:
+    SiblingIterator(SoundfontManager * sm, EltID id);
+    ~SiblingIterator();
+
+    bool hasNext();
+    int next();
+
+private:
+    Q_DISABLE_COPY(SiblingIterator)
+    TreeItem * getItem(int position); // nullptr after the last sample, instrument, preset or division
+
+    SoundfontManager * _sm;
+    ReadLocker _locker;
+    bool _isDivision;
+    int _position;
+    int _next;
+    const IndexedElementList<Smpl *> * _smpls;
+    const IndexedElementList<InstPrst *> * _instPrsts; // Instruments or presets
+    const IndexedElementList<Division *> * _divisions;
+    const IndexedElementList<Modulator *> * _mods;
+    QMap<AttributeType, AttributeValue>::const_iterator _gen, _genEnd;
+    QMap<int, Soundfont *>::const_iterator _sf2, _sf2End;
 };
 
 #endif // PILE_SF2_H
@@ -170,7 +170,7 @@ bool IdList::areAllWithDivisions(ElementType type)
     {
         EltID idTmp = id;
         idTmp.typeElement = (type == elementPrst) ? elementPrstInst : elementInstSmpl;
-        if (SoundfontManager::getInstance()->getSiblings(idTmp).empty())
+        if (SoundfontManager::getInstance()->getSiblingCount(idTmp) == 0)
             return false;
     }
 
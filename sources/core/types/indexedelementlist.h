@@ -75,7 +75,7 @@ public:
     }
 
     // Return all values for iterating over them
-    QVector<T> values() const { return _elementsByPosition; }
+    const QVector<T> & values() const { return _elementsByPosition; }
 
     // Get the position corresponding to an index
     int positionOfIndex(int index)
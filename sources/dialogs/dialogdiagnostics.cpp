@@ -0,0 +1,135 @@
+/***************************************************************************
+**                                                                        **
+**  Polyphone, a soundfont editor                                         **
+**  Copyright (C) 2013-2019 Davy Triponney                                **
+**                                                                        **
+**  This program is free software: you can redistribute it and/or modify  **
+**  it under the terms of the GNU General Public License as published by  **
+**  the Free Software Foundation, either version 3 of the License, or     **
+**  (at your option) any later version.                                   **
+**                                                                        **
+**  This program is distributed in the hope that it will be useful,       **
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of        **
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the          **
+**  GNU General Public License for more details.                          **
+**                                                                        **
+**  You should have received a copy of the GNU General Public License     **
+**  along with this program. If not, see http://www.gnu.org/licenses/.    **
+**                                                                        **
+****************************************************************************
+**           Author: Davy Triponney                                       **
+**  Website/Contact: https://www.polyphone-soundfonts.com                 **
+**             Date: 01.01.2013                                           **
+***************************************************************************/
+
+
+#include "dialogdiagnostics.h"
+#include "ui_dialogdiagnostics.h"
+#include <QTimer>
+#include <QFileDialog>
+#include <QMessageBox>
+#include <QFontDatabase>
+#include <QScrollBar>
+#include <QJsonArray>
+#include "profiler.h"
+
+const int DialogDiagnostics::REFRESH_PERIOD = 500;
+
+DialogDiagnostics::DialogDiagnostics(QWidget *parent) :
+    QDialog(parent),
+    ui(new Ui::DialogDiagnostics),
+    _timer(new QTimer(this))
+{
+    ui->setupUi(this);
+    this->setAttribute(Qt::WA_DeleteOnClose);
+    this->setWindowFlags((windowFlags() & ~Qt::WindowContextHelpButtonHint));
+    ui->textMeasures->setFont(QFontDatabase::systemFont(QFontDatabase::FixedFont));
+
+    ui->checkMeasure->blockSignals(true);
+    ui->checkMeasure->setChecked(Profiler::isEnabled());
+    ui->checkMeasure->blockSignals(false);
+
+    connect(_timer, SIGNAL(timeout()), this, SLOT(updateMeasures()));
+    _timer->start(REFRESH_PERIOD);
+    updateMeasures();
+}
+
+DialogDiagnostics::~DialogDiagnostics()
+{
+    delete ui;
+}
+
+void DialogDiagnostics::updateMeasures()
+{
+    QJsonObject measures = Profiler::toJson();
+    QStringList lines;
+
+    // Counters, always updated
+    lines << tr("Audio server xruns: %1").arg(measures["xruns"].toInt())
+          << tr("Audio callbacks too long: %1").arg(measures["missed_deadlines"].toInt())
+          << tr("Sound engines late: %1").arg(measures["buffer_underruns"].toInt())
+          << tr("Samples read from the disk too late: %1").arg(measures["streaming_underruns"].toInt())
+          << tr("Allocations in the audio thread: %1").arg(measures["scratch_allocations"].toInt())
+          << tr("MIDI messages dropped: %1").arg(measures["midi_messages_dropped"].toInt());
+    if (measures["min_buffer_level"].toDouble() >= 0)
+        lines << tr("Minimum buffer level: %1 values").arg(measures["min_buffer_level"].toInt());
+
+    // Timings per thread
+    foreach (QJsonValue value, measures["threads"].toArray())
+    {
+        QJsonObject thread = value.toObject();
+        lines << "" << QString("== %1 ==").arg(thread["name"].toString());
+        lines << tr("Blocks: %1, voices: %2 (peak %3)")
+                 .arg(thread["blocks"].toInt()).arg(thread["voices"].toInt()).arg(thread["peak_voices"].toInt());
+
+        QJsonObject stages = thread["stages"].toObject();
+        for (int i = 0; i < ProfilerStats::STAGE_NUMBER; i++)
+        {
+            QString name = ProfilerStats::getStageName(static_cast<ProfilerStats::Stage>(i));
+            if (!stages.contains(name))
+                continue;
+            QJsonObject stage = stages[name].toObject();
+            lines << QString("  %1 %2 µs (max %3 µs)")
+                     .arg(name + ":", -12)
+                     .arg(0.001 * stage["mean_ns"].toDouble(), 8, 'f', 1)
+                     .arg(0.001 * stage["max_ns"].toDouble(), 0, 'f', 1);
+        }
+
+        QJsonObject latency = thread["note_latency"].toObject();
+        if (latency["notes"].toInt() > 0)
+            lines << tr("  Note latency: max %1 ms over %2 notes")
+                     .arg(0.000001 * latency["max_ns"].toDouble(), 0, 'f', 2)
+                     .arg(latency["notes"].toInt());
+    }
+
+    int scroll = ui->textMeasures->verticalScrollBar()->value();
+    ui->textMeasures->setPlainText(lines.join("\n"));
+    ui->textMeasures->verticalScrollBar()->setValue(scroll);
+}
+
+void DialogDiagnostics::on_checkMeasure_toggled(bool checked)
+{
+    Profiler::setEnabled(checked);
+}
+
+void DialogDiagnostics::on_pushReset_clicked()
+{
+    Profiler::reset();
+    updateMeasures();
+}
+
+void DialogDiagnostics::on_pushSave_clicked()
+{
+    QString fileName = QFileDialog::getSaveFileName(this, tr("Save the measures"), "", tr("Json file") + " (*.json)");
+    if (fileName.isEmpty())
+        return;
+    if (!fileName.toLower().endsWith(".json"))
+        fileName += ".json";
+    if (!Profiler::writeDump(fileName))
+        QMessageBox::warning(this, tr("Warning"), tr("Cannot create file \"%1\".").arg(fileName));
+}
+
+void DialogDiagnostics::on_pushClose_clicked()
+{
+    this->close();
+}
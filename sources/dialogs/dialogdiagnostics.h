@@ -1,7 +1,7 @@
 /***************************************************************************
 **                                                                        **
 **  Polyphone, a soundfont editor                                         **
-**  Copyright (C) 2013-2020 Davy Triponney                                **
+**  Copyright (C) 2013-2019 Davy Triponney                                **
 **                                                                        **
 **  This program is free software: you can redistribute it and/or modify  **
 **  it under the terms of the GNU General Public License as published by  **
@@ -22,31 +22,38 @@
 **             Date: 01.01.2013                                           **
 ***************************************************************************/
 
-#ifndef POLYPRESSUREEVENT_H
-#define POLYPRESSUREEVENT_H
 
-#include <QEvent>
+#ifndef DIALOGDIAGNOSTICS_H
+#define DIALOGDIAGNOSTICS_H
 
-class PolyPressureEvent : public QEvent
+#include <QDialog>
+class QTimer;
+
+namespace Ui {
+class DialogDiagnostics;
+}
+
+// Display the measures of the audio computation (see Profiler)
+class DialogDiagnostics : public QDialog
 {
+    Q_OBJECT
+
 public:
-    PolyPressureEvent(unsigned char note, unsigned char val) : QEvent((QEvent::Type)(QEvent::User+2)),
-          _note(note),
-          _pressure(val) {}
-
-    unsigned char getNote() const
-    {
-        return _note;
-    }
-
-    unsigned char getPressure() const
-    {
-        return _pressure;
-    }
-
-protected:
-    unsigned char _note;
-    unsigned char _pressure;
+    explicit DialogDiagnostics(QWidget *parent = nullptr);
+    ~DialogDiagnostics() override;
+
+private slots:
+    void updateMeasures();
+    void on_checkMeasure_toggled(bool checked);
+    void on_pushReset_clicked();
+    void on_pushSave_clicked();
+    void on_pushClose_clicked();
+
+private:
+    Ui::DialogDiagnostics *ui;
+    QTimer * _timer;
+
+    static const int REFRESH_PERIOD; // In ms
 };
 
-#endif // POLYPRESSUREEVENT_H
+#endif // DIALOGDIAGNOSTICS_H
@@ -29,6 +29,7 @@
 #include <QDir>
 #include <QDesktopServices>
 #include <QFileDialog>
+#include <QMessageBox>
 #include "contextmanager.h"
 #include "synth.h"
 #include "editortoolbar.h"
@@ -40,6 +41,7 @@ DialogRecorder::DialogRecorder(QWidget *parent) :
     ui->setupUi(this);
     _synth = ContextManager::audio()->getSynth();
     connect(_synth, SIGNAL(dataWritten(quint32,quint32)), this, SLOT(onDataWritten(quint32,quint32)));
+    connect(_synth, SIGNAL(recordOverflowed(quint32)), this, SLOT(onRecordOverflowed(quint32)));
     this->setWindowFlags(Qt::Tool | Qt::CustomizeWindowHint | Qt::WindowCloseButtonHint);
     this->initialize();
 }
@@ -52,6 +54,7 @@ DialogRecorder::~DialogRecorder()
 void DialogRecorder::initialize()
 {
     // Initialize interface
+    this->setWindowTitle(tr("Recorder"));
     ui->lcdNumber->display("00:00:00");
     ui->pushRecord->setIcon(ContextManager::theme()->getColoredSvg(":/icons/recorder_record.svg", QSize(32, 32), ThemeManager::WINDOW_TEXT));
     ui->pushPlayPause->setEnabled(false);
@@ -76,6 +79,13 @@ void DialogRecorder::onDataWritten(quint32 sampleRate, quint32 number)
     }
 }
 
+void DialogRecorder::onRecordOverflowed(quint32 number)
+{
+    // The disk was too slow, part of the record is missing
+    Q_UNUSED(number)
+    this->setWindowTitle(tr("Recorder") + " - " + tr("data lost"));
+}
+
 void DialogRecorder::closeEvent(QCloseEvent * event)
 {
     QDialog::closeEvent(event);
@@ -97,22 +107,39 @@ void DialogRecorder::on_pushRecord_clicked()
     }
     else
     {
-        // File name
-        QString defaultPath = this->getDefaultPath();
+        // File name and format
+        QStringList filters;
+        filters << tr("Wav file") + " (*.wav)"
+                << tr("Wav file, 24 bits") + " (*.wav)"
+                << tr("Flac file") + " (*.flac)";
+        int formatIndex = ContextManager::configuration()->getValue(ConfManager::SECTION_DISPLAY, "recorderFormat", 0).toInt();
+        if (formatIndex < 0 || formatIndex >= filters.size())
+            formatIndex = 0;
+        QString extension = (formatIndex == Recorder::FORMAT_FLAC_24 ? ".flac" : ".wav");
+        QString selectedFilter = filters[formatIndex];
+        QString defaultPath = this->getDefaultPath(extension);
         defaultPath = QFileDialog::getSaveFileName(this, tr("Save a record"),
-                                                   defaultPath, tr("Wav file") + " (*.wav)");
+                                                   defaultPath, filters.join(";;"), &selectedFilter);
         if (!defaultPath.isEmpty())
         {
-            if (defaultPath.right(4).toLower() != ".wav")
-                defaultPath.append(".wav");
+            formatIndex = qMax(filters.indexOf(selectedFilter), 0);
+            ContextManager::configuration()->setValue(ConfManager::SECTION_DISPLAY, "recorderFormat", formatIndex);
+            extension = (formatIndex == Recorder::FORMAT_FLAC_24 ? ".flac" : ".wav");
+            if (defaultPath.right(extension.size()).toLower() != extension)
+                defaultPath.append(extension);
             ContextManager::recentFile()->addRecentFile(RecentFileManager::FILE_TYPE_RECORD, defaultPath);
 
+            if (!_synth->startNewRecord(defaultPath, static_cast<Recorder::Format>(formatIndex)))
+            {
+                QMessageBox::warning(this, tr("Warning"), tr("Cannot create file \"%1\".").arg(defaultPath));
+                return;
+            }
+
             // Begin the record
             ui->pushRecord->setIcon(ContextManager::theme()->getColoredSvg(":/icons/recorder_stop.svg", QSize(32, 32), ThemeManager::WINDOW_TEXT));
             ui->pushPlayPause->setIcon(ContextManager::theme()->getColoredSvg(":/icons/recorder_pause.svg", QSize(32, 32), ThemeManager::WINDOW_TEXT));
             _isPaused = false;
             _isRecording = true;
-            _synth->startNewRecord(defaultPath);
             ui->pushPlayPause->setEnabled(true);
         }
     }
@@ -131,25 +158,25 @@ void DialogRecorder::on_pushPlayPause_clicked()
     }
 }
 
-QString DialogRecorder::getDefaultPath()
+QString DialogRecorder::getDefaultPath(QString extension)
 {
     QString defaultPath = ContextManager::recentFile()->getLastFile(RecentFileManager::FILE_TYPE_RECORD);
     QFileInfo info(defaultPath);
     if (info.dir().exists() && defaultPath.size())
     {
         QString name = info.fileName();
-        QRegExp exp("^(.*)-[0-9][0-9]*.[wW][aA][vV]$");
+        QRegExp exp("^(.*)-[0-9][0-9]*\\.[^.]*$");
         if (exp.exactMatch(name))
             name = exp.cap(1);
         else
-            name = name.left(name.size() - 4);
+            name = info.completeBaseName();
 
         // Find the first available name for a new file
         QString folderName = info.dir().path();
-        if (QFile(folderName + "/" + name + ".wav").exists())
+        if (QFile(folderName + "/" + name + extension).exists())
         {
             int suffix = 2;
-            while (QFile(folderName + "/" + name + "-" + QString::number(suffix) + ".wav").exists())
+            while (QFile(folderName + "/" + name + "-" + QString::number(suffix) + extension).exists())
                 suffix++;
             defaultPath = folderName + "/" + name + "-" + QString::number(suffix);
         }
@@ -163,7 +190,7 @@ QString DialogRecorder::getDefaultPath()
         defaultPath = QDesktopServices::storageLocation(QDesktopServices::DesktopLocation) + "/" + tr("record");
 #endif
 
-    return defaultPath + ".wav";
+    return defaultPath + extension;
 }
 
 void DialogRecorder::hideEvent(QHideEvent * event)
@@ -48,6 +48,7 @@ protected:
 
 private slots:
     void onDataWritten(quint32 sampleRate, quint32 number);
+    void onRecordOverflowed(quint32 number);
     void on_pushRecord_clicked();
     void on_pushPlayPause_clicked();
 
@@ -59,7 +60,7 @@ private:
     Synth * _synth;
 
     void initialize();
-    QString getDefaultPath();
+    QString getDefaultPath(QString extension);
 };
 
 #endif // DIALOGRECORDER_H
@@ -138,9 +138,10 @@ QString PageOverview::getRange(bool orderMode, EltID id, AttributeType champ)
         id.typeElement = elementInstSmpl;
     else
         id.typeElement = elementPrstInst;
-    foreach (int i, _sf2->getSiblings(id))
+    SiblingIterator it(_sf2, id);
+    while (it.hasNext())
     {
-        id.indexElt2 = i;
+        id.indexElt2 = it.next();
         int value = globalValue;
         if (_sf2->isSet(id, champ))
             value = _sf2->get(id, champ).shValue;
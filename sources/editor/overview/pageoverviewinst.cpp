@@ -54,14 +54,16 @@ void PageOverviewInst::prepare(EltID id)
     _usedInst.clear();
 
     id.typeElement = elementPrst;
-    foreach (int i, _sf2->getSiblings(id))
+    SiblingIterator itElt(_sf2, id);
+    while (itElt.hasNext())
     {
-        id.indexElt = i;
+        id.indexElt = itElt.next();
         EltID idSubElt = id;
         idSubElt.typeElement = elementPrstInst;
-        foreach (int j, _sf2->getSiblings(idSubElt))
+        SiblingIterator itDiv(_sf2, idSubElt);
+        while (itDiv.hasNext())
         {
-            idSubElt.indexElt2 = j;
+            idSubElt.indexElt2 = itDiv.next();
             _usedInst << _sf2->get(idSubElt, champ_instrument).wValue;
         }
     }
@@ -103,7 +105,7 @@ QString PageOverviewInst::isUsed(EltID id)
 QString PageOverviewInst::getSampleNumber(EltID id)
 {
     id.typeElement = elementInstSmpl;
-    return QString::number(_sf2->getSiblings(id).count());
+    return QString::number(_sf2->getSiblingCount(id));
 }
 
 QString PageOverviewInst::getParameterNumber(EltID id)
@@ -112,16 +114,17 @@ QString PageOverviewInst::getParameterNumber(EltID id)
 
     // Parameters for the global division
     id.typeElement = elementInstGen;
-    count += _sf2->getSiblings(id).count();
+    count += _sf2->getSiblingCount(id);
 
     // Parameters for the sample divisions
     id.typeElement = elementInstSmpl;
-    foreach (int i, _sf2->getSiblings(id))
+    SiblingIterator it(_sf2, id);
+    while (it.hasNext())
     {
-        id.indexElt2 = i;
+        id.indexElt2 = it.next();
         EltID idGen = id;
         idGen.typeElement = elementInstSmplGen;
-        count += _sf2->getSiblings(idGen).count();
+        count += _sf2->getSiblingCount(idGen);
     }
 
     return QString::number(count);
@@ -133,16 +136,17 @@ QString PageOverviewInst::getModulatorNumber(EltID id)
 
     // Modulators for the global division
     id.typeElement = elementInstMod;
-    count += _sf2->getSiblings(id).count();
+    count += _sf2->getSiblingCount(id);
 
     // Modulators for the sample divisions
     id.typeElement = elementInstSmpl;
-    foreach (int i, _sf2->getSiblings(id))
+    SiblingIterator it(_sf2, id);
+    while (it.hasNext())
     {
-        id.indexElt2 = i;
+        id.indexElt2 = it.next();
         EltID idMod = id;
         idMod.typeElement = elementInstSmplMod;
-        count += _sf2->getSiblings(idMod).count();
+        count += _sf2->getSiblingCount(idMod);
     }
 
     return QString::number(count);
@@ -164,9 +168,10 @@ QString PageOverviewInst::getKeyRange(EltID id)
     int min = 127;
     int max = 0;
     id.typeElement = elementInstSmpl;
-    foreach (int i, _sf2->getSiblings(id))
+    SiblingIterator it(_sf2, id);
+    while (it.hasNext())
     {
-        id.indexElt2 = i;
+        id.indexElt2 = it.next();
         if (_sf2->isSet(id, champ_keyRange))
         {
             RangesType range = _sf2->get(id, champ_keyRange).rValue;
@@ -214,9 +219,10 @@ QString PageOverviewInst::getVelocityRange(EltID id)
     int min = 127;
     int max = 0;
     id.typeElement = elementInstSmpl;
-    foreach (int i, _sf2->getSiblings(id))
+    SiblingIterator it(_sf2, id);
+    while (it.hasNext())
     {
-        id.indexElt2 = i;
+        id.indexElt2 = it.next();
         if (_sf2->isSet(id, champ_velocity))
         {
             RangesType range = _sf2->get(id, champ_velocity).rValue;
@@ -263,9 +269,10 @@ QString PageOverviewInst::getLoop(EltID id)
     // Attenuation per division
     QList<int> modes;
     id.typeElement = elementInstSmpl;
-    foreach (int i, _sf2->getSiblings(id))
+    SiblingIterator it(_sf2, id);
+    while (it.hasNext())
     {
-        id.indexElt2 = i;
+        id.indexElt2 = it.next();
         int value = globalValue;
         if (_sf2->isSet(id, champ_sampleModes))
             value = _sf2->get(id, champ_sampleModes).wValue;
@@ -26,6 +26,7 @@
 #define PAGEOVERVIEWINST_H
 
 #include "pageoverview.h"
+#include <QSet>
 
 class PageOverviewInst : public PageOverview
 {
@@ -52,7 +53,7 @@ private:
     QString getChorus(EltID id);
     QString getReverb(EltID id);
 
-    QList<int> _usedInst;
+    QSet<int> _usedInst;
     bool _orderMode;
 };
 
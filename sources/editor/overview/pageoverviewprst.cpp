@@ -85,7 +85,7 @@ QString PageOverviewPrst::getBankAndPreset(EltID id)
 QString PageOverviewPrst::getSampleNumber(EltID id)
 {
     id.typeElement = elementPrstInst;
-    return QString::number(_sf2->getSiblings(id).count());
+    return QString::number(_sf2->getSiblingCount(id));
 }
 
 QString PageOverviewPrst::getParameterNumber(EltID id)
@@ -94,16 +94,17 @@ QString PageOverviewPrst::getParameterNumber(EltID id)
 
     // Parameters for the global division
     id.typeElement = elementPrstGen;
-    count += _sf2->getSiblings(id).count();
+    count += _sf2->getSiblingCount(id);
 
     // Parameters for the instrument divisions
     id.typeElement = elementPrstInst;
-    foreach (int i, _sf2->getSiblings(id))
+    SiblingIterator it(_sf2, id);
+    while (it.hasNext())
     {
-        id.indexElt2 = i;
+        id.indexElt2 = it.next();
         EltID idGen = id;
         idGen.typeElement = elementPrstInstGen;
-        count += _sf2->getSiblings(idGen).count();
+        count += _sf2->getSiblingCount(idGen);
     }
 
     return QString::number(count);
@@ -115,16 +116,17 @@ QString PageOverviewPrst::getModulatorNumber(EltID id)
 
     // Modulators for the global division
     id.typeElement = elementPrstMod;
-    count += _sf2->getSiblings(id).count();
+    count += _sf2->getSiblingCount(id);
 
     // Modulators for the instrument divisions
     id.typeElement = elementPrstInst;
-    foreach (int i, _sf2->getSiblings(id))
+    SiblingIterator it(_sf2, id);
+    while (it.hasNext())
     {
-        id.indexElt2 = i;
+        id.indexElt2 = it.next();
         EltID idMod = id;
         idMod.typeElement = elementPrstInstMod;
-        count += _sf2->getSiblings(idMod).count();
+        count += _sf2->getSiblingCount(idMod);
     }
 
     return QString::number(count);
@@ -146,9 +148,10 @@ QString PageOverviewPrst::getKeyRange(EltID id)
     int min = 127;
     int max = 0;
     id.typeElement = elementPrstInst;
-    foreach (int i, _sf2->getSiblings(id))
+    SiblingIterator it(_sf2, id);
+    while (it.hasNext())
     {
-        id.indexElt2 = i;
+        id.indexElt2 = it.next();
         if (_sf2->isSet(id, champ_keyRange))
         {
             RangesType range = _sf2->get(id, champ_keyRange).rValue;
@@ -196,9 +199,10 @@ QString PageOverviewPrst::getVelocityRange(EltID id)
     int min = 127;
     int max = 0;
     id.typeElement = elementPrstInst;
-    foreach (int i, _sf2->getSiblings(id))
+    SiblingIterator it(_sf2, id);
+    while (it.hasNext())
     {
-        id.indexElt2 = i;
+        id.indexElt2 = it.next();
         if (_sf2->isSet(id, champ_velocity))
         {
             RangesType range = _sf2->get(id, champ_velocity).rValue;
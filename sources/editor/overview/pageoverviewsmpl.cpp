@@ -52,14 +52,16 @@ void PageOverviewSmpl::prepare(EltID id)
     _usedSmpl.clear();
 
     id.typeElement = elementInst;
-    foreach (int i, _sf2->getSiblings(id))
+    SiblingIterator itElt(_sf2, id);
+    while (itElt.hasNext())
     {
-        id.indexElt = i;
+        id.indexElt = itElt.next();
         EltID idSubElt = id;
         idSubElt.typeElement = elementInstSmpl;
-        foreach (int j, _sf2->getSiblings(idSubElt))
+        SiblingIterator itDiv(_sf2, idSubElt);
+        while (itDiv.hasNext())
         {
-            idSubElt.indexElt2 = j;
+            idSubElt.indexElt2 = itDiv.next();
             _usedSmpl << _sf2->get(idSubElt, champ_sampleID).wValue;
         }
     }
@@ -26,6 +26,7 @@
 #define PAGEOVERVIEWSMPL_H
 
 #include "pageoverview.h"
+#include <QSet>
 
 class PageOverviewSmpl : public PageOverview
 {
@@ -50,7 +51,7 @@ private:
     QString link(EltID id);
     QString sampleRate(EltID id);
 
-    QList<int> _usedSmpl;
+    QSet<int> _usedSmpl;
     bool _orderMode;
 };
 
@@ -84,6 +84,10 @@ bool Page::preparePage(QString editingSource, IdList selectedIds)
     // Update the interface according to the selected display action
     bool result = updateInterface(editingSource, _currentIds, _currentDisplayOption);
 
+    // The selection may have changed the element played by the keys
+    if (this->isVisible())
+        ContextManager::midi()->setPlayedElement(this->getPlayedElement());
+
     _preparingPage = false;
     return result;
 }
@@ -107,12 +111,16 @@ void Page::showEvent(QShowEvent * event)
     // Specific display per page
     this->onShow();
 
+    // The keys now play the element of this page
+    ContextManager::midi()->setPlayedElement(this->getPlayedElement());
+
     QWidget::showEvent(event);
 }
 
 void Page::hideEvent(QHideEvent * event)
 {
     // Stop all sounds
+    ContextManager::midi()->releasePlayedElement(this->getPlayedElement());
     ContextManager::midi()->stopAll();
 
     QWidget::hideEvent(event);
@@ -108,12 +108,16 @@ protected:
     virtual bool updateInterface(QString editingSource, IdList selectedIds, int displayOption) = 0;
 
     // A key is being played or not played anymore (if velocity is 0)
+    // The sound is triggered by the MIDI device, only the display is updated here
     virtual void keyPlayedInternal(int key, int velocity)
     {
         Q_UNUSED(key)
         Q_UNUSED(velocity)
     }
 
+    // Element played by the keys when the page is displayed
+    virtual EltID getPlayedElement() { return EltID(elementUnknown); }
+
     // Refresh things after a page is shown
     virtual void onShow() = 0;
 
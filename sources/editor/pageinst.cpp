@@ -270,13 +270,17 @@ void PageInst::onLinkClicked(EltID id)
     emit(selectedIdsChanged(id));
 }
 
+EltID PageInst::getPlayedElement()
+{
+    IdList ids = _currentIds.getSelectedIds(elementInst);
+    return ids.count() == 1 ? ids[0] : EltID(elementUnknown);
+}
+
 void PageInst::keyPlayedInternal2(int key, int velocity)
 {
     IdList ids = _currentIds.getSelectedIds(elementInst);
     if (ids.count() == 1)
     {
-        ContextManager::audio()->getSynth()->play(ids[0], key, velocity);
-
         if (velocity > 0)
         {
             // Emphasize the related ranges
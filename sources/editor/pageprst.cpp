@@ -295,11 +295,10 @@ void PagePrst::setPreset()
     _preparingPage = false;
 }
 
-void PagePrst::keyPlayedInternal2(int key, int velocity)
+EltID PagePrst::getPlayedElement()
 {
     IdList ids = _currentIds.getSelectedIds(elementPrst);
-    if (ids.count() == 1)
-        ContextManager::audio()->getSynth()->play(ids[0], key, velocity);
+    return ids.count() == 1 ? ids[0] : EltID(elementUnknown);
 }
 
 void PagePrst::setBank(quint16 desiredBank, int collisionResolution)
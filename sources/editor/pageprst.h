@@ -50,7 +50,7 @@ public:
 
 protected:
     bool updateInterface(QString editingSource, IdList selectedIds, int displayOption) override;
-    void keyPlayedInternal2(int key, int velocity) override;
+    EltID getPlayedElement() override;
 
 private slots:
     void setBank();
@@ -318,18 +318,18 @@ void PageSf2::countElements(int &unusedSmpl, int &unusedInst, int &usedSmpl, int
     {
         id.indexElt = elementId;
         id.typeElement = elementPrstGen;
-        prstGen += _sf2->getSiblings(id).count();
+        prstGen += _sf2->getSiblingCount(id);
         id.typeElement = elementPrstMod;
-        prstMod += _sf2->getSiblings(id).count();
+        prstMod += _sf2->getSiblingCount(id);
 
         id.typeElement = elementPrstInst;
         foreach (int i, _sf2->getSiblings(id))
         {
             id.indexElt2 = i;
             id.typeElement = elementPrstInstGen;
-            prstGen += _sf2->getSiblings(id).count();
+            prstGen += _sf2->getSiblingCount(id);
             id.typeElement = elementPrstInstMod;
-            prstMod += _sf2->getSiblings(id).count();
+            prstMod += _sf2->getSiblingCount(id);
 
             id.typeElement = elementPrstInst;
             iTmp = _sf2->get(id, champ_instrument).wValue;
@@ -349,18 +349,18 @@ void PageSf2::countElements(int &unusedSmpl, int &unusedInst, int &usedSmpl, int
     {
         id.indexElt = elementId;
         id.typeElement = elementInstGen;
-        instGen += _sf2->getSiblings(id).count();
+        instGen += _sf2->getSiblingCount(id);
         id.typeElement = elementInstMod;
-        instMod += _sf2->getSiblings(id).count();
+        instMod += _sf2->getSiblingCount(id);
 
         id.typeElement = elementInstSmpl;
         foreach (int i, _sf2->getSiblings(id))
         {
             id.indexElt2 = i;
             id.typeElement = elementInstSmplGen;
-            instGen += _sf2->getSiblings(id).count();
+            instGen += _sf2->getSiblingCount(id);
             id.typeElement = elementInstSmplMod;
-            instMod += _sf2->getSiblings(id).count();
+            instMod += _sf2->getSiblingCount(id);
 
             id.typeElement = elementInstSmpl;
             iTmp = _sf2->get(id, champ_sampleID).wValue;
@@ -377,14 +377,14 @@ void PageSf2::countElements(int &unusedSmpl, int &unusedInst, int &usedSmpl, int
     {
         id.indexElt = elementId;
         id.typeElement = elementInstGen;
-        instGen += _sf2->getSiblings(id).count();
+        instGen += _sf2->getSiblingCount(id);
 
         id.typeElement = elementInstSmpl;
         foreach (int i, _sf2->getSiblings(id))
         {
             id.indexElt2 = i;
             id.typeElement = elementInstSmplGen;
-            instGen += _sf2->getSiblings(id).count();
+            instGen += _sf2->getSiblingCount(id);
             id.typeElement = elementInstSmpl;
         }
     }
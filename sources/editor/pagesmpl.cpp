@@ -1043,11 +1043,10 @@ void PageSmpl::onLinkClicked(EltID id)
     emit(selectedIdsChanged(id));
 }
 
-void PageSmpl::keyPlayedInternal(int key, int velocity)
+EltID PageSmpl::getPlayedElement()
 {
     IdList ids = _currentIds.getSelectedIds(elementSmpl);
-    if (ids.count() == 1)
-        ContextManager::audio()->getSynth()->play(ids[0], key, velocity);
+    return ids.count() == 1 ? ids[0] : EltID(elementUnknown);
 }
 
 void PageSmpl::onSampleOnOff()
@@ -55,8 +55,8 @@ protected:
     // Refresh things after a page is shown
     void onShow() override;
 
-    // Reaction when a key is played
-    void keyPlayedInternal(int key, int velocity) override;
+    // Element played by the keys
+    EltID getPlayedElement() override;
 
 private slots:
     void lecture();
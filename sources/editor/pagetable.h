@@ -52,7 +52,11 @@ protected:
     void afficheRanges(bool justSelection);
     void afficheEnvelops(bool justSelection);
     void keyPlayedInternal(int key, int velocity) override;
-    virtual void keyPlayedInternal2(int key, int velocity) = 0;
+    virtual void keyPlayedInternal2(int key, int velocity)
+    {
+        Q_UNUSED(key)
+        Q_UNUSED(velocity)
+    }
 
     // Refresh things after a page is shown
     void onShow() override;
@@ -56,7 +56,7 @@ void ToolChords::runInternal(SoundfontManager * sm, QWidget * parent, IdList ids
     EltID idInst = ids.getSelectedIds(elementInst)[0];
     idInst.typeElement = elementInst;
     EltID idInstSmpl(elementInstSmpl, idInst.indexSf2, idInst.indexElt);
-    if (sm->getSiblings(idInstSmpl).empty())
+    if (sm->getSiblingCount(idInstSmpl) == 0)
     {
         _warning = tr("The instrument contains no samples.");
         finished(true);
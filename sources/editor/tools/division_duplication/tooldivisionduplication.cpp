@@ -57,7 +57,7 @@ void ToolDivisionDuplication::process(SoundfontManager * sm, EltID id, AbstractT
     else
         divId.typeElement = elementPrstInst;
 
-    if (sm->getSiblings(divId).empty())
+    if (sm->getSiblingCount(divId) == 0)
     {
         // No divisions => error
         _mutex.lock();
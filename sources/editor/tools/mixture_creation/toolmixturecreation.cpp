@@ -55,7 +55,7 @@ void ToolMixtureCreation::runInternal(SoundfontManager * sm, QWidget * parent, I
     EltID idInst = ids.getSelectedIds(elementInst)[0];
     idInst.typeElement = elementInst;
     EltID idInstSmpl(elementInstSmpl, idInst.indexSf2, idInst.indexElt);
-    if (sm->getSiblings(idInstSmpl).empty())
+    if (sm->getSiblingCount(idInstSmpl) == 0)
     {
         _warning = tr("The instrument contains no samples.");
         finished(true);
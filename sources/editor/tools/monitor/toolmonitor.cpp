@@ -40,14 +40,14 @@ bool ToolMonitor::isCompatible(IdList ids)
         // The instrument must comprise at least one sample
         EltID id = ids.getSelectedIds(elementInst)[0];
         id.typeElement = elementInstSmpl;
-        return !sm->getSiblings(id).empty();
+        return sm->getSiblingCount(id) > 0;
     }
     else if (ids.getSelectedIds(elementPrst).count() == 1)
     {
         // The preset must comprise at least one instrument
         EltID id = ids.getSelectedIds(elementPrst)[0];
         id.typeElement = elementPrstInst;
-        return !sm->getSiblings(id).empty();
+        return sm->getSiblingCount(id) > 0;
     }
 
     return false;
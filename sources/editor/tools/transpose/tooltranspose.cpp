@@ -44,7 +44,7 @@ void ToolTranspose::process(SoundfontManager * sm, EltID id, AbstractToolParamet
     
     // Elements to transpose
     EltID divId = EltID(elementInstSmpl, id.indexSf2, id.indexElt);
-    if (sm->getSiblings(divId).empty())
+    if (sm->getSiblingCount(divId) == 0)
     {
         // No divisions => error
         _mutex.lock();
@@ -31,6 +31,9 @@
 #include "abstractinputparser.h"
 #include "outputfactory.h"
 #include "abstractoutput.h"
+#include "midifilereader.h"
+#include "offlinerenderer.h"
+#include "profiler.h"
 #include "options.h"
 #include "contextmanager.h"
 #include "utils.h"
@@ -85,7 +88,14 @@ int launchApplication(QtSingleApplication * app, Options &options)
     // Open files passed as argument
     w.openFiles(options.getInputFiles().join('|'));
 
-    return app->exec();
+    // Possibly measure the audio computation until the application is closed
+    if (!options.getProfileFile().isEmpty())
+        Profiler::setEnabled(true);
+    int result = app->exec();
+    if (!options.getProfileFile().isEmpty() && !Profiler::writeDump(options.getProfileFile()))
+        writeLine("Couldn't write " + options.getProfileFile());
+
+    return result;
 }
 
 /// Error codes
@@ -168,6 +178,83 @@ int convert(Options &options)
     return 0;
 }
 
+/// Same error codes as the conversion
+int renderMidi(Options &options)
+{
+    // Check the input files
+    QFileInfo inputFile(options.getInputFiles()[0]);
+    QFileInfo midiFile(options.getMidiFile());
+    foreach (QFileInfo fileInfo, QList<QFileInfo>() << inputFile << midiFile)
+    {
+        if (!fileInfo.exists())
+        {
+            writeLine("The file " + fileInfo.filePath() + " does not exist.");
+            return 1;
+        }
+    }
+
+    // Check the output
+    QFileInfo outputFile(options.getOutputFileFullPath());
+    if (!QDir(options.getOutputDirectory()).exists())
+    {
+        writeLine("The directory " + options.getOutputDirectory() + " does not exist.");
+        return 1;
+    }
+    if (outputFile.exists())
+    {
+        writeLine("The file "  + outputFile.filePath() + " already exists.");
+        return 1;
+    }
+
+    // Load the soundfont
+    writeLine("Loading file " + inputFile.filePath() + "...");
+    AbstractInputParser * input = InputFactory::getInput(inputFile.filePath());
+    input->process(false);
+    if (!input->isSuccess())
+    {
+        writeLine("Couldn't load " + inputFile.filePath() + ": " + input->getError());
+        delete input;
+        return 3;
+    }
+    int sf2Index = input->getSf2Index();
+    delete input;
+    writeLine("File loaded");
+
+    // Read the midi file
+    writeLine("Loading file " + midiFile.filePath() + "...");
+    MidiFileReader midiReader(midiFile.filePath());
+    midiReader.process();
+    if (!midiReader.isSuccess())
+    {
+        writeLine("Couldn't load " + midiFile.filePath() + ": " + midiReader.getError());
+        SoundfontManager::kill();
+        return 3;
+    }
+    writeLine("File loaded");
+
+    // Render
+    writeLine("Rendering file " + outputFile.filePath() + "...");
+    OfflineRenderer renderer(ContextManager::configuration(), sf2Index);
+    if (!options.getProfileFile().isEmpty())
+        Profiler::setEnabled(true);
+    renderer.process(midiReader.getEvents(), outputFile.filePath());
+    if (!options.getProfileFile().isEmpty() && !Profiler::writeDump(options.getProfileFile()))
+        writeLine("Couldn't write " + options.getProfileFile());
+    if (!renderer.isSuccess())
+    {
+        writeLine("Couldn't create " + outputFile.filePath() + ": " + renderer.getError());
+        SoundfontManager::kill();
+        return 4;
+    }
+    writeLine(QString("done (%1 s rendered, %2x real time)")
+              .arg(renderer.getDuration(), 0, 'f', 1)
+              .arg(renderer.getRealTimeFactor(), 0, 'f', 1));
+
+    // Destroy a singleton that has been silently created
+    SoundfontManager::kill();
+    return 0;
+}
+
 int resetConfig(Options &options)
 {
     Q_UNUSED(options)
@@ -225,6 +312,8 @@ int main(int argc, char *argv[])
         valRet = displayHelp(options);
     else if (options.mode() == Options::MODE_RESET_CONFIG)
         valRet = resetConfig(options);
+    else if (options.mode() == Options::MODE_MIDI_RENDERING)
+        valRet = renderMidi(options);
     else
         valRet = convert(options);
 
@@ -35,7 +35,8 @@ Options::Options(int argc, char *argv[]) :
     _sf3Quality(1),
     _sfzPresetPrefix(false),
     _sfzOneDirPerBank(false),
-    _sfzGeneralMidi(false)
+    _sfzGeneralMidi(false),
+    _renderingToFlac(false)
 {
     _appPath = QFileInfo(QCoreApplication::applicationFilePath()).path();
 
@@ -91,6 +92,9 @@ void Options::processType1(QString arg)
     case '3':
         _mode = MODE_CONVERSION_TO_SFZ;
         break;
+    case '4':
+        _mode = MODE_MIDI_RENDERING;
+        break;
     case 'd':
         _currentState = STATE_OUTPUT_DIRECTORY;
         break;
@@ -103,6 +107,9 @@ void Options::processType1(QString arg)
     case 'c':
         _currentState = STATE_CONFIG;
         break;
+    case 'p':
+        _currentState = STATE_PROFILE_FILE;
+        break;
     case 'h':
         _help = true;
         break;
@@ -130,6 +137,10 @@ void Options::processType2(QString arg)
         _outputFile = arg;
         _currentState = STATE_NONE; // no more output
         break;
+    case STATE_PROFILE_FILE:
+        _profileFile = arg;
+        _currentState = STATE_INPUT_FILE; // Files to open may follow
+        break;
     case STATE_CONFIG:
         if (_mode == MODE_CONVERSION_TO_SFZ)
         {
@@ -169,6 +180,13 @@ void Options::processType2(QString arg)
             else
                 _error = true;
         }
+        else if (_mode == MODE_MIDI_RENDERING)
+        {
+            if (arg == "0" || arg == "1")
+                _renderingToFlac = (arg == "1");
+            else
+                _error = true;
+        }
         else
             _error = true;
         break;
@@ -180,10 +198,15 @@ void Options::processType2(QString arg)
 
 void Options::checkErrors()
 {
-    // Input files
-    foreach (QString inputFile, _inputFiles)
+    // Input files (a midi file is taken apart for the midi rendering)
+    for (int i = _inputFiles.count() - 1; i >= 0; i--)
     {
-        QString extension = QFileInfo(inputFile).suffix().toLower();
+        QString extension = QFileInfo(_inputFiles[i]).suffix().toLower();
+        if (_mode == MODE_MIDI_RENDERING && (extension == "mid" || extension == "midi") && _midiFile == "")
+        {
+            _midiFile = _inputFiles.takeAt(i);
+            continue;
+        }
         if (extension != "sf2" && extension != "sf3" && extension != "sfark" && extension != "sfz")
         {
             _error = true;
@@ -201,7 +224,11 @@ void Options::checkErrors()
             _error = true;
         break;
     case MODE_CONVERSION_TO_SF2: case MODE_CONVERSION_TO_SF3: case MODE_CONVERSION_TO_SFZ:
-        if (_inputFiles.count() != 1)
+        if (_inputFiles.count() != 1 || _profileFile != "") // Nothing to measure
+            _error = true;
+        break;
+    case MODE_MIDI_RENDERING:
+        if (_inputFiles.count() != 1 || _midiFile == "")
             _error = true;
         break;
     }
@@ -212,12 +239,14 @@ void Options::postTreatment()
     if (_mode > MODE_GUI)
     {
         // By default, the output directory is the same than the input file directory
+        // (the midi file in the case of a rendering)
+        QString reference = (_mode == MODE_MIDI_RENDERING ? _midiFile : _inputFiles[0]);
         if (_outputDirectory == "")
-            _outputDirectory = QFileInfo(_inputFiles[0]).dir().absolutePath();
+            _outputDirectory = QFileInfo(reference).dir().absolutePath();
 
         // By default, the output file name is the same than the input file name
         if (_outputFile == "")
-            _outputFile = QFileInfo(_inputFiles[0]).baseName();
+            _outputFile = QFileInfo(reference).baseName();
     }
 }
 
@@ -240,6 +269,9 @@ QString Options::getOutputFileFullPath()
     case MODE_CONVERSION_TO_SFZ:
         extension = ".sfz";
         break;
+    case MODE_MIDI_RENDERING:
+        extension = _renderingToFlac ? ".flac" : ".wav";
+        break;
     default:
         break;
     }
@@ -36,7 +36,8 @@ public:
         MODE_GUI = 0,
         MODE_CONVERSION_TO_SF2 = 1,
         MODE_CONVERSION_TO_SF3 = 2,
-        MODE_CONVERSION_TO_SFZ = 3
+        MODE_CONVERSION_TO_SFZ = 3,
+        MODE_MIDI_RENDERING = 4
     };
 
     Options(int argc, char *argv[]);
@@ -68,6 +69,15 @@ public:
     /// Return the compression quality for sf3 conversion (0 is high, 1 is medium, 2 is high);
     int quality()  { return _sf3Quality; }
 
+    /// Midi rendering option: flac output instead of wav
+    bool renderingToFlac() { return _renderingToFlac; }
+
+    /// Midi rendering: return the midi file (the soundfont being in the input files)
+    QString getMidiFile() { return _midiFile; }
+
+    /// Return the file in which the audio measures are written at the end (empty if not profiling)
+    QString getProfileFile() { return _profileFile; }
+
     /// Return true in case of bad arguments
     bool error() { return _error; }
 
@@ -81,6 +91,7 @@ private:
         STATE_OUTPUT_FILE,
         STATE_OUTPUT_DIRECTORY,
         STATE_CONFIG,
+        STATE_PROFILE_FILE,
         STATE_NONE
     };
 
@@ -103,6 +114,13 @@ private:
     bool _sfzOneDirPerBank;
     bool _sfzGeneralMidi;
 
+    // Midi rendering options
+    bool _renderingToFlac;
+    QString _midiFile;
+
+    // Audio measures
+    QString _profileFile;
+
     QString _appPath;
 };
 
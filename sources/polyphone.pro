@@ -241,12 +241,15 @@ SOURCES	+= main.cpp \
     core/input/sfark/inputsfark.cpp \
     core/input/sfz/inputparsersfz.cpp \
     core/input/sfz/inputsfz.cpp \
+    core/sample/samplemapping.cpp \
     core/sample/samplereaderfactory.cpp \
     core/sample/samplereaderflac.cpp \
     core/sample/samplereadersf2.cpp \
     core/sample/samplereaderwav.cpp \
+    core/sample/streamedsample.cpp \
     core/sample/sampleutils.cpp \
     core/sample/samplewriterwav.cpp \
+    core/sample/samplewriterflac.cpp \
     core/sample/sound.cpp \
     core/sample/sampleloader.cpp \
     core/duplicator.cpp \
@@ -264,6 +267,7 @@ SOURCES	+= main.cpp \
     context/interface/editkey.cpp \
     context/audiodevice.cpp \
     context/mididevice.cpp \
+    context/mididispatcher.cpp \
     dialogs/dialog_list.cpp \
     dialogs/dialog_rename.cpp \
     dialogs/dialog_about.cpp \
@@ -310,14 +314,28 @@ SOURCES	+= main.cpp \
     repository/soundfont/editor/soundfontfilecell.cpp \
     sound_engine/elements/liveeq.cpp \
     sound_engine/modulatedparameter.cpp \
+    sound_engine/midifilereader.cpp \
+    sound_engine/offlinerenderer.cpp \
+    sound_engine/profiler.cpp \
+    sound_engine/recorder.cpp \
+    sound_engine/samplestreamer.cpp \
     sound_engine/synth.cpp \
     sound_engine/voice.cpp \
+    sound_engine/voicescratch.cpp \
+    sound_engine/voicemanager.cpp \
+    sound_engine/zoneindex.cpp \
     sound_engine/circularbuffer.cpp \
+    sound_engine/renderscheduler.cpp \
     sound_engine/voiceparam.cpp \
     sound_engine/soundengine.cpp \
+    sound_engine/controllervalues.cpp \
     sound_engine/elements/calibrationsinus.cpp \
     sound_engine/elements/enveloppevol.cpp \
     sound_engine/elements/oscsinus.cpp \
+    sound_engine/elements/dspkernels.cpp \
+    sound_engine/elements/chorus.cpp \
+    sound_engine/elements/reverb.cpp \
+    sound_engine/elements/resampler.cpp \
     lib/sf3/sfont.cpp \
     options.cpp \
     mainwindow/widgetshowhistory.cpp \
@@ -348,6 +366,7 @@ SOURCES	+= main.cpp \
     editor/pagesmpl.cpp \
     core/types/idlist.cpp \
     core/soundfontmanager.cpp \
+    core/readwritelock.cpp \
     core/actionmanager.cpp \
     core/model/soundfont.cpp \
     core/model/division.cpp \
@@ -403,6 +422,7 @@ SOURCES	+= main.cpp \
     editor/tools/transpose_smpl/tooltransposesmpl_gui.cpp \
     context/interface/configpanel.cpp \
     dialogs/dialogkeyboard.cpp \
+    dialogs/dialogdiagnostics.cpp \
     dialogs/dialogrecorder.cpp \
     editor/tools/link_sample/toollinksample.cpp \
     editor/tools/unlink_sample/toolunlinksample.cpp \
@@ -469,6 +489,8 @@ SOURCES	+= main.cpp \
     core/output/not_supported/outputnotsupported.cpp \
     core/output/sfz/sfzparamlist.cpp \
     core/output/sf2/sf2indexconverter.cpp \
+    core/output/sf2/sf2filewriter.cpp \
+    core/output/sf2/sf2pdtabuilder.cpp \
     core/output/sf3/outputsf3.cpp \
     core/input/sfz/sfzparameter.cpp \
     core/input/sfz/sfzparametergroup.cpp \
@@ -564,12 +586,15 @@ HEADERS += \
     core/input/sfz/inputsfz.h \
     core/sample/infosound.h \
     core/sample/samplereader.h \
+    core/sample/samplemapping.h \
     core/sample/samplereaderfactory.h \
     core/sample/samplereaderflac.h \
     core/sample/samplereadersf2.h \
     core/sample/samplereaderwav.h \
+    core/sample/streamedsample.h \
     core/sample/sampleutils.h \
     core/sample/samplewriterwav.h \
+    core/sample/samplewriterflac.h \
     core/sample/sound.h \
     core/sample/sampleloader.h \
     core/duplicator.h \
@@ -587,6 +612,7 @@ HEADERS += \
     context/translationmanager.h \
     context/interface/editkey.h \
     context/mididevice.h \
+    context/mididispatcher.h \
     context/audiodevice.h \
     dialogs/dialog_list.h \
     dialogs/dialog_rename.h \
@@ -637,14 +663,30 @@ HEADERS += \
     repository/soundfont/editor/soundfontfilecell.h \
     sound_engine/elements/liveeq.h \
     sound_engine/modulatedparameter.h \
+    sound_engine/midifilereader.h \
+    sound_engine/offlinerenderer.h \
+    sound_engine/profiler.h \
+    sound_engine/recorder.h \
+    sound_engine/samplestreamer.h \
     sound_engine/synth.h \
     sound_engine/voice.h \
+    sound_engine/voicescratch.h \
+    sound_engine/voicemanager.h \
+    sound_engine/zoneindex.h \
     sound_engine/circularbuffer.h \
+    sound_engine/renderscheduler.h \
     sound_engine/voiceparam.h \
     sound_engine/soundengine.h \
+    sound_engine/lockfreequeue.h \
+    sound_engine/controllersnapshot.h \
+    sound_engine/controllervalues.h \
     sound_engine/elements/calibrationsinus.h \
     sound_engine/elements/enveloppevol.h \
     sound_engine/elements/oscsinus.h \
+    sound_engine/elements/dspkernels.h \
+    sound_engine/elements/chorus.h \
+    sound_engine/elements/reverb.h \
+    sound_engine/elements/resampler.h \
     lib/sf3/sfont.h \
     options.h \
     mainwindow/widgetshowhistory.h \
@@ -675,6 +717,7 @@ HEADERS += \
     editor/pagesmpl.h \
     core/types/idlist.h \
     core/soundfontmanager.h \
+    core/readwritelock.h \
     core/actionmanager.h \
     core/model/soundfont.h \
     core/model/division.h \
@@ -735,9 +778,8 @@ HEADERS += \
     editor/tools/transpose_smpl/tooltransposesmpl_gui.h \
     context/interface/configpanel.h \
     dialogs/dialogkeyboard.h \
+    dialogs/dialogdiagnostics.h \
     dialogs/dialogrecorder.h \
-    context/controllerevent.h \
-    context/noteevent.h \
     editor/tools/link_sample/toollinksample.h \
     editor/tools/unlink_sample/toolunlinksample.h \
     editor/tools/change_attenuation/toolchangeattenuation.h \
@@ -804,6 +846,8 @@ HEADERS += \
     core/output/not_supported/outputnotsupported.h \
     core/output/sfz/sfzparamlist.h \
     core/output/sf2/sf2indexconverter.h \
+    core/output/sf2/sf2filewriter.h \
+    core/output/sf2/sf2pdtabuilder.h \
     core/output/sf3/outputsf3.h \
     core/input/sfz/sfzparameter.h \
     core/input/sfz/sfzparametergroup.h \
@@ -851,10 +895,6 @@ HEADERS += \
     editor/modulator/modulatorcombodest.h \
     editor/modulator/modulatorcombosrc.h \
     editor/modulator/modulatorlistwidget.h \
-    context/polypressureevent.h \
-    context/monopressureevent.h \
-    context/bendevent.h \
-    context/programevent.h \
     clavier/controllerarea.h \
     clavier/combocc.h \
     lib/iir/Iir_2.h \
@@ -923,6 +963,7 @@ FORMS += \
     editor/tools/transpose_smpl/tooltransposesmpl_gui.ui \
     context/interface/configpanel.ui \
     dialogs/dialogkeyboard.ui \
+    dialogs/dialogdiagnostics.ui \
     dialogs/dialogrecorder.ui \
     editor/tools/change_attenuation/toolchangeattenuation_gui.ui \
     editor/tools/global_settings/toolglobalsettings_gui.ui \
@@ -24,6 +24,16 @@
 ***************************************************************************/
 
 #include "circularbuffer.h"
+#include "profiler.h"
+#include "dspkernels.h"
+#include <QElapsedTimer>
+
+static QElapsedTimer startClock()
+{
+    QElapsedTimer clock;
+    clock.start();
+    return clock;
+}
 
 CircularBuffer::CircularBuffer(quint32 minBuffer, quint32 maxBuffer) : QObject(nullptr),
     _minBuffer(minBuffer),
@@ -32,6 +42,11 @@ CircularBuffer::CircularBuffer(quint32 minBuffer, quint32 maxBuffer) : QObject(n
     _posEcriture(0),
     _posLecture(0),
     _currentLengthAvailable(0),
+    _totalRead(0),
+    _totalWritten(0),
+    _readSequence(0),
+    _readTime(0),
+    _readLatency(0),
     _interrupted(0)
 {
 
@@ -58,6 +73,31 @@ CircularBuffer::~CircularBuffer()
     delete [] _dataTmpRevR;
 }
 
+qint64 CircularBuffer::currentTime()
+{
+    static QElapsedTimer clock = startClock();
+    return clock.nsecsElapsed();
+}
+
+quint32 CircularBuffer::positionAt(qint64 time, quint32 sampleRate)
+{
+    // Consistent copy of the last reading
+    int sequence;
+    quint32 readPosition, latency;
+    qint64 readTime;
+    do
+    {
+        sequence = _readSequence.loadAcquire();
+        readPosition = _totalRead.load();
+        readTime = _readTime.load();
+        latency = _readLatency.load();
+    } while ((sequence & 1) != 0 || sequence != _readSequence.loadAcquire());
+
+    // The reading is considered continuous between two calls of the audio server
+    qint64 elapsed = (time - readTime) * sampleRate / 1000000000;
+    return readPosition + latency + static_cast<quint32>(elapsed);
+}
+
 void CircularBuffer::stop()
 {
     _interrupted.store(1);
@@ -67,16 +107,17 @@ void CircularBuffer::stop()
 
 void CircularBuffer::start()
 {
+    // This thread computes audio
+    DspKernels::disableDenormals();
+
     quint32 avance = (_maxBuffer + _minBuffer) / 2;
 
     // Generate and copy data into the buffer after each reading
     while (_interrupted.load() == 0)
     {
         // Generate data
-        _mutexBuffer.lock();
         generateData(_dataTmpL, _dataTmpR, _dataTmpRevL, _dataTmpRevR, avance);
         writeData(_dataTmpL, _dataTmpR, _dataTmpRevL, _dataTmpRevR, avance);
-        _mutexBuffer.unlock();
         _mutexSynchro.lock();
     }
 
@@ -100,6 +141,8 @@ void CircularBuffer::writeData(const float *dataL, const float *dataR, float *da
         total += chunk;
     }
 
+    _totalWritten += total;
+
     // Update the quantity of data to read
     if (_currentLengthAvailable > _maxBuffer)
         len = _minBuffer; // Minimum to read
@@ -110,10 +153,34 @@ void CircularBuffer::writeData(const float *dataL, const float *dataR, float *da
     _currentLengthAvailable.fetchAndAddAcquire(total);
 }
 
+void CircularBuffer::computeDirect(quint32 len)
+{
+    generateData(_dataTmpL, _dataTmpR, _dataTmpRevL, _dataTmpRevR, len);
+
+    // Data is read as soon as it is written: an event can be taken into account in the next call
+    _totalWritten += len;
+    updateReading(len, len);
+}
+
+void CircularBuffer::addDirectData(float *dataL, float *dataR, float *dataRevL, float *dataRevR, quint32 len)
+{
+    for (quint32 i = 0; i < len; i++)
+    {
+        dataL   [i] += _dataTmpL   [i];
+        dataR   [i] += _dataTmpR   [i];
+        dataRevL[i] += _dataTmpRevL[i];
+        dataRevR[i] += _dataTmpRevR[i];
+    }
+}
+
 // Read data (audio thread)
 void CircularBuffer::addData(float *dataL, float *dataR, float *dataRevL, float *dataRevR, quint32 maxlen)
 {
-    quint32 readLen = qMin(maxlen, _currentLengthAvailable.load());
+    quint32 available = _currentLengthAvailable.load();
+    quint32 readLen = qMin(maxlen, available);
+    Profiler::reportBufferLevel(available);
+    if (readLen < maxlen)
+        Profiler::addBufferUnderrun();
     quint32 total = 0;
     while (total < readLen)
     {
@@ -129,6 +196,9 @@ void CircularBuffer::addData(float *dataL, float *dataR, float *dataRevL, float
         total += chunk;
     }
 
+    // An event can be taken into account after the data already written
+    updateReading(total, _minBuffer + (_maxBuffer + _minBuffer) / 2);
+
     // Possibly trigger data generation
     if (_currentLengthAvailable.fetchAndSubAcquire(total) - total <= _minBuffer)
     {
@@ -136,3 +206,12 @@ void CircularBuffer::addData(float *dataL, float *dataR, float *dataRevL, float
         _mutexSynchro.unlock();
     }
 }
+
+void CircularBuffer::updateReading(quint32 len, quint32 latency)
+{
+    _readSequence.fetchAndAddOrdered(1);
+    _readTime.store(currentTime());
+    _readLatency.store(latency);
+    _totalRead.fetchAndAddRelaxed(len);
+    _readSequence.fetchAndAddOrdered(1);
+}
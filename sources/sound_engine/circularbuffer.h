@@ -39,26 +39,54 @@ public:
 
     void addData(float *dataL, float *dataR, float *dataRevL, float *dataRevR, quint32 maxlen);
     quint32 currentLengthAvailable() { return _currentLengthAvailable.load(); }
+
+    // Number of values read since the beginning (modulo 2^32)
+    quint32 currentReadPosition() { return _totalRead.load(); }
+
+    // Monotonic clock in nanoseconds, shared by the MIDI input and the audio threads
+    static qint64 currentTime();
+
+    // Position in the stream that will be played at the given time (see currentTime)
+    // The latency of the buffer is included so that the position has not been computed yet
+    quint32 positionAt(qint64 time, quint32 sampleRate);
+
     void stop();
 
+    // Direct rendering (the thread loop is not started): compute "len" values (at most maxBuffer)
+    // in the internal buffers, then add them to the output without look-ahead
+    void computeDirect(quint32 len);
+    void addDirectData(float *dataL, float *dataR, float *dataRevL, float *dataRevR, quint32 len);
+
 public slots:
     void start();
 
 protected:
     virtual void generateData(float *dataL, float *dataR, float *dataRevL, float *dataRevR, quint32 len) = 0;
-    QMutex _mutexBuffer;
+
+    // Number of values written since the beginning (modulo 2^32), only for the sound engine thread
+    quint32 currentWritePosition() { return _totalWritten; }
 
 private:
     // Sound engine thread => write data in the buffer
     // "len" contains at the end the data length that should have been written to meet the buffer requirements
     void writeData(const float *dataL, const float *dataR, float *dataRevL, float *dataRevR, quint32 &len);
 
+    // Audio thread => update the reading position, time and latency
+    void updateReading(quint32 len, quint32 latency);
+
     // Buffer et positions
     float * _dataL, * _dataR, * _dataRevL, * _dataRevR;
     float * _dataTmpL, * _dataTmpR, * _dataTmpRevL, * _dataTmpRevR;
     const quint32 _minBuffer, _maxBuffer, _bufferSize;
     quint32 _posEcriture, _posLecture;
     QAtomicInteger<quint32> _currentLengthAvailable;
+    QAtomicInteger<quint32> _totalRead;
+    quint32 _totalWritten;
+
+    // Time of the last reading and latency, protected by a sequence number (odd during an update)
+    QAtomicInt _readSequence;
+    QAtomicInteger<qint64> _readTime;
+    QAtomicInteger<quint32> _readLatency;
 
     // Gestion interruption
     QAtomicInt _interrupted;
@@ -1,7 +1,7 @@
 /***************************************************************************
 **                                                                        **
 **  Polyphone, a soundfont editor                                         **
-**  Copyright (C) 2013-2020 Davy Triponney                                **
+**  Copyright (C) 2013-2019 Davy Triponney                                **
 **                                                                        **
 **  This program is free software: you can redistribute it and/or modify  **
 **  it under the terms of the GNU General Public License as published by  **
@@ -22,24 +22,35 @@
 **             Date: 01.01.2013                                           **
 ***************************************************************************/
 
-#ifndef MONOPRESSUREEVENT_H
-#define MONOPRESSUREEVENT_H
 
-#include <QEvent>
+#ifndef CONTROLLERSNAPSHOT_H
+#define CONTROLLERSNAPSHOT_H
 
-class MonoPressureEvent : public QEvent
-{
-public:
-    MonoPressureEvent(unsigned char val) : QEvent((QEvent::Type)(QEvent::User+3)),
-          _pressure(val) {}
+#include <QtGlobal>
+
+#define MIDI_CHANNEL_NUMBER 16
 
-    unsigned char getPressure() const
+// Copy of the MIDI values of a channel read by the modulators
+// Each sound engine updates its copy only when the version of the MIDI values changed,
+// so that the voices never lock the MIDI device
+struct ControllerSnapshot
+{
+    ControllerSnapshot() :
+        version(-1),
+        monoPressure(0),
+        bendValue(0),
+        bendSensitivityValue(2)
     {
-        return _pressure;
+        for (int i = 0; i < 128; i++)
+            controllerValues[i] = polyPressureValues[i] = -1;
     }
 
-protected:
-    unsigned char _pressure;
+    int version;
+    int controllerValues[128]; // -1 if not received yet
+    int polyPressureValues[128]; // -1 if not received yet
+    int monoPressure;
+    double bendValue;
+    double bendSensitivityValue;
 };
 
-#endif // MONOPRESSUREEVENT_H
+#endif // CONTROLLERSNAPSHOT_H
@@ -0,0 +1,218 @@
+/***************************************************************************
+**                                                                        **
+**  Polyphone, a soundfont editor                                         **
+**  Copyright (C) 2013-2019 Davy Triponney                                **
+**                                                                        **
+**  This program is free software: you can redistribute it and/or modify  **
+**  it under the terms of the GNU General Public License as published by  **
+**  the Free Software Foundation, either version 3 of the License, or     **
+**  (at your option) any later version.                                   **
+**                                                                        **
+**  This program is distributed in the hope that it will be useful,       **
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of        **
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the          **
+**  GNU General Public License for more details.                          **
+**                                                                        **
+**  You should have received a copy of the GNU General Public License     **
+**  along with this program. If not, see http://www.gnu.org/licenses/.    **
+**                                                                        **
+****************************************************************************
+**           Author: Davy Triponney                                       **
+**  Website/Contact: https://www.polyphone-soundfonts.com                 **
+**             Date: 01.01.2013                                           **
+***************************************************************************/
+
+#include "controllervalues.h"
+#include <atomic>
+
+ControllerValues::ControllerValues() :
+    _version(0)
+{
+    // Same values for all channels
+    for (int channel = 0; channel < MIDI_CHANNEL_NUMBER; channel++)
+    {
+        _values[channel].version = 0;
+        for (int i = 0; i < 128; i++)
+            _values[channel].controllerValues[i] = getDefaultValue(i);
+    }
+}
+
+int ControllerValues::getDefaultValue(int number)
+{
+    switch (number)
+    {
+    case 0: // Bank select
+    case 1: // Modulation wheel
+    case 2: // Breath controller
+    case 4: // Foot controller
+    case 12: case 13: // Effect controllers
+    case 64: case 65: case 66: case 67: case 68: case 69: // Pedals
+    case 80: case 81: case 82: case 83: // On/Off switch
+    case 91: case 92: case 93: case 94: case 95: // Effect amount
+        return 0;
+    case 7: case 11: // Main volume, expression
+        return 127;
+    default:
+        return 64;
+    }
+}
+
+void ControllerValues::setControllerValue(int channel, int number, int value)
+{
+    if (number < 0 || number >= 128)
+        return;
+    _mutex.lock();
+    if (_values[channel].controllerValues[number] != value)
+    {
+        beginChange(channel);
+        _values[channel].controllerValues[number] = value;
+        endChange(channel);
+    }
+    _mutex.unlock();
+}
+
+void ControllerValues::setPolyPressure(int channel, int key, int pressure)
+{
+    if (key < 0 || key >= 128)
+        return;
+    _mutex.lock();
+    if (_values[channel].polyPressureValues[key] != pressure)
+    {
+        beginChange(channel);
+        _values[channel].polyPressureValues[key] = pressure;
+        endChange(channel);
+    }
+    _mutex.unlock();
+}
+
+void ControllerValues::initPolyPressure(int channel, int key, int pressure)
+{
+    if (key < 0 || key >= 128)
+        return;
+    _mutex.lock();
+    if (_values[channel].polyPressureValues[key] == -1)
+    {
+        beginChange(channel);
+        _values[channel].polyPressureValues[key] = pressure;
+        endChange(channel);
+    }
+    _mutex.unlock();
+}
+
+void ControllerValues::setMonoPressure(int channel, int value)
+{
+    _mutex.lock();
+    if (_values[channel].monoPressure != value)
+    {
+        beginChange(channel);
+        _values[channel].monoPressure = value;
+        endChange(channel);
+    }
+    _mutex.unlock();
+}
+
+void ControllerValues::setBendValue(int channel, double value)
+{
+    _mutex.lock();
+    if (_values[channel].bendValue != value)
+    {
+        beginChange(channel);
+        _values[channel].bendValue = value;
+        endChange(channel);
+    }
+    _mutex.unlock();
+}
+
+void ControllerValues::setBendSensitivityValue(int channel, double semitones)
+{
+    _mutex.lock();
+    if (_values[channel].bendSensitivityValue != semitones)
+    {
+        beginChange(channel);
+        _values[channel].bendSensitivityValue = semitones;
+        endChange(channel);
+    }
+    _mutex.unlock();
+}
+
+int ControllerValues::getControllerValue(int channel, int number)
+{
+    _mutex.lock();
+    int result = (number >= 0 && number < 128) ? _values[channel].controllerValues[number] : -1;
+    _mutex.unlock();
+    return result;
+}
+
+int ControllerValues::getPolyPressure(int channel, int key)
+{
+    _mutex.lock();
+    int result = (key >= 0 && key < 128) ? _values[channel].polyPressureValues[key] : -1;
+    _mutex.unlock();
+    return result;
+}
+
+int ControllerValues::getMonoPressure(int channel)
+{
+    _mutex.lock();
+    int result = _values[channel].monoPressure;
+    _mutex.unlock();
+    return result;
+}
+
+double ControllerValues::getBendValue(int channel)
+{
+    _mutex.lock();
+    double result = _values[channel].bendValue;
+    _mutex.unlock();
+    return result;
+}
+
+double ControllerValues::getBendSensitivityValue(int channel)
+{
+    _mutex.lock();
+    double result = _values[channel].bendSensitivityValue;
+    _mutex.unlock();
+    return result;
+}
+
+void ControllerValues::beginChange(int channel)
+{
+    // Odd sequence while the values of the channel are modified (_mutex being locked)
+    _sequences[channel].fetchAndAddRelaxed(1);
+    std::atomic_thread_fence(std::memory_order_release);
+}
+
+void ControllerValues::endChange(int channel)
+{
+    _values[channel].version = _version.fetchAndAddRelaxed(1) + 1;
+    _sequences[channel].fetchAndAddRelease(1);
+}
+
+int ControllerValues::getSnapshots(ControllerSnapshot * snapshots)
+{
+    // Called by the sound engines: nothing is locked, a copy being kept only if the sequence of the channel
+    // didn't change while it was read. Otherwise the previous copy is kept and -1 is returned, so that the
+    // copy is tried again at the next call
+    int version = _version.loadAcquire();
+    bool isComplete = true;
+    for (int channel = 0; channel < MIDI_CHANNEL_NUMBER; channel++)
+    {
+        // Only the channels that changed are copied
+        int sequence = _sequences[channel].loadAcquire();
+        if (sequence & 1)
+        {
+            isComplete = false; // Being modified
+            continue;
+        }
+        if (snapshots[channel].version == _values[channel].version)
+            continue;
+
+        ControllerSnapshot copy = _values[channel];
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (_sequences[channel].load() == sequence)
+            snapshots[channel] = copy;
+        else
+            isComplete = false;
+    }
+    return isComplete ? version : -1;
+}
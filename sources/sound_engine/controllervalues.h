@@ -0,0 +1,74 @@
+/***************************************************************************
+**                                                                        **
+**  Polyphone, a soundfont editor                                         **
+**  Copyright (C) 2013-2019 Davy Triponney                                **
+**                                                                        **
+**  This program is free software: you can redistribute it and/or modify  **
+**  it under the terms of the GNU General Public License as published by  **
+**  the Free Software Foundation, either version 3 of the License, or     **
+**  (at your option) any later version.                                   **
+**                                                                        **
+**  This program is distributed in the hope that it will be useful,       **
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of        **
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the          **
+**  GNU General Public License for more details.                          **
+**                                                                        **
+**  You should have received a copy of the GNU General Public License     **
+**  along with this program. If not, see http://www.gnu.org/licenses/.    **
+**                                                                        **
+****************************************************************************
+**           Author: Davy Triponney                                       **
+**  Website/Contact: https://www.polyphone-soundfonts.com                 **
+**             Date: 01.01.2013                                           **
+***************************************************************************/
+
+#ifndef CONTROLLERVALUES_H
+#define CONTROLLERVALUES_H
+
+#include <QMutex>
+#include <QAtomicInt>
+#include "controllersnapshot.h"
+
+// Last MIDI values of each channel, written by the MIDI device or by the offline renderer and read by the sound engines
+// Writers lock a mutex, the sound engines read without lock and check the sequence of the channel
+// (odd while being written, see beginChange and endChange)
+class ControllerValues
+{
+public:
+    ControllerValues();
+
+    // Change a value (the version is incremented only if the value is different)
+    void setControllerValue(int channel, int number, int value);
+    void setPolyPressure(int channel, int key, int pressure);
+    void initPolyPressure(int channel, int key, int pressure); // Only if no pressure has been received yet
+    void setMonoPressure(int channel, int value);
+    void setBendValue(int channel, double value);
+    void setBendSensitivityValue(int channel, double semitones);
+
+    // Get a value (-1 if not received yet)
+    int getControllerValue(int channel, int number);
+    int getPolyPressure(int channel, int key);
+    int getMonoPressure(int channel);
+    double getBendValue(int channel);
+    double getBendSensitivityValue(int channel);
+
+    // Copy the values of the channels that changed for the sound engines (MIDI_CHANNEL_NUMBER snapshots)
+    // The global version is incremented each time a value changes, it is returned (or -1 if a channel
+    // being modified could not be copied). No lock is taken: this is called from the audio threads
+    int getVersion() { return _version.load(); }
+    int getSnapshots(ControllerSnapshot * snapshots);
+
+    // Initial value of a controller
+    static int getDefaultValue(int number);
+
+private:
+    void beginChange(int channel);
+    void endChange(int channel);
+
+    QMutex _mutex;
+    ControllerSnapshot _values[MIDI_CHANNEL_NUMBER];
+    QAtomicInt _sequences[MIDI_CHANNEL_NUMBER];
+    QAtomicInt _version;
+};
+
+#endif // CONTROLLERVALUES_H
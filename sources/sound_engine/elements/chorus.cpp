@@ -0,0 +1,127 @@
+/***************************************************************************
+**                                                                        **
+**  Polyphone, a soundfont editor                                         **
+**  Copyright (C) 2013-2019 Davy Triponney                                **
+**                                                                        **
+**  This program is free software: you can redistribute it and/or modify  **
+**  it under the terms of the GNU General Public License as published by  **
+**  the Free Software Foundation, either version 3 of the License, or     **
+**  (at your option) any later version.                                   **
+**                                                                        **
+**  This program is distributed in the hope that it will be useful,       **
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of        **
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the          **
+**  GNU General Public License for more details.                          **
+**                                                                        **
+**  You should have received a copy of the GNU General Public License     **
+**  along with this program. If not, see http://www.gnu.org/licenses/.    **
+**                                                                        **
+****************************************************************************
+**           Author: Davy Triponney                                       **
+**  Website/Contact: https://www.polyphone-soundfonts.com                 **
+**             Date: 01.01.2013                                           **
+***************************************************************************/
+
+
+#include "chorus.h"
+#include <qmath.h>
+
+const double Chorus::BASE_DELAY = 6000. / 44100.;
+const quint32 Chorus::CHUNK_SIZE = 64;
+
+Chorus::Chorus() :
+    _level(0),
+    _mask(0),
+    _writePos(0),
+    _silentLength(0)
+{
+    _phase[0] = _phase[1] = 0;
+    setParameters(0, 0, 0, 44100);
+}
+
+void Chorus::setParameters(int level, int depth, int frequency, quint32 sampleRate)
+{
+    // Same tuning as stk::Chorus
+    double baseDelay = BASE_DELAY * sampleRate;
+    _baseDelay[0] = static_cast<float>(0.707 * baseDelay);
+    _baseDelay[1] = static_cast<float>(0.5 * baseDelay);
+    _modDepth[0] = 0.00025f * depth;
+    _modDepth[1] = -_modDepth[0];
+    _phaseIncrement[0] = 2. * M_PI * 0.06667 * frequency / sampleRate;
+    _phaseIncrement[1] = 1.1111 * _phaseIncrement[0];
+
+    // Size of the delay lines, a chunk being written before being read
+    quint32 maxDelay = static_cast<quint32>(_baseDelay[0] * (1.f + _modDepth[0])) + 2;
+    quint32 size = 1;
+    while (size < maxDelay + CHUNK_SIZE)
+        size <<= 1;
+
+    // The delay lines are emptied if resized or if the chorus is enabled again (no old data played)
+    if (size != _mask + 1 || (_level == 0 && level > 0))
+    {
+        for (int i = 0; i < 2; i++)
+            _buffer[i].fill(0, static_cast<int>(size));
+        _mask = size - 1;
+        _writePos = 0;
+        _silentLength = size;
+    }
+    _level = level;
+}
+
+void Chorus::process(const float *busL, const float *busR, float *dataL, float *dataR, quint32 len, bool isBusEmpty)
+{
+    if (_level == 0)
+        return;
+
+    // Nothing to do if the delay lines only contain zeros
+    if (isBusEmpty)
+    {
+        if (_silentLength > _mask)
+            return;
+        _silentLength += len;
+    }
+    else
+        _silentLength = 0;
+
+    for (quint32 start = 0; start < len; start += CHUNK_SIZE)
+    {
+        quint32 chunk = qMin(CHUNK_SIZE, len - start);
+        for (int channel = 0; channel < 2; channel++)
+        {
+            // Delays at the beginning and at the end of the chunk, linearly interpolated in between
+            float delayStart = _baseDelay[channel] * (1.f + _modDepth[channel] * static_cast<float>(qSin(_phase[channel])));
+            _phase[channel] += _phaseIncrement[channel] * chunk;
+            if (_phase[channel] > 2. * M_PI)
+                _phase[channel] -= 2. * M_PI;
+            float delayEnd = _baseDelay[channel] * (1.f + _modDepth[channel] * static_cast<float>(qSin(_phase[channel])));
+
+            if (channel == 0)
+                processChannel(0, &busL[start], &dataL[start], chunk, delayStart, delayEnd);
+            else
+                processChannel(1, &busR[start], &dataR[start], chunk, delayStart, delayEnd);
+        }
+        _writePos = (_writePos + chunk) & _mask;
+    }
+}
+
+void Chorus::processChannel(int channel, const float *bus, float *data, quint32 len, float delayStart, float delayEnd)
+{
+    float * buffer = _buffer[channel].data();
+
+    // Write the chunk
+    for (quint32 i = 0; i < len; i++)
+        buffer[(_writePos + i) & _mask] = bus[i];
+
+    // Read the delay line with a linear interpolation
+    float step = (delayEnd - delayStart) / len;
+    for (quint32 i = 0; i < len; i++)
+    {
+        float delay = delayStart + step * i;
+        quint32 delayInt = static_cast<quint32>(delay);
+        float frac = delay - static_cast<float>(delayInt);
+        quint32 pos = _writePos + i - delayInt;
+        float val1 = buffer[pos & _mask];
+        float val2 = buffer[(pos - 1) & _mask];
+        data[i] += val1 + frac * (val2 - val1);
+    }
+}
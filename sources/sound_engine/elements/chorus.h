@@ -0,0 +1,67 @@
+/***************************************************************************
+**                                                                        **
+**  Polyphone, a soundfont editor                                         **
+**  Copyright (C) 2013-2019 Davy Triponney                                **
+**                                                                        **
+**  This program is free software: you can redistribute it and/or modify  **
+**  it under the terms of the GNU General Public License as published by  **
+**  the Free Software Foundation, either version 3 of the License, or     **
+**  (at your option) any later version.                                   **
+**                                                                        **
+**  This program is distributed in the hope that it will be useful,       **
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of        **
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the          **
+**  GNU General Public License for more details.                          **
+**                                                                        **
+**  You should have received a copy of the GNU General Public License     **
+**  along with this program. If not, see http://www.gnu.org/licenses/.    **
+**                                                                        **
+****************************************************************************
+**           Author: Davy Triponney                                       **
+**  Website/Contact: https://www.polyphone-soundfonts.com                 **
+**             Date: 01.01.2013                                           **
+***************************************************************************/
+
+
+#ifndef CHORUS_H
+#define CHORUS_H
+
+#include <QVector>
+
+// Stereo chorus of a sound engine, applied by blocks on the sum of the voice sends
+// Each channel of the bus goes through a delay line modulated by a sinus
+// Only accessed by the thread of the sound engine
+class Chorus
+{
+public:
+    Chorus();
+
+    // Level, depth and frequency are between 0 and 100
+    void setParameters(int level, int depth, int frequency, quint32 sampleRate);
+    bool isOn() { return _level > 0; }
+
+    // Coefficient applied to a voice for the send bus, depending on the chorus send of the voice (0 - 100)
+    float getSendCoef(float voiceSend) { return 0.00005f * _level * voiceSend; }
+
+    // Add to dataL / dataR the output of the chorus for the bus busL / busR
+    // "isBusEmpty" is true if no voices have been added to the bus: nothing is done once the delay lines are empty
+    void process(const float *busL, const float *busR, float *dataL, float *dataR, quint32 len, bool isBusEmpty);
+
+private:
+    void processChannel(int channel, const float *bus, float *data, quint32 len, float delayStart, float delayEnd);
+
+    int _level;
+    float _baseDelay[2];
+    float _modDepth[2]; // Signed, the modulation of the right channel is inverted
+    double _phase[2], _phaseIncrement[2];
+
+    // Delay lines (size being a power of 2)
+    QVector<float> _buffer[2];
+    quint32 _mask, _writePos;
+    quint32 _silentLength;
+
+    static const double BASE_DELAY; // In seconds
+    static const quint32 CHUNK_SIZE; // Number of values between two computations of the modulation
+};
+
+#endif // CHORUS_H
@@ -0,0 +1,542 @@
+/***************************************************************************
+**                                                                        **
+**  Polyphone, a soundfont editor                                         **
+**  Copyright (C) 2013-2019 Davy Triponney                                **
+**                                                                        **
+**  This program is free software: you can redistribute it and/or modify  **
+**  it under the terms of the GNU General Public License as published by  **
+**  the Free Software Foundation, either version 3 of the License, or     **
+**  (at your option) any later version.                                   **
+**                                                                        **
+**  This program is distributed in the hope that it will be useful,       **
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of        **
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the          **
+**  GNU General Public License for more details.                          **
+**                                                                        **
+**  You should have received a copy of the GNU General Public License     **
+**  along with this program. If not, see http://www.gnu.org/licenses/.    **
+**                                                                        **
+****************************************************************************
+**           Author: Davy Triponney                                       **
+**  Website/Contact: https://www.polyphone-soundfonts.com                 **
+**             Date: 01.01.2013                                           **
+***************************************************************************/
+
+
+#include "dspkernels.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define DSP_KERNELS_X86
+#define TARGET_SSE2 __attribute__((target("sse2")))
+#define TARGET_AVX2 __attribute__((target("avx2")))
+#include <immintrin.h>
+#elif defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#define DSP_KERNELS_X86
+#define TARGET_SSE2
+#define TARGET_AVX2
+#include <intrin.h>
+#include <immintrin.h>
+#endif
+
+static const float SCALE_32_BITS = 1.f / 2147483648.f;
+
+enum InstructionSet
+{
+    INSTRUCTIONS_SCALAR,
+    INSTRUCTIONS_SSE2,
+    INSTRUCTIONS_AVX2
+};
+
+static InstructionSet detectInstructionSet()
+{
+#if defined(DSP_KERNELS_X86) && defined(__GNUC__)
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2"))
+        return INSTRUCTIONS_AVX2;
+    if (__builtin_cpu_supports("sse2"))
+        return INSTRUCTIONS_SSE2;
+#elif defined(DSP_KERNELS_X86)
+    int info[4];
+    __cpuid(info, 0);
+    int maxLeaf = info[0];
+    __cpuid(info, 1);
+    bool sse2 = (info[3] & (1 << 26)) != 0;
+    bool avx = (info[2] & (1 << 28)) != 0 && (info[2] & (1 << 27)) != 0 && (_xgetbv(0) & 6) == 6;
+    if (avx && maxLeaf >= 7)
+    {
+        __cpuidex(info, 7, 0);
+        if ((info[1] & (1 << 5)) != 0)
+            return INSTRUCTIONS_AVX2;
+    }
+    if (sse2)
+        return INSTRUCTIONS_SSE2;
+#endif
+    return INSTRUCTIONS_SCALAR;
+}
+
+static InstructionSet instructionSet()
+{
+    static InstructionSet result = detectInstructionSet();
+    return result;
+}
+
+///////////////
+/// SCALAR ///
+///////////////
+
+static void interpolateLinearScalar(const qint32 *data, const float *positions, float *output, quint32 len)
+{
+    for (quint32 i = 0; i < len; i++)
+    {
+        quint32 index = static_cast<quint32>(positions[i]);
+        float pos = positions[i] - static_cast<float>(index);
+        float val1 = static_cast<float>(data[index]);
+        float val2 = static_cast<float>(data[index + 1]);
+        output[i] = (val1 + pos * (val2 - val1)) * SCALE_32_BITS;
+    }
+}
+
+static void interpolatePolyphaseScalar(const qint32 *data, const float *positions, float *output, quint32 len,
+                                       const float *table, int taps, int phases)
+{
+    for (quint32 i = 0; i < len; i++)
+    {
+        quint32 index = static_cast<quint32>(positions[i]);
+        float phase = (positions[i] - static_cast<float>(index)) * phases;
+        int row = static_cast<int>(phase);
+        float weight = phase - static_cast<float>(row);
+        const float * coef1 = &table[row * taps];
+        const float * coef2 = &coef1[taps];
+        const qint32 * values = &data[index + 1 - taps / 2];
+        float result = 0;
+        for (int j = 0; j < taps; j++)
+            result += (coef1[j] + weight * (coef2[j] - coef1[j])) * static_cast<float>(values[j]);
+        output[i] = result * SCALE_32_BITS;
+    }
+}
+
+static float multiplyLinearRampScalar(float *data, quint32 len, float gain, float start, float step)
+{
+    float value = start;
+    for (quint32 i = 0; i < len; i++)
+    {
+        data[i] *= gain * value;
+        value += step;
+    }
+    return value;
+}
+
+static float multiplyExponentialRampScalar(float *data, quint32 len, float gain, float start, float coef, float offset)
+{
+    float value = start;
+    for (quint32 i = 0; i < len; i++)
+    {
+        data[i] *= gain * (offset + value);
+        value *= coef;
+    }
+    return offset + value;
+}
+
+static void mixStereoScalar(const float *srcL, const float *srcR, float *dryL, float *dryR, float *revL, float *revR,
+                            float dryCoef, float revCoef, quint32 len)
+{
+    for (quint32 i = 0; i < len; i++)
+    {
+        dryL[i] += dryCoef * srcL[i];
+        dryR[i] += dryCoef * srcR[i];
+        revL[i] += revCoef * srcL[i];
+        revR[i] += revCoef * srcR[i];
+    }
+}
+
+static void addStereoScalar(const float *srcL, const float *srcR, float *dstL, float *dstR, float coef, quint32 len)
+{
+    for (quint32 i = 0; i < len; i++)
+    {
+        dstL[i] += coef * srcL[i];
+        dstR[i] += coef * srcR[i];
+    }
+}
+
+static void biquadCascadeStereoScalar(float *dataL, float *dataR, quint32 len, const float *coefs, float *states, int stages)
+{
+    for (int s = 0; s < stages; s++)
+    {
+        const float * c = &coefs[5 * s];
+        float z1L = states[4 * s], z1R = states[4 * s + 1], z2L = states[4 * s + 2], z2R = states[4 * s + 3];
+        for (quint32 i = 0; i < len; i++)
+        {
+            float x = dataL[i];
+            float y = c[0] * x + z1L;
+            z1L = c[1] * x - c[3] * y + z2L;
+            z2L = c[2] * x - c[4] * y;
+            dataL[i] = y;
+
+            x = dataR[i];
+            y = c[0] * x + z1R;
+            z1R = c[1] * x - c[3] * y + z2R;
+            z2R = c[2] * x - c[4] * y;
+            dataR[i] = y;
+        }
+        states[4 * s] = z1L;
+        states[4 * s + 1] = z1R;
+        states[4 * s + 2] = z2L;
+        states[4 * s + 3] = z2R;
+    }
+}
+
+#ifdef DSP_KERNELS_X86
+
+////////////
+/// SSE2 ///
+////////////
+
+TARGET_SSE2 static void interpolateLinearSse2(const qint32 *data, const float *positions, float *output, quint32 len)
+{
+    const __m128 scale = _mm_set1_ps(SCALE_32_BITS);
+    alignas(16) qint32 index[4];
+    quint32 i = 0;
+    for (; i + 4 <= len; i += 4)
+    {
+        __m128 pos = _mm_loadu_ps(&positions[i]);
+        __m128i indexes = _mm_cvttps_epi32(pos); // Positions are positive: truncation is floor
+        __m128 frac = _mm_sub_ps(pos, _mm_cvtepi32_ps(indexes));
+        _mm_store_si128(reinterpret_cast<__m128i *>(index), indexes);
+        __m128 val1 = _mm_cvtepi32_ps(_mm_setr_epi32(data[index[0]], data[index[1]], data[index[2]], data[index[3]]));
+        __m128 val2 = _mm_cvtepi32_ps(_mm_setr_epi32(data[index[0] + 1], data[index[1] + 1],
+                                                     data[index[2] + 1], data[index[3] + 1]));
+        __m128 result = _mm_add_ps(val1, _mm_mul_ps(frac, _mm_sub_ps(val2, val1)));
+        _mm_storeu_ps(&output[i], _mm_mul_ps(result, scale));
+    }
+    interpolateLinearScalar(data, &positions[i], &output[i], len - i);
+}
+
+TARGET_SSE2 static void interpolatePolyphaseSse2(const qint32 *data, const float *positions, float *output, quint32 len,
+                                                 const float *table, int taps, int phases)
+{
+    for (quint32 i = 0; i < len; i++)
+    {
+        quint32 index = static_cast<quint32>(positions[i]);
+        float phase = (positions[i] - static_cast<float>(index)) * phases;
+        int row = static_cast<int>(phase);
+        const __m128 weight = _mm_set1_ps(phase - static_cast<float>(row));
+        const float * coef1 = &table[row * taps];
+        const float * coef2 = &coef1[taps];
+        const qint32 * values = &data[index + 1 - taps / 2];
+        __m128 sum = _mm_setzero_ps();
+        for (int j = 0; j < taps; j += 4)
+        {
+            __m128 c1 = _mm_loadu_ps(&coef1[j]);
+            __m128 coef = _mm_add_ps(c1, _mm_mul_ps(weight, _mm_sub_ps(_mm_loadu_ps(&coef2[j]), c1)));
+            __m128 value = _mm_cvtepi32_ps(_mm_loadu_si128(reinterpret_cast<const __m128i *>(&values[j])));
+            sum = _mm_add_ps(sum, _mm_mul_ps(coef, value));
+        }
+
+        // Horizontal sum
+        sum = _mm_add_ps(sum, _mm_movehl_ps(sum, sum));
+        sum = _mm_add_ss(sum, _mm_shuffle_ps(sum, sum, 1));
+        output[i] = _mm_cvtss_f32(sum) * SCALE_32_BITS;
+    }
+}
+
+TARGET_SSE2 static float multiplyLinearRampSse2(float *data, quint32 len, float gain, float start, float step)
+{
+    __m128 value = _mm_setr_ps(start, start + step, start + 2 * step, start + 3 * step);
+    const __m128 increment = _mm_set1_ps(4 * step);
+    const __m128 gains = _mm_set1_ps(gain);
+    quint32 i = 0;
+    for (; i + 4 <= len; i += 4)
+    {
+        __m128 values = _mm_loadu_ps(&data[i]);
+        _mm_storeu_ps(&data[i], _mm_mul_ps(values, _mm_mul_ps(gains, value)));
+        value = _mm_add_ps(value, increment);
+    }
+    return multiplyLinearRampScalar(&data[i], len - i, gain, _mm_cvtss_f32(value), step);
+}
+
+TARGET_SSE2 static float multiplyExponentialRampSse2(float *data, quint32 len, float gain, float start, float coef, float offset)
+{
+    float coef2 = coef * coef;
+    __m128 value = _mm_setr_ps(start, start * coef, start * coef2, start * coef2 * coef);
+    const __m128 factor = _mm_set1_ps(coef2 * coef2);
+    const __m128 gains = _mm_set1_ps(gain);
+    const __m128 offsets = _mm_set1_ps(offset);
+    quint32 i = 0;
+    for (; i + 4 <= len; i += 4)
+    {
+        __m128 values = _mm_loadu_ps(&data[i]);
+        _mm_storeu_ps(&data[i], _mm_mul_ps(values, _mm_mul_ps(gains, _mm_add_ps(offsets, value))));
+        value = _mm_mul_ps(value, factor);
+    }
+    return multiplyExponentialRampScalar(&data[i], len - i, gain, _mm_cvtss_f32(value), coef, offset);
+}
+
+TARGET_SSE2 static void mixStereoSse2(const float *srcL, const float *srcR, float *dryL, float *dryR, float *revL, float *revR,
+                                      float dryCoef, float revCoef, quint32 len)
+{
+    const __m128 dry = _mm_set1_ps(dryCoef);
+    const __m128 rev = _mm_set1_ps(revCoef);
+    quint32 i = 0;
+    for (; i + 4 <= len; i += 4)
+    {
+        __m128 left = _mm_loadu_ps(&srcL[i]);
+        __m128 right = _mm_loadu_ps(&srcR[i]);
+        _mm_storeu_ps(&dryL[i], _mm_add_ps(_mm_loadu_ps(&dryL[i]), _mm_mul_ps(dry, left)));
+        _mm_storeu_ps(&dryR[i], _mm_add_ps(_mm_loadu_ps(&dryR[i]), _mm_mul_ps(dry, right)));
+        _mm_storeu_ps(&revL[i], _mm_add_ps(_mm_loadu_ps(&revL[i]), _mm_mul_ps(rev, left)));
+        _mm_storeu_ps(&revR[i], _mm_add_ps(_mm_loadu_ps(&revR[i]), _mm_mul_ps(rev, right)));
+    }
+    mixStereoScalar(&srcL[i], &srcR[i], &dryL[i], &dryR[i], &revL[i], &revR[i], dryCoef, revCoef, len - i);
+}
+
+TARGET_SSE2 static void addStereoSse2(const float *srcL, const float *srcR, float *dstL, float *dstR, float coef, quint32 len)
+{
+    const __m128 coefs = _mm_set1_ps(coef);
+    quint32 i = 0;
+    for (; i + 4 <= len; i += 4)
+    {
+        _mm_storeu_ps(&dstL[i], _mm_add_ps(_mm_loadu_ps(&dstL[i]), _mm_mul_ps(coefs, _mm_loadu_ps(&srcL[i]))));
+        _mm_storeu_ps(&dstR[i], _mm_add_ps(_mm_loadu_ps(&dstR[i]), _mm_mul_ps(coefs, _mm_loadu_ps(&srcR[i]))));
+    }
+    addStereoScalar(&srcL[i], &srcR[i], &dstL[i], &dstR[i], coef, len - i);
+}
+
+TARGET_SSE2 static void biquadCascadeStereoSse2(float *dataL, float *dataR, quint32 len, const float *coefs, float *states, int stages)
+{
+    // Left and right values in the first two lanes, all stages being applied to a pair before the next one
+    // Stages are processed by groups so that their coefficients and states stay in registers or on the stack
+    const int GROUP_SIZE = 16;
+    __m128 b0[GROUP_SIZE], b1[GROUP_SIZE], b2[GROUP_SIZE], a1[GROUP_SIZE], a2[GROUP_SIZE];
+    __m128 z1[GROUP_SIZE], z2[GROUP_SIZE];
+    for (int first = 0; first < stages; first += GROUP_SIZE)
+    {
+        int number = qMin(GROUP_SIZE, stages - first);
+        for (int s = 0; s < number; s++)
+        {
+            const float * c = &coefs[5 * (first + s)];
+            b0[s] = _mm_set1_ps(c[0]);
+            b1[s] = _mm_set1_ps(c[1]);
+            b2[s] = _mm_set1_ps(c[2]);
+            a1[s] = _mm_set1_ps(c[3]);
+            a2[s] = _mm_set1_ps(c[4]);
+            __m128 z = _mm_loadu_ps(&states[4 * (first + s)]);
+            z1[s] = z;
+            z2[s] = _mm_movehl_ps(z, z);
+        }
+
+        for (quint32 i = 0; i < len; i++)
+        {
+            __m128 x = _mm_unpacklo_ps(_mm_load_ss(&dataL[i]), _mm_load_ss(&dataR[i]));
+            for (int s = 0; s < number; s++)
+            {
+                __m128 y = _mm_add_ps(_mm_mul_ps(b0[s], x), z1[s]);
+                z1[s] = _mm_add_ps(_mm_sub_ps(_mm_mul_ps(b1[s], x), _mm_mul_ps(a1[s], y)), z2[s]);
+                z2[s] = _mm_sub_ps(_mm_mul_ps(b2[s], x), _mm_mul_ps(a2[s], y));
+                x = y;
+            }
+            _mm_store_ss(&dataL[i], x);
+            _mm_store_ss(&dataR[i], _mm_shuffle_ps(x, x, _MM_SHUFFLE(1, 1, 1, 1)));
+        }
+
+        for (int s = 0; s < number; s++)
+            _mm_storeu_ps(&states[4 * (first + s)], _mm_movelh_ps(z1[s], z2[s]));
+    }
+}
+
+////////////
+/// AVX2 ///
+////////////
+
+TARGET_AVX2 static void interpolateLinearAvx2(const qint32 *data, const float *positions, float *output, quint32 len)
+{
+    const __m256 scale = _mm256_set1_ps(SCALE_32_BITS);
+    const int * values = reinterpret_cast<const int *>(data);
+    quint32 i = 0;
+    for (; i + 8 <= len; i += 8)
+    {
+        __m256 pos = _mm256_loadu_ps(&positions[i]);
+        __m256i indexes = _mm256_cvttps_epi32(pos); // Positions are positive: truncation is floor
+        __m256 frac = _mm256_sub_ps(pos, _mm256_cvtepi32_ps(indexes));
+        __m256 val1 = _mm256_cvtepi32_ps(_mm256_i32gather_epi32(values, indexes, 4));
+        __m256 val2 = _mm256_cvtepi32_ps(_mm256_i32gather_epi32(values + 1, indexes, 4));
+        __m256 result = _mm256_add_ps(val1, _mm256_mul_ps(frac, _mm256_sub_ps(val2, val1)));
+        _mm256_storeu_ps(&output[i], _mm256_mul_ps(result, scale));
+    }
+    _mm256_zeroupper(); // Avoid the penalty of mixing AVX and SSE instructions afterwards
+    interpolateLinearScalar(data, &positions[i], &output[i], len - i);
+}
+
+TARGET_AVX2 static void interpolatePolyphaseAvx2(const qint32 *data, const float *positions, float *output, quint32 len,
+                                                 const float *table, int taps, int phases)
+{
+    if (taps % 8 != 0)
+    {
+        interpolatePolyphaseSse2(data, positions, output, len, table, taps, phases);
+        return;
+    }
+
+    for (quint32 i = 0; i < len; i++)
+    {
+        quint32 index = static_cast<quint32>(positions[i]);
+        float phase = (positions[i] - static_cast<float>(index)) * phases;
+        int row = static_cast<int>(phase);
+        const __m256 weight = _mm256_set1_ps(phase - static_cast<float>(row));
+        const float * coef1 = &table[row * taps];
+        const float * coef2 = &coef1[taps];
+        const qint32 * values = &data[index + 1 - taps / 2];
+        __m256 sum = _mm256_setzero_ps();
+        for (int j = 0; j < taps; j += 8)
+        {
+            __m256 c1 = _mm256_loadu_ps(&coef1[j]);
+            __m256 coef = _mm256_add_ps(c1, _mm256_mul_ps(weight, _mm256_sub_ps(_mm256_loadu_ps(&coef2[j]), c1)));
+            __m256 value = _mm256_cvtepi32_ps(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(&values[j])));
+            sum = _mm256_add_ps(sum, _mm256_mul_ps(coef, value));
+        }
+
+        // Horizontal sum
+        __m128 sum4 = _mm_add_ps(_mm256_castps256_ps128(sum), _mm256_extractf128_ps(sum, 1));
+        sum4 = _mm_add_ps(sum4, _mm_movehl_ps(sum4, sum4));
+        sum4 = _mm_add_ss(sum4, _mm_shuffle_ps(sum4, sum4, 1));
+        output[i] = _mm_cvtss_f32(sum4) * SCALE_32_BITS;
+    }
+    _mm256_zeroupper();
+}
+
+TARGET_AVX2 static float multiplyLinearRampAvx2(float *data, quint32 len, float gain, float start, float step)
+{
+    __m256 value = _mm256_setr_ps(start, start + step, start + 2 * step, start + 3 * step,
+                                  start + 4 * step, start + 5 * step, start + 6 * step, start + 7 * step);
+    const __m256 increment = _mm256_set1_ps(8 * step);
+    const __m256 gains = _mm256_set1_ps(gain);
+    quint32 i = 0;
+    for (; i + 8 <= len; i += 8)
+    {
+        __m256 values = _mm256_loadu_ps(&data[i]);
+        _mm256_storeu_ps(&data[i], _mm256_mul_ps(values, _mm256_mul_ps(gains, value)));
+        value = _mm256_add_ps(value, increment);
+    }
+    float next = _mm256_cvtss_f32(value);
+    _mm256_zeroupper();
+    return multiplyLinearRampScalar(&data[i], len - i, gain, next, step);
+}
+
+TARGET_AVX2 static float multiplyExponentialRampAvx2(float *data, quint32 len, float gain, float start, float coef, float offset)
+{
+    float powers[8];
+    powers[0] = start;
+    for (int j = 1; j < 8; j++)
+        powers[j] = powers[j - 1] * coef;
+    float coef2 = coef * coef;
+    float coef4 = coef2 * coef2;
+    __m256 value = _mm256_loadu_ps(powers);
+    const __m256 factor = _mm256_set1_ps(coef4 * coef4);
+    const __m256 gains = _mm256_set1_ps(gain);
+    const __m256 offsets = _mm256_set1_ps(offset);
+    quint32 i = 0;
+    for (; i + 8 <= len; i += 8)
+    {
+        __m256 values = _mm256_loadu_ps(&data[i]);
+        _mm256_storeu_ps(&data[i], _mm256_mul_ps(values, _mm256_mul_ps(gains, _mm256_add_ps(offsets, value))));
+        value = _mm256_mul_ps(value, factor);
+    }
+    float next = _mm256_cvtss_f32(value);
+    _mm256_zeroupper();
+    return multiplyExponentialRampScalar(&data[i], len - i, gain, next, coef, offset);
+}
+
+TARGET_AVX2 static void mixStereoAvx2(const float *srcL, const float *srcR, float *dryL, float *dryR, float *revL, float *revR,
+                                      float dryCoef, float revCoef, quint32 len)
+{
+    const __m256 dry = _mm256_set1_ps(dryCoef);
+    const __m256 rev = _mm256_set1_ps(revCoef);
+    quint32 i = 0;
+    for (; i + 8 <= len; i += 8)
+    {
+        __m256 left = _mm256_loadu_ps(&srcL[i]);
+        __m256 right = _mm256_loadu_ps(&srcR[i]);
+        _mm256_storeu_ps(&dryL[i], _mm256_add_ps(_mm256_loadu_ps(&dryL[i]), _mm256_mul_ps(dry, left)));
+        _mm256_storeu_ps(&dryR[i], _mm256_add_ps(_mm256_loadu_ps(&dryR[i]), _mm256_mul_ps(dry, right)));
+        _mm256_storeu_ps(&revL[i], _mm256_add_ps(_mm256_loadu_ps(&revL[i]), _mm256_mul_ps(rev, left)));
+        _mm256_storeu_ps(&revR[i], _mm256_add_ps(_mm256_loadu_ps(&revR[i]), _mm256_mul_ps(rev, right)));
+    }
+    _mm256_zeroupper();
+    mixStereoScalar(&srcL[i], &srcR[i], &dryL[i], &dryR[i], &revL[i], &revR[i], dryCoef, revCoef, len - i);
+}
+
+TARGET_AVX2 static void addStereoAvx2(const float *srcL, const float *srcR, float *dstL, float *dstR, float coef, quint32 len)
+{
+    const __m256 coefs = _mm256_set1_ps(coef);
+    quint32 i = 0;
+    for (; i + 8 <= len; i += 8)
+    {
+        _mm256_storeu_ps(&dstL[i], _mm256_add_ps(_mm256_loadu_ps(&dstL[i]), _mm256_mul_ps(coefs, _mm256_loadu_ps(&srcL[i]))));
+        _mm256_storeu_ps(&dstR[i], _mm256_add_ps(_mm256_loadu_ps(&dstR[i]), _mm256_mul_ps(coefs, _mm256_loadu_ps(&srcR[i]))));
+    }
+    _mm256_zeroupper();
+    addStereoScalar(&srcL[i], &srcR[i], &dstL[i], &dstR[i], coef, len - i);
+}
+
+#endif
+
+/////////////////
+/// DENORMALS ///
+/////////////////
+
+#ifdef DSP_KERNELS_X86
+TARGET_SSE2 static void setFlushToZeroSse2()
+{
+    // Flush to zero (bit 15) and denormals are zero (bit 6)
+    _mm_setcsr(_mm_getcsr() | 0x8040);
+}
+#endif
+
+void DspKernels::disableDenormals()
+{
+#if defined(DSP_KERNELS_X86)
+    if (instructionSet() != INSTRUCTIONS_SCALAR)
+        setFlushToZeroSse2();
+#elif defined(__GNUC__) && defined(__aarch64__)
+    // Flush to zero (bit 24 of FPCR)
+    quint64 fpcr;
+    __asm__ __volatile__("mrs %0, fpcr" : "=r"(fpcr));
+    __asm__ __volatile__("msr fpcr, %0" : : "r"(fpcr | (1ULL << 24)));
+#endif
+}
+
+/////////////////
+/// SELECTION ///
+/////////////////
+
+#ifdef DSP_KERNELS_X86
+#define SELECT_KERNEL(name) \
+    (instructionSet() == INSTRUCTIONS_AVX2 ? name##Avx2 : (instructionSet() == INSTRUCTIONS_SSE2 ? name##Sse2 : name##Scalar))
+#else
+#define SELECT_KERNEL(name) name##Scalar
+#endif
+
+DspKernels::InterpolateFunction DspKernels::s_interpolateLinear = SELECT_KERNEL(interpolateLinear);
+DspKernels::PolyphaseFunction DspKernels::s_interpolatePolyphase = SELECT_KERNEL(interpolatePolyphase);
+DspKernels::LinearRampFunction DspKernels::s_multiplyLinearRamp = SELECT_KERNEL(multiplyLinearRamp);
+DspKernels::ExponentialRampFunction DspKernels::s_multiplyExponentialRamp = SELECT_KERNEL(multiplyExponentialRamp);
+DspKernels::MixFunction DspKernels::s_mixStereo = SELECT_KERNEL(mixStereo);
+DspKernels::AddFunction DspKernels::s_addStereo = SELECT_KERNEL(addStereo);
+#ifdef DSP_KERNELS_X86
+// Only two channels in parallel: SSE2 is enough
+DspKernels::BiquadFunction DspKernels::s_biquadCascadeStereo =
+        (instructionSet() == INSTRUCTIONS_SCALAR ? biquadCascadeStereoScalar : biquadCascadeStereoSse2);
+#else
+DspKernels::BiquadFunction DspKernels::s_biquadCascadeStereo = biquadCascadeStereoScalar;
+#endif
+
+QString DspKernels::getInstructionSet()
+{
+    switch (instructionSet())
+    {
+    case INSTRUCTIONS_AVX2:
+        return "AVX2";
+    case INSTRUCTIONS_SSE2:
+        return "SSE2";
+    default:
+        return "scalar";
+    }
+}
@@ -0,0 +1,112 @@
+/***************************************************************************
+**                                                                        **
+**  Polyphone, a soundfont editor                                         **
+**  Copyright (C) 2013-2019 Davy Triponney                                **
+**                                                                        **
+**  This program is free software: you can redistribute it and/or modify  **
+**  it under the terms of the GNU General Public License as published by  **
+**  the Free Software Foundation, either version 3 of the License, or     **
+**  (at your option) any later version.                                   **
+**                                                                        **
+**  This program is distributed in the hope that it will be useful,       **
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of        **
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the          **
+**  GNU General Public License for more details.                          **
+**                                                                        **
+**  You should have received a copy of the GNU General Public License     **
+**  along with this program. If not, see http://www.gnu.org/licenses/.    **
+**                                                                        **
+****************************************************************************
+**           Author: Davy Triponney                                       **
+**  Website/Contact: https://www.polyphone-soundfonts.com                 **
+**             Date: 01.01.2013                                           **
+***************************************************************************/
+
+
+#ifndef DSPKERNELS_H
+#define DSPKERNELS_H
+
+#include <QtGlobal>
+#include <QString>
+
+// Vectorized loops used by the voices and the sound engines
+// The best implementation (AVX2, SSE2 or scalar) is selected at runtime, depending on the processor
+class DspKernels
+{
+public:
+    // Linear interpolation of a 32-bit sample at the given positions, result converted between -1 and 1
+    // "data" must contain at least floor(positions[i]) + 2 values
+    static void interpolateLinear(const qint32 *data, const float *positions, float *output, quint32 len)
+    {
+        s_interpolateLinear(data, positions, output, len);
+    }
+
+    // Interpolation of a 32-bit sample with a polyphase filter, result converted between -1 and 1
+    // "table" contains "phases + 1" rows of "taps" coefficients (taps being a multiple of 4)
+    // The coefficients of a row are applied to the values from floor(positions[i]) - taps / 2 + 1 to floor(positions[i]) + taps / 2
+    static void interpolatePolyphase(const qint32 *data, const float *positions, float *output, quint32 len,
+                                     const float *table, int taps, int phases)
+    {
+        s_interpolatePolyphase(data, positions, output, len, table, taps, phases);
+    }
+
+    // data[i] *= gain * (start + i * step)
+    // Return the value of the ramp for i = len
+    static float multiplyLinearRamp(float *data, quint32 len, float gain, float start, float step)
+    {
+        return s_multiplyLinearRamp(data, len, gain, start, step);
+    }
+
+    // data[i] *= gain * (offset + start * coef^i)
+    // Return the value of the ramp for i = len
+    static float multiplyExponentialRamp(float *data, quint32 len, float gain, float start, float coef, float offset)
+    {
+        return s_multiplyExponentialRamp(data, len, gain, start, coef, offset);
+    }
+
+    // Accumulate a stereo signal into a dry bus and a reverb bus
+    static void mixStereo(const float *srcL, const float *srcR, float *dryL, float *dryR, float *revL, float *revR,
+                          float dryCoef, float revCoef, quint32 len)
+    {
+        s_mixStereo(srcL, srcR, dryL, dryR, revL, revR, dryCoef, revCoef, len);
+    }
+
+    // Accumulate a stereo signal into a bus: dstL[i] += coef * srcL[i], dstR[i] += coef * srcR[i]
+    static void addStereo(const float *srcL, const float *srcR, float *dstL, float *dstR, float coef, quint32 len)
+    {
+        s_addStereo(srcL, srcR, dstL, dstR, coef, len);
+    }
+
+    // Cascade of biquads (transposed direct form II) applied to both channels, the result replacing the input
+    // "coefs" contains b0, b1, b2, a1, a2 for each stage (a0 being 1), "states" contains z1L, z1R, z2L, z2R for each stage
+    static void biquadCascadeStereo(float *dataL, float *dataR, quint32 len, const float *coefs, float *states, int stages)
+    {
+        s_biquadCascadeStereo(dataL, dataR, len, coefs, states, stages);
+    }
+
+    // Flush denormal numbers to zero for the floating point operations of the calling thread
+    // (to be called by each thread computing audio, denormals being very slow on some processors)
+    static void disableDenormals();
+
+    // Name of the instruction set in use
+    static QString getInstructionSet();
+
+private:
+    typedef void (*InterpolateFunction)(const qint32 *, const float *, float *, quint32);
+    typedef void (*PolyphaseFunction)(const qint32 *, const float *, float *, quint32, const float *, int, int);
+    typedef float (*LinearRampFunction)(float *, quint32, float, float, float);
+    typedef float (*ExponentialRampFunction)(float *, quint32, float, float, float, float);
+    typedef void (*MixFunction)(const float *, const float *, float *, float *, float *, float *, float, float, quint32);
+    typedef void (*AddFunction)(const float *, const float *, float *, float *, float, quint32);
+    typedef void (*BiquadFunction)(float *, float *, quint32, const float *, float *, int);
+
+    static InterpolateFunction s_interpolateLinear;
+    static PolyphaseFunction s_interpolatePolyphase;
+    static LinearRampFunction s_multiplyLinearRamp;
+    static ExponentialRampFunction s_multiplyExponentialRamp;
+    static MixFunction s_mixStereo;
+    static AddFunction s_addStereo;
+    static BiquadFunction s_biquadCascadeStereo;
+};
+
+#endif // DSPKERNELS_H
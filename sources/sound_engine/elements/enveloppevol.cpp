@@ -24,7 +24,9 @@
 
 #include "enveloppevol.h"
 #include "qmath.h"
+#include "dspkernels.h"
 
+const float EnveloppeVol::SILENCE_LEVEL = 0.000001f; // -120 dB
 
 EnveloppeVol::EnveloppeVol(quint32 sampleRate, bool isMod) :
     _currentSmpl(0),
@@ -148,11 +150,7 @@ bool EnveloppeVol::applyEnveloppe(float * data, quint32 size, bool release, int
             {
                 // Linear amplitude => convex attack (dB)
                 coef = 1.f / v_timeAttack; // Target is 1.f
-                for (quint32 i = 0; i < duration; i++)
-                {
-                    data[avancement + i] = gain * lastValue * data[avancement + i];
-                    lastValue += coef;
-                }
+                lastValue = DspKernels::multiplyLinearRamp(&data[avancement], duration, gain, lastValue, coef);
             }
             break;
         case phase3hold:
@@ -175,10 +173,7 @@ bool EnveloppeVol::applyEnveloppe(float * data, quint32 size, bool release, int
                     data[avancement + i] = gain;
             }
             else
-            {
-                for (quint32 i = 0; i < duration; i++)
-                    data[avancement + i] = gain * data[avancement + i];
-            }
+                DspKernels::multiplyLinearRamp(&data[avancement], duration, gain, 1.f, 0.f);
             break;
         case phase4decay:
             // Number of remaining points in the phase
@@ -210,12 +205,8 @@ bool EnveloppeVol::applyEnveloppe(float * data, quint32 size, bool release, int
             {
                 // Exponential decay
                 coef = static_cast<float>(qPow(0.00001585 / (1. - static_cast<double>(levelSustain) + 0.00001585), 1. / timeDecay));
-                lastValue = (_precValue - levelSustain) * coef + levelSustain;
-                for (quint32 i = 0; i < duration; i++)
-                {
-                    data[avancement + i] = gain * (data[avancement + i] * lastValue);
-                    lastValue = (lastValue - levelSustain) * coef + levelSustain;
-                }
+                lastValue = DspKernels::multiplyExponentialRamp(&data[avancement], duration, gain,
+                                                                (_precValue - levelSustain) * coef, coef, levelSustain);
             }
             break;
         case phase5sustain:
@@ -228,10 +219,7 @@ bool EnveloppeVol::applyEnveloppe(float * data, quint32 size, bool release, int
                     data[avancement + i] = gain * lastValue;
             }
             else
-            {
-                for (quint32 i = 0; i < duration; i++)
-                    data[avancement + i] = gain * (data[avancement + i] * lastValue);
-            }
+                DspKernels::multiplyLinearRamp(&data[avancement], duration, gain, lastValue, 0.f);
             break;
         case phase6release:
             // Number of remaining points in the phase
@@ -263,12 +251,8 @@ bool EnveloppeVol::applyEnveloppe(float * data, quint32 size, bool release, int
             {
                 // Exponential decay
                 coef = static_cast<float>(qPow(0.00001585, 1. / v_timeRelease));
-                lastValue = _precValue * coef;
-                for (quint32 i = 0; i < duration; i++)
-                {
-                    data[avancement + i] = gain * (data[avancement + i] * lastValue);
-                    lastValue *= coef;
-                }
+                lastValue = DspKernels::multiplyExponentialRamp(&data[avancement], duration, gain,
+                                                                _precValue * coef, coef, 0.f);
             }
             break;
         case phase7off:
@@ -282,6 +266,16 @@ bool EnveloppeVol::applyEnveloppe(float * data, quint32 size, bool release, int
             fin = true;
         }
 
+        // A volume envelope that can only decrease and that is below -120 dB ends the voice
+        if (!_isMod && _currentPhase != phase7off && lastValue < SILENCE_LEVEL &&
+                (_currentPhase == phase6release ||
+                 ((_currentPhase == phase4decay || _currentPhase == phase5sustain) && levelSustain < SILENCE_LEVEL)))
+        {
+            _currentPhase = phase7off;
+            _currentSmpl = 0;
+            fin = true;
+        }
+
         // We keep the last value and we go on
         _precValue = lastValue;
         avancement += duration;
@@ -39,6 +39,9 @@ public:
     // Call a quick release
     void quickRelease();
 
+    // Last value of the envelope
+    float getLevel() { return _precValue; }
+
     static float fastPow2(float p)
     {
         float offset = (p < 0) ? 1.0f : 0.0f;
@@ -70,6 +73,8 @@ private:
     quint32 _sampleRate;
     bool _isMod;
     bool _fastRelease;
+
+    static const float SILENCE_LEVEL;
 };
 
 #endif // ENVELOPPEVOL_H
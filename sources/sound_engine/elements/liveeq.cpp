@@ -24,101 +24,127 @@
 ***************************************************************************/
 
 #include "liveeq.h"
+#include "dspkernels.h"
 #include <qmath.h>
 
-int LiveEQ::CROSSFADE_LENGTH = 1000;
-double LiveEQ::CORRECTION = 0.85;
+const int LiveEQ::CROSSFADE_LENGTH = 1000;
+const quint32 LiveEQ::CHUNK_LENGTH = 32; // Gains are updated every CHUNK_LENGTH values
+const float LiveEQ::RAMP_STEP = 0.25f; // Maximum change of a value per chunk (0.5 dB)
+const double LiveEQ::FREQUENCIES[10] = {32, 64, 125, 250, 500, 1000, 2000, 4000, 8000, 16000};
+const double LiveEQ::BAND_Q = 1.41; // Bandwidth of one octave
 
 LiveEQ::LiveEQ() :
-    _isOn(false),
+    _sampleRate(44100),
+    _isOn(0),
     _crossFade(0)
 {
-    _coeff.resize(10);
+    for (int band = 0; band < 10; band++)
+        _values[band] = 0;
+    setSampleRate(_sampleRate);
 }
 
 void LiveEQ::setSampleRate(quint32 sampleRate)
 {
     _sampleRate = sampleRate;
 
-    // Prepare 10 pass bands per channel
-    _passBandsR.resize(10);
-    _passBandsR[0].setup(_sampleRate, 32, 2*12);
-    _passBandsR[1].setup(_sampleRate, 64, 2*20);
-    _passBandsR[2].setup(_sampleRate, 125, 2*41);
-    _passBandsR[3].setup(_sampleRate, 250, 2*84);
-    _passBandsR[4].setup(_sampleRate, 500, 2*166);
-    _passBandsR[5].setup(_sampleRate, 1000, 2*334);
-    _passBandsR[6].setup(_sampleRate, 2000, 2*666);
-    _passBandsR[7].setup(_sampleRate, 4000, 2*1334);
-    _passBandsR[8].setup(_sampleRate, 8000, 2*2666);
-    _passBandsR[9].setup(_sampleRate, 16000, 2*5334);
+    // Constant part of the coefficients, the frequencies being below the Nyquist frequency
+    for (int band = 0; band < 10; band++)
+    {
+        double w0 = 2. * M_PI * qMin(FREQUENCIES[band], 0.45 * sampleRate) / sampleRate;
+        _cosW0[band] = qCos(w0);
+        _alpha[band] = qSin(w0) / (2. * BAND_Q);
+        updateCoefficients(band);
+    }
 
-    _passBandsL.resize(10);
-    _passBandsL[0].setup(_sampleRate, 32, 2*12);
-    _passBandsL[1].setup(_sampleRate, 64, 2*20);
-    _passBandsL[2].setup(_sampleRate, 125, 2*41);
-    _passBandsL[3].setup(_sampleRate, 250, 2*84);
-    _passBandsL[4].setup(_sampleRate, 500, 2*166);
-    _passBandsL[5].setup(_sampleRate, 1000, 2*334);
-    _passBandsL[6].setup(_sampleRate, 2000, 2*666);
-    _passBandsL[7].setup(_sampleRate, 4000, 2*1334);
-    _passBandsL[8].setup(_sampleRate, 8000, 2*2666);
-    _passBandsL[9].setup(_sampleRate, 16000, 2*5334);
+    // Reset
+    for (int i = 0; i < 4 * 10; i++)
+        _states[i] = 0;
 }
 
 void LiveEQ::on()
 {
-    _mutex.lock();
-    _isOn = true;
-    _mutex.unlock();
+    _isOn.store(1);
 }
 
 void LiveEQ::off()
 {
-    _mutex.lock();
-    _isOn = false;
-    _mutex.unlock();
+    _isOn.store(0);
 }
 
 void LiveEQ::setValues(QVector<int> values)
 {
-    _mutex.lock();
-    for (int i = 0; i < 10; i++)
-        _coeff[i] = qPow(10.0, 0.1 * values[i]);
-    _mutex.unlock();
+    for (int band = 0; band < 10 && band < values.size(); band++)
+        _targetValues[band].store(values[band]);
 }
 
-void LiveEQ::filterData(float * dataR, float * dataL, quint32 len)
+void LiveEQ::updateCoefficients(int band)
 {
-    _mutex.lock();
+    // Peaking filter (Audio EQ Cookbook), the gain being 2 * value dB
+    double a = qPow(10.0, 0.05 * static_cast<double>(_values[band]));
+    double alpha = _alpha[band];
+    double a0 = 1. + alpha / a;
+    float * coefs = &_coefs[5 * band];
+    coefs[0] = static_cast<float>((1. + alpha * a) / a0);
+    coefs[1] = static_cast<float>(-2. * _cosW0[band] / a0);
+    coefs[2] = static_cast<float>((1. - alpha * a) / a0);
+    coefs[3] = coefs[1];
+    coefs[4] = static_cast<float>((1. - alpha / a) / a0);
+}
 
-    if (!_isOn && _crossFade == 0)
-    {
-        _mutex.unlock();
+void LiveEQ::filterData(float * dataR, float * dataL, quint32 len)
+{
+    bool isOn = (_isOn.load() != 0);
+    if (!isOn && _crossFade == 0)
         return;
+    if (_crossFade == 0)
+    {
+        // Start from silence
+        for (int i = 0; i < 4 * 10; i++)
+            _states[i] = 0;
     }
 
-    // Filter
-    for (quint32 i = 0; i < len; i++)
+    // Crossfade between the original and the filtered data, computed once for the block
+    float crossFadeStart = static_cast<float>(_crossFade) / CROSSFADE_LENGTH;
+    _crossFade = isOn ? qMin(CROSSFADE_LENGTH, _crossFade + static_cast<int>(len)) :
+                        qMax(0, _crossFade - static_cast<int>(len));
+    float crossFadeStep = (static_cast<float>(_crossFade) / CROSSFADE_LENGTH - crossFadeStart) / len;
+    bool isCrossFading = (crossFadeStart < 1.f || crossFadeStep != 0.f);
+
+    float dryR[CHUNK_LENGTH], dryL[CHUNK_LENGTH];
+    float pos = crossFadeStart;
+    for (quint32 start = 0; start < len; start += CHUNK_LENGTH)
     {
-        if (_isOn && _crossFade < CROSSFADE_LENGTH)
-            _crossFade++;
-        else if (!_isOn && _crossFade > 0)
-            _crossFade--;
-        double pos = static_cast<double>(_crossFade) / CROSSFADE_LENGTH;
+        quint32 chunk = qMin(CHUNK_LENGTH, len - start);
 
-        double value = static_cast<double>(dataR[i]);
-        double fTmp = 0;
-        for (int j = 0; j < 10; j++)
-            fTmp += _coeff[j] * _passBandsR[j].filter(value);
-        dataR[i] = static_cast<float>((1.0 - pos) * dataR[i] + pos * fTmp * CORRECTION);
+        // Gains progressively reaching the target values
+        for (int band = 0; band < 10; band++)
+        {
+            float target = static_cast<float>(_targetValues[band].load());
+            if (_values[band] != target)
+            {
+                if (qAbs(target - _values[band]) <= RAMP_STEP)
+                    _values[band] = target;
+                else
+                    _values[band] += (target > _values[band] ? RAMP_STEP : -RAMP_STEP);
+                updateCoefficients(band);
+            }
+        }
 
-        value = static_cast<double>(dataL[i]);
-        fTmp = 0;
-        for (int j = 0; j < 10; j++)
-            fTmp += _coeff[j] * _passBandsL[j].filter(value);
-        dataL[i] = static_cast<float>((1.0 - pos) * dataL[i] + pos * fTmp * CORRECTION);
+        // Filter
+        if (isCrossFading)
+        {
+            memcpy(dryR, &dataR[start], chunk * sizeof(float));
+            memcpy(dryL, &dataL[start], chunk * sizeof(float));
+        }
+        DspKernels::biquadCascadeStereo(&dataL[start], &dataR[start], chunk, _coefs, _states, 10);
+        if (isCrossFading)
+        {
+            for (quint32 i = 0; i < chunk; i++)
+            {
+                dataR[start + i] = dryR[i] + pos * (dataR[start + i] - dryR[i]);
+                dataL[start + i] = dryL[i] + pos * (dataL[start + i] - dryL[i]);
+                pos += crossFadeStep;
+            }
+        }
     }
-
-    _mutex.unlock();
 }
@@ -27,34 +27,47 @@
 #define LIVEEQ_H
 
 #include <QVector>
-#include <QMutex>
-#include "iir/Iir_2.h"
+#include <QAtomicInt>
 
+// Equalizer of 10 bands (from 32 Hz to 16 kHz) applied to the output when a sample is played
+// Cascade of peaking biquads computed by blocks, the configuration being progressively applied without locks
 class LiveEQ
 {
 public:
     LiveEQ();
 
-    // Initialize the sample rate
+    // Initialize the sample rate (no data must be filtered meanwhile)
     void setSampleRate(quint32 sampleRate);
 
-    // Configuration of the equalizer
+    // Configuration of the equalizer, possibly while data is filtered
     void on();
     void off();
-    void setValues(QVector<int> values);
+    void setValues(QVector<int> values); // 10 values, the gain of a band being 2 * value dB
 
-    // Filter data
+    // Filter data (audio thread)
     void filterData(float * dataR, float * dataL, quint32 len);
 
 private:
+    void updateCoefficients(int band);
+
     quint32 _sampleRate;
-    bool _isOn;
-    QVector<Iir::Butterworth::BandPass<4> > _passBandsR, _passBandsL;
-    QVector<double> _coeff;
-    QMutex _mutex;
+
+    // Written by the main thread
+    QAtomicInt _isOn;
+    QAtomicInt _targetValues[10];
+
+    // Only accessed by the audio thread
+    float _values[10]; // Reach the target values progressively
+    float _coefs[5 * 10]; // b0, b1, b2, a1, a2 for each band
+    float _states[4 * 10];
+    double _cosW0[10], _alpha[10];
     int _crossFade;
-    static int CROSSFADE_LENGTH;
-    static double CORRECTION;
+
+    static const int CROSSFADE_LENGTH;
+    static const quint32 CHUNK_LENGTH;
+    static const float RAMP_STEP;
+    static const double FREQUENCIES[10];
+    static const double BAND_Q;
 };
 
 #endif // LIVEEQ_H
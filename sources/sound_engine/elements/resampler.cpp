@@ -0,0 +1,149 @@
+/***************************************************************************
+**                                                                        **
+**  Polyphone, a soundfont editor                                         **
+**  Copyright (C) 2013-2019 Davy Triponney                                **
+**                                                                        **
+**  This program is free software: you can redistribute it and/or modify  **
+**  it under the terms of the GNU General Public License as published by  **
+**  the Free Software Foundation, either version 3 of the License, or     **
+**  (at your option) any later version.                                   **
+**                                                                        **
+**  This program is distributed in the hope that it will be useful,       **
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of        **
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the          **
+**  GNU General Public License for more details.                          **
+**                                                                        **
+**  You should have received a copy of the GNU General Public License     **
+**  along with this program. If not, see http://www.gnu.org/licenses/.    **
+**                                                                        **
+****************************************************************************
+**           Author: Davy Triponney                                       **
+**  Website/Contact: https://www.polyphone-soundfonts.com                 **
+**             Date: 01.01.2013                                           **
+***************************************************************************/
+
+
+#include "resampler.h"
+#include "dspkernels.h"
+#include "qmath.h"
+
+const int Resampler::PHASES = 256;
+const double Resampler::SINC_CUTOFF = 0.9;
+const int Resampler::SINC_CUTOFF_NUMBER = 7;
+const float Resampler::SINC_CUTOFF_RATIOS[] = { 1.f, 1.1f, 1.25f, 1.5f, 2.f, 3.f, 4.f };
+Resampler Resampler::s_instance;
+
+Resampler::Resampler()
+{
+    // Cubic Hermite interpolation
+    _tableHermite = new float[(PHASES + 1) * 4];
+    computeHermite();
+
+    // Windowed sinc, with a lower cutoff frequency when the sample is pitched up (anti-aliasing)
+    _tablesSinc8 = new float * [SINC_CUTOFF_NUMBER];
+    _tablesSinc16 = new float * [SINC_CUTOFF_NUMBER];
+    for (int i = 0; i < SINC_CUTOFF_NUMBER; i++)
+    {
+        double cutoff = SINC_CUTOFF / static_cast<double>(SINC_CUTOFF_RATIOS[i]);
+        _tablesSinc8[i] = new float[(PHASES + 1) * 8];
+        computeSinc(_tablesSinc8[i], 8, cutoff);
+        _tablesSinc16[i] = new float[(PHASES + 1) * 16];
+        computeSinc(_tablesSinc16[i], 16, cutoff);
+    }
+}
+
+Resampler::~Resampler()
+{
+    delete [] _tableHermite;
+    for (int i = 0; i < SINC_CUTOFF_NUMBER; i++)
+    {
+        delete [] _tablesSinc8[i];
+        delete [] _tablesSinc16[i];
+    }
+    delete [] _tablesSinc8;
+    delete [] _tablesSinc16;
+}
+
+void Resampler::computeHermite()
+{
+    // Catmull-Rom spline on the points -1, 0, 1 and 2
+    for (int phase = 0; phase <= PHASES; phase++)
+    {
+        float t = static_cast<float>(phase) / PHASES;
+        float t2 = t * t;
+        float t3 = t2 * t;
+        float * row = &_tableHermite[phase * 4];
+        row[0] = -0.5f * t3 + t2 - 0.5f * t;
+        row[1] = 1.5f * t3 - 2.5f * t2 + 1.f;
+        row[2] = -1.5f * t3 + 2.f * t2 + 0.5f * t;
+        row[3] = 0.5f * t3 - 0.5f * t2;
+    }
+}
+
+void Resampler::computeSinc(float *table, int taps, double cutoff)
+{
+    // Sinc filter with a Blackman window, each row being normalized so that the gain is 1 at 0 Hz
+    double halfWidth = 0.5 * taps;
+    for (int phase = 0; phase <= PHASES; phase++)
+    {
+        double frac = static_cast<double>(phase) / PHASES;
+        float * row = &table[phase * taps];
+        double sum = 0;
+        for (int j = 0; j < taps; j++)
+        {
+            // Distance between the point to compute and the value j
+            double x = static_cast<double>(j - taps / 2 + 1) - frac;
+            double sinc = qAbs(x) < 1e-9 ? 1.0 : qSin(M_PI * cutoff * x) / (M_PI * cutoff * x);
+            double window = qAbs(x) >= halfWidth ? 0.0 :
+                    0.42 + 0.5 * qCos(M_PI * x / halfWidth) + 0.08 * qCos(2. * M_PI * x / halfWidth);
+            double value = sinc * window;
+            row[j] = static_cast<float>(value);
+            sum += value;
+        }
+        for (int j = 0; j < taps; j++)
+            row[j] = static_cast<float>(row[j] / sum);
+    }
+}
+
+int Resampler::getTapNumber(InterpolationType type)
+{
+    switch (type)
+    {
+    case INTERPOLATION_HERMITE:
+        return 4;
+    case INTERPOLATION_SINC_8:
+        return 8;
+    case INTERPOLATION_SINC_16:
+        return 16;
+    default:
+        return 2;
+    }
+}
+
+void Resampler::resample(InterpolationType type, const qint32 *data, const float *positions, float *output, quint32 len,
+                         float pitchRatio)
+{
+    // Table of the sinc filters, depending on the pitch ratio: the highest cutoff that is still below the
+    // Nyquist frequency of the output, i.e. the smallest ratio that is at least SINC_CUTOFF * pitchRatio
+    // (for instance a sample at 48 kHz played at 44.1 kHz keeps the full bandwidth)
+    float minRatio = static_cast<float>(SINC_CUTOFF) * pitchRatio;
+    int cutoffIndex = 0;
+    while (cutoffIndex < SINC_CUTOFF_NUMBER - 1 && minRatio > SINC_CUTOFF_RATIOS[cutoffIndex])
+        cutoffIndex++;
+
+    switch (type)
+    {
+    case INTERPOLATION_HERMITE:
+        DspKernels::interpolatePolyphase(data, positions, output, len, s_instance._tableHermite, 4, PHASES);
+        break;
+    case INTERPOLATION_SINC_8:
+        DspKernels::interpolatePolyphase(data, positions, output, len, s_instance._tablesSinc8[cutoffIndex], 8, PHASES);
+        break;
+    case INTERPOLATION_SINC_16:
+        DspKernels::interpolatePolyphase(data, positions, output, len, s_instance._tablesSinc16[cutoffIndex], 16, PHASES);
+        break;
+    default:
+        DspKernels::interpolateLinear(data, positions, output, len);
+        break;
+    }
+}
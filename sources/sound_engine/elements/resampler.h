@@ -0,0 +1,75 @@
+/***************************************************************************
+**                                                                        **
+**  Polyphone, a soundfont editor                                         **
+**  Copyright (C) 2013-2019 Davy Triponney                                **
+**                                                                        **
+**  This program is free software: you can redistribute it and/or modify  **
+**  it under the terms of the GNU General Public License as published by  **
+**  the Free Software Foundation, either version 3 of the License, or     **
+**  (at your option) any later version.                                   **
+**                                                                        **
+**  This program is distributed in the hope that it will be useful,       **
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of        **
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the          **
+**  GNU General Public License for more details.                          **
+**                                                                        **
+**  You should have received a copy of the GNU General Public License     **
+**  along with this program. If not, see http://www.gnu.org/licenses/.    **
+**                                                                        **
+****************************************************************************
+**           Author: Davy Triponney                                       **
+**  Website/Contact: https://www.polyphone-soundfonts.com                 **
+**             Date: 01.01.2013                                           **
+***************************************************************************/
+
+
+#ifndef RESAMPLER_H
+#define RESAMPLER_H
+
+#include <QtGlobal>
+
+// Interpolation of the samples read by the voices
+// The coefficients of the cubic and sinc interpolations are precomputed in polyphase tables
+class Resampler
+{
+public:
+    enum InterpolationType
+    {
+        INTERPOLATION_LINEAR = 0,
+        INTERPOLATION_HERMITE = 1,
+        INTERPOLATION_SINC_8 = 2,
+        INTERPOLATION_SINC_16 = 3
+    };
+
+    // Maximum number of values used for computing one point
+    static const int MAX_TAPS = 16;
+
+    // Number of values used for computing one point
+    static int getTapNumber(InterpolationType type);
+
+    // Compute "len" values at the given positions
+    // The values from floor(positions[i]) - getTapNumber() / 2 + 1 to floor(positions[i]) + getTapNumber() / 2 must be readable in data
+    // "pitchRatio" is the average distance between two positions, used for choosing the cutoff of the sinc filters
+    static void resample(InterpolationType type, const qint32 *data, const float *positions, float *output, quint32 len,
+                         float pitchRatio);
+
+private:
+    Resampler();
+    ~Resampler();
+    void computeHermite();
+    void computeSinc(float *table, int taps, double cutoff);
+
+    static const int PHASES;
+    static const double SINC_CUTOFF; // Relative to the Nyquist frequency, for a pitch ratio of 1
+    static const int SINC_CUTOFF_NUMBER;
+    static const float SINC_CUTOFF_RATIOS[];
+
+    float * _tableHermite;
+    float ** _tablesSinc8;
+    float ** _tablesSinc16;
+
+    // Tables are computed once at startup, not in the audio threads
+    static Resampler s_instance;
+};
+
+#endif // RESAMPLER_H
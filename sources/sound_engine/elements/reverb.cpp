@@ -0,0 +1,177 @@
+/***************************************************************************
+**                                                                        **
+**  Polyphone, a soundfont editor                                         **
+**  Copyright (C) 2013-2019 Davy Triponney                                **
+**                                                                        **
+**  This program is free software: you can redistribute it and/or modify  **
+**  it under the terms of the GNU General Public License as published by  **
+**  the Free Software Foundation, either version 3 of the License, or     **
+**  (at your option) any later version.                                   **
+**                                                                        **
+**  This program is distributed in the hope that it will be useful,       **
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of        **
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the          **
+**  GNU General Public License for more details.                          **
+**                                                                        **
+**  You should have received a copy of the GNU General Public License     **
+**  along with this program. If not, see http://www.gnu.org/licenses/.    **
+**                                                                        **
+****************************************************************************
+**           Author: Davy Triponney                                       **
+**  Website/Contact: https://www.polyphone-soundfonts.com                 **
+**             Date: 01.01.2013                                           **
+***************************************************************************/
+
+
+#include "reverb.h"
+
+// Tuning of the original Freeverb, for a sample rate of 44100 Hz
+const int Reverb::COMB_LENGTHS[8] = {1617, 1557, 1491, 1422, 1356, 1277, 1188, 1116};
+const int Reverb::ALLPASS_LENGTHS[4] = {225, 556, 441, 341};
+const int Reverb::STEREO_SPREAD = 23;
+const quint32 Reverb::CHUNK_SIZE = 64;
+
+Reverb::Reverb() :
+    _isCleared(false)
+{
+    setSampleRate(44100);
+    setParameters(0, 0, 0, 0);
+}
+
+void Reverb::setSampleRate(quint32 sampleRate)
+{
+    _mutex.lock();
+    double scale = sampleRate / 44100.;
+    for (int channel = 0; channel < 2; channel++)
+    {
+        int spread = (channel == 0 ? 0 : STEREO_SPREAD);
+        for (int i = 0; i < 8; i++)
+            _combs[channel][i].buffer.resize(static_cast<int>(scale * COMB_LENGTHS[i]) + spread);
+        for (int i = 0; i < 4; i++)
+            _allpasses[channel][i].buffer.resize(static_cast<int>(scale * ALLPASS_LENGTHS[i]) + spread);
+    }
+    clear();
+    _mutex.unlock();
+}
+
+void Reverb::setParameters(float level, float roomSize, float width, float damping)
+{
+    _mutex.lock();
+    _level = level;
+    _roomSize = 0.28f * roomSize + 0.7f;
+    _damping = 0.4f * damping;
+
+    // Same mix as stk::FreeVerb
+    float wet = 3.f * level;
+    _dry = 2.f * (1.f - level);
+    wet /= (wet + _dry);
+    _dry /= (wet + _dry);
+    _wet1 = wet * (0.5f * width + 0.5f);
+    _wet2 = wet * 0.5f * (1.f - width);
+    _mutex.unlock();
+}
+
+void Reverb::clear()
+{
+    for (int channel = 0; channel < 2; channel++)
+    {
+        for (int i = 0; i < 8; i++)
+        {
+            _combs[channel][i].buffer.fill(0);
+            _combs[channel][i].pos = 0;
+            _filterStores[channel][i] = 0;
+        }
+        for (int i = 0; i < 4; i++)
+        {
+            _allpasses[channel][i].buffer.fill(0);
+            _allpasses[channel][i].pos = 0;
+        }
+    }
+    _isCleared = true;
+}
+
+void Reverb::process(float *dataL, float *dataR, const float *revL, const float *revR, quint32 len)
+{
+    QMutexLocker locker(&_mutex);
+
+    // No reverb: the bus is directly added, the filters are emptied once for the next time the reverb is enabled
+    if (_level <= 0)
+    {
+        if (!_isCleared)
+            clear();
+        for (quint32 i = 0; i < len; i++)
+        {
+            dataL[i] += revL[i];
+            dataR[i] += revR[i];
+        }
+        return;
+    }
+    _isCleared = false;
+
+    for (quint32 start = 0; start < len; start += CHUNK_SIZE)
+    {
+        quint32 chunk = qMin(CHUNK_SIZE, len - start);
+
+        // Mono input
+        for (quint32 i = 0; i < chunk; i++)
+            _input[i] = 0.015f * (revL[start + i] + revR[start + i]);
+
+        for (int channel = 0; channel < 2; channel++)
+        {
+            // Comb filters in parallel
+            float * output = _output[channel];
+            for (quint32 i = 0; i < chunk; i++)
+                output[i] = 0;
+            for (int i = 0; i < 8; i++)
+                processComb(_combs[channel][i], _filterStores[channel][i], _input, output, chunk);
+
+            // Allpass filters in series
+            for (int i = 0; i < 4; i++)
+                processAllpass(_allpasses[channel][i], output, chunk);
+        }
+
+        // Mix
+        for (quint32 i = 0; i < chunk; i++)
+        {
+            dataL[start + i] += _output[0][i] * _wet1 + _output[1][i] * _wet2 + revL[start + i] * _dry;
+            dataR[start + i] += _output[1][i] * _wet1 + _output[0][i] * _wet2 + revR[start + i] * _dry;
+        }
+    }
+}
+
+void Reverb::processComb(DelayLine &comb, float &filterStore, const float *input, float *output, quint32 len)
+{
+    float * buffer = comb.buffer.data();
+    int size = comb.buffer.size();
+    int pos = comb.pos;
+    float damping1 = _damping;
+    float damping2 = 1.f - _damping;
+    for (quint32 i = 0; i < len; i++)
+    {
+        // Low pass filter in the feedback
+        filterStore = buffer[pos] * damping2 + filterStore * damping1;
+        float value = input[i] + _roomSize * filterStore;
+        buffer[pos] = value;
+        output[i] += value;
+        if (++pos == size)
+            pos = 0;
+    }
+    comb.pos = pos;
+}
+
+void Reverb::processAllpass(DelayLine &allpass, float *data, quint32 len)
+{
+    float * buffer = allpass.buffer.data();
+    int size = allpass.buffer.size();
+    int pos = allpass.pos;
+    for (quint32 i = 0; i < len; i++)
+    {
+        float delayed = buffer[pos];
+        float value = data[i] + 0.5f * delayed;
+        buffer[pos] = value;
+        data[i] = 1.5f * delayed - value;
+        if (++pos == size)
+            pos = 0;
+    }
+    allpass.pos = pos;
+}
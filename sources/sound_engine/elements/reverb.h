@@ -0,0 +1,73 @@
+/***************************************************************************
+**                                                                        **
+**  Polyphone, a soundfont editor                                         **
+**  Copyright (C) 2013-2019 Davy Triponney                                **
+**                                                                        **
+**  This program is free software: you can redistribute it and/or modify  **
+**  it under the terms of the GNU General Public License as published by  **
+**  the Free Software Foundation, either version 3 of the License, or     **
+**  (at your option) any later version.                                   **
+**                                                                        **
+**  This program is distributed in the hope that it will be useful,       **
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of        **
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the          **
+**  GNU General Public License for more details.                          **
+**                                                                        **
+**  You should have received a copy of the GNU General Public License     **
+**  along with this program. If not, see http://www.gnu.org/licenses/.    **
+**                                                                        **
+****************************************************************************
+**           Author: Davy Triponney                                       **
+**  Website/Contact: https://www.polyphone-soundfonts.com                 **
+**             Date: 01.01.2013                                           **
+***************************************************************************/
+
+
+#ifndef REVERB_H
+#define REVERB_H
+
+#include <QVector>
+#include <QMutex>
+
+// Freeverb (8 comb filters in parallel followed by 4 allpass filters in series) applied on the reverb bus
+// Computed by blocks, in single precision, filter after filter
+class Reverb
+{
+public:
+    Reverb();
+
+    // Initialize the sample rate
+    void setSampleRate(quint32 sampleRate);
+
+    // Parameters between 0 and 1
+    void setParameters(float level, float roomSize, float width, float damping);
+
+    // Add to dataL / dataR the reverb bus revL / revR, processed by the reverb
+    void process(float *dataL, float *dataR, const float *revL, const float *revR, quint32 len);
+
+private:
+    struct DelayLine
+    {
+        QVector<float> buffer;
+        int pos;
+    };
+
+    void clear();
+    void processComb(DelayLine &comb, float &filterStore, const float *input, float *output, quint32 len);
+    void processAllpass(DelayLine &allpass, float *data, quint32 len);
+
+    DelayLine _combs[2][8], _allpasses[2][4];
+    float _filterStores[2][8];
+    float _input[64], _output[2][64]; // Working arrays for a chunk
+
+    float _level, _roomSize, _damping, _wet1, _wet2, _dry;
+    bool _isCleared;
+    QMutex _mutex;
+
+    static const int COMB_LENGTHS[8];
+    static const int ALLPASS_LENGTHS[4];
+    static const int STEREO_SPREAD;
+    static const quint32 CHUNK_SIZE;
+};
+
+#endif // REVERB_H
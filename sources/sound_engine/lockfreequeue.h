@@ -0,0 +1,115 @@
+/***************************************************************************
+**                                                                        **
+**  Polyphone, a soundfont editor                                         **
+**  Copyright (C) 2013-2019 Davy Triponney                                **
+**                                                                        **
+**  This program is free software: you can redistribute it and/or modify  **
+**  it under the terms of the GNU General Public License as published by  **
+**  the Free Software Foundation, either version 3 of the License, or     **
+**  (at your option) any later version.                                   **
+**                                                                        **
+**  This program is distributed in the hope that it will be useful,       **
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of        **
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the          **
+**  GNU General Public License for more details.                          **
+**                                                                        **
+**  You should have received a copy of the GNU General Public License     **
+**  along with this program. If not, see http://www.gnu.org/licenses/.    **
+**                                                                        **
+****************************************************************************
+**           Author: Davy Triponney                                       **
+**  Website/Contact: https://www.polyphone-soundfonts.com                 **
+**             Date: 01.01.2013                                           **
+***************************************************************************/
+
+
+#ifndef LOCKFREEQUEUE_H
+#define LOCKFREEQUEUE_H
+
+#include <QAtomicInteger>
+
+// Queue with a single producer and a single consumer, without any lock
+// The capacity is rounded up to a power of 2
+template <typename T>
+class LockFreeQueue
+{
+public:
+    LockFreeQueue(quint32 capacity) :
+        _readPos(0),
+        _writePos(0)
+    {
+        _capacity = 1;
+        while (_capacity < capacity)
+            _capacity <<= 1;
+        _mask = _capacity - 1;
+        _data = new T[_capacity];
+    }
+
+    ~LockFreeQueue()
+    {
+        delete [] _data;
+    }
+
+    // Producer side: add an element, return false if the queue is full
+    bool push(const T &element)
+    {
+        quint32 writePos = _writePos.loadAcquire();
+        if (writePos - _readPos.loadAcquire() >= _capacity)
+            return false;
+        _data[writePos & _mask] = element;
+        _writePos.storeRelease(writePos + 1);
+        return true;
+    }
+
+    // Consumer side: take the oldest element, return false if the queue is empty
+    bool pop(T &element)
+    {
+        quint32 readPos = _readPos.loadAcquire();
+        if (readPos == _writePos.loadAcquire())
+            return false;
+        element = _data[readPos & _mask];
+        _readPos.storeRelease(readPos + 1);
+        return true;
+    }
+
+    // Producer side: add "count" elements at once, return false (nothing being added) if there is not enough space
+    bool pushBlock(const T *elements, quint32 count)
+    {
+        quint32 writePos = _writePos.loadAcquire();
+        if (_capacity - (writePos - _readPos.loadAcquire()) < count)
+            return false;
+        for (quint32 i = 0; i < count; i++)
+            _data[(writePos + i) & _mask] = elements[i];
+        _writePos.storeRelease(writePos + count);
+        return true;
+    }
+
+    // Consumer side: take at most "maxCount" elements, return the number of elements taken
+    quint32 popBlock(T *elements, quint32 maxCount)
+    {
+        quint32 readPos = _readPos.loadAcquire();
+        quint32 count = qMin(_writePos.loadAcquire() - readPos, maxCount);
+        for (quint32 i = 0; i < count; i++)
+            elements[i] = _data[(readPos + i) & _mask];
+        _readPos.storeRelease(readPos + count);
+        return count;
+    }
+
+    // Number of elements that can be read (approximative if called by the producer)
+    quint32 size() const
+    {
+        return _writePos.loadAcquire() - _readPos.loadAcquire();
+    }
+
+    bool isEmpty() const { return size() == 0; }
+    quint32 capacity() const { return _capacity; }
+
+private:
+    Q_DISABLE_COPY(LockFreeQueue)
+
+    T * _data;
+    quint32 _capacity, _mask;
+    QAtomicInteger<quint32> _readPos, _writePos;
+};
+
+#endif // LOCKFREEQUEUE_H
@@ -0,0 +1,238 @@
+/***************************************************************************
+**                                                                        **
+**  Polyphone, a soundfont editor                                         **
+**  Copyright (C) 2013-2019 Davy Triponney                                **
+**                                                                        **
+**  This program is free software: you can redistribute it and/or modify  **
+**  it under the terms of the GNU General Public License as published by  **
+**  the Free Software Foundation, either version 3 of the License, or     **
+**  (at your option) any later version.                                   **
+**                                                                        **
+**  This program is distributed in the hope that it will be useful,       **
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of        **
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the          **
+**  GNU General Public License for more details.                          **
+**                                                                        **
+**  You should have received a copy of the GNU General Public License     **
+**  along with this program. If not, see http://www.gnu.org/licenses/.    **
+**                                                                        **
+****************************************************************************
+**           Author: Davy Triponney                                       **
+**  Website/Contact: https://www.polyphone-soundfonts.com                 **
+**             Date: 01.01.2013                                           **
+***************************************************************************/
+
+
+#include "midifilereader.h"
+#include <QFile>
+#include <QObject>
+
+MidiFileReader::MidiFileReader(QString fileName) :
+    _fileName(fileName)
+{
+
+}
+
+void MidiFileReader::process()
+{
+    _events.clear();
+    _error = "";
+
+    QFile file(_fileName);
+    if (!file.open(QIODevice::ReadOnly))
+    {
+        _error = QObject::tr("cannot open file \"%1\"").arg(_fileName);
+        return;
+    }
+    QByteArray data = file.readAll();
+    file.close();
+
+    // Header
+    if (data.size() < 14 || !data.startsWith("MThd") || readBigEndian(data, 4, 4) < 6)
+    {
+        _error = QObject::tr("not a MIDI file");
+        return;
+    }
+    quint32 format = readBigEndian(data, 8, 2);
+    quint32 trackNumber = readBigEndian(data, 10, 2);
+    quint32 division = readBigEndian(data, 12, 2);
+    if (format > 1)
+    {
+        _error = QObject::tr("MIDI file format %1 is not supported").arg(format);
+        return;
+    }
+    if (division == 0)
+    {
+        _error = QObject::tr("corrupted file");
+        return;
+    }
+
+    // Tracks
+    QList<TickEvent> tickEvents;
+    int pos = 8 + static_cast<int>(readBigEndian(data, 4, 4));
+    for (quint32 i = 0; i < trackNumber && pos + 8 <= data.size(); i++)
+    {
+        if (!readTrack(data, pos, tickEvents))
+        {
+            _error = QObject::tr("corrupted file");
+            return;
+        }
+    }
+
+    // Merge the tracks
+    qStableSort(tickEvents.begin(), tickEvents.end(), lessThan);
+
+    // Conversion of the ticks in seconds
+    double secondsPerTick;
+    bool isSmpte = (division & 0x8000) != 0;
+    if (isSmpte)
+    {
+        // Frames per second (negative value) and ticks per frame
+        int fps = 256 - static_cast<int>(division >> 8);
+        secondsPerTick = 1.0 / (fps * static_cast<double>(division & 0xFF));
+    }
+    else
+        secondsPerTick = 0.5 / division; // Default tempo: 120 bpm
+
+    double currentTime = 0;
+    quint32 currentTick = 0;
+    foreach (TickEvent tickEvent, tickEvents)
+    {
+        currentTime += (tickEvent.tick - currentTick) * secondsPerTick;
+        currentTick = tickEvent.tick;
+        if (tickEvent.status == 0xFF)
+        {
+            if (!isSmpte)
+                secondsPerTick = 0.000001 * tickEvent.tempo / division;
+        }
+        else
+        {
+            Event event;
+            event.time = currentTime;
+            event.status = tickEvent.status;
+            event.data1 = tickEvent.data1;
+            event.data2 = tickEvent.data2;
+            _events << event;
+        }
+    }
+}
+
+bool MidiFileReader::readTrack(const QByteArray &data, int &pos, QList<TickEvent> &events)
+{
+    // Chunk header, unknown chunks are skipped
+    bool isTrack = (data.mid(pos, 4) == "MTrk");
+    int end = pos + 8 + static_cast<int>(readBigEndian(data, pos + 4, 4));
+    pos += 8;
+    if (end > data.size() || end < pos)
+        return false;
+    if (!isTrack)
+    {
+        pos = end;
+        return true;
+    }
+
+    quint32 tick = 0;
+    quint8 runningStatus = 0;
+    while (pos < end)
+    {
+        quint32 delta;
+        if (!readVariableLength(data, pos, end, delta) || pos >= end)
+            return false;
+        tick += delta;
+
+        quint8 status = static_cast<quint8>(data[pos]);
+        if (status < 0x80)
+        {
+            // Running status
+            if (runningStatus == 0)
+                return false;
+            status = runningStatus;
+        }
+        else
+            pos++;
+
+        if (status == 0xFF)
+        {
+            // Meta event
+            if (pos >= end)
+                return false;
+            quint8 type = static_cast<quint8>(data[pos++]);
+            quint32 length;
+            if (!readVariableLength(data, pos, end, length) || pos + static_cast<int>(length) > end)
+                return false;
+            if (type == 0x51 && length == 3)
+            {
+                TickEvent event;
+                event.tick = tick;
+                event.order = events.size();
+                event.status = 0xFF;
+                event.data1 = event.data2 = 0;
+                event.tempo = readBigEndian(data, pos, 3);
+                events << event;
+            }
+            pos += static_cast<int>(length);
+            if (type == 0x2F)
+                break; // End of track
+        }
+        else if (status == 0xF0 || status == 0xF7)
+        {
+            // System exclusive, skipped
+            quint32 length;
+            if (!readVariableLength(data, pos, end, length) || pos + static_cast<int>(length) > end)
+                return false;
+            pos += static_cast<int>(length);
+        }
+        else if (status >= 0x80 && status < 0xF0)
+        {
+            // Channel message, with 1 or 2 data bytes
+            runningStatus = status;
+            int dataNumber = ((status & 0xF0) == 0xC0 || (status & 0xF0) == 0xD0) ? 1 : 2;
+            if (pos + dataNumber > end)
+                return false;
+
+            TickEvent event;
+            event.tick = tick;
+            event.order = events.size();
+            event.status = status;
+            event.data1 = static_cast<quint8>(data[pos]) & 0x7F;
+            event.data2 = dataNumber == 2 ? static_cast<quint8>(data[pos + 1]) & 0x7F : 0;
+            event.tempo = 0;
+            events << event;
+            pos += dataNumber;
+        }
+        else
+            return false; // System common messages are not allowed in a file
+    }
+
+    pos = end;
+    return true;
+}
+
+bool MidiFileReader::lessThan(const TickEvent &event1, const TickEvent &event2)
+{
+    return event1.tick < event2.tick || (event1.tick == event2.tick && event1.order < event2.order);
+}
+
+bool MidiFileReader::readVariableLength(const QByteArray &data, int &pos, int end, quint32 &value)
+{
+    // At most 4 bytes, 7 bits each
+    value = 0;
+    for (int i = 0; i < 4; i++)
+    {
+        if (pos >= end)
+            return false;
+        quint8 byte = static_cast<quint8>(data[pos++]);
+        value = (value << 7) | (byte & 0x7F);
+        if ((byte & 0x80) == 0)
+            return true;
+    }
+    return false;
+}
+
+quint32 MidiFileReader::readBigEndian(const QByteArray &data, int pos, int size)
+{
+    quint32 value = 0;
+    for (int i = 0; i < size; i++)
+        value = (value << 8) | static_cast<quint8>(data[pos + i]);
+    return value;
+}
@@ -0,0 +1,76 @@
+/***************************************************************************
+**                                                                        **
+**  Polyphone, a soundfont editor                                         **
+**  Copyright (C) 2013-2019 Davy Triponney                                **
+**                                                                        **
+**  This program is free software: you can redistribute it and/or modify  **
+**  it under the terms of the GNU General Public License as published by  **
+**  the Free Software Foundation, either version 3 of the License, or     **
+**  (at your option) any later version.                                   **
+**                                                                        **
+**  This program is distributed in the hope that it will be useful,       **
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of        **
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the          **
+**  GNU General Public License for more details.                          **
+**                                                                        **
+**  You should have received a copy of the GNU General Public License     **
+**  along with this program. If not, see http://www.gnu.org/licenses/.    **
+**                                                                        **
+****************************************************************************
+**           Author: Davy Triponney                                       **
+**  Website/Contact: https://www.polyphone-soundfonts.com                 **
+**             Date: 01.01.2013                                           **
+***************************************************************************/
+
+
+#ifndef MIDIFILEREADER_H
+#define MIDIFILEREADER_H
+
+#include <QString>
+#include <QList>
+
+// Read a Standard MIDI File (format 0 or 1)
+// Channel messages of all tracks are merged and dated in seconds with the tempo map
+class MidiFileReader
+{
+public:
+    struct Event
+    {
+        double time; // In seconds
+        quint8 status;
+        quint8 data1;
+        quint8 data2;
+    };
+
+    MidiFileReader(QString fileName);
+
+    // Read the file
+    void process();
+
+    // Result
+    bool isSuccess() { return _error.isEmpty(); }
+    QString getError() { return _error; }
+    QList<Event> getEvents() { return _events; }
+
+private:
+    struct TickEvent
+    {
+        quint32 tick;
+        int order; // Position in the file, for sorting simultaneous events
+        quint8 status;
+        quint8 data1;
+        quint8 data2;
+        quint32 tempo; // Microseconds per quarter note if status is 0xFF (tempo change)
+    };
+
+    static bool lessThan(const TickEvent &event1, const TickEvent &event2);
+    bool readTrack(const QByteArray &data, int &pos, QList<TickEvent> &events);
+    static bool readVariableLength(const QByteArray &data, int &pos, int end, quint32 &value);
+    static quint32 readBigEndian(const QByteArray &data, int pos, int size);
+
+    QString _fileName;
+    QString _error;
+    QList<Event> _events;
+};
+
+#endif // MIDIFILEREADER_H
@@ -25,14 +25,22 @@
 #include "modulatedparameter.h"
 #include "utils.h"
 
-ModulatedParameter::ModulatedParameter(AttributeType type) :
-    _type(type),
-    _instValue(type, false),
-    _prstValue(type, true),
+ModulatedParameter::ModulatedParameter() :
+    _type(champ_unknown),
     _instModulation(0),
     _prstModulation(0),
-    _computed(false)
+    _notRealTime(false),
+    _computed(false),
+    _computedRealValue(0)
+{}
+
+void ModulatedParameter::initialize(AttributeType type)
 {
+    _type = type;
+    _instValue = Attribute::getDefaultStoredValue(type, false);
+    _prstValue = Attribute::getDefaultStoredValue(type, true);
+    _computed = false;
+
     // Some parameters are computed only once
     _notRealTime = (_type == champ_keynum || _type == champ_velocity || _type == champ_sampleModes ||
                     _type == champ_scaleTuning || _type == champ_exclusiveClass || _type == champ_overridingRootKey ||
@@ -42,30 +50,48 @@ ModulatedParameter::ModulatedParameter(AttributeType type) :
 void ModulatedParameter::initValue(AttributeValue value, bool isPrst)
 {
     if (isPrst)
-        _prstValue.setStoredValue(value);
+        _prstValue = value;
     else
-        _instValue.setStoredValue(value);
+        _instValue = value;
 
     // Initialize the computed value for non real-time parameters
     _computedValue = value;
+    if (_notRealTime && _computed)
+        _computedRealValue = Attribute::toRealValue(_type, false, _computedValue);
+    else
+        _computed = false;
 }
 
 void ModulatedParameter::clearModulations()
 {
-    _instModulation = 0;
-    _prstModulation = 0;
+    if (_instModulation != 0 || _prstModulation != 0)
+    {
+        _instModulation = 0;
+        _prstModulation = 0;
+        if (!_notRealTime)
+            _computed = false;
+    }
 }
 
 void ModulatedParameter::addInstModulation(double value)
 {
-    _instModulation += value;
+    if (value != 0)
+    {
+        _instModulation += value;
+        if (!_notRealTime)
+            _computed = false;
+    }
 }
 
 void ModulatedParameter::addPrstModulation(double value)
 {
     // Some attributes cannot be modulated at the preset level
-    if (_type != champ_overridingRootKey && _type != champ_velocity && _type != champ_keynum)
+    if (value != 0 && _type != champ_overridingRootKey && _type != champ_velocity && _type != champ_keynum)
+    {
         _prstModulation += value;
+        if (!_notRealTime)
+            _computed = false;
+    }
 }
 
 qint32 ModulatedParameter::getIntValue()
@@ -82,35 +108,33 @@ double ModulatedParameter::getRealValue()
     // Compute the value
     computeValue();
 
-    // Special case: attenuation
-    if (_type == champ_initialAttenuation)
-    {
-        // Historical error: extra coefficient 0.4 for the inst and prst values => multiplication by 0.04
-        // no extra coefficient for the modulations => the conversion with the coeff 0.1 is kept
-        double value = 0.04 * (_instValue.getStoredValue().shValue + _prstValue.getStoredValue().shValue) +
-                0.1 * (_instModulation + _prstModulation);
-        return value < 0 ? 0 : (value > 144 ? 144 : value);
-    }
-
     // Return a possibly converted value
-    return Attribute(_type, false, _computedValue).getRealValue();
+    return _computedRealValue;
 }
 
 void ModulatedParameter::computeValue()
 {
-    // Attenuation is not computed here
-    if ((_computed && _notRealTime) || _type == champ_initialAttenuation)
+    if (_computed)
         return;
+    _computed = true;
+
+    // Special case: attenuation
+    if (_type == champ_initialAttenuation)
+    {
+        // Historical error: extra coefficient 0.4 for the inst and prst values => multiplication by 0.04
+        // no extra coefficient for the modulations => the conversion with the coeff 0.1 is kept
+        double value = 0.04 * (_instValue.shValue + _prstValue.shValue) + 0.1 * (_instModulation + _prstModulation);
+        _computedRealValue = value < 0 ? 0 : (value > 144 ? 144 : value);
+        return;
+    }
 
     // Add all values and modulations before any conversion
-    // Special case for the attenuation: the value (not the modulation) must be stupidly multiplied by 0.4
     // Special case for keynum, overriding root key and velocity: only instrument values
     qint32 addition = 0;
     if (_type == champ_overridingRootKey || _type == champ_velocity || _type == champ_keynum)
-        addition = Utils::round32(_instModulation) + _instValue.getStoredValue().shValue;
+        addition = Utils::round32(_instModulation) + _instValue.shValue;
     else
-        addition = Utils::round32(_instModulation + _prstModulation) +
-                _instValue.getStoredValue().shValue + _prstValue.getStoredValue().shValue;
+        addition = Utils::round32(_instModulation + _prstModulation) + _instValue.shValue + _prstValue.shValue;
 
     // Limit the result
     if (addition > 32767)
@@ -123,5 +147,6 @@ void ModulatedParameter::computeValue()
     if (_type != champ_fineTune) // This parameter can be out of its original range (pitch wheel)
         _computedValue = Attribute::limit(_type, _computedValue, false);
 
-    _computed = true;
+    // Conversion
+    _computedRealValue = Attribute::toRealValue(_type, false, _computedValue);
 }
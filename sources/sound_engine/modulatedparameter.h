@@ -30,8 +30,10 @@
 class ModulatedParameter
 {
 public:
-    // Initialize a modulated parameter
-    ModulatedParameter(AttributeType type);
+    // A modulated parameter is not used as long as its type is not initialized
+    ModulatedParameter();
+    void initialize(AttributeType type);
+    bool isUsed() { return _type != champ_unknown; }
 
     // Set the values from the instrument or preset level
     void initValue(AttributeValue value, bool isPrst);
@@ -42,6 +44,7 @@ public:
     void addPrstModulation(double value);
 
     // Get the resulting value as an integer or a double (a conversion might occur)
+    // The result is computed again only if a value or a modulation changed
     qint32 getIntValue();
     double getRealValue();
 
@@ -49,12 +52,13 @@ private:
     void computeValue();
 
     AttributeType _type;
-    Attribute _instValue, _prstValue;
+    AttributeValue _instValue, _prstValue;
     double _instModulation, _prstModulation;
 
     bool _notRealTime;
     bool _computed;
     AttributeValue _computedValue;
+    double _computedRealValue;
 };
 
 #endif // MODULATEDPARAMETER_H
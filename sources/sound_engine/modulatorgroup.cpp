@@ -27,7 +27,7 @@
 #include "modulatedparameter.h"
 #include "parametermodulator.h"
 
-ModulatorGroup::ModulatorGroup(QMap<AttributeType, ModulatedParameter *> * parameters, bool isPrst) :
+ModulatorGroup::ModulatorGroup(ModulatedParameter * parameters, bool isPrst) :
     _parameters(parameters),
     _isPrst(isPrst)
 {
@@ -81,7 +81,10 @@ void ModulatorGroup::loadModulators(QList<ModulatorData> &modulators)
         if (!overwritten)
             _modulators << new ParameterModulator(modData, _isPrst, _initialKey, _keyForComputation, _velForComputation);
     }
+}
 
+void ModulatorGroup::prepare()
+{
     // Link outputs
     foreach (ParameterModulator * modulator, _modulators)
     {
@@ -89,8 +92,8 @@ void ModulatorGroup::loadModulators(QList<ModulatorData> &modulators)
         if (output < 32768)
         {
             // The target is a parameter
-            if (_parameters->contains(static_cast<AttributeType>(output)))
-                modulator->setOutput(_parameters->value(static_cast<AttributeType>(output)));
+            if (output < champ_endOper && _parameters[output].isUsed())
+                modulator->setOutput(&_parameters[output]);
         }
         else
         {
@@ -106,21 +109,35 @@ void ModulatorGroup::loadModulators(QList<ModulatorData> &modulators)
             }
         }
     }
-}
 
-void ModulatorGroup::process()
-{
-    // Process the input of the modulators
+    // Number of inputs coming from other modulators
+    int count = _modulators.count();
+    QVector<int> inputNumber(count, 0);
     foreach (ParameterModulator * modulator, _modulators)
-        modulator->processInput();
+        if (modulator->getOutputModulator() != nullptr)
+            inputNumber[_modulators.indexOf(modulator->getOutputModulator())]++;
 
-    // Compute the output of the modulators, as long as everything has not been completed
-    // or until a maximum (reached in the case where we have a loop)
-    bool ok;
-    int count = 0;
-    do {
-        ok = true;
-        foreach (ParameterModulator * modulator, _modulators)
-            ok &= modulator->processOutput();
-    } while (!ok && count++ < _modulators.count());
+    // Topological sort: a modulator is ready when all its inputs are sorted
+    _sortedModulators.clear();
+    _sortedModulators.reserve(count);
+    for (int i = 0; i < count; i++)
+        if (inputNumber[i] == 0)
+            _sortedModulators << _modulators[i];
+    for (int i = 0; i < _sortedModulators.count(); i++)
+    {
+        ParameterModulator * target = _sortedModulators[i]->getOutputModulator();
+        if (target != nullptr && --inputNumber[_modulators.indexOf(target)] == 0)
+            _sortedModulators << target;
+    }
+
+    // Modulators in a loop (or fed by a loop) are never complete and are not processed
+    foreach (ParameterModulator * modulator, _sortedModulators)
+        if (modulator->getOutputModulator() != nullptr && !_sortedModulators.contains(modulator->getOutputModulator()))
+            modulator->setOutput(static_cast<ParameterModulator *>(nullptr));
+}
+
+void ModulatorGroup::process(const ControllerSnapshot &controllers)
+{
+    for (int i = 0; i < _sortedModulators.count(); i++)
+        _sortedModulators[i]->process(controllers);
 }
@@ -26,13 +26,15 @@
 #define MODULATORGROUP_H
 
 #include "basetypes.h"
+#include <QVector>
 class ModulatedParameter;
 class ParameterModulator;
+struct ControllerSnapshot;
 
 class ModulatorGroup
 {
 public:
-    ModulatorGroup(QMap<AttributeType, ModulatedParameter *> * parameters, bool isPrst);
+    ModulatorGroup(ModulatedParameter * parameters, bool isPrst);
     ~ModulatorGroup();
 
     // Initialize with keys and vel
@@ -41,16 +43,21 @@ public:
     // Load modulators from the instrument or preset level
     void loadModulators(QList<ModulatorData> &modulators);
 
+    // Link the modulators once they are all loaded and sort them so that
+    // a modulator is always processed after the modulators linked to its input
+    void prepare();
+
     // Compute the modulations and apply them on the parameters
-    void process();
+    void process(const ControllerSnapshot &controllers);
 
 private:
     void loadDefaultModulators();
 
-    QMap<AttributeType, ModulatedParameter *> * _parameters;
+    ModulatedParameter * _parameters; // Array indexed by AttributeType
     bool _isPrst;
     int _initialKey, _keyForComputation, _velForComputation;
     QList<ParameterModulator *> _modulators;
+    QVector<ParameterModulator *> _sortedModulators;
 };
 
 #endif // MODULATORGROUP_H
@@ -0,0 +1,290 @@
+/***************************************************************************
+**                                                                        **
+**  Polyphone, a soundfont editor                                         **
+**  Copyright (C) 2013-2019 Davy Triponney                                **
+**                                                                        **
+**  This program is free software: you can redistribute it and/or modify  **
+**  it under the terms of the GNU General Public License as published by  **
+**  the Free Software Foundation, either version 3 of the License, or     **
+**  (at your option) any later version.                                   **
+**                                                                        **
+**  This program is distributed in the hope that it will be useful,       **
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of        **
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the          **
+**  GNU General Public License for more details.                          **
+**                                                                        **
+**  You should have received a copy of the GNU General Public License     **
+**  along with this program. If not, see http://www.gnu.org/licenses/.    **
+**                                                                        **
+****************************************************************************
+**           Author: Davy Triponney                                       **
+**  Website/Contact: https://www.polyphone-soundfonts.com                 **
+**             Date: 01.01.2013                                           **
+***************************************************************************/
+
+
+#include "offlinerenderer.h"
+#include "synth.h"
+#include "soundfontmanager.h"
+#include "samplewriterwav.h"
+#include "samplewriterflac.h"
+#include <QElapsedTimer>
+#include <QFileInfo>
+
+const float OfflineRenderer::SILENCE_THRESHOLD = 0.00001f; // -100 dB
+const double OfflineRenderer::MAX_TAIL_DURATION = 10.0; // Seconds rendered at most after the last event
+
+OfflineRenderer::OfflineRenderer(ConfManager * configuration, int sf2Index, quint32 sampleRate) :
+    _synth(new Synth(configuration, true)),
+    _sf2Index(sf2Index),
+    _sampleRate(sampleRate),
+    _controllerValues(_synth->getControllerValues()), // Read by the voices of the synth
+    _lastPeak(0),
+    _frameNumber(0),
+    _wavWriter(nullptr),
+    _flacWriter(nullptr),
+    _duration(0),
+    _realTimeFactor(0)
+{
+    AudioFormat format;
+    format.setChannelCount(2);
+    format.setSampleRate(sampleRate);
+    format.setSampleSize(32);
+    _synth->setFormat(format);
+
+    _dataL = new float[_synth->getBufferSize()];
+    _dataR = new float[_synth->getBufferSize()];
+    _data.reserve(static_cast<int>(6 * _synth->getBufferSize()));
+
+    // Initial state of the channels, the 10th channel being for drums
+    for (int i = 0; i < 16; i++)
+    {
+        _channels[i].bank = (i == 9 ? 128 : 0);
+        _channels[i].program = 0;
+        _channels[i].isSustainOn = false;
+        updatePreset(i);
+    }
+}
+
+OfflineRenderer::~OfflineRenderer()
+{
+    delete _synth;
+    delete [] _dataL;
+    delete [] _dataR;
+    delete _wavWriter;
+    delete _flacWriter;
+}
+
+void OfflineRenderer::process(QList<MidiFileReader::Event> events, QString outputFile)
+{
+    _error = "";
+    _frameNumber = 0;
+    EltID idPrst(elementPrst, _sf2Index);
+    if (SoundfontManager::getInstance()->getSiblingCount(idPrst) == 0)
+    {
+        _error = QObject::tr("no presets in the soundfont");
+        return;
+    }
+
+    // The file is written while rendering
+    InfoSound info;
+    info.dwSampleRate = _sampleRate;
+    info.wChannels = 2;
+    info.wBpsFile = 24;
+    info.dwLength = 0; // Unknown
+    bool ok;
+    if (QFileInfo(outputFile).suffix().toLower() == "flac")
+    {
+        _flacWriter = new SampleWriterFlac(outputFile);
+        ok = _flacWriter->open(info);
+    }
+    else
+    {
+        _wavWriter = new SampleWriterWav(outputFile);
+        ok = _wavWriter->open(info);
+    }
+    if (!ok)
+        _error = QObject::tr("cannot write file \"%1\"").arg(outputFile);
+
+    QElapsedTimer timer;
+    timer.start();
+
+    // Render the sound between each event, so that each event occurs at the right sample
+    quint64 currentPosition = 0;
+    foreach (MidiFileReader::Event event, events)
+    {
+        if (!_error.isEmpty())
+            break;
+        quint64 eventPosition = static_cast<quint64>(event.time * _sampleRate + 0.5);
+        if (eventPosition > currentPosition)
+        {
+            render(static_cast<quint32>(eventPosition - currentPosition));
+            currentPosition = eventPosition;
+        }
+        processEvent(event);
+    }
+
+    // Release everything and render the tail until silence
+    for (int channel = 0; channel < 16; channel++)
+    {
+        _channels[channel].isSustainOn = false;
+        while (!_channels[channel].sustainedKeys.isEmpty())
+            releaseKey(channel, _channels[channel].sustainedKeys.takeFirst());
+    }
+    quint32 tailLength = 0;
+    quint32 silenceLength = 0;
+    while (_error.isEmpty() && silenceLength < _sampleRate / 2 && tailLength < MAX_TAIL_DURATION * _sampleRate)
+    {
+        render(_synth->getBufferSize());
+        tailLength += _synth->getBufferSize();
+        silenceLength = (_lastPeak < SILENCE_THRESHOLD) ? silenceLength + _synth->getBufferSize() : 0;
+    }
+
+    // Statistics
+    _duration = static_cast<double>(_frameNumber) / _sampleRate;
+    qint64 elapsed = timer.nsecsElapsed();
+    _realTimeFactor = elapsed > 0 ? _duration * 1000000000. / elapsed : 0;
+
+    // Complete the file
+    if (_flacWriter != nullptr)
+        ok = _flacWriter->close();
+    else if (_wavWriter != nullptr)
+        ok = _wavWriter->close();
+    delete _wavWriter;
+    _wavWriter = nullptr;
+    delete _flacWriter;
+    _flacWriter = nullptr;
+    if (!ok && _error.isEmpty())
+        _error = QObject::tr("cannot write file \"%1\"").arg(outputFile);
+}
+
+void OfflineRenderer::processEvent(const MidiFileReader::Event &event)
+{
+    int channel = event.status & 0x0F;
+    ChannelState &state = _channels[channel];
+    switch (event.status & 0xF0)
+    {
+    case 0x80: case 0x90: // NOTE ON or NOTE OFF
+        if ((event.status & 0xF0) == 0x80 || event.data2 == 0)
+        {
+            if (state.isSustainOn)
+            {
+                if (!state.sustainedKeys.contains(event.data1))
+                    state.sustainedKeys << event.data1;
+            }
+            else
+                releaseKey(channel, event.data1);
+        }
+        else if (state.preset != -1) // Nothing is played if the bank and the program match no preset
+        {
+            _controllerValues->initPolyPressure(channel, event.data1, event.data2);
+            state.sustainedKeys.removeAll(event.data1);
+            _synth->play(EltID(elementPrst, _sf2Index, state.preset), event.data1, event.data2, -1, channel);
+        }
+        break;
+    case 0xA0: // AFTERTOUCH
+        _controllerValues->setPolyPressure(channel, event.data1, event.data2);
+        break;
+    case 0xB0: // CONTROLLER CHANGE
+        _controllerValues->setControllerValue(channel, event.data1, event.data2);
+        switch (event.data1)
+        {
+        case 0: // Bank select (MSB), the drum channel keeps the bank 128
+            if (channel != 9)
+            {
+                state.bank = event.data2;
+                updatePreset(channel);
+            }
+            break;
+        case 64: // Sustain pedal
+            state.isSustainOn = (event.data2 >= 64);
+            if (!state.isSustainOn)
+                while (!state.sustainedKeys.isEmpty())
+                    releaseKey(channel, state.sustainedKeys.takeFirst());
+            break;
+        case 101: case 100: case 6: case 38:
+            // RPN, the bend sensitivity being sent with 4 messages (same as the MIDI device)
+            state.rpnHistory << QPair<int, int>(event.data1, event.data2);
+            if (state.rpnHistory.size() > 4)
+                state.rpnHistory.removeFirst();
+            if (event.data1 == 38 && state.rpnHistory.size() == 4 &&
+                    state.rpnHistory[0].first == 101 && state.rpnHistory[0].second == 0 &&
+                    state.rpnHistory[1].first == 100 && state.rpnHistory[1].second == 0 &&
+                    state.rpnHistory[2].first == 6)
+                _controllerValues->setBendSensitivityValue(
+                            channel, 0.01 * state.rpnHistory[3].second + state.rpnHistory[2].second);
+            break;
+        case 120: case 123: // All sound off, all notes off
+            state.sustainedKeys.clear();
+            for (int key = 0; key < 128; key++)
+                releaseKey(channel, key);
+            break;
+        default:
+            break;
+        }
+        break;
+    case 0xC0: // PROGRAM CHANGED
+        state.program = event.data1;
+        updatePreset(channel);
+        break;
+    case 0xD0: // MONO PRESSURE
+        _controllerValues->setMonoPressure(channel, event.data1);
+        break;
+    case 0xE0: // BEND
+        // Value on 14 bits, converted between -1 and 1
+        _controllerValues->setBendValue(channel, static_cast<double>(((event.data2 << 7) | event.data1) - 8192) / 8192.0);
+        break;
+    default:
+        break;
+    }
+}
+
+void OfflineRenderer::releaseKey(int channel, int key)
+{
+    _synth->play(EltID(elementUnknown), key, 0, -1, channel);
+}
+
+void OfflineRenderer::updatePreset(int channel)
+{
+    // Resolved once per bank or program change rather than for each note
+    _channels[channel].preset = SoundfontManager::getInstance()->getMidiPreset(
+                _sf2Index, _channels[channel].bank, _channels[channel].program);
+}
+
+void OfflineRenderer::render(quint32 length)
+{
+    // Same channel order as the recorder of the synth
+    _lastPeak = 0;
+    while (length > 0)
+    {
+        quint32 chunk = qMin(length, _synth->getBufferSize());
+        _synth->readData(_dataL, _dataR, chunk);
+
+        _data.resize(static_cast<int>(6 * chunk)); // Capacity reserved for a whole buffer
+        char * data = _data.data();
+        for (quint32 i = 0; i < chunk; i++)
+        {
+            qint32 values[2] = {
+                static_cast<qint32>(qBound(-1.f, _dataR[i], 0.9999999f) * 8388608.f),
+                static_cast<qint32>(qBound(-1.f, _dataL[i], 0.9999999f) * 8388608.f)
+            };
+            for (int j = 0; j < 2; j++)
+            {
+                *data++ = static_cast<char>(values[j] & 0xFF);
+                *data++ = static_cast<char>((values[j] >> 8) & 0xFF);
+                *data++ = static_cast<char>((values[j] >> 16) & 0xFF);
+            }
+            _lastPeak = qMax(_lastPeak, qMax(qAbs(_dataL[i]), qAbs(_dataR[i])));
+        }
+        _frameNumber += chunk;
+        length -= chunk;
+
+        bool ok = (_flacWriter != nullptr) ? _flacWriter->append(_data) : _wavWriter->append(_data);
+        if (!ok)
+        {
+            _error = QObject::tr("cannot write file, %1 seconds rendered").arg(
+                        static_cast<double>(_frameNumber) / _sampleRate, 0, 'f', 1);
+            break;
+        }
+    }
+}
@@ -0,0 +1,90 @@
+/***************************************************************************
+**                                                                        **
+**  Polyphone, a soundfont editor                                         **
+**  Copyright (C) 2013-2019 Davy Triponney                                **
+**                                                                        **
+**  This program is free software: you can redistribute it and/or modify  **
+**  it under the terms of the GNU General Public License as published by  **
+**  the Free Software Foundation, either version 3 of the License, or     **
+**  (at your option) any later version.                                   **
+**                                                                        **
+**  This program is distributed in the hope that it will be useful,       **
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of        **
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the          **
+**  GNU General Public License for more details.                          **
+**                                                                        **
+**  You should have received a copy of the GNU General Public License     **
+**  along with this program. If not, see http://www.gnu.org/licenses/.    **
+**                                                                        **
+****************************************************************************
+**           Author: Davy Triponney                                       **
+**  Website/Contact: https://www.polyphone-soundfonts.com                 **
+**             Date: 01.01.2013                                           **
+***************************************************************************/
+
+
+#ifndef OFFLINERENDERER_H
+#define OFFLINERENDERER_H
+
+#include "basetypes.h"
+#include "midifilereader.h"
+class ConfManager;
+class Synth;
+class ControllerValues;
+class SampleWriterWav;
+class SampleWriterFlac;
+
+// Render a MIDI file with a soundfont, as fast as possible and without audio device
+class OfflineRenderer
+{
+public:
+    OfflineRenderer(ConfManager * configuration, int sf2Index, quint32 sampleRate = 44100);
+    ~OfflineRenderer();
+
+    // Render the events and write the result in a wav or flac file (depending on the extension)
+    void process(QList<MidiFileReader::Event> events, QString outputFile);
+
+    // Result
+    bool isSuccess() { return _error.isEmpty(); }
+    QString getError() { return _error; }
+    double getDuration() { return _duration; } // Seconds rendered
+    double getRealTimeFactor() { return _realTimeFactor; } // Duration divided by the time spent
+
+private:
+    struct ChannelState
+    {
+        int bank;
+        int program;
+        int preset; // Index of the preset played with the bank and program, -1 if none
+        bool isSustainOn;
+        QList<int> sustainedKeys;
+        QList<QPair<int, int> > rpnHistory;
+    };
+
+    void processEvent(const MidiFileReader::Event &event);
+    void render(quint32 length); // The result is written in the output file
+    void updatePreset(int channel);
+    void releaseKey(int channel, int key);
+
+    Synth * _synth;
+    int _sf2Index;
+    quint32 _sampleRate;
+    ControllerValues * _controllerValues;
+    ChannelState _channels[16];
+    QByteArray _data; // 24-bit stereo, one chunk
+    float * _dataL, * _dataR;
+    float _lastPeak;
+    quint64 _frameNumber;
+
+    // Only one of them is used, depending on the extension of the output file
+    SampleWriterWav * _wavWriter;
+    SampleWriterFlac * _flacWriter;
+
+    QString _error;
+    double _duration, _realTimeFactor;
+
+    static const float SILENCE_THRESHOLD;
+    static const double MAX_TAIL_DURATION;
+};
+
+#endif // OFFLINERENDERER_H
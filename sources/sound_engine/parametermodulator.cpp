@@ -24,16 +24,12 @@
 
 #include "parametermodulator.h"
 #include "modulatedparameter.h"
-#include "contextmanager.h"
+#include "controllersnapshot.h"
 #include "utils.h"
 
 ParameterModulator::ParameterModulator(ModulatorData &modData, bool isPrst, int initialKey, int keyForComputation, int velForComputation) :
     _data(modData),
-    _inputNumber(0),
-    _inputCount(0),
-    _computed(false),
-    _input1(0),
-    _input2(0),
+    _linkedInput(0),
     _outputParameter(nullptr),
     _outputModulator(nullptr),
     _isPrst(isPrst),
@@ -65,38 +61,26 @@ void ParameterModulator::setOutput(ModulatedParameter * parameter)
 void ParameterModulator::setOutput(ParameterModulator * modulator)
 {
     _outputModulator = modulator;
-    _outputModulator->waitForAnInput();
 }
 
-void ParameterModulator::processInput()
+void ParameterModulator::process(const ControllerSnapshot &controllers)
 {
+    // Compute data
+    double result = 0;
     if (_data.amount != 0)
     {
-        _input1 = getValue(_data.srcOper);
-        _input2 = getValue(_data.amtSrcOper);
+        result = (getValue(_data.srcOper, controllers) + _linkedInput) *
+                getValue(_data.amtSrcOper, controllers) * _data.amount;
+        if (_data.transOper == SFTransform::absolute_value && result < 0)
+            result = -result;
     }
-
-    _inputCount = 0;
-    _computed = false;
-}
-
-bool ParameterModulator::processOutput()
-{
-    if (_inputCount < _inputNumber)
-        return false; // We need to wait
-    if (_computed)
-        return true; // Already computed
-
-    // Compute data
-    double result = _input1 * _input2 * _data.amount;
-    if (_data.transOper == SFTransform::absolute_value && result < 0)
-        result = -result;
+    _linkedInput = 0;
 
     // Output
     if (_outputModulator != nullptr)
     {
         // Send the value to another modulator
-        _outputModulator->setInput(result);
+        _outputModulator->addInput(result);
     }
     else if (_outputParameter != nullptr)
     {
@@ -106,26 +90,16 @@ bool ParameterModulator::processOutput()
         else
             _outputParameter->addInstModulation(result);
     }
-
-    // Computed!
-    _computed = true;
-    return true;
-}
-
-void ParameterModulator::setInput(double value)
-{
-    _input1 += value;
-    _inputCount++;
 }
 
-double ParameterModulator::getValue(SFModulator sfMod)
+double ParameterModulator::getValue(SFModulator sfMod, const ControllerSnapshot &controllers)
 {
     // Base value
     double value = -1;
     if (sfMod.CC)
     {
         // Midi controllers
-        value = ContextManager::midi()->getControllerValue(sfMod.Index);
+        value = controllers.controllerValues[sfMod.Index & 0x7F];
     }
     else
     {
@@ -144,17 +118,17 @@ double ParameterModulator::getValue(SFModulator sfMod)
             break;
         case GC_polypressure:
             // After touch by key
-            value = ContextManager::midi()->getPolyPressure(_initialKey);
+            value = (_initialKey >= 0 && _initialKey < 128) ? controllers.polyPressureValues[_initialKey] : -1;
             break;
         case GC_channelPressure:
             // After touch for the whole keyboard
-            value = ContextManager::midi()->getMonoPressure();
+            value = controllers.monoPressure;
             break;
         case GC_pitchWheel:
-            value = 64 * (ContextManager::midi()->getBendValue() + 1);
+            value = 64 * (controllers.bendValue + 1);
             break;
         case GC_pitchWheelSensitivity:
-            value = ContextManager::midi()->getBendSensitivityValue();
+            value = controllers.bendSensitivityValue;
             break;
         case GC_link: default:
             // Link (the value will come later)
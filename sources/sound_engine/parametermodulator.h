@@ -27,6 +27,7 @@
 
 #include "basetypes.h"
 class ModulatedParameter;
+struct ControllerSnapshot;
 
 class ParameterModulator
 {
@@ -40,32 +41,26 @@ public:
     // Get info about the modulator
     quint16 getOuputType() { return _data.destOper; }
     quint16 getIndex() { return _data.index; }
+    ParameterModulator * getOutputModulator() { return _outputModulator; }
 
     // Set the output
     void setOutput(ModulatedParameter * parameter);
     void setOutput(ParameterModulator * modulator);
 
-    // Compute the input based on midi values
-    void processInput();
-
-    // Process the output and return true or return false if the input is not computed yet
-    bool processOutput();
+    // Compute the modulation based on the midi values of the voice channel and send it to the output
+    // The modulators linked to the input must be processed before
+    void process(const ControllerSnapshot &controllers);
 
 private:
     // Input coming from another modulator
-    void setInput(double value);
-
-    // Add 1 to the number of input to wait before computing the result
-    void waitForAnInput() { _inputNumber++; }
+    void addInput(double value) { _linkedInput += value; }
 
     // Get a current input value
-    double getValue(SFModulator sfMod);
+    double getValue(SFModulator sfMod, const ControllerSnapshot &controllers);
 
     ModulatorData _data;
 
-    int _inputNumber, _inputCount;
-    bool _computed;
-    double _input1, _input2;
+    double _linkedInput;
     ModulatedParameter * _outputParameter;
     ParameterModulator * _outputModulator;
     bool _isPrst;
@@ -0,0 +1,246 @@
+/***************************************************************************
+**                                                                        **
+**  Polyphone, a soundfont editor                                         **
+**  Copyright (C) 2013-2019 Davy Triponney                                **
+**                                                                        **
+**  This program is free software: you can redistribute it and/or modify  **
+**  it under the terms of the GNU General Public License as published by  **
+**  the Free Software Foundation, either version 3 of the License, or     **
+**  (at your option) any later version.                                   **
+**                                                                        **
+**  This program is distributed in the hope that it will be useful,       **
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of        **
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the          **
+**  GNU General Public License for more details.                          **
+**                                                                        **
+**  You should have received a copy of the GNU General Public License     **
+**  along with this program. If not, see http://www.gnu.org/licenses/.    **
+**                                                                        **
+****************************************************************************
+**           Author: Davy Triponney                                       **
+**  Website/Contact: https://www.polyphone-soundfonts.com                 **
+**             Date: 01.01.2013                                           **
+***************************************************************************/
+
+
+#include "profiler.h"
+#include "samplestreamer.h"
+#include "voicescratch.h"
+#include "mididispatcher.h"
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QFile>
+
+QAtomicInt Profiler::s_isEnabled(0);
+QAtomicInteger<quint32> Profiler::s_xrunNumber(0);
+QAtomicInteger<quint32> Profiler::s_missedDeadlineNumber(0);
+QAtomicInteger<quint32> Profiler::s_bufferUnderrunNumber(0);
+QAtomicInteger<quint32> Profiler::s_minBufferLevel(0xFFFFFFFF);
+QList<ProfilerStats *> Profiler::s_stats;
+QMutex Profiler::s_mutexStats;
+
+ProfilerStats::ProfilerStats(QString name) :
+    _name(name),
+    _resetRequested(0)
+{
+    for (int i = 0; i < STAGE_NUMBER; i++)
+        _blockTimes[i] = 0;
+    clear();
+    Profiler::registerStats(this);
+}
+
+ProfilerStats::~ProfilerStats()
+{
+    Profiler::unregisterStats(this);
+}
+
+void ProfilerStats::addLatency(qint64 ns)
+{
+    _latencies[getBucket(ns)].fetchAndAddRelaxed(1);
+    if (ns > _maxLatency.load())
+        _maxLatency.store(ns);
+}
+
+void ProfilerStats::endBlock(int voiceNumber)
+{
+    if (_resetRequested.loadAcquire() != 0)
+    {
+        clear();
+        _resetRequested.storeRelease(0);
+    }
+
+    // Stages not used during the block are not counted
+    for (int i = 0; i < STAGE_NUMBER; i++)
+    {
+        qint64 time = _blockTimes[i];
+        if (time > 0)
+        {
+            _histograms[i][getBucket(time)].fetchAndAddRelaxed(1);
+            _totalTimes[i].fetchAndAddRelaxed(time);
+            if (time > _maxTimes[i].load())
+                _maxTimes[i].store(time);
+            _blockTimes[i] = 0;
+        }
+    }
+
+    _blockNumber.fetchAndAddRelaxed(1);
+    _voiceNumber.store(static_cast<quint32>(voiceNumber));
+    if (static_cast<quint32>(voiceNumber) > _peakVoiceNumber.load())
+        _peakVoiceNumber.store(static_cast<quint32>(voiceNumber));
+}
+
+void ProfilerStats::clear()
+{
+    for (int i = 0; i < STAGE_NUMBER; i++)
+    {
+        for (int j = 0; j < BUCKET_NUMBER; j++)
+            _histograms[i][j].store(0);
+        _totalTimes[i].store(0);
+        _maxTimes[i].store(0);
+    }
+    for (int j = 0; j < BUCKET_NUMBER; j++)
+        _latencies[j].store(0);
+    _maxLatency.store(0);
+    _blockNumber.store(0);
+    _peakVoiceNumber.store(_voiceNumber.load());
+}
+
+int ProfilerStats::getBucket(qint64 ns)
+{
+    quint64 us = static_cast<quint64>(qMax(ns, static_cast<qint64>(0))) / 1000;
+    int bucket = 0;
+    while (us > 0 && bucket < BUCKET_NUMBER - 1)
+    {
+        us >>= 1;
+        bucket++;
+    }
+    return bucket;
+}
+
+QString ProfilerStats::getStageName(Stage stage)
+{
+    switch (stage)
+    {
+    case STAGE_MODULATORS: return "modulators";
+    case STAGE_RESAMPLE:   return "resample";
+    case STAGE_FILTER:     return "filter";
+    case STAGE_ENVELOPES:  return "envelopes";
+    case STAGE_EFFECTS:    return "effects";
+    case STAGE_MIX:        return "mix";
+    case STAGE_TOTAL:      return "total";
+    default:               return "";
+    }
+}
+
+QJsonObject ProfilerStats::toJson()
+{
+    QJsonObject stages;
+    for (int i = 0; i < STAGE_NUMBER; i++)
+    {
+        QJsonArray histogram;
+        quint32 count = 0;
+        for (int j = 0; j < BUCKET_NUMBER; j++)
+        {
+            quint32 value = _histograms[i][j].load();
+            histogram.append(static_cast<double>(value));
+            count += value;
+        }
+        if (count == 0)
+            continue;
+
+        QJsonObject stage;
+        stage["blocks"] = static_cast<double>(count);
+        stage["total_ns"] = static_cast<double>(_totalTimes[i].load());
+        stage["mean_ns"] = static_cast<double>(_totalTimes[i].load()) / count;
+        stage["max_ns"] = static_cast<double>(_maxTimes[i].load());
+        stage["histogram_us"] = histogram;
+        stages[getStageName(static_cast<Stage>(i))] = stage;
+    }
+
+    QJsonArray latencies;
+    quint32 latencyCount = 0;
+    for (int j = 0; j < BUCKET_NUMBER; j++)
+    {
+        quint32 value = _latencies[j].load();
+        latencies.append(static_cast<double>(value));
+        latencyCount += value;
+    }
+    QJsonObject latency;
+    latency["notes"] = static_cast<double>(latencyCount);
+    latency["max_ns"] = static_cast<double>(_maxLatency.load());
+    latency["histogram_us"] = latencies;
+
+    QJsonObject result;
+    result["name"] = _name;
+    result["blocks"] = static_cast<double>(_blockNumber.load());
+    result["voices"] = static_cast<double>(_voiceNumber.load());
+    result["peak_voices"] = static_cast<double>(_peakVoiceNumber.load());
+    result["stages"] = stages;
+    result["note_latency"] = latency;
+    return result;
+}
+
+void Profiler::reportBufferLevel(quint32 level)
+{
+    quint32 minLevel = s_minBufferLevel.load();
+    while (level < minLevel && !s_minBufferLevel.testAndSetRelaxed(minLevel, level))
+        minLevel = s_minBufferLevel.load();
+}
+
+void Profiler::registerStats(ProfilerStats * stats)
+{
+    QMutexLocker locker(&s_mutexStats);
+    s_stats << stats;
+}
+
+void Profiler::unregisterStats(ProfilerStats * stats)
+{
+    QMutexLocker locker(&s_mutexStats);
+    s_stats.removeAll(stats);
+}
+
+void Profiler::reset()
+{
+    s_xrunNumber.store(0);
+    s_missedDeadlineNumber.store(0);
+    s_bufferUnderrunNumber.store(0);
+    s_minBufferLevel.store(0xFFFFFFFF);
+
+    QMutexLocker locker(&s_mutexStats);
+    foreach (ProfilerStats * stats, s_stats)
+        stats->reset();
+}
+
+QJsonObject Profiler::toJson()
+{
+    QJsonObject result;
+    result["enabled"] = isEnabled();
+    result["xruns"] = static_cast<double>(s_xrunNumber.load());
+    result["missed_deadlines"] = static_cast<double>(s_missedDeadlineNumber.load());
+    result["buffer_underruns"] = static_cast<double>(s_bufferUnderrunNumber.load());
+    quint32 minLevel = s_minBufferLevel.load();
+    result["min_buffer_level"] = (minLevel == 0xFFFFFFFF ? -1. : static_cast<double>(minLevel));
+    result["streaming_underruns"] = SampleStream::getUnderrunCount();
+    result["scratch_allocations"] = VoiceScratch::getAllocationCount();
+    result["midi_messages_dropped"] = MidiDispatcher::getDroppedCount();
+
+    QJsonArray threads;
+    s_mutexStats.lock();
+    foreach (ProfilerStats * stats, s_stats)
+        threads.append(stats->toJson());
+    s_mutexStats.unlock();
+    result["threads"] = threads;
+
+    return result;
+}
+
+bool Profiler::writeDump(QString fileName)
+{
+    QFile file(fileName);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate))
+        return false;
+    QByteArray data = QJsonDocument(toJson()).toJson();
+    bool ok = (file.write(data) == data.size());
+    file.close();
+    return ok;
+}
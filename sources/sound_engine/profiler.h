@@ -0,0 +1,146 @@
+/***************************************************************************
+**                                                                        **
+**  Polyphone, a soundfont editor                                         **
+**  Copyright (C) 2013-2019 Davy Triponney                                **
+**                                                                        **
+**  This program is free software: you can redistribute it and/or modify  **
+**  it under the terms of the GNU General Public License as published by  **
+**  the Free Software Foundation, either version 3 of the License, or     **
+**  (at your option) any later version.                                   **
+**                                                                        **
+**  This program is distributed in the hope that it will be useful,       **
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of        **
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the          **
+**  GNU General Public License for more details.                          **
+**                                                                        **
+**  You should have received a copy of the GNU General Public License     **
+**  along with this program. If not, see http://www.gnu.org/licenses/.    **
+**                                                                        **
+****************************************************************************
+**           Author: Davy Triponney                                       **
+**  Website/Contact: https://www.polyphone-soundfonts.com                 **
+**             Date: 01.01.2013                                           **
+***************************************************************************/
+
+
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <QAtomicInteger>
+#include <QJsonObject>
+#include <QMutex>
+#include <QList>
+#include "circularbuffer.h"
+
+// Measures of one sound engine or of the audio thread
+// Written by one thread at a time without lock, read by any thread
+class ProfilerStats
+{
+public:
+    enum Stage
+    {
+        STAGE_MODULATORS = 0,
+        STAGE_RESAMPLE = 1,
+        STAGE_FILTER = 2,
+        STAGE_ENVELOPES = 3,
+        STAGE_EFFECTS = 4,
+        STAGE_MIX = 5,
+        STAGE_TOTAL = 6, // Whole block
+        STAGE_NUMBER = 7
+    };
+
+    // Bucket 0 is below 1 µs, bucket i is [2^(i-1), 2^i[ µs, the last one also contains the longer durations
+    static const int BUCKET_NUMBER = 20;
+
+    ProfilerStats(QString name);
+    ~ProfilerStats();
+
+    // Writing thread
+    void addTime(Stage stage, qint64 ns) { _blockTimes[stage] += ns; }
+    void addLatency(qint64 ns);
+    void endBlock(int voiceNumber); // Histograms updated with the times added since the previous block
+
+    // Any thread
+    QString getName() { return _name; }
+    void reset() { _resetRequested.storeRelease(1); } // Applied by the writing thread at the end of the next block
+    QJsonObject toJson();
+
+    static QString getStageName(Stage stage);
+
+private:
+    static int getBucket(qint64 ns);
+    void clear();
+
+    QString _name;
+    qint64 _blockTimes[STAGE_NUMBER]; // Only accessed by the writing thread
+    QAtomicInteger<quint32> _histograms[STAGE_NUMBER][BUCKET_NUMBER];
+    QAtomicInteger<qint64> _totalTimes[STAGE_NUMBER], _maxTimes[STAGE_NUMBER];
+    QAtomicInteger<quint32> _latencies[BUCKET_NUMBER];
+    QAtomicInteger<qint64> _maxLatency;
+    QAtomicInteger<quint32> _blockNumber, _voiceNumber, _peakVoiceNumber;
+    QAtomicInt _resetRequested;
+};
+
+// Measure consecutive stages of a computation, nothing being done without stats
+class ProfilerTimer
+{
+public:
+    ProfilerTimer(ProfilerStats * stats) :
+        _stats(stats),
+        _time(stats != nullptr ? CircularBuffer::currentTime() : 0)
+    {}
+
+    // Time since the previous lap added to "stage"
+    void lap(ProfilerStats::Stage stage)
+    {
+        if (_stats != nullptr)
+        {
+            qint64 time = CircularBuffer::currentTime();
+            _stats->addTime(stage, time - _time);
+            _time = time;
+        }
+    }
+
+    // Next lap measured from now
+    void restart()
+    {
+        if (_stats != nullptr)
+            _time = CircularBuffer::currentTime();
+    }
+
+private:
+    ProfilerStats * _stats;
+    qint64 _time;
+};
+
+// Measures of the audio computation, to understand why the sound glitches on a given machine
+// The timings are only done when enabled, the counters are always updated
+class Profiler
+{
+public:
+    static void setEnabled(bool isEnabled) { s_isEnabled.storeRelease(isEnabled ? 1 : 0); }
+    static bool isEnabled() { return s_isEnabled.load() != 0; }
+
+    // Audio callbacks
+    static void addXrun() { s_xrunNumber.fetchAndAddRelaxed(1); } // Reported by the audio server
+    static void addMissedDeadline() { s_missedDeadlineNumber.fetchAndAddRelaxed(1); } // Callback longer than its period
+    static void addBufferUnderrun() { s_bufferUnderrunNumber.fetchAndAddRelaxed(1); } // Sound engine late
+    static void reportBufferLevel(quint32 level); // Values available in a sound engine buffer when read
+
+    // Stats of the sound engines and audio threads (created and deleted by the main thread)
+    static void registerStats(ProfilerStats * stats);
+    static void unregisterStats(ProfilerStats * stats);
+
+    // Main thread
+    static void reset();
+    static QJsonObject toJson();
+    static bool writeDump(QString fileName);
+
+private:
+    static QAtomicInt s_isEnabled;
+    static QAtomicInteger<quint32> s_xrunNumber, s_missedDeadlineNumber, s_bufferUnderrunNumber, s_minBufferLevel;
+    static QList<ProfilerStats *> s_stats;
+    static QMutex s_mutexStats;
+};
+
+#endif // PROFILER_H
@@ -0,0 +1,277 @@
+/***************************************************************************
+**                                                                        **
+**  Polyphone, a soundfont editor                                         **
+**  Copyright (C) 2013-2019 Davy Triponney                                **
+**                                                                        **
+**  This program is free software: you can redistribute it and/or modify  **
+**  it under the terms of the GNU General Public License as published by  **
+**  the Free Software Foundation, either version 3 of the License, or     **
+**  (at your option) any later version.                                   **
+**                                                                        **
+**  This program is distributed in the hope that it will be useful,       **
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of        **
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the          **
+**  GNU General Public License for more details.                          **
+**                                                                        **
+**  You should have received a copy of the GNU General Public License     **
+**  along with this program. If not, see http://www.gnu.org/licenses/.    **
+**                                                                        **
+****************************************************************************
+**           Author: Davy Triponney                                       **
+**  Website/Contact: https://www.polyphone-soundfonts.com                 **
+**             Date: 01.01.2013                                           **
+***************************************************************************/
+
+
+#include "recorder.h"
+#include <QDataStream>
+#include <QElapsedTimer>
+#include <QtEndian>
+#include "FLAC/stream_encoder.h"
+
+const quint32 Recorder::QUEUE_DURATION = 4;
+const quint32 Recorder::CHUNK_LENGTH = 4096;
+const int Recorder::FILE_BUFFER_SIZE = 1048576;
+const int Recorder::POLLING_PERIOD = 50;
+const int Recorder::PROGRESS_PERIOD = 250;
+
+Recorder::Recorder() : QThread(),
+    _queue(nullptr),
+    _isActive(0),
+    _isPaused(0),
+    _writerCount(0),
+    _lostFrames(0),
+    _format(FORMAT_WAV_FLOAT),
+    _sampleRate(0),
+    _flacEncoder(nullptr),
+    _flacBuffer(nullptr),
+    _dataLength(0),
+    _interrupted(0)
+{
+}
+
+Recorder::~Recorder()
+{
+    this->close();
+}
+
+bool Recorder::open(QString fileName, Format format, quint32 sampleRate)
+{
+    this->close();
+
+    _format = format;
+    _sampleRate = sampleRate;
+    _dataLength = 0;
+    _lostFrames.storeRelease(0);
+    _isPaused.storeRelease(0);
+    _interrupted.storeRelease(0);
+
+    if (format == FORMAT_FLAC_24)
+    {
+        // The encoder writes the file by itself
+        _flacEncoder = FLAC__stream_encoder_new();
+        if (_flacEncoder == nullptr)
+            return false;
+        FLAC__stream_encoder_set_verify(_flacEncoder, false);
+        FLAC__stream_encoder_set_compression_level(_flacEncoder, 5);
+        FLAC__stream_encoder_set_channels(_flacEncoder, 2);
+        FLAC__stream_encoder_set_bits_per_sample(_flacEncoder, 24);
+        FLAC__stream_encoder_set_sample_rate(_flacEncoder, sampleRate);
+        if (FLAC__stream_encoder_init_file(_flacEncoder, fileName.toLocal8Bit().constData(), nullptr, nullptr) !=
+                FLAC__STREAM_ENCODER_INIT_STATUS_OK)
+        {
+            FLAC__stream_encoder_delete(_flacEncoder);
+            _flacEncoder = nullptr;
+            return false;
+        }
+        _flacBuffer = new qint32[2 * CHUNK_LENGTH];
+    }
+    else
+    {
+        _file.setFileName(fileName);
+        if (!_file.open(QIODevice::WriteOnly))
+            return false;
+        if (!writeWavHeader())
+        {
+            _file.close();
+            return false;
+        }
+        _fileBuffer.reserve(FILE_BUFFER_SIZE + static_cast<int>(8 * CHUNK_LENGTH)); // Kept when flushed
+    }
+
+    // Start the recorder thread, then accept data from the audio thread
+    _queue = new LockFreeQueue<float>(2 * QUEUE_DURATION * sampleRate);
+    this->start();
+    _isActive.storeRelease(1);
+    return true;
+}
+
+void Recorder::close()
+{
+    if (_isActive.fetchAndStoreOrdered(0) == 0)
+        return;
+
+    // Wait for a possible writing of the audio thread
+    while (_writerCount.loadAcquire() != 0)
+        QThread::yieldCurrentThread();
+
+    // The recorder thread writes the remaining data before stopping
+    _interrupted.storeRelease(1);
+    _semaphore.release();
+    this->wait();
+    delete _queue;
+    _queue = nullptr;
+
+    if (_format == FORMAT_FLAC_24)
+    {
+        FLAC__stream_encoder_finish(_flacEncoder);
+        FLAC__stream_encoder_delete(_flacEncoder);
+        _flacEncoder = nullptr;
+        delete [] _flacBuffer;
+        _flacBuffer = nullptr;
+    }
+    else
+    {
+        // Adjust file dimensions
+        uchar value[4];
+        qToLittleEndian<quint32>(_dataLength + 18 + 4 + 8 + 8, value);
+        _file.seek(4);
+        _file.write(reinterpret_cast<char *>(value), 4);
+        qToLittleEndian<quint32>(_dataLength, value);
+        _file.seek(42);
+        _file.write(reinterpret_cast<char *>(value), 4);
+        _file.close();
+    }
+}
+
+void Recorder::write(const float *data, quint32 frameNumber)
+{
+    _writerCount.ref();
+    if (_isActive.loadAcquire() != 0 && _isPaused.loadAcquire() == 0)
+    {
+        if (!_queue->pushBlock(data, 2 * frameNumber))
+            _lostFrames.fetchAndAddRelaxed(frameNumber);
+    }
+    _writerCount.deref();
+}
+
+void Recorder::run()
+{
+    float * data = new float[2 * CHUNK_LENGTH];
+    quint32 framesWritten = 0; // Since the last progress
+    quint32 lostFrames = 0; // Already reported
+    QElapsedTimer timer;
+    timer.start();
+
+    bool interrupted = false;
+    while (!interrupted)
+    {
+        // Read before emptying the queue so that the last data is written
+        interrupted = (_interrupted.loadAcquire() != 0);
+
+        quint32 count;
+        while ((count = _queue->popBlock(data, 2 * CHUNK_LENGTH)) > 0)
+        {
+            encode(data, count / 2);
+            framesWritten += count / 2;
+        }
+
+        // Progress and lost data
+        if (interrupted || timer.elapsed() >= PROGRESS_PERIOD)
+        {
+            if (framesWritten > 0)
+                emit dataWritten(_sampleRate, framesWritten);
+            framesWritten = 0;
+
+            quint32 lost = _lostFrames.loadAcquire();
+            if (lost != lostFrames)
+            {
+                lostFrames = lost;
+                emit overflowed(lost);
+            }
+            timer.restart();
+        }
+
+        if (!interrupted)
+            _semaphore.tryAcquire(1, POLLING_PERIOD);
+    }
+
+    flush();
+    delete [] data;
+}
+
+bool Recorder::writeWavHeader()
+{
+    quint16 bytesPerValue = (_format == FORMAT_WAV_FLOAT ? 4 : 3);
+
+    QByteArray header;
+    QDataStream stream(&header, QIODevice::WriteOnly);
+    stream.setByteOrder(QDataStream::LittleEndian);
+    stream.writeRawData("RIFF", 4);
+    stream << static_cast<quint32>(18 + 4 + 8 + 8);
+    stream.writeRawData("WAVE", 4);
+    ///////////// BLOC FMT /////////////
+    stream.writeRawData("fmt ", 4);
+    stream << static_cast<quint32>(18);
+    // Compression code (float or PCM)
+    stream << static_cast<quint16>(_format == FORMAT_WAV_FLOAT ? 3 : 1);
+    // Number of channels
+    stream << static_cast<quint16>(2);
+    // Sample rate
+    stream << _sampleRate;
+    // Average byte per second
+    stream << static_cast<quint32>(_sampleRate * 2 * bytesPerValue);
+    // Block align
+    stream << static_cast<quint16>(2 * bytesPerValue);
+    // Significants bits per smpl
+    stream << static_cast<quint16>(8 * bytesPerValue);
+    // Extra format bytes
+    stream << static_cast<quint16>(0);
+    ///////////// BLOC DATA /////////////
+    stream.writeRawData("data", 4);
+    stream << static_cast<quint32>(0);
+
+    return _file.write(header) == header.size();
+}
+
+void Recorder::encode(const float *data, quint32 frameNumber)
+{
+    switch (_format)
+    {
+    case FORMAT_WAV_FLOAT:
+        _fileBuffer.append(reinterpret_cast<const char *>(data), static_cast<int>(8 * frameNumber));
+        _dataLength += 8 * frameNumber;
+        break;
+    case FORMAT_WAV_24: {
+        int pos = _fileBuffer.size();
+        _fileBuffer.resize(pos + static_cast<int>(6 * frameNumber));
+        char * dest = &_fileBuffer.data()[pos];
+        for (quint32 i = 0; i < 2 * frameNumber; i++)
+        {
+            qint32 value = qRound(qBound(-1.0f, data[i], 1.0f) * 8388607.0f);
+            dest[3 * i] = static_cast<char>(value & 0xFF);
+            dest[3 * i + 1] = static_cast<char>((value >> 8) & 0xFF);
+            dest[3 * i + 2] = static_cast<char>((value >> 16) & 0xFF);
+        }
+        _dataLength += 6 * frameNumber;
+    } break;
+    case FORMAT_FLAC_24:
+        for (quint32 i = 0; i < 2 * frameNumber; i++)
+            _flacBuffer[i] = qRound(qBound(-1.0f, data[i], 1.0f) * 8388607.0f);
+        FLAC__stream_encoder_process_interleaved(_flacEncoder, _flacBuffer, frameNumber);
+        break;
+    }
+
+    // Large writings
+    if (_fileBuffer.size() >= FILE_BUFFER_SIZE)
+        flush();
+}
+
+void Recorder::flush()
+{
+    if (!_fileBuffer.isEmpty())
+    {
+        _file.write(_fileBuffer);
+        _fileBuffer.resize(0);
+    }
+}
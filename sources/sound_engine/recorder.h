@@ -0,0 +1,101 @@
+/***************************************************************************
+**                                                                        **
+**  Polyphone, a soundfont editor                                         **
+**  Copyright (C) 2013-2019 Davy Triponney                                **
+**                                                                        **
+**  This program is free software: you can redistribute it and/or modify  **
+**  it under the terms of the GNU General Public License as published by  **
+**  the Free Software Foundation, either version 3 of the License, or     **
+**  (at your option) any later version.                                   **
+**                                                                        **
+**  This program is distributed in the hope that it will be useful,       **
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of        **
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the          **
+**  GNU General Public License for more details.                          **
+**                                                                        **
+**  You should have received a copy of the GNU General Public License     **
+**  along with this program. If not, see http://www.gnu.org/licenses/.    **
+**                                                                        **
+****************************************************************************
+**           Author: Davy Triponney                                       **
+**  Website/Contact: https://www.polyphone-soundfonts.com                 **
+**             Date: 01.01.2013                                           **
+***************************************************************************/
+
+
+#ifndef RECORDER_H
+#define RECORDER_H
+
+#include <QThread>
+#include <QSemaphore>
+#include <QFile>
+#include "lockfreequeue.h"
+struct FLAC__StreamEncoder;
+
+// Record the audio output in a file
+// The audio thread only copies the data in a queue, the encoding and the writing being done by the recorder thread
+class Recorder : public QThread
+{
+    Q_OBJECT
+
+public:
+    enum Format
+    {
+        FORMAT_WAV_FLOAT = 0,
+        FORMAT_WAV_24 = 1,
+        FORMAT_FLAC_24 = 2
+    };
+
+    Recorder();
+    ~Recorder() override;
+
+    // Main thread: begin or finish a record, return false if the file couldn't be created
+    bool open(QString fileName, Format format, quint32 sampleRate);
+    void close();
+    void pause(bool isOn) { _isPaused.storeRelease(isOn ? 1 : 0); }
+    bool isRecording() { return _isActive.loadAcquire() != 0 && _isPaused.loadAcquire() == 0; }
+
+    // Audio thread: add interleaved stereo data, without waiting
+    // Data is lost if the recorder thread is late (see overflowed)
+    void write(const float *data, quint32 frameNumber);
+
+signals:
+    // Periodically emitted by the recorder thread
+    void dataWritten(quint32 sampleRate, quint32 number);
+
+    // Emitted when data has been lost, with the total number of frames lost since the beginning of the record
+    void overflowed(quint32 number);
+
+protected:
+    void run() override;
+
+private:
+    bool writeWavHeader();
+    void encode(const float *data, quint32 frameNumber);
+    void flush();
+
+    // Shared with the audio thread
+    LockFreeQueue<float> * _queue;
+    QAtomicInt _isActive, _isPaused, _writerCount;
+    QAtomicInteger<quint32> _lostFrames;
+
+    // Only accessed by the recorder thread once the record started
+    Format _format;
+    quint32 _sampleRate;
+    QFile _file;
+    QByteArray _fileBuffer;
+    FLAC__StreamEncoder * _flacEncoder;
+    qint32 * _flacBuffer;
+    quint32 _dataLength; // In bytes, for the wav header
+
+    QSemaphore _semaphore;
+    QAtomicInt _interrupted;
+
+    static const quint32 QUEUE_DURATION; // In seconds
+    static const quint32 CHUNK_LENGTH; // In frames
+    static const int FILE_BUFFER_SIZE; // In bytes
+    static const int POLLING_PERIOD; // In ms
+    static const int PROGRESS_PERIOD; // In ms
+};
+
+#endif // RECORDER_H
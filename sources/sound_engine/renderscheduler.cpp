@@ -0,0 +1,125 @@
+/***************************************************************************
+**                                                                        **
+**  Polyphone, a soundfont editor                                         **
+**  Copyright (C) 2013-2019 Davy Triponney                                **
+**                                                                        **
+**  This program is free software: you can redistribute it and/or modify  **
+**  it under the terms of the GNU General Public License as published by  **
+**  the Free Software Foundation, either version 3 of the License, or     **
+**  (at your option) any later version.                                   **
+**                                                                        **
+**  This program is distributed in the hope that it will be useful,       **
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of        **
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the          **
+**  GNU General Public License for more details.                          **
+**                                                                        **
+**  You should have received a copy of the GNU General Public License     **
+**  along with this program. If not, see http://www.gnu.org/licenses/.    **
+**                                                                        **
+****************************************************************************
+**           Author: Davy Triponney                                       **
+**  Website/Contact: https://www.polyphone-soundfonts.com                 **
+**             Date: 01.01.2013                                           **
+***************************************************************************/
+
+
+#include "renderscheduler.h"
+#include "soundengine.h"
+#include "dspkernels.h"
+#include <QThread>
+
+// Thread computing a sound engine each time it is triggered
+class RenderWorker : public QThread
+{
+public:
+    RenderWorker(SoundEngine * soundEngine, QSemaphore * semaphoreDone) : QThread(),
+        _soundEngine(soundEngine),
+        _semaphoreDone(semaphoreDone),
+        _length(0),
+        _interrupted(0)
+    {}
+
+    void trigger(quint32 len)
+    {
+        _length = len;
+        _semaphoreStart.release();
+    }
+
+    void interrupt()
+    {
+        _interrupted.store(1);
+        _semaphoreStart.release();
+    }
+
+protected:
+    void run() override
+    {
+        DspKernels::disableDenormals();
+        while (true)
+        {
+            _semaphoreStart.acquire();
+            if (_interrupted.load() != 0)
+                break;
+            _soundEngine->computeDirect(_length);
+            _semaphoreDone->release();
+        }
+    }
+
+private:
+    SoundEngine * _soundEngine;
+    QSemaphore * _semaphoreDone;
+    QSemaphore _semaphoreStart;
+    quint32 _length; // Written before the semaphore is released
+    QAtomicInt _interrupted;
+};
+
+RenderScheduler::RenderScheduler(QList<SoundEngine *> soundEngines, quint32 maxLength) :
+    _soundEngines(soundEngines),
+    _maxLength(maxLength)
+{
+    // One worker per sound engine, except the first one
+    for (int i = 1; i < _soundEngines.size(); i++)
+    {
+        RenderWorker * worker = new RenderWorker(_soundEngines[i], &_semaphoreDone);
+        worker->start(QThread::TimeCriticalPriority);
+        _workers << worker;
+    }
+}
+
+RenderScheduler::~RenderScheduler()
+{
+    foreach (RenderWorker * worker, _workers)
+        worker->interrupt();
+    while (!_workers.isEmpty())
+    {
+        RenderWorker * worker = _workers.takeLast();
+        worker->wait();
+        delete worker;
+    }
+}
+
+void RenderScheduler::render(float *dataL, float *dataR, float *dataRevL, float *dataRevR, quint32 len)
+{
+    if (_soundEngines.isEmpty())
+        return;
+
+    quint32 total = 0;
+    while (total < len)
+    {
+        quint32 chunk = qMin(len - total, _maxLength);
+
+        // Start the workers and compute the first sound engine meanwhile
+        foreach (RenderWorker * worker, _workers)
+            worker->trigger(chunk);
+        _soundEngines[0]->computeDirect(chunk);
+
+        // Wait for all workers
+        _semaphoreDone.acquire(_workers.size());
+
+        // Sum the data of all sound engines
+        foreach (SoundEngine * soundEngine, _soundEngines)
+            soundEngine->addDirectData(&dataL[total], &dataR[total], &dataRevL[total], &dataRevR[total], chunk);
+
+        total += chunk;
+    }
+}
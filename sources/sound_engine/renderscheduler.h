@@ -0,0 +1,52 @@
+/***************************************************************************
+**                                                                        **
+**  Polyphone, a soundfont editor                                         **
+**  Copyright (C) 2013-2019 Davy Triponney                                **
+**                                                                        **
+**  This program is free software: you can redistribute it and/or modify  **
+**  it under the terms of the GNU General Public License as published by  **
+**  the Free Software Foundation, either version 3 of the License, or     **
+**  (at your option) any later version.                                   **
+**                                                                        **
+**  This program is distributed in the hope that it will be useful,       **
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of        **
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the          **
+**  GNU General Public License for more details.                          **
+**                                                                        **
+**  You should have received a copy of the GNU General Public License     **
+**  along with this program. If not, see http://www.gnu.org/licenses/.    **
+**                                                                        **
+****************************************************************************
+**           Author: Davy Triponney                                       **
+**  Website/Contact: https://www.polyphone-soundfonts.com                 **
+**             Date: 01.01.2013                                           **
+***************************************************************************/
+
+
+#ifndef RENDERSCHEDULER_H
+#define RENDERSCHEDULER_H
+
+#include <QList>
+#include <QSemaphore>
+class SoundEngine;
+class RenderWorker;
+
+// Direct rendering: the sound engines are computed when the audio server asks for data, without look-ahead
+// The first sound engine is computed by the audio thread, the others by a fixed pool of workers
+class RenderScheduler
+{
+public:
+    RenderScheduler(QList<SoundEngine *> soundEngines, quint32 maxLength);
+    ~RenderScheduler();
+
+    // Audio thread: compute all sound engines and add the result to the buffers
+    void render(float *dataL, float *dataR, float *dataRevL, float *dataRevR, quint32 len);
+
+private:
+    QList<SoundEngine *> _soundEngines;
+    QList<RenderWorker *> _workers;
+    QSemaphore _semaphoreDone; // Released by each worker once its sound engine is computed
+    quint32 _maxLength; // Maximum length computed at once by a sound engine
+};
+
+#endif // RENDERSCHEDULER_H
@@ -0,0 +1,373 @@
+/***************************************************************************
+**                                                                        **
+**  Polyphone, a soundfont editor                                         **
+**  Copyright (C) 2013-2019 Davy Triponney                                **
+**                                                                        **
+**  This program is free software: you can redistribute it and/or modify  **
+**  it under the terms of the GNU General Public License as published by  **
+**  the Free Software Foundation, either version 3 of the License, or     **
+**  (at your option) any later version.                                   **
+**                                                                        **
+**  This program is distributed in the hope that it will be useful,       **
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of        **
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the          **
+**  GNU General Public License for more details.                          **
+**                                                                        **
+**  You should have received a copy of the GNU General Public License     **
+**  along with this program. If not, see http://www.gnu.org/licenses/.    **
+**                                                                        **
+****************************************************************************
+**           Author: Davy Triponney                                       **
+**  Website/Contact: https://www.polyphone-soundfonts.com                 **
+**             Date: 01.01.2013                                           **
+***************************************************************************/
+
+
+#include "samplestreamer.h"
+#include "streamedsample.h"
+#include <QFile>
+
+QAtomicInt SampleStream::s_underrunCount(0);
+const quint32 SampleStream::MIN_CAPACITY = 16384;
+const quint32 SampleStream::NO_EXIT = 0xFFFFFFFF;
+const quint32 SampleStreamer::CHUNK_LENGTH = 8192;
+const int SampleStreamer::POLLING_PERIOD = 2;
+
+SampleStream::SampleStream(QSharedPointer<StreamedSample> sample, quint32 startPosition,
+                           quint32 loopStart, quint32 loopEnd, bool isLooping) :
+    _sample(sample),
+    _readIndex(0),
+    _writeIndex(0),
+    _seekIndex(0),
+    _exitRequest(NO_EXIT),
+    _exitApplied(NO_EXIT),
+    _isClosed(0),
+    _exitIndex(NO_EXIT),
+    _nextIndex(0),
+    _loopStart(loopStart),
+    _loopEnd(loopEnd),
+    _isLooping(isLooping),
+    _needsJump(false),
+    _fillExitIndex(NO_EXIT),
+    _isFinished(false)
+{
+    // Twice the resident beginning: the voice can start on it while the first values are read
+    _capacity = 1;
+    while (_capacity < MIN_CAPACITY || _capacity < 2 * sample->getHeadLength())
+        _capacity <<= 1;
+    _mask = _capacity - 1;
+    _buffer = new qint32[_capacity];
+
+    // First segment, known by both threads
+    _segment.index = 0;
+    _segment.position = startPosition;
+    _segment.loopStart = loopStart;
+    _segment.loopEnd = loopEnd;
+    _segment.isLooping = isLooping && loopStart < loopEnd && startPosition < loopEnd;
+    _requestedSegment = _fillSegment = _segment;
+}
+
+SampleStream::~SampleStream()
+{
+    delete [] _buffer;
+}
+
+QString SampleStream::getFileName()
+{
+    return _sample->getFileName();
+}
+
+quint32 SampleStream::positionOf(const Segment &segment, quint32 exitIndex, quint32 index)
+{
+    if (!segment.isLooping)
+        return segment.position + (index - segment.index);
+
+    // After the exit of the loop, the positions go on from the loop end
+    if (index >= exitIndex)
+        return segment.loopEnd + (index - exitIndex);
+
+    // Wrap at the end of the loop (the segment starts before it)
+    quint64 position = static_cast<quint64>(segment.position) + (index - segment.index);
+    if (position >= segment.loopEnd)
+        position = segment.loopStart + (position - segment.loopEnd) % (segment.loopEnd - segment.loopStart);
+    return static_cast<quint32>(position);
+}
+
+quint32 SampleStream::getRunLength(const Segment &segment, quint32 exitIndex, quint32 index, quint32 position)
+{
+    // Consecutive positions until the end of the loop or its exit
+    if (segment.isLooping && index < exitIndex)
+        return qMin(segment.loopEnd - position, exitIndex - index);
+
+    // Or until the end of the sample
+    return position < _sample->getLength() ? _sample->getLength() - position : 0;
+}
+
+void SampleStream::setLoop(quint32 loopStart, quint32 loopEnd, bool isLooping)
+{
+    if (loopStart == _loopStart && loopEnd == _loopEnd && isLooping == _isLooping)
+        return;
+
+    // Release: the loop ends at its next wrap, the values read until there are kept
+    bool isExit = (loopStart == _loopStart && loopEnd == _loopEnd && _isLooping && !isLooping);
+    _loopStart = loopStart;
+    _loopEnd = loopEnd;
+    _isLooping = isLooping;
+    if (isExit && !_needsJump)
+    {
+        if (_segment.isLooping && _exitIndex == NO_EXIT)
+        {
+            _exitIndex = _nextIndex + (_segment.loopEnd - positionOf(_segment, NO_EXIT, _nextIndex));
+            _exitRequest.storeRelease(_exitIndex);
+        }
+        return;
+    }
+
+    // Other change: a new segment will start at the next read
+    _needsJump = true;
+}
+
+bool SampleStream::read(quint32 position, quint32 length, qint32 *data)
+{
+    // The values that will be read by the voice have possibly not been prepared
+    if ((_needsJump || position != positionOf(_segment, _exitIndex, _nextIndex)) && !requestJump(position))
+    {
+        // The previous jump is not done yet
+        memset(data, 0, length * sizeof(qint32));
+        s_underrunCount.fetchAndAddRelaxed(1);
+        return false;
+    }
+
+    bool ok = true;
+    while (length > 0)
+    {
+        const qint32 * resident;
+        quint32 count = _sample->getResident(position, resident);
+        if (count > 0)
+        {
+            // Values in memory
+            count = qMin(count, length);
+            memcpy(data, resident, count * sizeof(qint32));
+        }
+        else if (position >= _sample->getLength())
+        {
+            // After the end
+            memset(data, 0, length * sizeof(qint32));
+            _nextIndex += length;
+            break;
+        }
+        else
+        {
+            // Values read from the disk
+            count = qMin(length, _sample->getLength() - position);
+            if (!readBuffer(_nextIndex, count, data))
+            {
+                memset(data, 0, count * sizeof(qint32));
+                ok = false;
+            }
+        }
+
+        position += count;
+        data += count;
+        length -= count;
+        _nextIndex += count;
+    }
+
+    // The values before are not needed anymore
+    _readIndex.storeRelease(_nextIndex);
+
+    if (!ok)
+        s_underrunCount.fetchAndAddRelaxed(1);
+    return ok;
+}
+
+bool SampleStream::requestJump(quint32 position)
+{
+    // Only one jump at a time
+    if (_seekIndex.loadAcquire() != 0)
+    {
+        _needsJump = true;
+        return false;
+    }
+
+    // New indexes, far enough from the values previously published
+    _nextIndex += 2 * _capacity;
+    if (_nextIndex == NO_EXIT)
+        _nextIndex = 0;
+    _segment.index = _nextIndex;
+    _segment.position = position;
+    _segment.loopStart = _loopStart;
+    _segment.loopEnd = _loopEnd;
+    _segment.isLooping = _isLooping && _loopStart < _loopEnd && position < _loopEnd;
+    _exitIndex = NO_EXIT;
+    _needsJump = false;
+
+    // Published for the streaming thread
+    _requestedSegment = _segment;
+    _exitRequest.storeRelease(NO_EXIT);
+    _readIndex.storeRelease(_nextIndex);
+    _seekIndex.storeRelease(_nextIndex + 1);
+    return true;
+}
+
+bool SampleStream::readBuffer(quint32 index, quint32 length, qint32 *data)
+{
+    // Nothing is available while a jump is being done
+    if (_seekIndex.loadAcquire() != 0)
+        return false;
+
+    // Values after the exit of the loop, only valid once the streaming thread knows about it
+    if (index + length > _exitIndex && _exitApplied.loadAcquire() != _exitIndex)
+        return false;
+
+    // The streaming thread is late
+    if (index + length > _writeIndex.loadAcquire())
+        return false;
+
+    // Copy, the circular buffer being possibly read in two parts
+    quint32 start = index & _mask;
+    quint32 length1 = qMin(length, _capacity - start);
+    memcpy(data, &_buffer[start], length1 * sizeof(qint32));
+    memcpy(&data[length1], _buffer, (length - length1) * sizeof(qint32));
+    return true;
+}
+
+quint32 SampleStream::fill(QFile &file, quint32 maxLength)
+{
+    // Possible jump requested by the voice
+    quint32 seekIndex = _seekIndex.loadAcquire();
+    if (seekIndex != 0)
+    {
+        _fillSegment = _requestedSegment;
+        _fillExitIndex = NO_EXIT;
+        _writeIndex.storeRelease(seekIndex - 1);
+        _isFinished = false;
+        _seekIndex.storeRelease(0);
+    }
+
+    // Possible exit of the loop: the values read after it are dropped
+    quint32 exitIndex = _exitRequest.loadAcquire();
+    if (exitIndex != _fillExitIndex)
+    {
+        _fillExitIndex = exitIndex;
+        if (_writeIndex.loadAcquire() > exitIndex)
+            _writeIndex.storeRelease(exitIndex);
+        _isFinished = false;
+        _exitApplied.storeRelease(exitIndex);
+    }
+    if (_isFinished)
+        return 0;
+
+    // Free space, the voice being possibly ahead (values read in memory or missed)
+    quint32 writeIndex = _writeIndex.loadAcquire();
+    qint32 used = static_cast<qint32>(writeIndex - _readIndex.loadAcquire());
+    if (used < 0)
+    {
+        writeIndex -= static_cast<quint32>(used);
+        used = 0;
+    }
+    if (static_cast<quint32>(used) >= _capacity)
+        return 0;
+    quint32 length = qMin(_capacity - static_cast<quint32>(used), maxLength);
+
+    // Read in the circular buffer, by runs of consecutive positions
+    quint32 total = 0;
+    while (total < length)
+    {
+        quint32 index = writeIndex + total;
+        quint32 position = positionOf(_fillSegment, _fillExitIndex, index);
+        quint32 count = qMin(qMin(length - total, _capacity - (index & _mask)),
+                             getRunLength(_fillSegment, _fillExitIndex, index, position));
+        if (count == 0 || !_sample->read(file, position, count, &_buffer[index & _mask]))
+        {
+            // End of the sample, or the voice will get 0
+            _isFinished = true;
+            break;
+        }
+        total += count;
+    }
+
+    // Data published, unless a jump has been requested meanwhile
+    if (total > 0 && _seekIndex.loadAcquire() == 0)
+        _writeIndex.storeRelease(writeIndex + total);
+    return total;
+}
+
+SampleStreamer::SampleStreamer() : QThread(),
+    _interrupted(0)
+{
+    this->start(QThread::HighPriority);
+}
+
+SampleStreamer::~SampleStreamer()
+{
+    _interrupted.store(1);
+    _semaphore.release();
+    this->wait();
+    qDeleteAll(_files);
+}
+
+QSharedPointer<SampleStream> SampleStreamer::createStream(QSharedPointer<StreamedSample> sample, quint32 startPosition,
+                                                          quint32 loopStart, quint32 loopEnd, bool isLooping)
+{
+    QSharedPointer<SampleStream> stream(new SampleStream(sample, startPosition, loopStart, loopEnd, isLooping));
+    _mutexNewStreams.lock();
+    _newStreams << stream;
+    _mutexNewStreams.unlock();
+    _semaphore.release();
+    return stream;
+}
+
+void SampleStreamer::run()
+{
+    while (_interrupted.load() == 0)
+    {
+        // Take the new streams
+        _mutexNewStreams.lock();
+        _streams << _newStreams;
+        _newStreams.clear();
+        _mutexNewStreams.unlock();
+
+        // Streams of the voices that ended are deleted here, not in the audio threads
+        for (int i = _streams.size() - 1; i >= 0; i--)
+            if (_streams.at(i)->isClosed())
+                _streams.removeAt(i);
+
+        if (_streams.isEmpty())
+        {
+            // Nothing to read: close the files and wait for a new stream
+            qDeleteAll(_files);
+            _files.clear();
+            _semaphore.acquire();
+            continue;
+        }
+
+        // One chunk per stream at a time, so that all voices progress together
+        quint32 total = 0;
+        foreach (QSharedPointer<SampleStream> stream, _streams)
+        {
+            QFile * file = getFile(stream->getFileName());
+            if (file != nullptr)
+                total += stream->fill(*file, CHUNK_LENGTH);
+        }
+
+        // Everything is full: wait for the voices to read
+        if (total == 0)
+            _semaphore.tryAcquire(1, POLLING_PERIOD);
+    }
+}
+
+QFile * SampleStreamer::getFile(QString fileName)
+{
+    if (!_files.contains(fileName))
+    {
+        QFile * file = new QFile(fileName);
+        if (!file->open(QFile::ReadOnly | QFile::Unbuffered))
+        {
+            delete file;
+            file = nullptr;
+        }
+        _files[fileName] = file;
+    }
+    return _files[fileName];
+}
@@ -0,0 +1,138 @@
+/***************************************************************************
+**                                                                        **
+**  Polyphone, a soundfont editor                                         **
+**  Copyright (C) 2013-2019 Davy Triponney                                **
+**                                                                        **
+**  This program is free software: you can redistribute it and/or modify  **
+**  it under the terms of the GNU General Public License as published by  **
+**  the Free Software Foundation, either version 3 of the License, or     **
+**  (at your option) any later version.                                   **
+**                                                                        **
+**  This program is distributed in the hope that it will be useful,       **
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of        **
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the          **
+**  GNU General Public License for more details.                          **
+**                                                                        **
+**  You should have received a copy of the GNU General Public License     **
+**  along with this program. If not, see http://www.gnu.org/licenses/.    **
+**                                                                        **
+****************************************************************************
+**           Author: Davy Triponney                                       **
+**  Website/Contact: https://www.polyphone-soundfonts.com                 **
+**             Date: 01.01.2013                                           **
+***************************************************************************/
+
+
+#ifndef SAMPLESTREAMER_H
+#define SAMPLESTREAMER_H
+
+#include <QThread>
+#include <QSemaphore>
+#include <QMutex>
+#include <QSharedPointer>
+#include <QHash>
+class StreamedSample;
+class QFile;
+
+// Window on the values of a sample played by one voice, filled by the streaming thread ahead of the voice
+// (one producer, one consumer). The values are indexed in the order the voice plays them: the stream follows
+// the loop of the voice, so that the values after each wrap are already there
+class SampleStream
+{
+public:
+    SampleStream(QSharedPointer<StreamedSample> sample, quint32 startPosition,
+                 quint32 loopStart, quint32 loopEnd, bool isLooping);
+    ~SampleStream();
+
+    // Voice thread: loop currently played, before reading
+    // Leaving the loop (release) keeps the values read until the loop end, another change is a jump
+    void setLoop(quint32 loopStart, quint32 loopEnd, bool isLooping);
+
+    // Voice thread: copy "length" values from "position", return false in case of underrun (missing values are 0)
+    // The positions are consecutive except when wrapping at the end of the loop, otherwise this is a jump
+    bool read(quint32 position, quint32 length, qint32 *data);
+
+    // Voice thread: the stream is not used anymore
+    // The voice must have released its reference before, so that the stream is deleted by the streaming thread
+    void close() { _isClosed.storeRelease(1); }
+    bool isClosed() { return _isClosed.loadAcquire() != 0; }
+
+    // Streaming thread: read the next values from the file, return the number of values read
+    quint32 fill(QFile &file, quint32 maxLength);
+    QString getFileName();
+
+    // Number of underruns since the beginning, all voices included
+    static int getUnderrunCount() { return s_underrunCount.load(); }
+
+private:
+    // Positions played from the value "index", possibly looping until the value "exitIndex"
+    struct Segment
+    {
+        quint32 index;
+        quint32 position;
+        quint32 loopStart;
+        quint32 loopEnd;
+        bool isLooping;
+    };
+    static quint32 positionOf(const Segment &segment, quint32 exitIndex, quint32 index);
+    quint32 getRunLength(const Segment &segment, quint32 exitIndex, quint32 index, quint32 position);
+
+    bool requestJump(quint32 position);
+    bool readBuffer(quint32 index, quint32 length, qint32 *data);
+
+    QSharedPointer<StreamedSample> _sample;
+    qint32 * _buffer;
+    quint32 _capacity, _mask;
+    QAtomicInteger<quint32> _readIndex, _writeIndex; // Values available: [_readIndex, _writeIndex[
+    QAtomicInteger<quint32> _seekIndex; // Index + 1 of the segment _requestedSegment, 0 if no jump is requested
+    QAtomicInteger<quint32> _exitRequest, _exitApplied; // End of the loop requested by the voice / taken into account
+    QAtomicInt _isClosed;
+    Segment _requestedSegment; // Written by the voice only when no jump is requested
+
+    // Only accessed by the voice thread
+    Segment _segment;
+    quint32 _exitIndex, _nextIndex;
+    quint32 _loopStart, _loopEnd;
+    bool _isLooping, _needsJump;
+
+    // Only accessed by the streaming thread
+    Segment _fillSegment;
+    quint32 _fillExitIndex;
+    bool _isFinished;
+
+    static QAtomicInt s_underrunCount;
+    static const quint32 MIN_CAPACITY;
+    static const quint32 NO_EXIT;
+};
+
+// Thread reading the streamed samples from the disk, ahead of the voices
+class SampleStreamer : public QThread
+{
+public:
+    SampleStreamer();
+    ~SampleStreamer() override;
+
+    // Create the stream of a new voice, starting at "startPosition" and possibly looping
+    QSharedPointer<SampleStream> createStream(QSharedPointer<StreamedSample> sample, quint32 startPosition,
+                                              quint32 loopStart, quint32 loopEnd, bool isLooping);
+
+protected:
+    void run() override;
+
+private:
+    QFile * getFile(QString fileName);
+
+    QList<QSharedPointer<SampleStream> > _newStreams;
+    QMutex _mutexNewStreams;
+    QSemaphore _semaphore; // Released for each new stream and when the thread is interrupted
+    QAtomicInt _interrupted;
+
+    // Only accessed by the streaming thread
+    QList<QSharedPointer<SampleStream> > _streams;
+    QHash<QString, QFile *> _files;
+
+    static const quint32 CHUNK_LENGTH;
+    static const int POLLING_PERIOD; // In ms
+};
+
+#endif // SAMPLESTREAMER_H
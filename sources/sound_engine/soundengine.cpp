@@ -23,19 +23,35 @@
 **             Date: 01.01.2013                                           **
 ***************************************************************************/
 
+
 #include "soundengine.h"
 #include <QThread>
 
 QList<SoundEngine*> SoundEngine::_listInstances = QList<SoundEngine*>();
+QMutex SoundEngine::_mutexCommands;
 int SoundEngine::_gainSmpl = 0;
+int SoundEngine::_chorusLevel = 0;
+int SoundEngine::_chorusDepth = 0;
+int SoundEngine::_chorusFrequency = 0;
 bool SoundEngine::_isStereo = false;
 bool SoundEngine::_isLoopEnabled = true;
-
-SoundEngine::SoundEngine(unsigned int bufferSize) : CircularBuffer(bufferSize, 2 * bufferSize)
+quint32 SoundEngine::_sampleRate = 44100;
+
+SoundEngine::SoundEngine(ControllerValues * controllerValues, unsigned int bufferSize) : CircularBuffer(bufferSize, 2 * bufferSize),
+    _scratch(2 * bufferSize), // Data is generated by chunks of 1.5 * bufferSize
+    _controllerValues(controllerValues),
+    _controllersVersion(-1),
+    _stats(QString("sound engine %1").arg(_listInstances.size() + 1)),
+    _commands(1024),
+    _finishedVoices(1024),
+    _nbVoices(0)
 {
     _listInstances << this;
     _dataTmpL = new float [8 * bufferSize];
     _dataTmpR = new float [8 * bufferSize];
+    _dataChoL = new float [8 * bufferSize];
+    _dataChoR = new float [8 * bufferSize];
+    _chorus.setParameters(_chorusLevel, _chorusDepth, _chorusFrequency, _sampleRate);
 }
 
 SoundEngine::~SoundEngine()
@@ -43,134 +59,276 @@ SoundEngine::~SoundEngine()
     _listInstances.removeOne(this);
     delete [] _dataTmpL;
     delete [] _dataTmpR;
+    delete [] _dataChoL;
+    delete [] _dataChoR;
+
+    // Voices not processed yet or not deleted yet
+    Command command;
+    while (_commands.pop(command))
+        if (command.type == Command::ADD_VOICE)
+            delete command.voice;
+    Voice * voice;
+    while (_finishedVoices.pop(voice))
+        delete voice;
+    while (!_listVoices.isEmpty())
+        delete _listVoices.takeLast();
 }
 
-int SoundEngine::getNbVoices()
+int SoundEngine::getVoiceNumber()
 {
-    _mutexVoices.lock();
-    int iRet = _listVoices.size();
-    _mutexVoices.unlock();
-    return iRet;
+    int voiceNumber = 0;
+    for (int i = 0; i < _listInstances.size(); i++)
+        voiceNumber += _listInstances.at(i)->_nbVoices.load();
+    return voiceNumber;
 }
 
-void SoundEngine::addVoice(Voice * voice, QList<Voice*> friends)
+void SoundEngine::postCommand(const Command &command)
 {
+    for (int i = 0; i < _listInstances.size(); i++)
+        _listInstances.at(i)->postCommandInstance(command);
+}
+
+void SoundEngine::postCommandInstance(const Command &command)
+{
+    // The queue has a single producer at a time, the sound engine never waits for this lock
+    QMutexLocker locker(&_mutexCommands);
+
+    // Voices finished by the sound engine, deleted here rather than in the audio thread
+    Voice * voice;
+    while (_finishedVoices.pop(voice))
+        delete voice;
+
+    // The queue is full only if the sound engine is stuck: wait for it
+    while (!_commands.push(command))
+        QThread::yieldCurrentThread();
+}
+
+void SoundEngine::deleteVoice(Voice * voice)
+{
+    // The queue is emptied each time a note is played (commands sent to all sound engines)
+    // It can only be full if many voices are stopped at once: the remaining ones are deleted here
+    if (!_finishedVoices.push(voice))
+        delete voice;
+}
+
+void SoundEngine::updateControllers()
+{
+    // Values copied without lock, only if a value changed since the last copy
+    if (_controllerValues->getVersion() != _controllersVersion)
+        _controllersVersion = _controllerValues->getSnapshots(_controllers);
+}
+
+void SoundEngine::processCommands()
+{
+    Command command;
+    while (_commands.pop(command))
+    {
+        switch (command.type)
+        {
+        case Command::ADD_VOICE:
+            _listVoices << command.voice;
+            _voiceManager.applyLimit(_listVoices, command.voice, command.value3);
+            break;
+        case Command::RUN_NEW_VOICES:
+            runNewVoicesInstance(command.position);
+            break;
+        case Command::RELEASE_NOTE:
+            releaseNoteInstance(command.value1, command.channel, command.flag, command.position);
+            break;
+        case Command::CLOSE_EXCLUSIVE_CLASS:
+            closeAllInstance(command.value1, command.value2, command.channel, command.value3);
+            break;
+        case Command::STOP_ALL_VOICES:
+            stopAllVoicesInstance();
+            break;
+        case Command::SET_GAIN:
+            setGainInstance(command.realValue);
+            break;
+        case Command::SET_CHORUS:
+            setChorusInstance(command.value1, command.value2, command.value3, command.position);
+            break;
+        case Command::SET_PITCH_CORRECTION:
+            setPitchCorrectionInstance(static_cast<qint16>(command.value1), command.flag);
+            break;
+        case Command::SET_START_LOOP:
+            setStartLoopInstance(command.position, command.flag);
+            break;
+        case Command::SET_END_LOOP:
+            setEndLoopInstance(command.position, command.flag);
+            break;
+        case Command::SET_LOOP_ENABLED:
+            setLoopEnabledInstance(command.flag);
+            break;
+        case Command::SET_STEREO:
+            setStereoInstance(command.flag, command.value1);
+            break;
+        case Command::SET_GAIN_SAMPLE:
+            setGainSampleInstance(command.value1, command.flag);
+            break;
+        case Command::SET_POLYPHONY:
+            _voiceManager.configure(command.value1, static_cast<VoiceManager::StealingPolicy>(command.value2),
+                                    command.flag, command.position);
+            _voiceManager.applyLimit(_listVoices, nullptr, 0x7FFFFFFF);
+
+            // No allocation when adding voices, stolen voices being still in the list while they fade out
+            _listVoices.reserve(2 * command.value1);
+            break;
+        }
+    }
+}
+
+void SoundEngine::addVoice(Voice * voice, int firstTokenOfNote)
+{
+    // The voice is not shared yet: it can be read and configured here
     int key = voice->getKey();
     if (key >= 0)
     {
         int exclusiveClass = voice->getExclusiveClass();
         if (exclusiveClass != 0)
-            closeAll(exclusiveClass, voice->getPresetNumber(), friends);
+        {
+            // Voices triggered by the same note (token >= firstTokenOfNote) are not closed
+            Command command;
+            command.type = Command::CLOSE_EXCLUSIVE_CLASS;
+            command.value1 = exclusiveClass;
+            command.value2 = voice->getPresetNumber();
+            command.value3 = firstTokenOfNote;
+            command.channel = voice->getChannel();
+            postCommand(command);
+        }
     }
     else
         voice->setLoopMode(_isLoopEnabled);
 
-    // Find the less busy SoundEngine
+    // Find the less busy SoundEngine, whatever the channel: each engine has the controllers of all channels
     int index = -1;
     int minVoiceNumber = -1;
     for (int i = 0; i < _listInstances.size(); i++)
     {
-        int nbVoices = _listInstances.at(i)->getNbVoices();
+        int nbVoices = _listInstances.at(i)->_nbVoices.load();
         if (minVoiceNumber == -1 || nbVoices < minVoiceNumber)
         {
             index = i;
             minVoiceNumber = nbVoices;
         }
     }
-    if (index != -1)
-        _listInstances.at(index)->addVoiceInstance(voice);
+    if (index == -1)
+    {
+        delete voice;
+        return;
+    }
 
-    if (key < 0)
-        _listInstances.at(index)->setStereoInstance(_isStereo);
-}
+    SoundEngine * engine = _listInstances.at(index);
+    engine->_nbVoices.fetchAndAddRelaxed(1);
+    Command command;
+    command.type = Command::ADD_VOICE;
+    command.voice = voice;
+    command.value3 = firstTokenOfNote;
+    engine->postCommandInstance(command);
 
-void SoundEngine::addVoiceInstance(Voice * voice)
-{
-    _mutexVoices.lock();
-    _listVoices << voice;
-    _mutexVoices.unlock();
+    if (key < 0)
+    {
+        command.type = Command::SET_STEREO;
+        command.flag = _isStereo;
+        command.value1 = _gainSmpl;
+        engine->postCommandInstance(command);
+    }
 }
 
 void SoundEngine::stopAllVoices()
 {
-    for (int i = 0; i < _listInstances.size(); i++)
-        _listInstances.at(i)->stopAllVoicesInstance();
+    Command command;
+    command.type = Command::STOP_ALL_VOICES;
+    postCommand(command);
 }
 
 void SoundEngine::stopAllVoicesInstance()
 {
-    _mutexVoices.lock();
     while (!_listVoices.isEmpty())
     {
         // Signal emitted for the sample player (voice -1)
         if (_listVoices.last()->getKey() == -1)
             emit(readFinished(_listVoices.last()->getToken()));
 
-        delete _listVoices.takeLast();
+        deleteVoice(_listVoices.takeLast());
+        _nbVoices.fetchAndSubRelaxed(1);
     }
-    _mutexVoices.unlock();
 }
 
-void SoundEngine::syncNewVoices()
+void SoundEngine::syncNewVoices(qint64 timestamp)
 {
-    foreach (SoundEngine * engine, _listInstances)
-        engine->_mutexBuffer.lock();
-
-    foreach (SoundEngine * engine, _listInstances)
-        engine->_mutexVoices.lock();
+    if (timestamp >= 0)
+    {
+        // The voices start at the position corresponding to the time the key has been pressed,
+        // the latency of each buffer being constant
+        Command command;
+        command.type = Command::RUN_NEW_VOICES;
+        for (int i = 0; i < _listInstances.size(); i++)
+        {
+            command.position = _listInstances.at(i)->positionAt(timestamp, _sampleRate);
+            _listInstances.at(i)->postCommandInstance(command);
+        }
+        return;
+    }
 
     // Current data length available in all buffers
-    QList<quint32> dataAvailable;
     quint32 maxDataLength = 0;
     for (int i = 0; i < _listInstances.size(); i++)
     {
         quint32 iTmp = _listInstances.at(i)->currentLengthAvailable();
         if (iTmp > maxDataLength)
             maxDataLength = iTmp;
-        dataAvailable << iTmp;
     }
 
     // Synchronization of all new voices based on the greatest buffer length
+    // The start is expressed as a position in the stream of each engine, so that it doesn't depend on
+    // the moment the command is processed
+    Command command;
+    command.type = Command::RUN_NEW_VOICES;
     for (int i = 0; i < _listInstances.size(); i++)
-        _listInstances.at(i)->syncNewVoicesInstance(maxDataLength - dataAvailable.at(i));
-
-    foreach (SoundEngine * engine, _listInstances)
-        engine->_mutexVoices.unlock();
-
-    foreach (SoundEngine * engine, _listInstances)
-        engine->_mutexBuffer.unlock();
+    {
+        command.position = _listInstances.at(i)->currentReadPosition() + maxDataLength;
+        _listInstances.at(i)->postCommandInstance(command);
+    }
 }
 
-void SoundEngine::syncNewVoicesInstance(quint32 delay)
+void SoundEngine::runNewVoicesInstance(quint32 startPosition)
 {
+    // Delay between the beginning of the next block and the start of the new voices
+    qint32 delay = static_cast<qint32>(startPosition - currentWritePosition());
+    if (delay < 0)
+        delay = 0;
+
     int nbVoices = _listVoices.size();
     for (int i = nbVoices - 1; i >= 0; i--)
     {
         // Check for started voice
         if (!_listVoices.at(i)->isRunning())
-            _listVoices.at(i)->runVoice(delay);
+            _listVoices.at(i)->runVoice(static_cast<quint32>(delay));
     }
 }
 
-void SoundEngine::releaseNote(int numNote)
+void SoundEngine::releaseNote(int numNote, int channel, qint64 timestamp)
 {
-    foreach (SoundEngine * engine, _listInstances)
-        engine->_mutexBuffer.lock();
-
-    foreach (SoundEngine * engine, _listInstances)
-        engine->_mutexVoices.lock();
-
-    for (int i = 0; i < _listInstances.size(); i++)
-        _listInstances.at(i)->releaseNoteInstance(numNote);
-
-    foreach (SoundEngine * engine, _listInstances)
-        engine->_mutexVoices.unlock();
-
-    foreach (SoundEngine * engine, _listInstances)
-        engine->_mutexBuffer.unlock();
+    Command command;
+    command.type = Command::RELEASE_NOTE;
+    command.value1 = numNote;
+    command.channel = channel;
+    command.flag = (timestamp >= 0 && numNote >= 0);
+    command.position = 0;
+    if (command.flag)
+    {
+        // Release at the position corresponding to the time the key has been released
+        for (int i = 0; i < _listInstances.size(); i++)
+        {
+            command.position = _listInstances.at(i)->positionAt(timestamp, _sampleRate);
+            _listInstances.at(i)->postCommandInstance(command);
+        }
+    }
+    else
+        postCommand(command);
 }
 
-void SoundEngine::releaseNoteInstance(int numNote)
+void SoundEngine::releaseNoteInstance(int numNote, int channel, bool isTimed, quint32 position)
 {
     if (numNote == -1)
     {
@@ -181,118 +339,139 @@ void SoundEngine::releaseNoteInstance(int numNote)
     }
     else
     {
+        // Delay between the beginning of the next block and the release
+        qint32 delay = isTimed ? static_cast<qint32>(position - currentWritePosition()) : 0;
+        if (delay < 0)
+            delay = 0;
+
         for (int i = 0; i < _listVoices.size(); i++)
-            if (_listVoices.at(i)->getKey() == numNote)
-                _listVoices.at(i)->release();
+            if (_listVoices.at(i)->getKey() == numNote && _listVoices.at(i)->getChannel() == channel)
+                _listVoices.at(i)->releaseAt(static_cast<quint32>(delay));
     }
 }
 
 void SoundEngine::setGain(double gain)
 {
-    for (int i = 0; i < _listInstances.size(); i++)
-        _listInstances.at(i)->setGainInstance(gain);
+    Command command;
+    command.type = Command::SET_GAIN;
+    command.realValue = gain;
+    postCommand(command);
 }
 
 void SoundEngine::setGainInstance(double gain)
 {
-    _mutexVoices.lock();
     for (int i = 0; i < _listVoices.size(); i++)
         if (_listVoices.at(i)->getKey() >= 0)
             _listVoices.at(i)->setGain(gain);
-    _mutexVoices.unlock();
 }
 
 void SoundEngine::setChorus(int level, int depth, int frequency)
 {
-    for (int i = 0; i < _listInstances.size(); i++)
-        _listInstances.at(i)->setChorusInstance(level, depth, frequency);
+    _chorusLevel = level;
+    _chorusDepth = depth;
+    _chorusFrequency = frequency;
+    Command command;
+    command.type = Command::SET_CHORUS;
+    command.value1 = level;
+    command.value2 = depth;
+    command.value3 = frequency;
+    command.position = _sampleRate;
+    postCommand(command);
 }
 
-void SoundEngine::setChorusInstance(int level, int depth, int frequency)
+void SoundEngine::setChorusInstance(int level, int depth, int frequency, quint32 sampleRate)
 {
-    _mutexVoices.lock();
-    for (int i = 0; i < _listVoices.size(); i++)
-        if (_listVoices.at(i)->getKey() >= 0)
-            _listVoices.at(i)->setChorus(level, depth, frequency);
-    _mutexVoices.unlock();
+    _chorus.setParameters(level, depth, frequency, sampleRate);
+}
+
+void SoundEngine::setSampleRate(quint32 sampleRate)
+{
+    // The delays of the chorus depend on the sample rate
+    _sampleRate = sampleRate;
+    setChorus(_chorusLevel, _chorusDepth, _chorusFrequency);
 }
 
 void SoundEngine::setPitchCorrection(qint16 correction, bool repercute)
 {
-    for (int i = 0; i < _listInstances.size(); i++)
-        _listInstances.at(i)->setPitchCorrectionInstance(correction, repercute);
+    Command command;
+    command.type = Command::SET_PITCH_CORRECTION;
+    command.value1 = correction;
+    command.flag = repercute;
+    postCommand(command);
 }
 
 void SoundEngine::setPitchCorrectionInstance(qint16 correction, bool repercute)
 {
-    _mutexVoices.lock();
     for (int i = 0; i < _listVoices.size(); i++)
         if (_listVoices.at(i)->getKey() == -1 ||
                 (_listVoices.at(i)->getKey() == -2 && repercute))
             _listVoices[i]->setFineTune(correction);
-    _mutexVoices.unlock();
 }
 
 void SoundEngine::setStartLoop(quint32 startLoop, bool repercute)
 {
-    for (int i = 0; i < _listInstances.size(); i++)
-        _listInstances.at(i)->setStartLoopInstance(startLoop, repercute);
+    Command command;
+    command.type = Command::SET_START_LOOP;
+    command.position = startLoop;
+    command.flag = repercute;
+    postCommand(command);
 }
 
 void SoundEngine::setStartLoopInstance(quint32 startLoop, bool repercute)
 {
-    _mutexVoices.lock();
     for (int i = 0; i < _listVoices.size(); i++)
         if (_listVoices.at(i)->getKey() == -1 ||
                 (_listVoices.at(i)->getKey() == -2 && repercute))
             _listVoices[i]->setLoopStart(startLoop);
-    _mutexVoices.unlock();
 }
 
 void SoundEngine::setEndLoop(quint32 endLoop, bool repercute)
 {
-    for (int i = 0; i < _listInstances.size(); i++)
-        _listInstances.at(i)->setEndLoopInstance(endLoop, repercute);
+    Command command;
+    command.type = Command::SET_END_LOOP;
+    command.position = endLoop;
+    command.flag = repercute;
+    postCommand(command);
 }
 
 void SoundEngine::setEndLoopInstance(quint32 endLoop, bool repercute)
 {
-    _mutexVoices.lock();
     for (int i = 0; i < _listVoices.size(); i++)
         if (_listVoices.at(i)->getKey() == -1 ||
                 (_listVoices.at(i)->getKey() == -2 && repercute))
             _listVoices[i]->setLoopEnd(endLoop);
-    _mutexVoices.unlock();
 }
 
 void SoundEngine::setLoopEnabled(bool isEnabled)
 {
     _isLoopEnabled = isEnabled;
-    for (int i = 0; i < _listInstances.size(); i++)
-        _listInstances.at(i)->setLoopEnabledInstance(isEnabled);
+    Command command;
+    command.type = Command::SET_LOOP_ENABLED;
+    command.flag = isEnabled;
+    postCommand(command);
 }
 
 void SoundEngine::setLoopEnabledInstance(bool isEnabled)
 {
     // Update voices -1 and -2
-    _mutexVoices.lock();
     for (int i = 0; i < _listVoices.size(); i++)
         if (_listVoices.at(i)->getKey() < 0)
             _listVoices.at(i)->setLoopMode(isEnabled);
-    _mutexVoices.unlock();
 }
 
 void SoundEngine::setStereo(bool isStereo)
 {
     _isStereo = isStereo;
-    for (int i = 0; i < _listInstances.size(); i++)
-        _listInstances.at(i)->setStereoInstance(isStereo);
+    Command command;
+    command.type = Command::SET_STEREO;
+    command.flag = isStereo;
+    command.value1 = _gainSmpl;
+    postCommand(command);
 }
 
-void SoundEngine::setStereoInstance(bool isStereo)
+void SoundEngine::setStereoInstance(bool isStereo, int gainSample)
 {
     // Update voices -1 and -2
-    _mutexVoices.lock();
     Voice * voice1 = nullptr;
     Voice * voice2 = nullptr;
     for (int i = 0; i < _listVoices.size(); i++)
@@ -311,10 +490,10 @@ void SoundEngine::setStereoInstance(bool isStereo)
                 voice1->setPan(-50);
             else if (pan > 0)
                 voice1->setPan(50);
-            voice1->setGain(_gainSmpl - 3);
+            voice1->setGain(gainSample - 3);
         }
         if (voice2)
-            voice2->setGain(_gainSmpl - 3);
+            voice2->setGain(gainSample - 3);
     }
     else
     {
@@ -325,55 +504,62 @@ void SoundEngine::setStereoInstance(bool isStereo)
                 voice1->setPan(-1);
             else if (pan > 0)
                 voice1->setPan(1);
-            voice1->setGain(_gainSmpl);
+            voice1->setGain(gainSample);
         }
         if (voice2)
             voice2->setGain(-1000);
     }
-    _mutexVoices.unlock();
 }
 
 void SoundEngine::setGainSample(int gain)
 {
     _gainSmpl = gain;
-    for (int i = 0; i < _listInstances.size(); i++)
-        _listInstances.at(i)->setGainSampleInstance(gain);
+    Command command;
+    command.type = Command::SET_GAIN_SAMPLE;
+    command.value1 = gain;
+    command.flag = _isStereo;
+    postCommand(command);
 }
 
-void SoundEngine::setGainSampleInstance(int gain)
+void SoundEngine::setGainSampleInstance(int gain, bool isStereo)
 {
     // Update voices -1 and -2
-    _mutexVoices.lock();
     for (int i = 0; i < _listVoices.size(); i++)
     {
         if (_listVoices.at(i)->getKey() == -1)
         {
-            if (_isStereo)
+            if (isStereo)
                 _listVoices.at(i)->setGain(gain - 12);
             else
                 _listVoices.at(i)->setGain(gain);
         }
-        else if (_listVoices.at(i)->getKey() == -2 && _isStereo)
+        else if (_listVoices.at(i)->getKey() == -2 && isStereo)
             _listVoices.at(i)->setGain(gain - 12);
     }
-    _mutexVoices.unlock();
-}
-
-void SoundEngine::closeAll(int exclusiveClass, int numPreset, QList<Voice*> friends)
-{
-    for (int i = 0; i < _listInstances.size(); i++)
-        _listInstances.at(i)->closeAllInstance(exclusiveClass, numPreset, friends);
 }
 
-void SoundEngine::closeAllInstance(int exclusiveClass, int numPreset, QList<Voice*> friends)
+void SoundEngine::closeAllInstance(int exclusiveClass, int numPreset, int channel, int firstTokenOfNote)
 {
-    _mutexVoices.lock();
     for (int i = 0; i < _listVoices.size(); i++)
     {
         if (_listVoices.at(i)->getExclusiveClass() == exclusiveClass &&
                 _listVoices.at(i)->getPresetNumber() == numPreset &&
-                !friends.contains(_listVoices.at(i)))
+                _listVoices.at(i)->getChannel() == channel &&
+                _listVoices.at(i)->getToken() < firstTokenOfNote)
             _listVoices.at(i)->release(true);
     }
-    _mutexVoices.unlock();
+}
+
+void SoundEngine::setPolyphony(int maxPolyphony, VoiceManager::StealingPolicy policy, bool isAdaptive, quint32 sampleRate)
+{
+    // The voices being distributed among the sound engines, each one has a part of the polyphony
+    if (_listInstances.isEmpty())
+        return;
+    Command command;
+    command.type = Command::SET_POLYPHONY;
+    command.value1 = (maxPolyphony + _listInstances.size() - 1) / _listInstances.size();
+    command.value2 = policy;
+    command.flag = isAdaptive;
+    command.position = sampleRate;
+    postCommand(command);
 }
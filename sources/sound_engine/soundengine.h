@@ -23,24 +23,34 @@
 **             Date: 01.01.2013                                           **
 ***************************************************************************/
 
+
 #ifndef SOUNDENGINE_H
 #define SOUNDENGINE_H
 
 #include "circularbuffer.h"
 #include "voice.h"
+#include "lockfreequeue.h"
+#include "dspkernels.h"
+#include "controllervalues.h"
+#include "voicemanager.h"
+#include "chorus.h"
+#include "profiler.h"
+#include <QElapsedTimer>
 
 class SoundEngine : public CircularBuffer
 {
     Q_OBJECT
 
 public:
-    SoundEngine(unsigned int bufferSize);
+    SoundEngine(ControllerValues * controllerValues, unsigned int bufferSize);
     virtual ~SoundEngine();
 
-    static void addVoice(Voice * voice, QList<Voice *> friends = QList<Voice*>());
+    // The following functions are executed by the main thread
+    // They only post commands that will be processed by the sound engine threads
+    static void addVoice(Voice * voice, int firstTokenOfNote);
     static void stopAllVoices();
-    static void syncNewVoices();
-    static void releaseNote(int numNote);
+    static void syncNewVoices(qint64 timestamp = -1);
+    static void releaseNote(int numNote, int channel, qint64 timestamp = -1);
     static void setGain(double gain);
     static void setChorus(int level, int depth, int frequency);
     static void setPitchCorrection(qint16 correction, bool repercute);
@@ -50,6 +60,9 @@ public:
     static void setStereo(bool isStereo);
     static bool isStereo() { return _isStereo; }
     static void setGainSample(int gain);
+    static void setPolyphony(int maxPolyphony, VoiceManager::StealingPolicy policy, bool isAdaptive, quint32 sampleRate);
+    static void setSampleRate(quint32 sampleRate);
+    static int getVoiceNumber(); // Voices added and not finished yet, all sound engines included
 
 signals:
     void readFinished(int token);
@@ -58,11 +71,22 @@ protected:
     // Executed by the circular buffer thread
     void generateData(float *dataL, float *dataR, float *dataRevL, float *dataRevR, quint32 len)
     {
+        // First take into account the commands sent by the main thread and the new MIDI values
+        _renderTimer.start();
+        ProfilerStats * stats = Profiler::isEnabled() ? &_stats : nullptr;
+        ProfilerTimer timer(stats);
+        processCommands();
+        updateControllers();
+        timer.lap(ProfilerStats::STAGE_MODULATORS);
+
         // Initialize data
         for (quint32 i = 0; i < len; i++)
             dataL[i] = dataR[i] = dataRevL[i] = dataRevR[i] = 0;
-
-        _mutexVoices.lock();
+        bool isChorusOn = _chorus.isOn();
+        bool isChorusBusEmpty = true;
+        if (isChorusOn)
+            for (quint32 i = 0; i < len; i++)
+                _dataChoL[i] = _dataChoR[i] = 0;
 
         int nbVoices = _listVoices.size();
         for (int i = nbVoices - 1; i >= 0; i--)
@@ -70,19 +94,28 @@ protected:
             // Check for started voice (synchronization)
             if (_listVoices.at(i)->isRunning())
             {
-                // Get data
-                _listVoices.at(i)->generateData(_dataTmpL, _dataTmpR, len);
-                float coef1 = _listVoices.at(i)->getReverb() / 100.0f;
-                float coef2 = 1.f - coef1;
-
-                // Fusion
-                for (quint32 j = 0; j < len; j++)
+                // Get data (the voice measures its own stages)
+                qint64 creationTime = _listVoices.at(i)->takeCreationTime();
+                if (stats != nullptr && creationTime != 0)
+                    stats->addLatency(CircularBuffer::currentTime() - creationTime);
+                _listVoices.at(i)->generateData(_dataTmpL, _dataTmpR, len, &_scratch,
+                                                _controllers[_listVoices.at(i)->getChannel()], stats);
+                timer.restart(); // Time already counted by the voice
+                float coefRev = _listVoices.at(i)->getReverb() / 100.0f;
+                float coefCho = (isChorusOn && _listVoices.at(i)->getKey() >= 0) ?
+                            _chorus.getSendCoef(_listVoices.at(i)->getChorus()) : 0.f;
+
+                // Fusion, the chorus bus being only filled by the voices having a chorus send
+                if (coefCho > 0)
                 {
-                    dataL   [j] += coef2 * _dataTmpL[j];
-                    dataR   [j] += coef2 * _dataTmpR[j];
-                    dataRevL[j] += coef1 * _dataTmpL[j];
-                    dataRevR[j] += coef1 * _dataTmpR[j];
+                    DspKernels::mixStereo(_dataTmpL, _dataTmpR, dataL, dataR, dataRevL, dataRevR,
+                                          (1.f - coefRev) * (1.f - coefCho), coefRev, len);
+                    DspKernels::addStereo(_dataTmpL, _dataTmpR, _dataChoL, _dataChoR, (1.f - coefRev) * coefCho, len);
+                    isChorusBusEmpty = false;
                 }
+                else
+                    DspKernels::mixStereo(_dataTmpL, _dataTmpR, dataL, dataR, dataRevL, dataRevR, 1.f - coefRev, coefRev, len);
+                timer.lap(ProfilerStats::STAGE_MIX);
 
                 // Voice ended?
                 if (_listVoices.at(i)->isFinished())
@@ -91,38 +124,106 @@ protected:
                     if (_listVoices.at(i)->getKey() == -1)
                         emit(readFinished(_listVoices.at(i)->getToken()));
 
-                    delete _listVoices.takeAt(i);
+                    deleteVoice(_listVoices.takeAt(i));
+                    _nbVoices.fetchAndSubRelaxed(1);
                 }
             }
         }
-        _mutexVoices.unlock();
+
+        // Chorus applied once on the sum of the sends
+        if (isChorusOn)
+        {
+            timer.lap(ProfilerStats::STAGE_MIX);
+            _chorus.process(_dataChoL, _dataChoR, dataL, dataR, len, isChorusBusEmpty);
+            timer.lap(ProfilerStats::STAGE_EFFECTS);
+        }
+
+        // Possibly adapt the polyphony to the time spent
+        qint64 elapsed = _renderTimer.nsecsElapsed();
+        _voiceManager.updateLoad(_listVoices, len, elapsed);
+        if (stats != nullptr)
+        {
+            stats->addTime(ProfilerStats::STAGE_TOTAL, elapsed);
+            stats->endBlock(_listVoices.size());
+        }
     }
 
 private:
-    static void closeAll(int exclusiveClass, int numPreset, QList<Voice *> friends);
-
-    int getNbVoices();
-    void closeAllInstance(int exclusiveClass, int numPreset, QList<Voice*> friends);
-    void addVoiceInstance(Voice * voice);
+    // Command sent by the main thread to a sound engine
+    struct Command
+    {
+        enum Type
+        {
+            ADD_VOICE,
+            RUN_NEW_VOICES,
+            RELEASE_NOTE,
+            CLOSE_EXCLUSIVE_CLASS,
+            STOP_ALL_VOICES,
+            SET_GAIN,
+            SET_CHORUS,
+            SET_PITCH_CORRECTION,
+            SET_START_LOOP,
+            SET_END_LOOP,
+            SET_LOOP_ENABLED,
+            SET_STEREO,
+            SET_GAIN_SAMPLE,
+            SET_POLYPHONY
+        };
+
+        Type type;
+        Voice * voice;
+        qint32 value1, value2, value3;
+        qint32 channel;
+        quint32 position;
+        double realValue;
+        bool flag;
+    };
+
+    static void postCommand(const Command &command);
+    void postCommandInstance(const Command &command);
+    void processCommands();
+    void updateControllers();
+    void deleteVoice(Voice * voice);
+
+    // Executed by the sound engine thread
+    void closeAllInstance(int exclusiveClass, int numPreset, int channel, int firstTokenOfNote);
     void stopAllVoicesInstance();
-    void syncNewVoicesInstance(quint32 delay);
-    void releaseNoteInstance(int numNote);
+    void runNewVoicesInstance(quint32 startPosition);
+    void releaseNoteInstance(int numNote, int channel, bool isTimed, quint32 position);
     void setGainInstance(double gain);
-    void setChorusInstance(int level, int depth, int frequency);
+    void setChorusInstance(int level, int depth, int frequency, quint32 sampleRate);
     void setPitchCorrectionInstance(qint16 correction, bool repercute);
     void setStartLoopInstance(quint32 startLoop, bool repercute);
     void setEndLoopInstance(quint32 endLoop, bool repercute);
     void setLoopEnabledInstance(bool isEnabled);
-    void setStereoInstance(bool isStereo);
-    void setGainSampleInstance(int gain);
+    void setStereoInstance(bool isStereo, int gainSample);
+    void setGainSampleInstance(int gain, bool isStereo);
 
-    QMutex _mutexVoices;
+    // Only accessed by the sound engine thread
     QList<Voice *> _listVoices;
     float * _dataTmpL, * _dataTmpR;
-
+    float * _dataChoL, * _dataChoR; // Chorus bus
+    Chorus _chorus;
+    VoiceScratch _scratch;
+    ControllerValues * _controllerValues; // Shared with the other sound engines
+    ControllerSnapshot _controllers[MIDI_CHANNEL_NUMBER];
+    int _controllersVersion;
+    VoiceManager _voiceManager;
+    QElapsedTimer _renderTimer;
+    ProfilerStats _stats;
+
+    // Link between the main thread and the sound engine thread
+    LockFreeQueue<Command> _commands;
+    LockFreeQueue<Voice *> _finishedVoices; // Deleted by the threads posting commands
+    QAtomicInt _nbVoices;
+
+    // Only accessed by the main thread
     static int _gainSmpl;
+    static int _chorusLevel, _chorusDepth, _chorusFrequency;
     static bool _isStereo, _isLoopEnabled;
+    static quint32 _sampleRate;
     static QList<SoundEngine*> _listInstances;
+    static QMutex _mutexCommands; // Several threads can post commands (main thread, MIDI dispatcher thread)
 };
 
 #endif // SOUNDENGINE_H
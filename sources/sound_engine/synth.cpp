@@ -28,49 +28,91 @@
 #include <QFile>
 #include "contextmanager.h"
 #include "soundfontmanager.h"
+#include "renderscheduler.h"
+#include "zoneindex.h"
+#include "dspkernels.h"
 
 int Synth::s_sampleVoiceTokenCounter = 0;
 
 // Constructeur, destructeur
-Synth::Synth(ConfManager *configuration) : QObject(nullptr),
+Synth::Synth(ConfManager *configuration, bool isOffline) : QObject(nullptr),
     _sf2(SoundfontManager::getInstance()),
+    _firstTokenOfNote(0),
+    _currentChannel(0),
+    _zoneIndexesVersion(0),
+    _zoneIndexVersion(0),
     _gain(0),
-    _choLevel(0), _choDepth(0), _choFrequency(0),
+    _interpolation(Resampler::INTERPOLATION_LINEAR),
+    _maxPolyphony(256),
+    _stealingPolicy(VoiceManager::STEALING_OLDEST_RELEASED),
+    _adaptivePolyphony(false),
+    _streamer(nullptr),
+    _streamingPreload(0),
     _clipCoef(1),
-    _recordFile(nullptr),
-    _isRecording(true),
+    _stats("audio output"),
     _fTmpSumRev1(nullptr),
     _fTmpSumRev2(nullptr),
     _dataWav(nullptr),
     _bufferSize(0),
+    _directRendering(false),
+    _renderScheduler(nullptr),
+    _isOffline(isOffline),
     _configuration(configuration)
 {
+    // Streaming thread, not needed when rendering offline since the time is not constrained
+    if (!_isOffline)
+        _streamer = new SampleStreamer();
+
     // Creation buffers and sound engines
     updateConfiguration();
+
+    // Progress of the record, periodically sent by the recorder thread
+    connect(&_recorder, SIGNAL(dataWritten(quint32,quint32)), this, SIGNAL(dataWritten(quint32,quint32)));
+    connect(&_recorder, SIGNAL(overflowed(quint32)), this, SIGNAL(recordOverflowed(quint32)));
+
+    // The key indexes must be built again after each edition
+    connect(_sf2, SIGNAL(editingDone(QString,QList<int>)), this, SLOT(onEditingDone(QString,QList<int>)));
 }
 
 Synth::~Synth()
 {
+    _recorder.close();
     destroySoundEnginesAndBuffers();
+    qDeleteAll(_zoneIndexes);
+    delete _streamer; // After the voices
 }
 
 void Synth::destroySoundEnginesAndBuffers()
 {
-    // Stop sound engines
-    for (int i = 0; i < _soundEngines.size(); i++)
-        _soundEngines.at(i)->stop();
+    // No keys played by the MIDI dispatcher thread meanwhile
+    QMutexLocker locker(&_mutexPlay);
 
-    // Stop threads
-    for (int i = 0; i < _soundEngines.size(); i++)
-        _soundEngines.at(i)->thread()->quit();
-
-    // Delete sound engines and threads
-    while (_soundEngines.size())
+    if (_renderScheduler != nullptr)
+    {
+        // Direct rendering: stop the workers, sound engines have no threads
+        delete _renderScheduler;
+        _renderScheduler = nullptr;
+        while (_soundEngines.size())
+            delete _soundEngines.takeLast();
+    }
+    else
     {
-        QThread * thread = _soundEngines.last()->thread();
-        thread->wait(50);
-        delete _soundEngines.takeLast();
-        delete thread;
+        // Stop sound engines
+        for (int i = 0; i < _soundEngines.size(); i++)
+            _soundEngines.at(i)->stop();
+
+        // Stop threads
+        for (int i = 0; i < _soundEngines.size(); i++)
+            _soundEngines.at(i)->thread()->quit();
+
+        // Delete sound engines and threads
+        while (_soundEngines.size())
+        {
+            QThread * thread = _soundEngines.last()->thread();
+            thread->wait(50);
+            delete _soundEngines.takeLast();
+            delete thread;
+        }
     }
 
     delete [] _fTmpSumRev1;
@@ -80,32 +122,47 @@ void Synth::destroySoundEnginesAndBuffers()
 
 void Synth::createSoundEnginesAndBuffers()
 {
+    // No keys played by the MIDI dispatcher thread meanwhile
+    QMutexLocker locker(&_mutexPlay);
+
     _fTmpSumRev1 = new float [4 * _bufferSize];
     _fTmpSumRev2 = new float [4 * _bufferSize];
     _dataWav = new float[8 * _bufferSize];
 
-    int nbEngines = qMax(QThread::idealThreadCount() - 2, 1);
+    // With the direct rendering, the audio thread also computes a sound engine
+    int nbEngines = qMax(QThread::idealThreadCount() - (_directRendering ? 1 : 2), 1);
     for (int i = 0; i < nbEngines; i++)
     {
-        SoundEngine * soundEngine = new SoundEngine(_bufferSize);
+        SoundEngine * soundEngine = new SoundEngine(&_controllerValues, _bufferSize);
         connect(soundEngine, SIGNAL(readFinished(int)), this, SIGNAL(readFinished(int)));
-        soundEngine->moveToThread(new QThread());
-        soundEngine->thread()->start(QThread::TimeCriticalPriority);
-        QMetaObject::invokeMethod(soundEngine, "start");
+        if (!_directRendering)
+        {
+            soundEngine->moveToThread(new QThread());
+            soundEngine->thread()->start(QThread::TimeCriticalPriority);
+            QMetaObject::invokeMethod(soundEngine, "start");
+        }
         _soundEngines << soundEngine;
     }
+
+    // Direct rendering: the audio thread and a pool of workers compute the sound engines on demand
+    if (_directRendering)
+        _renderScheduler = new RenderScheduler(_soundEngines, _bufferSize);
 }
 
-int Synth::play(EltID id, int key, int velocity)
+int Synth::play(EltID id, int key, int velocity, qint64 timestamp, int channel)
 {
+    QMutexLocker locker(&_mutexPlay);
     if (velocity == 0)
     {
         // Release of a key
-        SoundEngine::releaseNote(key);
+        SoundEngine::releaseNote(key, channel, timestamp);
         return -1;
     }
 
     // A key is pressed
+    // All voices created from now on are triggered by the same note (exclusive class system)
+    _firstTokenOfNote = s_sampleVoiceTokenCounter;
+    _currentChannel = (channel >= 0 && channel < MIDI_CHANNEL_NUMBER) ? channel : 0;
     int playingToken = -1;
     switch (id.typeElement)
     {
@@ -123,143 +180,89 @@ int Synth::play(EltID id, int key, int velocity)
     }
 
     // Synchronize all new voices that have been added
-    _mutexSynchro.lock();
-    SoundEngine::syncNewVoices();
-    _mutexSynchro.unlock();
-
-    // Reset the list used for the exclusive class system
-    _listVoixTmp.clear();
+    SoundEngine::syncNewVoices(timestamp);
     return playingToken;
 }
 
 void Synth::playPrst(int idSf2, int idElt, int key, int velocity)
 {
-    // Default preset range
-    EltID idPrst(elementPrst, idSf2, idElt, 0, 0);
-    RangesType defaultKeyRange, defaultVelRange;
-    if (_sf2->isSet(idPrst, champ_keyRange))
-        defaultKeyRange = _sf2->get(idPrst, champ_keyRange).rValue;
-    else
-    {
-        defaultKeyRange.byLo = 0;
-        defaultKeyRange.byHi = 127;
-    }
-    if (_sf2->isSet(idPrst, champ_velRange))
-        defaultVelRange = _sf2->get(idPrst, champ_velRange).rValue;
-    else
-    {
-        defaultVelRange.byLo = 0;
-        defaultVelRange.byHi = 127;
-    }
+    if (key < 0 || key > 127)
+        return;
 
-    // Browse the ranges of all linked instruments
+    // Go inside the instruments of the divisions containing {key, vel}
+    const ZoneIndex * index = getZoneIndex(EltID(elementPrst, idSf2, idElt, 0, 0));
     EltID idPrstInst(elementPrstInst, idSf2, idElt, 0, 0);
-    int keyMin, keyMax, velMin, velMax;
-    RangesType rangeTmp;
-    foreach (int i, _sf2->getSiblings(idPrstInst))
+    for (const ZoneIndex::Zone * zone = index->zonesBegin(key); zone != index->zonesEnd(key); ++zone)
     {
-        idPrstInst.indexElt2 = i;
+        if (velocity < zone->velMin || velocity > zone->velMax)
+            continue;
 
         // Skip muted divisions
+        idPrstInst.indexElt2 = zone->division;
         if (_sf2->get(idPrstInst, champ_mute).bValue > 0)
             continue;
 
-        if (_sf2->isSet(idPrstInst, champ_keyRange))
-        {
-            rangeTmp = _sf2->get(idPrstInst, champ_keyRange).rValue;
-            keyMin = rangeTmp.byLo;
-            keyMax = rangeTmp.byHi;
-        }
-        else
-        {
-            keyMin = defaultKeyRange.byLo;
-            keyMax = defaultKeyRange.byHi;
-        }
-        if (_sf2->isSet(idPrstInst, champ_velRange))
-        {
-            rangeTmp = _sf2->get(idPrstInst, champ_velRange).rValue;
-            velMin = rangeTmp.byLo;
-            velMax = rangeTmp.byHi;
-        }
-        else
-        {
-            velMin = defaultVelRange.byLo;
-            velMax = defaultVelRange.byHi;
-        }
-
-        // Check {key, vel} is in the division and go inside the instruments
-        if (keyMin <= key && key <= keyMax && velMin <= velocity && velocity <= velMax)
-            this->playInst(idSf2, _sf2->get(idPrstInst, champ_instrument).wValue, key, velocity, idPrstInst);
+        this->playInst(idSf2, zone->target, key, velocity, idPrstInst);
     }
 }
 
 void Synth::playInst(int idSf2, int idElt, int key, int velocity, EltID idPrstInst)
 {
-    // Default instrument range
-    EltID idInst(elementInst, idSf2, idElt, 0, 0);
-    idInst.typeElement = elementInst;
-    RangesType defaultKeyRange, defaultVelRange;
-    if (_sf2->isSet(idInst, champ_keyRange))
-        defaultKeyRange = _sf2->get(idInst, champ_keyRange).rValue;
-    else
-    {
-        defaultKeyRange.byLo = 0;
-        defaultKeyRange.byHi = 127;
-    }
-    if (_sf2->isSet(idInst, champ_velRange))
-        defaultVelRange = _sf2->get(idInst, champ_velRange).rValue;
-    else
-    {
-        defaultVelRange.byLo = 0;
-        defaultVelRange.byHi = 127;
-    }
+    if (key < 0 || key > 127)
+        return;
 
-    // Browse the range of all linked samples
+    // Go inside the samples of the divisions containing {key, vel}
+    const ZoneIndex * index = getZoneIndex(EltID(elementInst, idSf2, idElt, 0, 0));
     EltID idInstSmpl(elementInstSmpl, idSf2, idElt, 0, 0);
-    int keyMin, keyMax, velMin, velMax;
-    RangesType rangeTmp;
-    foreach (int i, _sf2->getSiblings(idInstSmpl))
+    for (const ZoneIndex::Zone * zone = index->zonesBegin(key); zone != index->zonesEnd(key); ++zone)
     {
-        idInstSmpl.indexElt2 = i;
+        if (velocity < zone->velMin || velocity > zone->velMax)
+            continue;
 
         // Skip muted divisions
+        idInstSmpl.indexElt2 = zone->division;
         if (_sf2->get(idInstSmpl, champ_mute).bValue > 0)
             continue;
 
-        if (_sf2->isSet(idInstSmpl, champ_keyRange))
-        {
-            rangeTmp = _sf2->get(idInstSmpl, champ_keyRange).rValue;
-            keyMin = rangeTmp.byLo;
-            keyMax = rangeTmp.byHi;
-        }
-        else
-        {
-            keyMin = defaultKeyRange.byLo;
-            keyMax = defaultKeyRange.byHi;
-        }
-        if (_sf2->isSet(idInstSmpl, champ_velRange))
-        {
-            rangeTmp = _sf2->get(idInstSmpl, champ_velRange).rValue;
-            velMin = rangeTmp.byLo;
-            velMax = rangeTmp.byHi;
-        }
-        else
-        {
-            velMin = defaultVelRange.byLo;
-            velMax = defaultVelRange.byHi;
-        }
+        this->playSmpl(idSf2, zone->target, key, velocity, idInstSmpl, idPrstInst);
+    }
+}
 
-        // Check {key, vel} is in the division and go inside the samples
-        if (keyMin <= key && key <= keyMax && velMin <= velocity && velocity <= velMax)
-            this->playSmpl(idSf2, _sf2->get(idInstSmpl, champ_sampleID).wValue, key, velocity, idInstSmpl, idPrstInst);
+const ZoneIndex * Synth::getZoneIndex(EltID id)
+{
+    // All indexes are built again after an edition
+    int version = _zoneIndexVersion.load();
+    if (version != _zoneIndexesVersion)
+    {
+        qDeleteAll(_zoneIndexes);
+        _zoneIndexes.clear();
+        _zoneIndexesVersion = version;
+    }
+
+    QPair<int, int> key(id.indexSf2, id.typeElement == elementInst ? id.indexElt : -1 - id.indexElt);
+    ZoneIndex * index = _zoneIndexes.value(key, nullptr);
+    if (index == nullptr)
+    {
+        index = new ZoneIndex(_sf2, id);
+        _zoneIndexes[key] = index;
     }
+    return index;
+}
+
+void Synth::onEditingDone(QString editingSource, QList<int> sf2Indexes)
+{
+    Q_UNUSED(editingSource)
+    Q_UNUSED(sf2Indexes)
+
+    // Notes may be played meanwhile by the MIDI dispatcher thread: the indexes will be cleared by the next one
+    _zoneIndexVersion.ref();
 }
 
 int Synth::playSmpl(int idSf2, int idElt, int key, int velocity, EltID idInstSmpl, EltID idPrstInst)
 {
     // Only one -1 or -2 at a time
     if (key < 0)
-        SoundEngine::releaseNote(key);
+        SoundEngine::releaseNote(key, 0);
 
     EltID idSmpl(elementSmpl, idSf2, idElt, 0, 0);
 
@@ -269,24 +272,36 @@ int Synth::playSmpl(int idSf2, int idElt, int key, int velocity, EltID idInstSmp
     if (key < 0) // Smpl area
         voiceParam->prepareForSmpl(key, _sf2->get(idSmpl, champ_sfSampleType).sfLinkValue);
 
+    // Sample read from the disk while playing if possible (not in the sample editor), otherwise fully loaded
+    QSharedPointer<SampleStream> stream;
+    if (key >= 0 && _streamingPreload > 0)
+    {
+        QSharedPointer<StreamedSample> streamedSample = _sf2->getStreamedSample(idSmpl, _streamingPreload);
+        if (!streamedSample.isNull())
+        {
+            // Same loop as in Voice::takeData, the voice being not released
+            int loopMode = voiceParam->getInteger(champ_sampleModes);
+            quint32 loopStart = voiceParam->getPosition(champ_dwStartLoop);
+            quint32 loopEnd = voiceParam->getPosition(champ_dwEndLoop);
+            stream = _streamer->createStream(streamedSample, voiceParam->getPosition(champ_dwStart16), loopStart, loopEnd,
+                                             loopMode == 1 || loopMode == 2 || loopMode == 3);
+        }
+    }
+
     // Create a voice
     int currentToken = s_sampleVoiceTokenCounter++;
-    Voice * voiceTmp = new Voice(_sf2->getData(idSmpl, champ_sampleData32),
+    Voice * voiceTmp = new Voice(stream.isNull() ? _sf2->getData(idSmpl, champ_sampleData32) : QByteArray(), stream,
                                  _sf2->get(idSmpl, champ_dwSampleRate).dwValue,
                                  _format.sampleRate(), key, voiceParam, currentToken);
 
-    // Initialize chorus and gain
-    if (key < 0)
-        voiceTmp->setChorus(0, 0, 0);
-    else
-    {
-        voiceTmp->setChorus(_choLevel, _choDepth, _choFrequency);
+    // Initialize gain
+    if (key >= 0)
         voiceTmp->setGain(_gain);
-    }
+    voiceTmp->setInterpolation(_interpolation);
+    voiceTmp->setChannel(_currentChannel);
 
-    // Add the voice in the list
-    _listVoixTmp << voiceTmp;
-    SoundEngine::addVoice(voiceTmp, _listVoixTmp);
+    // Add the voice in a sound engine
+    SoundEngine::addVoice(voiceTmp, _firstTokenOfNote);
 
     if (key == -1) // -2 is the linked sample
     {
@@ -312,39 +327,53 @@ void Synth::updateConfiguration()
 {
     this->stop();
 
-    // Update chorus
-    _choLevel = _configuration->getValue(ConfManager::SECTION_SOUND_ENGINE, "cho_level", 0).toInt();
-    _choDepth = _configuration->getValue(ConfManager::SECTION_SOUND_ENGINE, "cho_depth", 0).toInt();
-    _choFrequency = _configuration->getValue(ConfManager::SECTION_SOUND_ENGINE, "cho_frequency", 0).toInt();
-    SoundEngine::setChorus(_choLevel, _choDepth, _choFrequency);
+    // Update chorus, computed by each sound engine
+    SoundEngine::setChorus(_configuration->getValue(ConfManager::SECTION_SOUND_ENGINE, "cho_level", 0).toInt(),
+                           _configuration->getValue(ConfManager::SECTION_SOUND_ENGINE, "cho_depth", 0).toInt(),
+                           _configuration->getValue(ConfManager::SECTION_SOUND_ENGINE, "cho_frequency", 0).toInt());
 
     // Update reverb
-    double revLevel = 0.01 * _configuration->getValue(ConfManager::SECTION_SOUND_ENGINE, "rev_level", 0).toInt();
-    double revSize = 0.01 * _configuration->getValue(ConfManager::SECTION_SOUND_ENGINE, "rev_size", 0).toInt();
-    double revWidth = 0.01 * _configuration->getValue(ConfManager::SECTION_SOUND_ENGINE, "rev_width", 0).toInt();
-    double revDamping = 0.01 * _configuration->getValue(ConfManager::SECTION_SOUND_ENGINE, "rev_damping", 0).toInt();
-
-    _mutexReverb.lock();
-    _reverb.setEffectMix(revLevel);
-    _reverb.setRoomSize(revSize);
-    _reverb.setWidth(revWidth);
-    _reverb.setDamping(revDamping);
-    _mutexReverb.unlock();
+    float revLevel = 0.01f * _configuration->getValue(ConfManager::SECTION_SOUND_ENGINE, "rev_level", 0).toInt();
+    float revSize = 0.01f * _configuration->getValue(ConfManager::SECTION_SOUND_ENGINE, "rev_size", 0).toInt();
+    float revWidth = 0.01f * _configuration->getValue(ConfManager::SECTION_SOUND_ENGINE, "rev_width", 0).toInt();
+    float revDamping = 0.01f * _configuration->getValue(ConfManager::SECTION_SOUND_ENGINE, "rev_damping", 0).toInt();
+    _reverb.setParameters(revLevel, revSize, revWidth, revDamping);
 
     // Update gain
     _gain = _configuration->getValue(ConfManager::SECTION_SOUND_ENGINE, "gain", 0).toInt();
     SoundEngine::setGain(_gain);
 
-    // Update buffer size
+    // Update the interpolation, used by the next voices
+    _interpolation = static_cast<Resampler::InterpolationType>(
+                _configuration->getValue(ConfManager::SECTION_SOUND_ENGINE, "interpolation", 0).toInt());
+
+    // Update the streaming, used by the next voices
+    if (_streamer != nullptr && _configuration->getValue(ConfManager::SECTION_SOUND_ENGINE, "streaming", false).toBool())
+        _streamingPreload = _configuration->getValue(ConfManager::SECTION_SOUND_ENGINE, "streaming_preload", 500).toUInt();
+    else
+        _streamingPreload = 0;
+
+    // Update buffer size and rendering mode
     quint32 bufferSize = 2 * _configuration->getValue(ConfManager::SECTION_AUDIO, "buffer_size", 512).toUInt();
-    if (_bufferSize != bufferSize)
+    bool directRendering = _isOffline ||
+            _configuration->getValue(ConfManager::SECTION_AUDIO, "direct_rendering", false).toBool();
+    if (_bufferSize != bufferSize || _directRendering != directRendering)
     {
         _bufferSize = bufferSize;
+        _directRendering = directRendering;
         _mutexSynchro.lock();
         destroySoundEnginesAndBuffers();
         createSoundEnginesAndBuffers();
         _mutexSynchro.unlock();
     }
+
+    // Update the polyphony (after the possible creation of the sound engines)
+    _maxPolyphony = _configuration->getValue(ConfManager::SECTION_SOUND_ENGINE, "max_polyphony", 256).toInt();
+    _stealingPolicy = static_cast<VoiceManager::StealingPolicy>(
+                _configuration->getValue(ConfManager::SECTION_SOUND_ENGINE, "voice_stealing", 0).toInt());
+    _adaptivePolyphony = !_isOffline && // The load is not related to real time
+            _configuration->getValue(ConfManager::SECTION_SOUND_ENGINE, "adaptive_polyphony", false).toBool();
+    SoundEngine::setPolyphony(_maxPolyphony, _stealingPolicy, _adaptivePolyphony, _format.sampleRate());
 }
 
 void Synth::setGainSample(int gain)
@@ -421,139 +450,82 @@ void Synth::setFormat(AudioFormat format)
     // Sample rate update
     _sinus.setSampleRate(format.sampleRate());
     _eq.setSampleRate(format.sampleRate());
+    _reverb.setSampleRate(format.sampleRate());
+    SoundEngine::setPolyphony(_maxPolyphony, _stealingPolicy, _adaptivePolyphony, format.sampleRate());
+    SoundEngine::setSampleRate(format.sampleRate());
     this->sampleRateChanged(format.sampleRate());
 }
 
-void Synth::startNewRecord(QString fileName)
+bool Synth::startNewRecord(QString fileName, Recorder::Format format)
 {
-    _mutexRecord.lock();
-    if (_recordFile)
-        this->endRecord();
-    _recordFile = new QFile(fileName);
-    if (_recordFile->open(QIODevice::WriteOnly))
-    {
-        // Create header
-        quint32 dwTemp = 0;
-        quint16 wTemp;
-        _recordStream.setDevice(_recordFile);
-        _recordStream.setByteOrder(QDataStream::LittleEndian);
-        _recordLength = 0;
-        // header
-        _recordStream.writeRawData("RIFF", 4);
-        _recordStream << static_cast<quint32>(_recordLength + 18 + 4 + 8 + 8);
-        _recordStream.writeRawData("WAVE", 4);
-        ///////////// BLOC FMT /////////////
-        _recordStream.writeRawData("fmt ", 4);
-        dwTemp = 18;
-        _recordStream << dwTemp;
-        // Compression code
-        wTemp = 3;
-        _recordStream << wTemp;
-        // Number of channels
-        wTemp = 2;
-        _recordStream << wTemp;
-        // Sample rate
-        dwTemp = _format.sampleRate();
-        _recordStream << dwTemp;
-        // Average byte per second
-        dwTemp *= 2 * 4;
-        _recordStream << dwTemp;
-        // Block align
-        wTemp = 2 * 4;
-        _recordStream << wTemp;
-        // Significants bits per smpl
-        _recordStream << static_cast<quint16>(32);
-        // Extra format bytes
-        wTemp = 0;
-        _recordStream << wTemp;
-        ///////////// BLOC DATA /////////////
-        _recordStream.writeRawData("data", 4);
-        _recordStream << _recordLength;
-
-        _isRecording = true;
-    }
-    else
-    {
-        delete _recordFile;
-        _recordFile = nullptr;
-    }
-    _mutexRecord.unlock();
+    return _recorder.open(fileName, format, _format.sampleRate());
 }
 
 void Synth::endRecord()
 {
-    _mutexRecord.lock();
-    if (_recordFile)
-    {
-        // Adjust file dimensions
-        _recordFile->seek(4);
-        _recordStream << static_cast<quint32>(_recordLength + 18 + 4 + 8 + 8);
-        _recordFile->seek(42);
-        _recordStream << _recordLength;
-
-        // Close file
-        _recordStream.setDevice(nullptr);
-        _recordFile->close();
-        delete _recordFile;
-        _recordFile = nullptr;
-
-        _isRecording = false;
-    }
-    _mutexRecord.unlock();
+    _recorder.close();
 }
 
 void Synth::pause(bool isOn)
 {
-    _mutexRecord.lock();
-    _isRecording = !isOn;
-    _mutexRecord.unlock();
+    _recorder.pause(isOn);
 }
 
 void Synth::readData(float *data1, float *data2, quint32 maxlen)
 {
+    qint64 startTime = CircularBuffer::currentTime();
+    ProfilerStats * stats = Profiler::isEnabled() ? &_stats : nullptr;
+    ProfilerTimer timer(stats);
+
+    // Called by the audio server (or by the offline rendering): the thread may be different each time
+    DspKernels::disableDenormals();
+
     for (quint32 i = 0; i < maxlen; i++)
         data1[i] = data2[i] = _fTmpSumRev1[i] = _fTmpSumRev2[i] = 0;
 
     // Merge sound engines
     _mutexSynchro.lock();
-    for (int i = 0; i < _soundEngines.size(); i++)
-        _soundEngines.at(i)->addData(data1, data2, _fTmpSumRev1, _fTmpSumRev2, maxlen);
+    if (_renderScheduler != nullptr)
+        _renderScheduler->render(data1, data2, _fTmpSumRev1, _fTmpSumRev2, maxlen);
+    else
+    {
+        for (int i = 0; i < _soundEngines.size(); i++)
+            _soundEngines.at(i)->addData(data1, data2, _fTmpSumRev1, _fTmpSumRev2, maxlen);
+    }
     _mutexSynchro.unlock();
+    timer.lap(ProfilerStats::STAGE_MIX);
 
     // EQ filter (live preview of filtered samples)
     _eq.filterData(data1, data2, maxlen);
 
     // Apply reverb and add data
-    _mutexReverb.lock();
-    for (quint32 i = 0; i < maxlen; i++)
-    {
-        data1[i] += static_cast<float>(
-                    _reverb.tick(static_cast<double>(_fTmpSumRev1[i]), static_cast<double>(_fTmpSumRev2[i])));
-        data2[i] += static_cast<float>(_reverb.lastOut(1));
-    }
-    _mutexReverb.unlock();
+    _reverb.process(data1, data2, _fTmpSumRev1, _fTmpSumRev2, maxlen);
 
     // Add calibrating sinus
     _sinus.addData(data1, data2, maxlen);
+    timer.lap(ProfilerStats::STAGE_EFFECTS);
 
     // Clipping
     clip(data1, data2, maxlen);
 
-    // Possibly record in a file
-    _mutexRecord.lock();
-    if (_recordFile && _isRecording)
+    // Possibly record in a file (encoded and written by the recorder thread)
+    if (_recorder.isRecording())
     {
-        // Interleave and write
         for (quint32 i = 0; i < maxlen; i++)
         {
             _dataWav[2 * i + 1] = data1[i];
             _dataWav[2 * i]     = data2[i];
         }
-        _recordStream.writeRawData(reinterpret_cast<char*>(_dataWav), static_cast<int>(maxlen * 8));
+        _recorder.write(_dataWav, maxlen);
+    }
 
-        // Prise en compte de l'avance
-        _recordLength += maxlen * 8;
-        emit(dataWritten(_format.sampleRate(), maxlen));
+    // The audio server is waiting for the data: the callback must not last longer than the data it provides
+    qint64 elapsed = CircularBuffer::currentTime() - startTime;
+    if (!_isOffline && _format.sampleRate() > 0 && elapsed * _format.sampleRate() > 1000000000LL * maxlen)
+        Profiler::addMissedDeadline();
+    if (stats != nullptr)
+    {
+        stats->addTime(ProfilerStats::STAGE_TOTAL, elapsed);
+        stats->endBlock(0);
     }
-    _mutexRecord.unlock();
 }
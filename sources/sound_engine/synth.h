@@ -30,8 +30,14 @@
 #include "audiodevice.h"
 #include "calibrationsinus.h"
 #include "liveeq.h"
-#include <QDataStream>
+#include "reverb.h"
+#include "samplestreamer.h"
+#include "recorder.h"
+#include "profiler.h"
+class RenderScheduler;
+#include <QHash>
 class SoundfontManager;
+class ZoneIndex;
 class ConfManager;
 
 class Synth : public QObject
@@ -39,13 +45,21 @@ class Synth : public QObject
     Q_OBJECT
 
 public:
-    Synth(ConfManager *configuration);
+    // In offline mode, the sound engines are always computed on demand with all cores (no audio server)
+    Synth(ConfManager *configuration, bool isOffline = false);
     ~Synth();
 
-    // Executed by the main thread (thread 1)
-    int play(EltID id, int key, int velocity);
+    // Executed by the main thread (thread 1) or the MIDI dispatcher thread
+    // The timestamp (see CircularBuffer::currentTime) is the time at which the key has been pressed or released,
+    // -1 for playing as soon as possible
+    // The voices are related to a MIDI channel (0 to 15): they read its controllers and are released with it
+    int play(EltID id, int key, int velocity, qint64 timestamp = -1, int channel = 0);
     void stop();
     void setGain(double gain);
+    int getVoiceNumber() { return SoundEngine::getVoiceNumber(); }
+
+    // Last MIDI values of the channels (controllers, pressures, bend), read by the voices
+    ControllerValues * getControllerValues() { return &_controllerValues; }
 
     // Parameters for reading samples
     void setGainSample(int gain);
@@ -59,13 +73,14 @@ public:
     void activateSmplEq(bool isActivated);
     void setSmplEqValues(QVector<int> values);
 
-    // Record
-    void startNewRecord(QString fileName);
+    // Record (false is returned if the file couldn't be created)
+    bool startNewRecord(QString fileName, Recorder::Format format);
     void endRecord();
     void pause(bool isOn);
 
     // Following functions are executed by the audio server (thread 2)
-    void readData(float *data1, float *data2, quint32 maxlen);
+    void readData(float *data1, float *data2, quint32 maxlen); // maxlen is at most getBufferSize()
+    quint32 getBufferSize() { return _bufferSize; }
     void setFormat(AudioFormat format);
 
 signals:
@@ -73,15 +88,20 @@ signals:
     void readFinished(int token);
     void sampleRateChanged(quint32 sampleRate);
     void dataWritten(quint32 sampleRate, quint32 number);
+    void recordOverflowed(quint32 number);
 
 public slots:
     void updateConfiguration();
 
+private slots:
+    void onEditingDone(QString editingSource, QList<int> sf2Indexes);
+
 private:
     void playPrst(int idSf2, int idElt, int key, int velocity);
     void playInst(int idSf2, int idElt, int key, int velocity, EltID idPrstInst = EltID(elementUnknown));
     int playSmpl(int idSf2, int idElt, int key, int velocity,
                  EltID idInstSmpl = EltID(elementUnknown), EltID idPrstInst = EltID(elementUnknown));
+    const ZoneIndex * getZoneIndex(EltID id); // Instrument or preset
 
     void destroySoundEnginesAndBuffers();
     void createSoundEnginesAndBuffers();
@@ -131,10 +151,17 @@ private:
     LiveEQ _eq;
     SoundfontManager * _sf2;
 
-    // Liste des sound engines, voix temporaires (pour exclusive class)
+    // Liste des sound engines, premier token et canal de la note en cours (pour exclusive class)
     QList<SoundEngine *> _soundEngines;
-    QList<Voice *> _listVoixTmp;
+    int _firstTokenOfNote;
+    int _currentChannel;
     static int s_sampleVoiceTokenCounter;
+    QMutex _mutexPlay;
+
+    // Divisions triggered by each key, per instrument and preset (built when played, accessed with _mutexPlay)
+    QHash<QPair<int, int>, ZoneIndex *> _zoneIndexes;
+    int _zoneIndexesVersion;
+    QAtomicInt _zoneIndexVersion; // Incremented after each edition
 
     // Audio format
     AudioFormat _format;
@@ -142,24 +169,40 @@ private:
     // Global parameter
     double _gain;
 
-    // Effects
-    int _choLevel, _choDepth, _choFrequency;
-    stk::FreeVerb _reverb;
-    QMutex _mutexReverb, _mutexSynchro;
+    // Reverb (the chorus being computed by each sound engine)
+    Reverb _reverb;
+    QMutex _mutexSynchro;
+
+    // Interpolation and polyphony
+    Resampler::InterpolationType _interpolation;
+    int _maxPolyphony;
+    VoiceManager::StealingPolicy _stealingPolicy;
+    bool _adaptivePolyphony;
+
+    // Samples read from the disk while playing, with the duration (ms) loaded beforehand (0 if disabled)
+    SampleStreamer * _streamer;
+    quint32 _streamingPreload;
 
     // Clipping state
     float _clipCoef;
 
+    // Measures of the audio thread
+    ProfilerStats _stats;
+
+    // MIDI values shared by the sound engines
+    ControllerValues _controllerValues;
+
     // Record management
-    QFile * _recordFile;
-    QDataStream _recordStream;
-    bool _isRecording;
-    quint32 _recordLength;
-    QMutex _mutexRecord;
+    Recorder _recorder;
 
     float * _fTmpSumRev1, * _fTmpSumRev2, * _dataWav;
     quint32 _bufferSize;
 
+    // Direct rendering: sound engines computed on demand instead of being buffered by their threads
+    bool _directRendering;
+    RenderScheduler * _renderScheduler;
+    bool _isOffline;
+
     ConfManager * _configuration;
 };
 
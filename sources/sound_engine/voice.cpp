@@ -24,47 +24,99 @@
 
 #include "voice.h"
 #include "qmath.h"
+#include "resampler.h"
+
+const quint32 Voice::FILTER_STEP = 16;
+const float Voice::FILTER_SILENCE = 1e-9f; // -180 dB
 
 // Constructeur, destructeur
-Voice::Voice(QByteArray baData, quint32 smplRate, quint32 audioSmplRate, int initialKey,
+Voice::Voice(const QByteArray &baData, QSharedPointer<SampleStream> stream, quint32 smplRate, quint32 audioSmplRate, int initialKey,
              VoiceParam * voiceParam, int token) : QObject(nullptr),
     _modLFO(audioSmplRate),
     _vibLFO(audioSmplRate),
     _enveloppeVol(audioSmplRate, false),
     _enveloppeMod(audioSmplRate, true),
-    _chorusLevel(0),
     _baData(baData),
+    _stream(stream),
     _smplRate(smplRate),
     _audioSmplRate(audioSmplRate),
     _gain(0),
     _initialKey(initialKey),
     _voiceParam(voiceParam),
     _token(token),
+    _channel(0),
+    _creationTime(CircularBuffer::currentTime()),
     _currentSmplPos(voiceParam->getPosition(champ_dwStart16)), // This value is read only once
+    _valuesSinceWrap(Resampler::MAX_TAPS),
+    _wrapEnd(0),
     _time(0),
     _release(false),
+    _isStolen(false),
     _delayEnd(10),
     _delayStart(0),
+    _delayRelease(0),
+    _releasePlanned(false),
     _isFinished(false),
     _isRunning(false),
     _deltaPos(0),
-    _valPrec(0),
-    _x1(0), _x2(0), _y1(0), _y2(0)
+    _interpolation(Resampler::INTERPOLATION_LINEAR),
+    _x1(0), _x2(0), _y1(0), _y2(0),
+    _a0(0), _a1(0), _a2(0), _b1(0), _b2(0),
+    _filterInitialized(false)
 {
-    // Initialisation resampling
-    takeData(&_valBase, 1);
+    // Initialisation resampling: the first values are read in advance so that
+    // the interpolation can use the points following the current position
+    memset(_history, 0, sizeof(_history));
+    takeData(&_history[Resampler::MAX_TAPS / 2], Resampler::MAX_TAPS / 2);
 }
 
 Voice::~Voice()
 {
+    // The streaming thread keeps a reference until the stream is closed: the last one is released there,
+    // not in the audio thread
+    if (!_stream.isNull())
+    {
+        SampleStream * stream = _stream.data();
+        _stream.clear();
+        stream->close();
+    }
     delete _voiceParam;
 }
 
-void Voice::generateData(float *dataL, float *dataR, quint32 len)
+void Voice::generateData(float *dataL, float *dataR, quint32 len, VoiceScratch *scratch, const ControllerSnapshot &controllers,
+                         ProfilerStats * stats)
 {
+    if (!_releasePlanned || _delayRelease >= len)
+    {
+        if (_releasePlanned)
+            _delayRelease -= len;
+        generateBlock(dataL, dataR, len, scratch, controllers, stats);
+        return;
+    }
+
+    // The release occurs during this block: the block is split so that the release is sample-accurate
+    quint32 firstPart = _delayRelease;
+    if (firstPart > 0)
+        generateBlock(dataL, dataR, firstPart, scratch, controllers, stats);
+    _releasePlanned = false;
+    _release = true;
+
+    if (_isFinished)
+    {
+        for (quint32 i = firstPart; i < len; i++)
+            dataL[i] = dataR[i] = 0;
+    }
+    else
+        generateBlock(&dataL[firstPart], &dataR[firstPart], len - firstPart, scratch, controllers, stats);
+}
+
+void Voice::generateBlock(float *dataL, float *dataR, quint32 len, VoiceScratch *scratch, const ControllerSnapshot &controllers,
+                          ProfilerStats * stats)
+{
+    ProfilerTimer timer(stats);
+
     // Get voice current parameters
-    _mutexParam.lock();
-    _voiceParam->computeModulations();
+    _voiceParam->computeModulations(controllers);
     qint32 v_rootkey = _voiceParam->getInteger(champ_overridingRootKey);
     qint32 playedNote = _voiceParam->getInteger(champ_keynum);
     qint32 v_scaleTune = _voiceParam->getInteger(champ_scaleTuning);
@@ -88,7 +140,6 @@ void Voice::generateData(float *dataL, float *dataR, quint32 len)
     double v_filterFreq = _voiceParam->getDouble(champ_initialFilterFc);
     qint32 v_loopMode = _voiceParam->getInteger(champ_sampleModes);
     double v_pan = _voiceParam->getDouble(champ_pan);
-    double v_chorusEffect = _voiceParam->getDouble(champ_chorusEffectsSend);
 
     double v_attenuation = _voiceParam->getDouble(champ_initialAttenuation);
 
@@ -102,21 +153,18 @@ void Voice::generateData(float *dataL, float *dataR, quint32 len)
     _delayStart -= nbNullValues;
     len -= nbNullValues;
     if (len == 0)
-    {
-        _mutexParam.unlock();
         return;
-    }
     dataL = &dataL[nbNullValues];
     dataR = &dataR[nbNullValues];
 
     bool endSample = false;
 
-    // Prepare arrays
-    float * dataMod = new float[len];
-    float * modLfo = new float[len];
-    float * vibLfo = new float[len];
-    float * modPitch = new float[len+1];
-    double * modFreq = new double[len];
+    // Arrays borrowed from the sound engine
+    scratch->reserve(len);
+    float * dataMod = scratch->dataMod();
+    float * modLfo = scratch->modLfo();
+    float * vibLfo = scratch->vibLfo();
+    float * modPitch = scratch->modPitch();
 
     /// ENVELOPPE DE MODULATION ///
     _enveloppeMod.applyEnveloppe(dataMod, len, _release, playedNote, 1.0f, _voiceParam);
@@ -139,62 +187,89 @@ void Voice::generateData(float *dataL, float *dataR, quint32 len)
         modPitch[i] = qMin(qMax(0.001f, EnveloppeVol::fastPow2(modPitch[i] / 12)), 64.f) + modPitch[i-1];
     _deltaPos = modPitch[len];
     _deltaPos = _deltaPos - ceil(_deltaPos);
+    timer.lap(ProfilerStats::STAGE_MODULATORS);
 
     // Resample data
     quint32 nbDataTmp = static_cast<quint32>(ceil(static_cast<double>(modPitch[len]))) - 1;
-    qint32 * dataTmp = new qint32[nbDataTmp + 2];
-    dataTmp[0] = _valPrec;
-    dataTmp[1] = _valBase;
-    endSample = takeData(&dataTmp[2], nbDataTmp);
-    _valPrec = dataTmp[nbDataTmp];
-    _valBase = dataTmp[nbDataTmp + 1];
-    double pos;
-    qint32 val1, val2;
-    for (quint32 i = 0; i < len; i++)
-    {
-        pos = static_cast<double>(modPitch[i]);
-        val1 = dataTmp[static_cast<quint32>(floor(pos))];
-        val2 = dataTmp[static_cast<quint32>(ceil(pos))];
-        pos -= floor(pos);
-        dataL[i] = static_cast<float>(((1. - pos) * val1 + pos * val2) / 2147483648LL); // Cast to double from -1 to 1
-    }
-    delete [] dataTmp;
+    qint32 * dataTmp = scratch->dataTmp();
+    memcpy(dataTmp, _history, sizeof(_history));
+    endSample = takeData(&dataTmp[Resampler::MAX_TAPS], nbDataTmp);
+    memcpy(_history, &dataTmp[nbDataTmp], sizeof(_history));
+    Resampler::resample(_interpolation, &dataTmp[Resampler::MAX_TAPS / 2 - 1], modPitch, dataL, len,
+                        (modPitch[len] - modPitch[0]) / len);
+    timer.lap(ProfilerStats::STAGE_RESAMPLE);
 
     // Low-pass filter
-    for (quint32 i = 0; i < len; i++)
-    {
-        modFreq[i] = v_filterFreq * static_cast<double>(
-                    EnveloppeVol::fastPow2((dataMod[i] * v_modEnvToFilterFc + modLfo[i] * v_modLfoToFilterFreq) / 1200));
-        if (modFreq[i] > 20000)
-            modFreq[i] = 20000;
-        else if (modFreq[i] < 20)
-            modFreq[i] = 20;
-    }
-    double a0, a1, a2, b1, b2, valTmp;
+    // Coefficients are computed every FILTER_STEP values and linearly interpolated in between
     double filterQ = v_filterQ - 3.01; // So that a value of 0 gives a non-resonant low pass
     double q_lin = qPow(10, filterQ / 20.); // If filterQ is -3.01, q_lin is 1/sqrt(2)
-    for (quint32 i = 0; i < len; i++)
+    double a0, a1, a2, b1, b2;
+    float valTmp;
+    for (quint32 start = 0; start < len; start += FILTER_STEP)
     {
-        biQuadCoefficients(a0, a1, a2, b1, b2, modFreq[i], q_lin);
-        valTmp = a0 * static_cast<double>(dataL[i]) + a1 * _x1 + a2 * _x2 - b1 * _y1 - b2 * _y2;
-        _x2 = _x1;
-        _x1 = static_cast<double>(dataL[i]);
-        _y2 = _y1;
-        _y1 = valTmp;
-        dataL[i] = static_cast<float>(valTmp);
+        quint32 end = qMin(start + FILTER_STEP, len);
+
+        // Target coefficients at the end of the chunk
+        double freq = v_filterFreq * static_cast<double>(
+                    EnveloppeVol::fastPow2((dataMod[end - 1] * v_modEnvToFilterFc + modLfo[end - 1] * v_modLfoToFilterFreq) / 1200));
+        if (freq > 20000)
+            freq = 20000;
+        else if (freq < 20)
+            freq = 20;
+        biQuadCoefficients(a0, a1, a2, b1, b2, freq, q_lin);
+        if (!_filterInitialized)
+        {
+            _a0 = static_cast<float>(a0);
+            _a1 = static_cast<float>(a1);
+            _a2 = static_cast<float>(a2);
+            _b1 = static_cast<float>(b1);
+            _b2 = static_cast<float>(b2);
+            _filterInitialized = true;
+        }
+
+        // Interpolation steps
+        float step = 1.f / (end - start);
+        float da0 = (static_cast<float>(a0) - _a0) * step;
+        float da1 = (static_cast<float>(a1) - _a1) * step;
+        float da2 = (static_cast<float>(a2) - _a2) * step;
+        float db1 = (static_cast<float>(b1) - _b1) * step;
+        float db2 = (static_cast<float>(b2) - _b2) * step;
+        for (quint32 i = start; i < end; i++)
+        {
+            _a0 += da0;
+            _a1 += da1;
+            _a2 += da2;
+            _b1 += db1;
+            _b2 += db2;
+            valTmp = _a0 * dataL[i] + _a1 * _x1 + _a2 * _x2 - _b1 * _y1 - _b2 * _y2;
+            _x2 = _x1;
+            _x1 = dataL[i];
+            _y2 = _y1;
+            _y1 = valTmp;
+            dataL[i] = valTmp;
+        }
+
+        // Avoid the accumulation of rounding errors
+        _a0 = static_cast<float>(a0);
+        _a1 = static_cast<float>(a1);
+        _a2 = static_cast<float>(a2);
+        _b1 = static_cast<float>(b1);
+        _b2 = static_cast<float>(b2);
     }
 
+    // Silence: the filter state is cleared instead of decaying towards zero
+    if (qAbs(_x1) + qAbs(_x2) + qAbs(_y1) + qAbs(_y2) < FILTER_SILENCE)
+        _x1 = _x2 = _y1 = _y2 = 0;
+    timer.lap(ProfilerStats::STAGE_FILTER);
+
     // Volume modulation with values from the mod LFO converted to dB
-    if (v_modLfoToVolume <= 0.1 || v_modLfoToVolume >= 0.1)
+    // 10^(0.05 * x) is computed as 2^(0.05 * log2(10) * x)
+    if (v_modLfoToVolume <= -0.1 || v_modLfoToVolume >= 0.1)
+    {
+        float coef = static_cast<float>(0.166096404744 * v_modLfoToVolume);
         for (quint32 i = 0; i < len; i++)
-            dataL[i] *= static_cast<float>(qPow(10., 0.05 * v_modLfoToVolume * static_cast<double>(modLfo[i])));
-
-    // Destroy arrays
-    delete [] dataMod;
-    delete [] modLfo;
-    delete [] vibLfo;
-    delete [] modPitch;
-    delete [] modFreq;
+            dataL[i] *= EnveloppeVol::fastPow2(coef * modLfo[i]);
+    }
 
     // Apply the volume envelop
     bool bRet2 = _enveloppeVol.applyEnveloppe(dataL, len, _release, playedNote,
@@ -207,21 +282,20 @@ void Voice::generateData(float *dataL, float *dataR, quint32 len)
         emit(currentPosChanged(0));
     }
     else
-        emit(currentPosChanged(_currentSmplPos));
+        emit(currentPosChanged(getPlayedPosition()));
 
-    //// APPLY PAN AND CHORUS ////
+    //// APPLY PAN ////
+    // (chorus and reverb are applied by the sound engine on the sum of the voices)
 
     double pan = (v_pan + 50) * M_PI / 200.; // Between 0 and PI/2
-    double coef1 = sin(pan);
-    double coef2 = cos(pan);
-    _chorus.setEffectMix(0.005 * _chorusLevel * 0.01 * v_chorusEffect);
+    float coef1 = static_cast<float>(sin(pan));
+    float coef2 = static_cast<float>(cos(pan));
     for (quint32 i = 0; i < len; i++)
     {
-        dataL[i] = static_cast<float>(coef1 * _chorus.tick(static_cast<double>(dataL[i])));
-        dataR[i] = static_cast<float>(coef2 * _chorus.lastOut(1));
+        dataR[i] = coef2 * dataL[i];
+        dataL[i] *= coef1;
     }
-
-    _mutexParam.unlock();
+    timer.lap(ProfilerStats::STAGE_ENVELOPES);
 
     dataL = &dataL[-static_cast<int>(nbNullValues)];
     dataR = &dataR[-static_cast<int>(nbNullValues)];
@@ -230,87 +304,128 @@ void Voice::generateData(float *dataL, float *dataR, quint32 len)
 bool Voice::takeData(qint32 * data, quint32 nbRead)
 {
     bool endSample = false;
-    const qint32 * dataSmpl = reinterpret_cast<const qint32*>(_baData.constData());
 
     int loopMode = _voiceParam->getInteger(champ_sampleModes);
     quint32 loopStart = _voiceParam->getPosition(champ_dwStartLoop);
     quint32 loopEnd = _voiceParam->getPosition(champ_dwEndLoop);
 
-    if ((loopMode == 1 || loopMode == 2 || (loopMode == 3 && !_release)) && loopStart < loopEnd)
+    bool isLooping = (loopMode == 1 || loopMode == 2 || (loopMode == 3 && !_release)) && loopStart < loopEnd;
+
+    // The stream reads in advance the values after the wrap, and after the loop end once released
+    if (!_stream.isNull())
+        _stream->setLoop(loopStart, loopEnd, isLooping);
+
+    if (isLooping)
     {
         // Loop
         if (_currentSmplPos >= loopEnd)
+        {
+            _wrapEnd = _currentSmplPos;
             _currentSmplPos = loopStart;
+            _valuesSinceWrap = 0;
+        }
         quint32 total = 0;
         while (nbRead - total > 0)
         {
             const quint32 chunk = qMin(_currentSmplPos < loopEnd ? loopEnd - _currentSmplPos : 0, nbRead - total);
-            memcpy(&data[total], &dataSmpl[_currentSmplPos], chunk * sizeof(qint32));
+            copyData(&data[total], _currentSmplPos, chunk);
             _currentSmplPos += chunk;
+            _valuesSinceWrap += chunk;
             if (_currentSmplPos >= loopEnd)
+            {
+                _wrapEnd = _currentSmplPos;
                 _currentSmplPos = loopStart;
+                _valuesSinceWrap = 0;
+            }
             total += chunk;
         }
     }
     else
     {
-        // No loop
+        // No loop, the position going on after the end (values read as 0) until the last value is played
         quint32 sampleEnd = _voiceParam->getPosition(champ_dwLength);
-        if (_currentSmplPos > sampleEnd)
+        quint32 playedEnd = sampleEnd + Resampler::MAX_TAPS / 2;
+        if (_currentSmplPos > playedEnd)
         {
             // No more data, fill with 0
             memset(data, 0, nbRead * sizeof(qint32));
             endSample = true;
         }
-        else if (sampleEnd - _currentSmplPos < nbRead)
-        {
-            // Copy what is possible to copy, fill the rest with 0
-            memcpy(data, &dataSmpl[_currentSmplPos], sizeof(qint32) * (sampleEnd - _currentSmplPos));
-            memset(&data[sampleEnd - _currentSmplPos], 0, (nbRead - sampleEnd + _currentSmplPos) * sizeof(qint32));
-
-            // We are now at the end
-            _currentSmplPos = sampleEnd;
-            _delayEnd--;
-            if (_delayEnd == 0)
-                endSample = true;
-        }
         else
         {
-            // Copy data
-            memcpy(data, &dataSmpl[_currentSmplPos], nbRead * sizeof(qint32));
-            _currentSmplPos += nbRead;
+            // Copy what is possible to copy, fill the rest with 0
+            quint32 length = _currentSmplPos < sampleEnd ? qMin(sampleEnd - _currentSmplPos, nbRead) : 0;
+            copyData(data, _currentSmplPos, length);
+            memset(&data[length], 0, (nbRead - length) * sizeof(qint32));
+            _currentSmplPos = qMin(_currentSmplPos + nbRead, playedEnd);
+            _valuesSinceWrap += nbRead;
+
+            // The end has been played
+            if (_currentSmplPos == playedEnd)
+            {
+                _delayEnd--;
+                if (_delayEnd == 0)
+                    endSample = true;
+            }
         }
     }
+    _valuesSinceWrap = qMin(_valuesSinceWrap, static_cast<quint32>(Resampler::MAX_TAPS));
 
     return endSample;
 }
 
+quint32 Voice::getPlayedPosition()
+{
+    // The last MAX_TAPS / 2 values read have not been played yet, possibly before a jump to the loop start
+    const quint32 lookahead = Resampler::MAX_TAPS / 2;
+    if (_valuesSinceWrap >= lookahead)
+        return _currentSmplPos - lookahead;
+    return _wrapEnd > lookahead - _valuesSinceWrap ? _wrapEnd - (lookahead - _valuesSinceWrap) : 0;
+}
+
+void Voice::copyData(qint32 * data, quint32 position, quint32 length)
+{
+    if (length == 0)
+        return;
+    if (_stream.isNull())
+        memcpy(data, &reinterpret_cast<const qint32*>(_baData.constData())[position], length * sizeof(qint32));
+    else
+        _stream->read(position, length, data);
+}
+
+void Voice::releaseAt(quint32 delay)
+{
+    if (delay == 0)
+        release();
+    else if (!_release)
+    {
+        _delayRelease = delay;
+        _releasePlanned = true;
+    }
+}
+
 void Voice::release(bool quick)
 {
-    _mutexParam.lock();
+    _releasePlanned = false;
     if (quick)
     {
         // Stopped by an exclusive class => quick release
         _enveloppeVol.quickRelease();
     }
     _release = true;
-    _mutexParam.unlock();
 }
 
-void Voice::setGain(double gain)
+void Voice::steal()
 {
-    _mutexParam.lock();
-    _gain = gain;
-    _mutexParam.unlock();
+    // Stolen by the voice manager => quick release
+    _enveloppeVol.quickRelease();
+    _release = true;
+    _isStolen = true;
 }
 
-void Voice::setChorus(int level, int depth, int frequency)
+void Voice::setGain(double gain)
 {
-    _mutexParam.lock();
-    _chorusLevel = level;
-    _chorus.setModDepth(0.00025 * depth);
-    _chorus.setModFrequency(0.06667 * frequency);
-    _mutexParam.unlock();
+    _gain = gain;
 }
 
 void Voice::biQuadCoefficients(double &a0, double &a1, double &a2, double &b1, double &b2, double freq, double Q)
@@ -352,67 +467,50 @@ void Voice::biQuadCoefficients(double &a0, double &a1, double &a2, double &b1, d
 
 double Voice::getPan()
 {
-    _mutexParam.lock();
-    double val = _voiceParam->getDouble(champ_pan);
-    _mutexParam.unlock();
-    return val;
+    return _voiceParam->getDouble(champ_pan);
 }
 
 int Voice::getExclusiveClass()
 {
-    _mutexParam.lock();
-    int val = _voiceParam->getInteger(champ_exclusiveClass);
-    _mutexParam.unlock();
-    return val;
+    return _voiceParam->getInteger(champ_exclusiveClass);
 }
 
 int Voice::getPresetNumber()
 {
-    _mutexParam.lock();
-    int val = _voiceParam->getInteger(champ_wPreset);
-    _mutexParam.unlock();
-    return val;
+    return _voiceParam->getInteger(champ_wPreset);
 }
 
 float Voice::getReverb()
 {
-    _mutexParam.lock();
-    float val = static_cast<float>(_voiceParam->getDouble(champ_reverbEffectsSend));
-    _mutexParam.unlock();
-    return val;
+    return static_cast<float>(_voiceParam->getDouble(champ_reverbEffectsSend));
+}
+
+float Voice::getChorus()
+{
+    return static_cast<float>(_voiceParam->getDouble(champ_chorusEffectsSend));
 }
 
 void Voice::setPan(double val)
 {
-    _mutexParam.lock();
     _voiceParam->setPan(val);
-    _mutexParam.unlock();
 }
 
 void Voice::setLoopMode(quint16 val)
 {
-    _mutexParam.lock();
     _voiceParam->setLoopMode(val);
-    _mutexParam.unlock();
 }
 
 void Voice::setLoopStart(quint32 val)
 {
-    _mutexParam.lock();
     _voiceParam->setLoopStart(val);
-    _mutexParam.unlock();
 }
 
 void Voice::setLoopEnd(quint32 val)
 {
-    _mutexParam.lock();
     _voiceParam->setLoopEnd(val);
-    _mutexParam.unlock();
 }
 
 void Voice::setFineTune(qint16 val)
 {
-    _mutexParam.lock();
     _voiceParam->setFineTune(val);
-    _mutexParam.unlock();
 }
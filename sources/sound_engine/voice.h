@@ -25,13 +25,16 @@
 #ifndef VOICE_H
 #define VOICE_H
 
-#include <QMutex>
 #include "sound.h"
 #include "enveloppevol.h"
 #include "oscsinus.h"
-#include "stk/Chorus.h"
-#include "stk/FreeVerb.h"
+#include "voicescratch.h"
+#include "resampler.h"
+#include "controllersnapshot.h"
+#include "samplestreamer.h"
+#include "profiler.h"
 
+// Once added to a sound engine, a voice is only accessed by the thread of this sound engine
 class Voice : public QObject
 {
     Q_OBJECT
@@ -41,23 +44,34 @@ public:
     // * -1 when we use "play" for reading a sample
     // * -2 when we want to read the stereo part of a sample, with "play"
     // >= 0 otherwise (sample, instrument or preset level)
-    Voice(QByteArray baData, quint32 smplRate, quint32 audioSmplRate, int initialKey, VoiceParam *voiceParam, int token);
+    // If "stream" is not null, the sample is read from it instead of baData
+    Voice(const QByteArray &baData, QSharedPointer<SampleStream> stream, quint32 smplRate, quint32 audioSmplRate, int initialKey, VoiceParam *voiceParam, int token);
     ~Voice();
 
     int getKey() { return _initialKey; }
     int getToken() { return _token; }
+    int getChannel() { return _channel; }
+    void setChannel(int channel) { _channel = channel; }
     void release(bool quick = false);
+    void releaseAt(quint32 delay); // Release after "delay" values, counted from the beginning of the next block
+    void steal();
+    bool isReleased() { return _release; }
+    bool isStolen() { return _isStolen; }
+    float getEnvelopeLevel() { return _enveloppeVol.getLevel(); }
     void setGain(double gain);
-    void setChorus(int level, int depth, int frequency);
     bool isFinished() { return _isFinished; }
     bool isRunning() { return _isRunning; }
     void runVoice(quint32 delay) { _isRunning = true; _delayStart = delay; }
 
+    // Time at which the voice has been created (see CircularBuffer::currentTime), returned only once and then 0
+    qint64 takeCreationTime() { qint64 time = _creationTime; _creationTime = 0; return time; }
+
     // Access to voiceParam properties
     double getPan();
     int getExclusiveClass();
     int getPresetNumber();
     float getReverb();
+    float getChorus();
 
     // Update voiceParam properties
     void setPan(double val);
@@ -65,48 +79,64 @@ public:
     void setLoopStart(quint32 val);
     void setLoopEnd(quint32 val);
     void setFineTune(qint16 val);
+    void setInterpolation(Resampler::InterpolationType type) { _interpolation = type; }
 
-    // Generate data
-    void generateData(float *dataL, float *dataR, quint32 len);
+    // Generate data, the working arrays and the MIDI values of the channel being provided by the sound engine
+    // The time spent in each stage is added to "stats" if not null
+    void generateData(float *dataL, float *dataR, quint32 len, VoiceScratch *scratch, const ControllerSnapshot &controllers,
+                      ProfilerStats * stats = nullptr);
 
 signals:
     void currentPosChanged(quint32 pos);
 
 private:
-    // Oscillators, envelopes and chorus
+    // Oscillators and envelopes
     OscSinus _modLFO, _vibLFO;
     EnveloppeVol _enveloppeVol, _enveloppeMod;
-    stk::Chorus _chorus;
-    int _chorusLevel;
 
-    // Sound data and parameters
+    // Sound data (shared with the sample, only read with constData() so that it is never copied) and parameters
     QByteArray _baData;
+    QSharedPointer<SampleStream> _stream;
     quint32 _smplRate, _audioSmplRate;
     double _gain;
     int _initialKey; // Only used to know which key triggered the sound, not for computing data
     VoiceParam * _voiceParam;
     int _token;
+    int _channel; // MIDI channel, the voice reading the controllers of this channel
+    qint64 _creationTime;
 
     // Sample playback
-    quint32 _currentSmplPos;
+    quint32 _currentSmplPos; // Read position, MAX_TAPS / 2 values after the played position
+    quint32 _valuesSinceWrap, _wrapEnd; // Values read since the last jump to the loop start, position before it
     double _time;
     bool _release;
-    quint32 _delayEnd, _delayStart;
+    bool _isStolen;
+    quint32 _delayEnd, _delayStart, _delayRelease;
+    bool _releasePlanned;
     bool _isFinished;
     bool _isRunning;
 
     // Save state for resampling
+    // The last MAX_TAPS / 2 values of the history have not been played yet
     float _deltaPos;
-    qint32 _valPrec, _valBase;
-
-    // Save state for low pass filter
-    double _x1, _x2, _y1, _y2;
-
+    qint32 _history[Resampler::MAX_TAPS];
+    Resampler::InterpolationType _interpolation;
+
+    // Save state for low pass filter (coefficients are updated every FILTER_STEP values)
+    // Single precision, the state being reset below FILTER_SILENCE so that it doesn't decay slowly through denormals
+    float _x1, _x2, _y1, _y2;
+    float _a0, _a1, _a2, _b1, _b2;
+    bool _filterInitialized;
+    static const quint32 FILTER_STEP;
+    static const float FILTER_SILENCE;
+
+    // Data generation, the release state being constant during "len" values
+    void generateBlock(float *dataL, float *dataR, quint32 len, VoiceScratch *scratch, const ControllerSnapshot &controllers,
+                       ProfilerStats * stats);
     bool takeData(qint32 *data, quint32 nbRead);
+    quint32 getPlayedPosition();
+    void copyData(qint32 *data, quint32 position, quint32 length);
     void biQuadCoefficients(double &a0, double &a1, double &a2, double &b1, double &b2, double freq, double Q);
-
-    // Protect parameters
-    QMutex _mutexParam;
 };
 
 #endif // VOICE_H
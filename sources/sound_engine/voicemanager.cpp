@@ -0,0 +1,147 @@
+/***************************************************************************
+**                                                                        **
+**  Polyphone, a soundfont editor                                         **
+**  Copyright (C) 2013-2019 Davy Triponney                                **
+**                                                                        **
+**  This program is free software: you can redistribute it and/or modify  **
+**  it under the terms of the GNU General Public License as published by  **
+**  the Free Software Foundation, either version 3 of the License, or     **
+**  (at your option) any later version.                                   **
+**                                                                        **
+**  This program is distributed in the hope that it will be useful,       **
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of        **
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the          **
+**  GNU General Public License for more details.                          **
+**                                                                        **
+**  You should have received a copy of the GNU General Public License     **
+**  along with this program. If not, see http://www.gnu.org/licenses/.    **
+**                                                                        **
+****************************************************************************
+**           Author: Davy Triponney                                       **
+**  Website/Contact: https://www.polyphone-soundfonts.com                 **
+**             Date: 01.01.2013                                           **
+***************************************************************************/
+
+
+#include "voicemanager.h"
+#include "voice.h"
+
+const int VoiceManager::MIN_POLYPHONY = 8;
+
+VoiceManager::VoiceManager() :
+    _maxPolyphony(256),
+    _adaptiveLimit(256),
+    _policy(STEALING_OLDEST_RELEASED),
+    _isAdaptive(false),
+    _sampleRate(0),
+    _load(0)
+{}
+
+void VoiceManager::configure(int maxPolyphony, StealingPolicy policy, bool isAdaptive, quint32 sampleRate)
+{
+    _maxPolyphony = qMax(maxPolyphony, 1);
+    _policy = policy;
+    _isAdaptive = isAdaptive;
+    _sampleRate = sampleRate;
+
+    // Start again with the maximum
+    _adaptiveLimit = _maxPolyphony;
+    _load = 0;
+}
+
+void VoiceManager::applyLimit(QList<Voice *> &voices, Voice * newVoice, int firstTokenOfNote)
+{
+    // Number of voices that count in the polyphony (voices for reading a sample are not included)
+    int count = 0;
+    foreach (Voice * voice, voices)
+        if (voice->getKey() >= 0 && !voice->isStolen())
+            count++;
+
+    int limit = getCurrentLimit();
+    while (count > limit)
+    {
+        Voice * voice = findVoiceToSteal(voices, newVoice, firstTokenOfNote);
+        if (voice == nullptr)
+            break;
+        voice->steal();
+        count--;
+    }
+}
+
+Voice * VoiceManager::findVoiceToSteal(QList<Voice *> &voices, Voice * newVoice, int firstTokenOfNote)
+{
+    Voice * oldest = nullptr;
+    Voice * oldestReleased = nullptr;
+    Voice * oldestSameKey = nullptr;
+    Voice * quietest = nullptr;
+    float minLevel = 0;
+
+    foreach (Voice * voice, voices)
+    {
+        if (voice == newVoice || voice->getKey() < 0 || voice->isStolen() || voice->getToken() >= firstTokenOfNote)
+            continue;
+
+        if (oldest == nullptr || voice->getToken() < oldest->getToken())
+            oldest = voice;
+        if (voice->isReleased() && (oldestReleased == nullptr || voice->getToken() < oldestReleased->getToken()))
+            oldestReleased = voice;
+        if (newVoice != nullptr && voice->getKey() == newVoice->getKey() && voice->getChannel() == newVoice->getChannel() &&
+                (oldestSameKey == nullptr || voice->getToken() < oldestSameKey->getToken()))
+            oldestSameKey = voice;
+
+        float level = voice->getEnvelopeLevel();
+        if (quietest == nullptr || level < minLevel)
+        {
+            quietest = voice;
+            minLevel = level;
+        }
+    }
+
+    switch (_policy)
+    {
+    case STEALING_QUIETEST:
+        return quietest;
+    case STEALING_SAME_KEY:
+        if (oldestSameKey != nullptr)
+            return oldestSameKey;
+        break;
+    default:
+        break;
+    }
+
+    // Oldest released voice or, if all voices are held, the oldest one
+    return oldestReleased != nullptr ? oldestReleased : oldest;
+}
+
+void VoiceManager::updateLoad(QList<Voice *> &voices, quint32 len, qint64 elapsedNs)
+{
+    if (!_isAdaptive || _sampleRate == 0 || len == 0)
+        return;
+
+    // Ratio between the computation time and the duration of the data
+    double load = 0.000000001 * static_cast<double>(elapsedNs) * _sampleRate / len;
+    _load = 0.9 * _load + 0.1 * load;
+
+    if (_load > 0.8)
+    {
+        // Too close to the deadline: less voices
+        int count = 0;
+        foreach (Voice * voice, voices)
+            if (voice->getKey() >= 0 && !voice->isStolen())
+                count++;
+        int limit = qMax(qMin(MIN_POLYPHONY, _maxPolyphony), qMin(_adaptiveLimit, count) * 9 / 10);
+        if (limit < _adaptiveLimit)
+        {
+            _adaptiveLimit = limit;
+            applyLimit(voices, nullptr, 0x7FFFFFFF);
+        }
+
+        // New measurements are needed before another change
+        _load = 0.65;
+    }
+    else if (_load < 0.5 && _adaptiveLimit < _maxPolyphony)
+    {
+        // Enough time: progressively go back to the maximum
+        _adaptiveLimit++;
+    }
+}
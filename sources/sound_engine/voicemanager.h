@@ -0,0 +1,75 @@
+/***************************************************************************
+**                                                                        **
+**  Polyphone, a soundfont editor                                         **
+**  Copyright (C) 2013-2019 Davy Triponney                                **
+**                                                                        **
+**  This program is free software: you can redistribute it and/or modify  **
+**  it under the terms of the GNU General Public License as published by  **
+**  the Free Software Foundation, either version 3 of the License, or     **
+**  (at your option) any later version.                                   **
+**                                                                        **
+**  This program is distributed in the hope that it will be useful,       **
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of        **
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the          **
+**  GNU General Public License for more details.                          **
+**                                                                        **
+**  You should have received a copy of the GNU General Public License     **
+**  along with this program. If not, see http://www.gnu.org/licenses/.    **
+**                                                                        **
+****************************************************************************
+**           Author: Davy Triponney                                       **
+**  Website/Contact: https://www.polyphone-soundfonts.com                 **
+**             Date: 01.01.2013                                           **
+***************************************************************************/
+
+
+#ifndef VOICEMANAGER_H
+#define VOICEMANAGER_H
+
+#include <QList>
+class Voice;
+
+// Limit the number of voices played by a sound engine
+// Voices above the limit are stolen: they end with a very short release
+// Only accessed by the thread of the sound engine
+class VoiceManager
+{
+public:
+    enum StealingPolicy
+    {
+        STEALING_OLDEST_RELEASED = 0,
+        STEALING_QUIETEST = 1,
+        STEALING_SAME_KEY = 2
+    };
+
+    VoiceManager();
+
+    // Maximum number of voices, stealing policy and possible adaptation of the limit according to the CPU load
+    // The load is not measured if sampleRate is 0
+    void configure(int maxPolyphony, StealingPolicy policy, bool isAdaptive, quint32 sampleRate);
+
+    // Steal voices if the limit is exceeded after "newVoice" has been added (can be nullptr)
+    // Voices having a token greater than or equal to firstTokenOfNote have been triggered
+    // by the same note than the new voice and are not stolen
+    void applyLimit(QList<Voice *> &voices, Voice * newVoice, int firstTokenOfNote);
+
+    // Adaptive mode: update the limit according to the time spent for computing "len" values
+    void updateLoad(QList<Voice *> &voices, quint32 len, qint64 elapsedNs);
+
+    // Current limit of the sound engine
+    int getCurrentLimit() { return _isAdaptive ? _adaptiveLimit : _maxPolyphony; }
+
+    // Minimum limit in the adaptive mode, whatever the load
+    static const int MIN_POLYPHONY;
+
+private:
+    Voice * findVoiceToSteal(QList<Voice *> &voices, Voice * newVoice, int firstTokenOfNote);
+
+    int _maxPolyphony, _adaptiveLimit;
+    StealingPolicy _policy;
+    bool _isAdaptive;
+    quint32 _sampleRate;
+    double _load; // Smoothed ratio between the computation time and the duration of the data computed
+};
+
+#endif // VOICEMANAGER_H
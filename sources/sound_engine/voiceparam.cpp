@@ -24,13 +24,15 @@
 
 #include "voiceparam.h"
 #include "qmath.h"
-#include "modulatedparameter.h"
 #include "soundfontmanager.h"
+#include "controllersnapshot.h"
 
 VoiceParam::VoiceParam(EltID idPrstInst, EltID idInstSmpl, EltID idSmpl, int key, int vel) :
     _sm(SoundfontManager::getInstance()),
-    _modulatorGroupInst(&_parameters, false),
-    _modulatorGroupPrst(&_parameters, true)
+    _modulatorGroupInst(_parameters, false),
+    _modulatorGroupPrst(_parameters, true),
+    _modulationsComputed(false),
+    _controllersVersion(-1)
 {
     // Prepare the parameters (everything to default)
     prepareParameters();
@@ -39,15 +41,15 @@ VoiceParam::VoiceParam(EltID idPrstInst, EltID idInstSmpl, EltID idSmpl, int key
     readSmpl(idSmpl);
     AttributeValue value;
     if (key < 0)
-        value.wValue = static_cast<quint16>(_parameters[champ_overridingRootKey]->getIntValue());
+        value.wValue = static_cast<quint16>(_parameters[champ_overridingRootKey].getIntValue());
     else
         value.wValue = static_cast<quint16>(key);
-    _parameters[champ_keynum]->initValue(value, false);
+    _parameters[champ_keynum].initValue(value, false);
     if (vel < 0)
         value.wValue = 127;
     else
         value.wValue = static_cast<quint16>(vel);
-    _parameters[champ_velocity]->initValue(value, false);
+    _parameters[champ_velocity].initValue(value, false);
 
     // Possibly add the configuration of the instrument level
     if (idInstSmpl.typeElement != elementUnknown)
@@ -63,8 +65,8 @@ VoiceParam::VoiceParam(EltID idPrstInst, EltID idInstSmpl, EltID idSmpl, int key
         _wPresetNumber = -1;
 
     // Initialize the modulator groups
-    int keyForComputation = _parameters[champ_keynum]->getIntValue();
-    int velForComputation = _parameters[champ_velocity]->getIntValue();
+    int keyForComputation = _parameters[champ_keynum].getIntValue();
+    int velForComputation = _parameters[champ_velocity].getIntValue();
     _modulatorGroupInst.initialize(key, keyForComputation, velForComputation);
     _modulatorGroupPrst.initialize(key, keyForComputation, velForComputation);
 
@@ -73,91 +75,86 @@ VoiceParam::VoiceParam(EltID idPrstInst, EltID idInstSmpl, EltID idSmpl, int key
         readDivisionModulators(idInstSmpl);
     if (idPrstInst.typeElement != elementUnknown)
         readDivisionModulators(idPrstInst);
-}
-
-VoiceParam::~VoiceParam()
-{
-    QList<AttributeType> attributeTypes = _parameters.keys();
-    foreach (AttributeType attributeType, attributeTypes)
-        delete _parameters.take(attributeType);
+    _modulatorGroupInst.prepare();
+    _modulatorGroupPrst.prepare();
 }
 
 void VoiceParam::prepareParameters()
 {
     // Offsets
-    _parameters[champ_startAddrsOffset] = new ModulatedParameter(champ_startAddrsOffset);
-    _parameters[champ_startAddrsCoarseOffset] = new ModulatedParameter(champ_startAddrsCoarseOffset);
-    _parameters[champ_endAddrsOffset] = new ModulatedParameter(champ_endAddrsOffset);
-    _parameters[champ_endAddrsCoarseOffset] = new ModulatedParameter(champ_endAddrsCoarseOffset);
-    _parameters[champ_startloopAddrsOffset] = new ModulatedParameter(champ_startloopAddrsOffset);
-    _parameters[champ_startloopAddrsCoarseOffset] = new ModulatedParameter(champ_startloopAddrsCoarseOffset);
-    _parameters[champ_endloopAddrsOffset] = new ModulatedParameter(champ_endloopAddrsOffset);
-    _parameters[champ_endloopAddrsCoarseOffset] = new ModulatedParameter(champ_endloopAddrsCoarseOffset);
+    _parameters[champ_startAddrsOffset].initialize(champ_startAddrsOffset);
+    _parameters[champ_startAddrsCoarseOffset].initialize(champ_startAddrsCoarseOffset);
+    _parameters[champ_endAddrsOffset].initialize(champ_endAddrsOffset);
+    _parameters[champ_endAddrsCoarseOffset].initialize(champ_endAddrsCoarseOffset);
+    _parameters[champ_startloopAddrsOffset].initialize(champ_startloopAddrsOffset);
+    _parameters[champ_startloopAddrsCoarseOffset].initialize(champ_startloopAddrsCoarseOffset);
+    _parameters[champ_endloopAddrsOffset].initialize(champ_endloopAddrsOffset);
+    _parameters[champ_endloopAddrsCoarseOffset].initialize(champ_endloopAddrsCoarseOffset);
 
     // Volume envelop
-    _parameters[champ_delayVolEnv] = new ModulatedParameter(champ_delayVolEnv);
-    _parameters[champ_attackVolEnv] = new ModulatedParameter(champ_attackVolEnv);
-    _parameters[champ_holdVolEnv] = new ModulatedParameter(champ_holdVolEnv);
-    _parameters[champ_decayVolEnv] = new ModulatedParameter(champ_decayVolEnv);
-    _parameters[champ_sustainVolEnv] = new ModulatedParameter(champ_sustainVolEnv);
-    _parameters[champ_releaseVolEnv] = new ModulatedParameter(champ_releaseVolEnv);
+    _parameters[champ_delayVolEnv].initialize(champ_delayVolEnv);
+    _parameters[champ_attackVolEnv].initialize(champ_attackVolEnv);
+    _parameters[champ_holdVolEnv].initialize(champ_holdVolEnv);
+    _parameters[champ_decayVolEnv].initialize(champ_decayVolEnv);
+    _parameters[champ_sustainVolEnv].initialize(champ_sustainVolEnv);
+    _parameters[champ_releaseVolEnv].initialize(champ_releaseVolEnv);
 
-    _parameters[champ_keynumToVolEnvHold] = new ModulatedParameter(champ_keynumToVolEnvHold);
-    _parameters[champ_keynumToVolEnvDecay] = new ModulatedParameter(champ_keynumToVolEnvDecay);
+    _parameters[champ_keynumToVolEnvHold].initialize(champ_keynumToVolEnvHold);
+    _parameters[champ_keynumToVolEnvDecay].initialize(champ_keynumToVolEnvDecay);
 
     // Modulation envelop
-    _parameters[champ_delayModEnv] = new ModulatedParameter(champ_delayModEnv);
-    _parameters[champ_attackModEnv] = new ModulatedParameter(champ_attackModEnv);
-    _parameters[champ_holdModEnv] = new ModulatedParameter(champ_holdModEnv);
-    _parameters[champ_decayModEnv] = new ModulatedParameter(champ_decayModEnv);
-    _parameters[champ_sustainModEnv] = new ModulatedParameter(champ_sustainModEnv);
-    _parameters[champ_releaseModEnv] = new ModulatedParameter(champ_releaseModEnv);
+    _parameters[champ_delayModEnv].initialize(champ_delayModEnv);
+    _parameters[champ_attackModEnv].initialize(champ_attackModEnv);
+    _parameters[champ_holdModEnv].initialize(champ_holdModEnv);
+    _parameters[champ_decayModEnv].initialize(champ_decayModEnv);
+    _parameters[champ_sustainModEnv].initialize(champ_sustainModEnv);
+    _parameters[champ_releaseModEnv].initialize(champ_releaseModEnv);
 
-    _parameters[champ_keynumToModEnvHold] = new ModulatedParameter(champ_keynumToModEnvHold);
-    _parameters[champ_keynumToModEnvDecay] = new ModulatedParameter(champ_keynumToModEnvDecay);
+    _parameters[champ_keynumToModEnvHold].initialize(champ_keynumToModEnvHold);
+    _parameters[champ_keynumToModEnvDecay].initialize(champ_keynumToModEnvDecay);
 
-    _parameters[champ_modEnvToFilterFc] = new ModulatedParameter(champ_modEnvToFilterFc);
-    _parameters[champ_modEnvToPitch] = new ModulatedParameter(champ_modEnvToPitch);
+    _parameters[champ_modEnvToFilterFc].initialize(champ_modEnvToFilterFc);
+    _parameters[champ_modEnvToPitch].initialize(champ_modEnvToPitch);
 
     // Modulation LFO
-    _parameters[champ_delayModLFO] = new ModulatedParameter(champ_delayModLFO);
-    _parameters[champ_freqModLFO] = new ModulatedParameter(champ_freqModLFO);
-    _parameters[champ_modLfoToPitch] = new ModulatedParameter(champ_modLfoToPitch);
-    _parameters[champ_modLfoToFilterFc] = new ModulatedParameter(champ_modLfoToFilterFc);
-    _parameters[champ_modLfoToVolume] = new ModulatedParameter(champ_modLfoToVolume);
+    _parameters[champ_delayModLFO].initialize(champ_delayModLFO);
+    _parameters[champ_freqModLFO].initialize(champ_freqModLFO);
+    _parameters[champ_modLfoToPitch].initialize(champ_modLfoToPitch);
+    _parameters[champ_modLfoToFilterFc].initialize(champ_modLfoToFilterFc);
+    _parameters[champ_modLfoToVolume].initialize(champ_modLfoToVolume);
 
     // Vibrato LFO
-    _parameters[champ_delayVibLFO] = new ModulatedParameter(champ_delayVibLFO);
-    _parameters[champ_freqVibLFO] = new ModulatedParameter(champ_freqVibLFO);
-    _parameters[champ_vibLfoToPitch] = new ModulatedParameter(champ_vibLfoToPitch);
+    _parameters[champ_delayVibLFO].initialize(champ_delayVibLFO);
+    _parameters[champ_freqVibLFO].initialize(champ_freqVibLFO);
+    _parameters[champ_vibLfoToPitch].initialize(champ_vibLfoToPitch);
 
     // Low pass filter and attenuation
-    _parameters[champ_initialFilterFc] = new ModulatedParameter(champ_initialFilterFc);
-    _parameters[champ_initialFilterQ] = new ModulatedParameter(champ_initialFilterQ);
-    _parameters[champ_initialAttenuation] = new ModulatedParameter(champ_initialAttenuation);
+    _parameters[champ_initialFilterFc].initialize(champ_initialFilterFc);
+    _parameters[champ_initialFilterQ].initialize(champ_initialFilterQ);
+    _parameters[champ_initialAttenuation].initialize(champ_initialAttenuation);
 
     // Effects, pan
-    _parameters[champ_chorusEffectsSend] = new ModulatedParameter(champ_chorusEffectsSend);
-    _parameters[champ_reverbEffectsSend] = new ModulatedParameter(champ_reverbEffectsSend);
-    _parameters[champ_pan] = new ModulatedParameter(champ_pan);
+    _parameters[champ_chorusEffectsSend].initialize(champ_chorusEffectsSend);
+    _parameters[champ_reverbEffectsSend].initialize(champ_reverbEffectsSend);
+    _parameters[champ_pan].initialize(champ_pan);
 
     // Tuning
-    _parameters[champ_coarseTune] = new ModulatedParameter(champ_coarseTune);
-    _parameters[champ_fineTune] = new ModulatedParameter(champ_fineTune);
-    _parameters[champ_scaleTuning] = new ModulatedParameter(champ_scaleTuning);
+    _parameters[champ_coarseTune].initialize(champ_coarseTune);
+    _parameters[champ_fineTune].initialize(champ_fineTune);
+    _parameters[champ_scaleTuning].initialize(champ_scaleTuning);
 
     // Other
-    _parameters[champ_overridingRootKey] = new ModulatedParameter(champ_overridingRootKey);
-    _parameters[champ_keynum] = new ModulatedParameter(champ_keynum);
-    _parameters[champ_velocity] = new ModulatedParameter(champ_velocity);
-    _parameters[champ_sampleModes] = new ModulatedParameter(champ_sampleModes);
-    _parameters[champ_exclusiveClass] = new ModulatedParameter(champ_exclusiveClass);
+    _parameters[champ_overridingRootKey].initialize(champ_overridingRootKey);
+    _parameters[champ_keynum].initialize(champ_keynum);
+    _parameters[champ_velocity].initialize(champ_velocity);
+    _parameters[champ_sampleModes].initialize(champ_sampleModes);
+    _parameters[champ_exclusiveClass].initialize(champ_exclusiveClass);
 }
 
 void VoiceParam::readSmpl(EltID idSmpl)
 {
     // Read sample properties
-    _parameters[champ_overridingRootKey]->initValue(_sm->get(idSmpl, champ_byOriginalPitch), false);
+    _parameters[champ_overridingRootKey].initValue(_sm->get(idSmpl, champ_byOriginalPitch), false);
     _sampleFineTune = _sm->get(idSmpl, champ_chPitchCorrection).cValue;
     _sampleLength = static_cast<qint32>(_sm->get(idSmpl, champ_dwLength).dwValue);
     _sampleLoopStart = static_cast<qint32>(_sm->get(idSmpl, champ_dwStartLoop).dwValue);
@@ -168,26 +165,24 @@ void VoiceParam::readDivisionAttributes(EltID idDivision)
 {
     bool isPrst = idDivision.isPrst();
 
-    // Load global attributes
-    EltID id(isPrst ? elementPrst : elementInst, idDivision.indexSf2, idDivision.indexElt);
-    QList<AttributeType> globalAttributeTypes;
-    QList<AttributeValue> globalAttributeValues;
-    _sm->getAllAttributes(id, globalAttributeTypes, globalAttributeValues);
-
     // Configure with the global attributes
-    for (int i = 0; i < globalAttributeTypes.count(); i++)
-        if (_parameters.contains(globalAttributeTypes[i]))
-            _parameters[globalAttributeTypes[i]]->initValue(globalAttributeValues[i], isPrst);
-
-    // Load division attributes
-    QList<AttributeType> divisionAttributeTypes;
-    QList<AttributeValue> divisionAttributeValues;
-    _sm->getAllAttributes(idDivision, divisionAttributeTypes, divisionAttributeValues);
+    EltID id(isPrst ? elementPrst : elementInst, idDivision.indexSf2, idDivision.indexElt);
+    QMapIterator<AttributeType, AttributeValue> globalAttributes(_sm->getAttributes(id));
+    while (globalAttributes.hasNext())
+    {
+        globalAttributes.next();
+        if (isParameter(globalAttributes.key()))
+            _parameters[globalAttributes.key()].initValue(globalAttributes.value(), isPrst);
+    }
 
     // Configure with the division attributes (possibly overriding it)
-    for (int i = 0; i < divisionAttributeTypes.count(); i++)
-        if (_parameters.contains(divisionAttributeTypes[i]))
-            _parameters[divisionAttributeTypes[i]]->initValue(divisionAttributeValues[i], isPrst);
+    QMapIterator<AttributeType, AttributeValue> divisionAttributes(_sm->getAttributes(idDivision));
+    while (divisionAttributes.hasNext())
+    {
+        divisionAttributes.next();
+        if (isParameter(divisionAttributes.key()))
+            _parameters[divisionAttributes.key()].initValue(divisionAttributes.value(), isPrst);
+    }
 }
 
 void VoiceParam::readDivisionModulators(EltID idDivision)
@@ -217,26 +212,26 @@ void VoiceParam::prepareForSmpl(int key, SFSampleLink link)
     // Calling a second time the same sample mute the first one
     AttributeValue value;
     value.wValue = static_cast<quint16>(key); // Not a problem if -1 is translated into an unsigned
-    _parameters[champ_exclusiveClass]->initValue(value, false);
+    _parameters[champ_exclusiveClass].initValue(value, false);
 
     // Default release
     value.shValue = static_cast<qint16>(qRound(1200. * qLn(0.2) / M_LN2));
-    _parameters[champ_releaseVolEnv]->initValue(value, false);
+    _parameters[champ_releaseVolEnv].initValue(value, false);
 
     // Pan
     switch (link)
     {
     case leftSample: case RomLeftSample:
         value.shValue = -500;
-        _parameters[champ_pan]->initValue(value, false);
+        _parameters[champ_pan].initValue(value, false);
         break;
     case rightSample: case RomRightSample:
         value.shValue = 500;
-        _parameters[champ_pan]->initValue(value, false);
+        _parameters[champ_pan].initValue(value, false);
         break;
     default:
         value.shValue = 0;
-        _parameters[champ_pan]->initValue(value, false);
+        _parameters[champ_pan].initValue(value, false);
         break;
     }
 }
@@ -245,14 +240,14 @@ void VoiceParam::setPan(double val)
 {
     AttributeValue value;
     value.shValue = static_cast<qint16>(qRound(val * 10.));
-    _parameters[champ_pan]->initValue(value, false);
+    _parameters[champ_pan].initValue(value, false);
 }
 
 void VoiceParam::setLoopMode(quint16 val)
 {
     AttributeValue value;
     value.wValue = val;
-    _parameters[champ_sampleModes]->initValue(value, false);
+    _parameters[champ_sampleModes].initValue(value, false);
 }
 
 void VoiceParam::setLoopStart(quint32 val)
@@ -272,8 +267,8 @@ void VoiceParam::setFineTune(qint16 val)
 
 double VoiceParam::getDouble(AttributeType type)
 {
-    if (_parameters.contains(type))
-        return _parameters[type]->getRealValue();
+    if (isParameter(type))
+        return _parameters[type].getRealValue();
 
     qDebug() << "VoiceParam: type" << type << "-" << Attribute::getDescription(type, false) << "not found";
     return 0.0;
@@ -284,8 +279,8 @@ qint32 VoiceParam::getInteger(AttributeType type)
     // Notes:
     // * if fineTune is required: add the finetune from the sample level
     // * if wPreset is required, it will be stored in a special variable
-    if (_parameters.contains(type))
-        return (type == champ_fineTune ? _sampleFineTune : 0) + _parameters[type]->getIntValue();
+    if (isParameter(type))
+        return (type == champ_fineTune ? _sampleFineTune : 0) + _parameters[type].getIntValue();
     if (type == champ_wPreset)
         return _wPresetNumber;
 
@@ -300,8 +295,8 @@ quint32 VoiceParam::getPosition(AttributeType type)
     switch (type)
     {
     case champ_dwStart16: { // Used here for computing the beginning
-        qint32 offset = _parameters[champ_startAddrsOffset]->getIntValue() +
-                32768 * _parameters[champ_startAddrsCoarseOffset]->getIntValue();
+        qint32 offset = _parameters[champ_startAddrsOffset].getIntValue() +
+                32768 * _parameters[champ_startAddrsCoarseOffset].getIntValue();
         if (offset < 0)
             result = 0;
         else
@@ -313,8 +308,8 @@ quint32 VoiceParam::getPosition(AttributeType type)
         }
     } break;
     case champ_dwLength: {
-        qint32 offset = _parameters[champ_endAddrsOffset]->getIntValue() +
-                32768 * _parameters[champ_endAddrsCoarseOffset]->getIntValue();
+        qint32 offset = _parameters[champ_endAddrsOffset].getIntValue() +
+                32768 * _parameters[champ_endAddrsCoarseOffset].getIntValue();
         if (_sampleLength + offset < 0)
             result = 0;
         else if (offset > 0)
@@ -323,8 +318,8 @@ quint32 VoiceParam::getPosition(AttributeType type)
             result = static_cast<quint32>(_sampleLength + offset);
     } break;
     case champ_dwStartLoop: {
-        qint32 offset = _parameters[champ_startloopAddrsOffset]->getIntValue() +
-                32768 * _parameters[champ_startloopAddrsCoarseOffset]->getIntValue();
+        qint32 offset = _parameters[champ_startloopAddrsOffset].getIntValue() +
+                32768 * _parameters[champ_startloopAddrsCoarseOffset].getIntValue();
         if (_sampleLoopStart + offset < 0)
             result = 0;
         else
@@ -336,8 +331,8 @@ quint32 VoiceParam::getPosition(AttributeType type)
         }
     } break;
     case champ_dwEndLoop: {
-        qint32 offset = _parameters[champ_endloopAddrsOffset]->getIntValue() +
-                32768 * _parameters[champ_endloopAddrsCoarseOffset]->getIntValue();
+        qint32 offset = _parameters[champ_endloopAddrsOffset].getIntValue() +
+                32768 * _parameters[champ_endloopAddrsCoarseOffset].getIntValue();
         if (_sampleLoopEnd + offset < 0)
             result = 0;
         else
@@ -355,13 +350,19 @@ quint32 VoiceParam::getPosition(AttributeType type)
     return result;
 }
 
-void VoiceParam::computeModulations()
+void VoiceParam::computeModulations(const ControllerSnapshot &controllers)
 {
+    // The modulations only depend on the controllers, the key and the velocity
+    if (_modulationsComputed && controllers.version == _controllersVersion)
+        return;
+    _modulationsComputed = true;
+    _controllersVersion = controllers.version;
+
     // First clear all modulations
-    foreach (ModulatedParameter * parameter, _parameters)
-        parameter->clearModulations();
+    for (int i = 0; i < champ_endOper; i++)
+        _parameters[i].clearModulations();
 
     // Process modulators
-    _modulatorGroupInst.process();
-    _modulatorGroupPrst.process();
+    _modulatorGroupInst.process(controllers);
+    _modulatorGroupPrst.process(controllers);
 }
@@ -27,8 +27,9 @@
 
 #include "basetypes.h"
 #include "modulatorgroup.h"
+#include "modulatedparameter.h"
 class SoundfontManager;
-class ModulatedParameter;
+struct ControllerSnapshot;
 
 // Class gathering all parameters useful to create a sound
 // Parameters can evolve in real-time depending on the modulators
@@ -46,11 +47,9 @@ public:
     void setLoopEnd(quint32 val);
     void setFineTune(qint16 val);
 
-    // Destructor
-    ~VoiceParam();
-
     // Update parameters before reading them (modulators)
-    void computeModulations();
+    // Nothing is done if the controllers didn't change since the last call
+    void computeModulations(const ControllerSnapshot &controllers);
 
     // Get a param
     double getDouble(AttributeType type);
@@ -60,14 +59,17 @@ public:
 private:
     SoundfontManager * _sm;
 
-    // All parameters
-    QMap<AttributeType, ModulatedParameter *> _parameters;
+    // All parameters, indexed by AttributeType (only those that are initialized are used)
+    ModulatedParameter _parameters[champ_endOper];
     ModulatorGroup _modulatorGroupInst, _modulatorGroupPrst;
+    bool _modulationsComputed;
+    int _controllersVersion;
     qint32 _sampleLength, _sampleLoopStart, _sampleLoopEnd, _sampleFineTune;
     qint32 _wPresetNumber;
 
     // Initialization of the parameters
     void prepareParameters();
+    bool isParameter(AttributeType type) { return type >= 0 && type < champ_endOper && _parameters[type].isUsed(); }
     void readSmpl(EltID idSmpl);
     void readDivisionAttributes(EltID idDivision);
     void readDivisionModulators(EltID idDivision);
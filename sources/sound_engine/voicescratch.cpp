@@ -0,0 +1,71 @@
+/***************************************************************************
+**                                                                        **
+**  Polyphone, a soundfont editor                                         **
+**  Copyright (C) 2013-2019 Davy Triponney                                **
+**                                                                        **
+**  This program is free software: you can redistribute it and/or modify  **
+**  it under the terms of the GNU General Public License as published by  **
+**  the Free Software Foundation, either version 3 of the License, or     **
+**  (at your option) any later version.                                   **
+**                                                                        **
+**  This program is distributed in the hope that it will be useful,       **
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of        **
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the          **
+**  GNU General Public License for more details.                          **
+**                                                                        **
+**  You should have received a copy of the GNU General Public License     **
+**  along with this program. If not, see http://www.gnu.org/licenses/.    **
+**                                                                        **
+****************************************************************************
+**           Author: Davy Triponney                                       **
+**  Website/Contact: https://www.polyphone-soundfonts.com                 **
+**             Date: 01.01.2013                                           **
+***************************************************************************/
+
+
+#include "voicescratch.h"
+#include "resampler.h"
+
+const quint32 VoiceScratch::MAX_PITCH_RATIO = 64;
+QAtomicInt VoiceScratch::s_allocationCount(0);
+
+VoiceScratch::VoiceScratch(quint32 maxLength)
+{
+    allocate(maxLength);
+}
+
+VoiceScratch::~VoiceScratch()
+{
+    release();
+}
+
+void VoiceScratch::reserve(quint32 len)
+{
+    if (len <= _maxLength)
+        return;
+
+    // Not expected: the sound engine asked for more data than the size of the buffers
+    // (only counted here, the number being reported outside the audio thread)
+    s_allocationCount.fetchAndAddRelaxed(1);
+    release();
+    allocate(len);
+}
+
+void VoiceScratch::allocate(quint32 maxLength)
+{
+    _maxLength = maxLength;
+    _dataMod = new float[maxLength + 1];
+    _modLfo = new float[maxLength + 1];
+    _vibLfo = new float[maxLength + 1];
+    _modPitch = new float[maxLength + 1];
+    _dataTmp = new qint32[MAX_PITCH_RATIO * maxLength + Resampler::MAX_TAPS];
+}
+
+void VoiceScratch::release()
+{
+    delete [] _dataMod;
+    delete [] _modLfo;
+    delete [] _vibLfo;
+    delete [] _modPitch;
+    delete [] _dataTmp;
+}
@@ -0,0 +1,70 @@
+/***************************************************************************
+**                                                                        **
+**  Polyphone, a soundfont editor                                         **
+**  Copyright (C) 2013-2019 Davy Triponney                                **
+**                                                                        **
+**  This program is free software: you can redistribute it and/or modify  **
+**  it under the terms of the GNU General Public License as published by  **
+**  the Free Software Foundation, either version 3 of the License, or     **
+**  (at your option) any later version.                                   **
+**                                                                        **
+**  This program is distributed in the hope that it will be useful,       **
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of        **
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the          **
+**  GNU General Public License for more details.                          **
+**                                                                        **
+**  You should have received a copy of the GNU General Public License     **
+**  along with this program. If not, see http://www.gnu.org/licenses/.    **
+**                                                                        **
+****************************************************************************
+**           Author: Davy Triponney                                       **
+**  Website/Contact: https://www.polyphone-soundfonts.com                 **
+**             Date: 01.01.2013                                           **
+***************************************************************************/
+
+
+#ifndef VOICESCRATCH_H
+#define VOICESCRATCH_H
+
+#include <QtGlobal>
+#include <QAtomicInt>
+
+// Working buffers borrowed by the voices of a sound engine while they compute data
+// Everything is allocated once so that no allocation occurs in the audio threads
+class VoiceScratch
+{
+public:
+    VoiceScratch(quint32 maxLength);
+    ~VoiceScratch();
+
+    // Make sure that a block of "len" values can be computed
+    // An allocation is done (and counted) only if the buffers are too small
+    void reserve(quint32 len);
+
+    // Buffers for computing a block, length is at least "len + 1"
+    float * dataMod() { return _dataMod; }
+    float * modLfo() { return _modLfo; }
+    float * vibLfo() { return _vibLfo; }
+    float * modPitch() { return _modPitch; }
+
+    // Buffer for reading the sample before resampling, length is at least "MAX_PITCH_RATIO * len + Resampler::MAX_TAPS"
+    qint32 * dataTmp() { return _dataTmp; }
+
+    // Number of allocations made after the initialization, by all scratches (should stay 0)
+    static int getAllocationCount() { return s_allocationCount.load(); }
+
+    // Maximum distance between two points read in the sample
+    static const quint32 MAX_PITCH_RATIO;
+
+private:
+    void allocate(quint32 maxLength);
+    void release();
+
+    quint32 _maxLength;
+    float * _dataMod, * _modLfo, * _vibLfo, * _modPitch;
+    qint32 * _dataTmp;
+
+    static QAtomicInt s_allocationCount;
+};
+
+#endif // VOICESCRATCH_H
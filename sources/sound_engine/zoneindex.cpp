@@ -0,0 +1,109 @@
+/***************************************************************************
+**                                                                        **
+**  Polyphone, a soundfont editor                                         **
+**  Copyright (C) 2013-2019 Davy Triponney                                **
+**                                                                        **
+**  This program is free software: you can redistribute it and/or modify  **
+**  it under the terms of the GNU General Public License as published by  **
+**  the Free Software Foundation, either version 3 of the License, or     **
+**  (at your option) any later version.                                   **
+**                                                                        **
+**  This program is distributed in the hope that it will be useful,       **
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of        **
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the          **
+**  GNU General Public License for more details.                          **
+**                                                                        **
+**  You should have received a copy of the GNU General Public License     **
+**  along with this program. If not, see http://www.gnu.org/licenses/.    **
+**                                                                        **
+****************************************************************************
+**           Author: Davy Triponney                                       **
+**  Website/Contact: https://www.polyphone-soundfonts.com                 **
+**             Date: 01.01.2013                                           **
+***************************************************************************/
+
+
+#include "zoneindex.h"
+#include "soundfontmanager.h"
+
+ZoneIndex::ZoneIndex(SoundfontManager * sf2, EltID id)
+{
+    // Default range of the element
+    RangesType defaultKeyRange, defaultVelRange;
+    if (sf2->isSet(id, champ_keyRange))
+        defaultKeyRange = sf2->get(id, champ_keyRange).rValue;
+    else
+    {
+        defaultKeyRange.byLo = 0;
+        defaultKeyRange.byHi = 127;
+    }
+    if (sf2->isSet(id, champ_velRange))
+        defaultVelRange = sf2->get(id, champ_velRange).rValue;
+    else
+    {
+        defaultVelRange.byLo = 0;
+        defaultVelRange.byHi = 127;
+    }
+
+    // Ranges of all divisions
+    bool isInst = (id.typeElement == elementInst);
+    EltID idDiv(isInst ? elementInstSmpl : elementPrstInst, id.indexSf2, id.indexElt, 0, 0);
+    QVector<Zone> divisions;
+    QVector<int> keyMins, keyMaxs;
+    RangesType rangeTmp;
+    SiblingIterator it(sf2, idDiv);
+    while (it.hasNext())
+    {
+        idDiv.indexElt2 = it.next();
+        const QMap<AttributeType, AttributeValue> attributes = sf2->getAttributes(idDiv);
+        Zone zone;
+        zone.division = idDiv.indexElt2;
+        zone.target = attributes.value(isInst ? champ_sampleID : champ_instrument).wValue;
+
+        int keyMin, keyMax;
+        if (attributes.contains(champ_keyRange))
+        {
+            rangeTmp = attributes[champ_keyRange].rValue;
+            keyMin = rangeTmp.byLo;
+            keyMax = rangeTmp.byHi;
+        }
+        else
+        {
+            keyMin = defaultKeyRange.byLo;
+            keyMax = defaultKeyRange.byHi;
+        }
+        if (attributes.contains(champ_velRange))
+        {
+            rangeTmp = attributes[champ_velRange].rValue;
+            zone.velMin = rangeTmp.byLo;
+            zone.velMax = rangeTmp.byHi;
+        }
+        else
+        {
+            zone.velMin = defaultVelRange.byLo;
+            zone.velMax = defaultVelRange.byHi;
+        }
+
+        divisions << zone;
+        keyMins << qMax(keyMin, 0);
+        keyMaxs << qMin(keyMax, 127);
+    }
+
+    // Number of zones per key, then offsets
+    int count[128];
+    memset(count, 0, sizeof(count));
+    for (int i = 0; i < divisions.size(); i++)
+        for (int key = keyMins[i]; key <= keyMaxs[i]; key++)
+            count[key]++;
+    _firstZone[0] = 0;
+    for (int key = 0; key < 128; key++)
+        _firstZone[key + 1] = _firstZone[key] + count[key];
+
+    // Fill the zones, keeping the order of the divisions for each key
+    _zones.resize(_firstZone[128]);
+    int position[128];
+    memcpy(position, _firstZone, sizeof(position));
+    for (int i = 0; i < divisions.size(); i++)
+        for (int key = keyMins[i]; key <= keyMaxs[i]; key++)
+            _zones[position[key]++] = divisions[i];
+}
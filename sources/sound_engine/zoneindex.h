@@ -0,0 +1,60 @@
+/***************************************************************************
+**                                                                        **
+**  Polyphone, a soundfont editor                                         **
+**  Copyright (C) 2013-2019 Davy Triponney                                **
+**                                                                        **
+**  This program is free software: you can redistribute it and/or modify  **
+**  it under the terms of the GNU General Public License as published by  **
+**  the Free Software Foundation, either version 3 of the License, or     **
+**  (at your option) any later version.                                   **
+**                                                                        **
+**  This program is distributed in the hope that it will be useful,       **
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of        **
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the          **
+**  GNU General Public License for more details.                          **
+**                                                                        **
+**  You should have received a copy of the GNU General Public License     **
+**  along with this program. If not, see http://www.gnu.org/licenses/.    **
+**                                                                        **
+****************************************************************************
+**           Author: Davy Triponney                                       **
+**  Website/Contact: https://www.polyphone-soundfonts.com                 **
+**             Date: 01.01.2013                                           **
+***************************************************************************/
+
+
+#ifndef ZONEINDEX_H
+#define ZONEINDEX_H
+
+#include "basetypes.h"
+#include <QVector>
+class SoundfontManager;
+
+// Divisions of an instrument or a preset that can be triggered by each key, so that a note
+// doesn't browse all divisions of an element
+// The index is a snapshot: it must be built again after the element has been edited
+class ZoneIndex
+{
+public:
+    struct Zone
+    {
+        int division;   // indexElt2 of the instsmpl or prstinst
+        int target;     // Sample (instrument level) or instrument (preset level) triggered
+        quint8 velMin;
+        quint8 velMax;
+    };
+
+    // "id" is an instrument or a preset
+    ZoneIndex(SoundfontManager * sf2, EltID id);
+
+    // Zones triggered by a key, the velocity is still to be checked
+    // Divisions are in the order of the soundfont
+    const Zone * zonesBegin(int key) const { return _zones.constData() + _firstZone[key]; }
+    const Zone * zonesEnd(int key) const { return _zones.constData() + _firstZone[key + 1]; }
+
+private:
+    QVector<Zone> _zones; // Zones sorted by key, a zone covering several keys is repeated
+    int _firstZone[129];
+};
+
+#endif // ZONEINDEX_H
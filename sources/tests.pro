@@ -0,0 +1,23 @@
+#-------------------------------------------------
+#
+# Tests of Polyphone
+#
+# Same sources as Polyphone except the entry point, build it in a separate directory:
+#   mkdir build-tests && cd build-tests
+#   qmake ../tests.pro && make
+#   ./polyphone-tests
+#
+#-------------------------------------------------
+
+include(polyphone.pro)
+
+TARGET = polyphone-tests
+QT += testlib
+SOURCES -= main.cpp
+SOURCES += tests/main.cpp \
+    tests/offlinerenderertest.cpp
+HEADERS += tests/offlinerenderertest.h
+INCLUDEPATH += tests
+
+# Nothing to install
+INSTALLS =
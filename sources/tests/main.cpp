@@ -0,0 +1,56 @@
+/***************************************************************************
+**                                                                        **
+**  Polyphone, a soundfont editor                                         **
+**  Copyright (C) 2013-2019 Davy Triponney                                **
+**                                                                        **
+**  This program is free software: you can redistribute it and/or modify  **
+**  it under the terms of the GNU General Public License as published by  **
+**  the Free Software Foundation, either version 3 of the License, or     **
+**  (at your option) any later version.                                   **
+**                                                                        **
+**  This program is distributed in the hope that it will be useful,       **
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of        **
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the          **
+**  GNU General Public License for more details.                          **
+**                                                                        **
+**  You should have received a copy of the GNU General Public License     **
+**  along with this program. If not, see http://www.gnu.org/licenses/.    **
+**                                                                        **
+****************************************************************************
+**           Author: Davy Triponney                                       **
+**  Website/Contact: https://www.polyphone-soundfonts.com                 **
+**             Date: 01.01.2013                                           **
+***************************************************************************/
+
+
+#include <QApplication>
+#include <QTest>
+#include "offlinerenderertest.h"
+#include "contextmanager.h"
+#include "soundfontmanager.h"
+#include "utils.h"
+
+// Usage: polyphone-tests [QTest options]
+int main(int argc, char *argv[])
+{
+    // No display required
+    if (qEnvironmentVariableIsEmpty("QT_QPA_PLATFORM"))
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+
+    Utils::prepareConversionTables();
+    QApplication app(argc, argv);
+
+    // Configuration not shared with Polyphone, so that the default parameters are used
+    QApplication::setApplicationName("Polyphone tests");
+    QApplication::setOrganizationName("polyphone");
+    ContextManager::initializeNoAudioMidi();
+
+    int valRet = 0;
+    {
+        OfflineRendererTest offlineRendererTest;
+        valRet |= QTest::qExec(&offlineRendererTest, argc, argv);
+    }
+
+    SoundfontManager::kill();
+    return valRet;
+}
@@ -0,0 +1,247 @@
+/***************************************************************************
+**                                                                        **
+**  Polyphone, a soundfont editor                                         **
+**  Copyright (C) 2013-2019 Davy Triponney                                **
+**                                                                        **
+**  This program is free software: you can redistribute it and/or modify  **
+**  it under the terms of the GNU General Public License as published by  **
+**  the Free Software Foundation, either version 3 of the License, or     **
+**  (at your option) any later version.                                   **
+**                                                                        **
+**  This program is distributed in the hope that it will be useful,       **
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of        **
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the          **
+**  GNU General Public License for more details.                          **
+**                                                                        **
+**  You should have received a copy of the GNU General Public License     **
+**  along with this program. If not, see http://www.gnu.org/licenses/.    **
+**                                                                        **
+****************************************************************************
+**           Author: Davy Triponney                                       **
+**  Website/Contact: https://www.polyphone-soundfonts.com                 **
+**             Date: 01.01.2013                                           **
+***************************************************************************/
+
+
+#include "offlinerenderertest.h"
+#include "offlinerenderer.h"
+#include "midifilereader.h"
+#include "contextmanager.h"
+#include "soundfontmanager.h"
+#include <QTest>
+#include <QFile>
+#include <QtMath>
+
+void OfflineRendererTest::initTestCase()
+{
+    QVERIFY(_dir.isValid());
+    createSoundfont();
+}
+
+void OfflineRendererTest::createSoundfont()
+{
+    SoundfontManager * sm = SoundfontManager::getInstance();
+    _sf2Index = sm->add(EltID(elementSf2));
+    sm->set(EltID(elementSf2, _sf2Index), champ_name, QString("test"));
+
+    // Sine of 441 Hz (period of 100 values), looped
+    QVector<float> sine(44100);
+    QByteArray baData;
+    baData.resize(2 * sine.size());
+    qint16 * data16 = reinterpret_cast<qint16 *>(baData.data());
+    for (int i = 0; i < sine.size(); i++)
+        data16[i] = static_cast<qint16>(0.25 * 32768. * qSin(2. * M_PI * i / 100.));
+
+    EltID idSmpl(elementSmpl, _sf2Index);
+    idSmpl.indexElt = sm->add(idSmpl);
+    sm->set(idSmpl, champ_name, QString("sine"));
+    sm->set(idSmpl, champ_sampleData16, baData);
+    AttributeValue value;
+    value.dwValue = static_cast<quint32>(sine.size());
+    sm->set(idSmpl, champ_dwLength, value);
+    value.dwValue = 44100;
+    sm->set(idSmpl, champ_dwSampleRate, value);
+    value.wValue = 69;
+    sm->set(idSmpl, champ_byOriginalPitch, value);
+    value.cValue = 0;
+    sm->set(idSmpl, champ_chPitchCorrection, value);
+    value.dwValue = 400;
+    sm->set(idSmpl, champ_dwStartLoop, value);
+    value.dwValue = static_cast<quint32>(sine.size()) - 400;
+    sm->set(idSmpl, champ_dwEndLoop, value);
+    value.sfLinkValue = monoSample;
+    sm->set(idSmpl, champ_sfSampleType, value);
+
+    // Instrument with one looped division covering all keys
+    EltID idInst(elementInst, _sf2Index);
+    idInst.indexElt = sm->add(idInst);
+    sm->set(idInst, champ_name, QString("sine"));
+    EltID idInstSmpl(elementInstSmpl, _sf2Index, idInst.indexElt);
+    idInstSmpl.indexElt2 = sm->add(idInstSmpl);
+    value.wValue = static_cast<quint16>(idSmpl.indexElt);
+    sm->set(idInstSmpl, champ_sampleID, value);
+    value.rValue.byLo = 0;
+    value.rValue.byHi = 127;
+    sm->set(idInstSmpl, champ_keyRange, value);
+    value.wValue = 1;
+    sm->set(idInstSmpl, champ_sampleModes, value);
+
+    // Preset 000:000 using the instrument
+    EltID idPrst(elementPrst, _sf2Index);
+    idPrst.indexElt = sm->add(idPrst);
+    sm->set(idPrst, champ_name, QString("sine"));
+    value.wValue = 0;
+    sm->set(idPrst, champ_wPreset, value);
+    sm->set(idPrst, champ_wBank, value);
+    EltID idPrstInst(elementPrstInst, _sf2Index, idPrst.indexElt);
+    idPrstInst.indexElt2 = sm->add(idPrstInst);
+    value.wValue = static_cast<quint16>(idInst.indexElt);
+    sm->set(idPrstInst, champ_instrument, value);
+    value.rValue.byLo = 0;
+    value.rValue.byHi = 127;
+    sm->set(idPrstInst, champ_keyRange, value);
+
+    sm->clearNewEditing();
+}
+
+void OfflineRendererTest::volumeAndBend()
+{
+    // 480 ticks per quarter note with the default tempo: 0.5 second
+    // The volume is lowered after 0.5 second, the pitch is bent to the maximum after 1 second
+    QByteArray track;
+    track.append("\x00\x90\x45\x7F", 4); // Note on A4
+    track.append("\x83\x60\xB0\x07\x40", 5); // CC7 = 64
+    track.append("\x83\x60\xE0\x7F\x7F", 5); // Bend +2 semitones (default sensitivity)
+    track.append("\x83\x60\x80\x45\x00", 5); // Note off
+    track.append("\x00\xFF\x2F\x00", 4); // End of track
+    QString midiFile = _dir.filePath("test.mid");
+    QVERIFY(writeMidiFile(midiFile, track));
+
+    MidiFileReader midiReader(midiFile);
+    midiReader.process();
+    QVERIFY2(midiReader.isSuccess(), midiReader.getError().toLocal8Bit().constData());
+
+    QString wavFile = _dir.filePath("test.wav");
+    {
+        OfflineRenderer renderer(ContextManager::configuration(), _sf2Index);
+        renderer.process(midiReader.getEvents(), wavFile);
+        QVERIFY2(renderer.isSuccess(), renderer.getError().toLocal8Bit().constData());
+        QVERIFY(renderer.getDuration() > 1.5);
+    }
+
+    quint32 sampleRate = 0;
+    QVector<float> data = readWav24(wavFile, sampleRate);
+    QCOMPARE(sampleRate, 44100u);
+    QVERIFY(data.size() > static_cast<int>(1.5 * sampleRate));
+
+    // Main volume: about -12 dB, same pitch
+    int fullStart = static_cast<int>(0.1 * sampleRate), fullEnd = static_cast<int>(0.4 * sampleRate);
+    int volumeStart = static_cast<int>(0.6 * sampleRate), volumeEnd = static_cast<int>(0.9 * sampleRate);
+    int bendStart = static_cast<int>(1.1 * sampleRate), bendEnd = static_cast<int>(1.4 * sampleRate);
+    double fullRms = getRms(data, fullStart, fullEnd);
+    double volumeRms = getRms(data, volumeStart, volumeEnd);
+    QVERIFY(fullRms > 0.01);
+    QVERIFY2(volumeRms < 0.5 * fullRms && volumeRms > 0.1 * fullRms,
+             QString("RMS %1 => %2").arg(fullRms).arg(volumeRms).toLocal8Bit().constData());
+
+    double fullFrequency = getFrequency(data, fullStart, fullEnd, sampleRate);
+    double volumeFrequency = getFrequency(data, volumeStart, volumeEnd, sampleRate);
+    QVERIFY2(qAbs(fullFrequency - 441.) < 1.,
+             QString("frequency %1").arg(fullFrequency).toLocal8Bit().constData());
+    QVERIFY2(qAbs(volumeFrequency - fullFrequency) < 1.,
+             QString("frequency %1 => %2").arg(fullFrequency).arg(volumeFrequency).toLocal8Bit().constData());
+
+    // Bend: 2 semitones higher
+    double bendFrequency = getFrequency(data, bendStart, bendEnd, sampleRate);
+    double ratio = bendFrequency / fullFrequency;
+    QVERIFY2(qAbs(ratio - qPow(2., 2. / 12.)) < 0.01,
+             QString("frequency %1 => %2").arg(fullFrequency).arg(bendFrequency).toLocal8Bit().constData());
+}
+
+bool OfflineRendererTest::writeMidiFile(QString fileName, const QByteArray &track)
+{
+    QFile file(fileName);
+    if (!file.open(QIODevice::WriteOnly))
+        return false;
+
+    // Format 0, 1 track, 480 ticks per quarter note
+    QByteArray data("MThd\x00\x00\x00\x06\x00\x00\x00\x01\x01\xE0", 14);
+    data.append("MTrk", 4);
+    data.append(static_cast<char>((track.size() >> 24) & 0xFF));
+    data.append(static_cast<char>((track.size() >> 16) & 0xFF));
+    data.append(static_cast<char>((track.size() >> 8) & 0xFF));
+    data.append(static_cast<char>(track.size() & 0xFF));
+    data.append(track);
+    return file.write(data) == data.size();
+}
+
+QVector<float> OfflineRendererTest::readWav24(QString fileName, quint32 &sampleRate)
+{
+    // First channel of a 24-bit stereo wav file
+    QVector<float> result;
+    QFile file(fileName);
+    if (!file.open(QIODevice::ReadOnly))
+        return result;
+    QByteArray data = file.readAll();
+    const uchar * raw = reinterpret_cast<const uchar *>(data.constData());
+    if (data.size() < 12 || !data.startsWith("RIFF") || data.mid(8, 4) != "WAVE")
+        return result;
+
+    // Browse the chunks
+    int pos = 12;
+    while (pos + 8 <= data.size())
+    {
+        QByteArray name = data.mid(pos, 4);
+        int size = static_cast<int>(raw[pos + 4] | (raw[pos + 5] << 8) | (raw[pos + 6] << 16) | (raw[pos + 7] << 24));
+        pos += 8;
+        if (name == "fmt " && size >= 16)
+        {
+            sampleRate = raw[pos + 4] | (raw[pos + 5] << 8) | (raw[pos + 6] << 16) | (raw[pos + 7] << 24);
+            int channelNumber = raw[pos + 2] | (raw[pos + 3] << 8);
+            int bitsPerSample = raw[pos + 14] | (raw[pos + 15] << 8);
+            if (channelNumber != 2 || bitsPerSample != 24)
+                return result;
+        }
+        else if (name == "data")
+        {
+            int frameNumber = qMin(size, data.size() - pos) / 6;
+            result.resize(frameNumber);
+            for (int i = 0; i < frameNumber; i++)
+            {
+                const uchar * value = &raw[pos + 6 * i];
+                result[i] = static_cast<float>(static_cast<qint32>((value[0] << 8) | (value[1] << 16) | (value[2] << 24)) >> 8)
+                        / 8388608.f;
+            }
+            return result;
+        }
+        pos += size + (size & 1);
+    }
+    return result;
+}
+
+double OfflineRendererTest::getRms(const QVector<float> &data, int start, int end)
+{
+    double sum = 0;
+    for (int i = start; i < end; i++)
+        sum += static_cast<double>(data[i]) * data[i];
+    return end > start ? qSqrt(sum / (end - start)) : 0;
+}
+
+double OfflineRendererTest::getFrequency(const QVector<float> &data, int start, int end, quint32 sampleRate)
+{
+    // Rising zero crossings, interpolated between two values
+    double firstCrossing = -1, lastCrossing = -1;
+    int crossingNumber = 0;
+    for (int i = start + 1; i < end; i++)
+    {
+        if (data[i - 1] < 0 && data[i] >= 0)
+        {
+            double crossing = i - 1 + static_cast<double>(data[i - 1]) / (data[i - 1] - data[i]);
+            if (firstCrossing < 0)
+                firstCrossing = crossing;
+            lastCrossing = crossing;
+            crossingNumber++;
+        }
+    }
+    return crossingNumber > 1 ? (crossingNumber - 1) * sampleRate / (lastCrossing - firstCrossing) : 0;
+}
@@ -1,7 +1,7 @@
 /***************************************************************************
 **                                                                        **
 **  Polyphone, a soundfont editor                                         **
-**  Copyright (C) 2013-2020 Davy Triponney                                **
+**  Copyright (C) 2013-2019 Davy Triponney                                **
 **                                                                        **
 **  This program is free software: you can redistribute it and/or modify  **
 **  it under the terms of the GNU General Public License as published by  **
@@ -22,31 +22,32 @@
 **             Date: 01.01.2013                                           **
 ***************************************************************************/
 
-#ifndef NOTEEVENT_H
-#define NOTEEVENT_H
 
-#include <QEvent>
+#ifndef OFFLINERENDERERTEST_H
+#define OFFLINERENDERERTEST_H
 
-class NoteEvent : public QEvent
+#include <QObject>
+#include <QTemporaryDir>
+#include <QVector>
+
+// Render MIDI files with a synthetic soundfont and check the result
+class OfflineRendererTest : public QObject
 {
-public:
-    NoteEvent(unsigned char note, unsigned char val) : QEvent(QEvent::User),
-          _note(note),
-          _velocity(val) {}
-
-    unsigned char getNote() const
-    {
-        return _note;
-    }
-
-    unsigned char getVelocity() const
-    {
-        return _velocity;
-    }
-
-protected:
-    unsigned char _note;
-    unsigned char _velocity;
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+    void volumeAndBend();
+
+private:
+    void createSoundfont();
+    static bool writeMidiFile(QString fileName, const QByteArray &track);
+    static QVector<float> readWav24(QString fileName, quint32 &sampleRate);
+    static double getRms(const QVector<float> &data, int start, int end);
+    static double getFrequency(const QVector<float> &data, int start, int end, quint32 sampleRate);
+
+    QTemporaryDir _dir;
+    int _sf2Index;
 };
 
-#endif // NOTEEVENT_H
+#endif // OFFLINERENDERERTEST_H